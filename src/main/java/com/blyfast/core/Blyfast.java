@@ -4,6 +4,7 @@ import com.blyfast.http.Context;
 import com.blyfast.http.Request;
 import com.blyfast.http.Response;
 import com.blyfast.middleware.Middleware;
+import com.blyfast.nativeopt.HeaderFramingException;
 import com.blyfast.plugin.Plugin;
 import com.blyfast.routing.Route;
 import com.blyfast.routing.Router;
@@ -14,7 +15,10 @@ import io.undertow.Undertow;
 import io.undertow.UndertowOptions;
 import io.undertow.server.HttpHandler;
 import io.undertow.server.HttpServerExchange;
+import io.undertow.util.HeaderMap;
+import io.undertow.util.HeaderValues;
 import io.undertow.util.Headers;
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
@@ -62,6 +66,7 @@ public class Blyfast {
 
   // HTTP status codes
   private static final int HTTP_OK = 200;
+  private static final int HTTP_BAD_REQUEST = 400;
   private static final int HTTP_NOT_FOUND = 404;
   private static final int HTTP_INTERNAL_SERVER_ERROR = 500;
   private static final int HTTP_SERVICE_UNAVAILABLE = 503;
@@ -878,13 +883,16 @@ public class Blyfast {
   }
 
   /**
-   * Returns objects to their respective pools after use.
+   * Returns objects to their respective pools after use, and the request body buffer to the
+   * direct buffer pool.
    *
    * @param context the context to recycle
    * @param request the request to recycle
    * @param response the response to recycle
    */
   private void recycleObjects(Context context, Request request, Response response) {
+    // Before the request is pooled, where another thread may pick it up
+    request.releaseBody();
     if (useObjectPooling) {
       // Only return to pool if not at capacity
       requestPool.offer(request);
@@ -899,6 +907,10 @@ public class Blyfast {
     private static final String GET_METHOD = "GET";
     private static final String HEAD_METHOD = "HEAD";
 
+    // Framing fields written out for HeaderFramingException.check
+    private static final ThreadLocal<ByteBuffer> FRAMING_BLOCK =
+        ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(256));
+
     // Track frequently accessed routes for optimization
     // Use ConcurrentHashMap with manual size management for thread safety
     private static final int ROUTE_CACHE_SIZE = 1000;
@@ -909,6 +921,13 @@ public class Blyfast {
 
     @Override
     public void handleRequest(HttpServerExchange exchange) throws Exception {
+      // Reject ambiguous framing on the IO thread, before any body is read or work is dispatched
+      int framingError = checkFraming(exchange.getRequestHeaders());
+      if (framingError != 0) {
+        rejectFraming(exchange, framingError);
+        return;
+      }
+
       String path = exchange.getRequestPath();
       String method = exchange.getRequestMethod().toString();
 
@@ -1039,6 +1058,83 @@ public class Blyfast {
       }
     }
 
+    /**
+     * Checks the framing headers of a request parsed by Undertow. Line-level problems (bare CR,
+     * NUL, obs-fold) are rejected by Undertow's own parser; the framing fields it lets through are
+     * written out as a header block and run through {@link HeaderFramingException#check}, the
+     * rules of the native strict header scanner.
+     *
+     * @param headers the request headers
+     * @return the {@link HeaderFramingException} code, or 0 if the framing is unambiguous
+     */
+    private int checkFraming(HeaderMap headers) {
+      // Every rule involves Content-Length, which most requests without a body do not send
+      HeaderValues contentLength = headers.get(Headers.CONTENT_LENGTH);
+      if (contentLength == null) {
+        return 0;
+      }
+      HeaderValues transferEncoding = headers.get(Headers.TRANSFER_ENCODING);
+
+      int size = framingFieldsSize(contentLength) + framingFieldsSize(transferEncoding);
+      ByteBuffer block = FRAMING_BLOCK.get();
+      if (size > block.capacity()) {
+        block = ByteBuffer.allocateDirect(size);
+      }
+      block.clear();
+      putFramingFields(block, contentLength);
+      putFramingFields(block, transferEncoding);
+      return HeaderFramingException.check(block, block.position());
+    }
+
+    // "Name: value\r\n" for each value
+    private int framingFieldsSize(HeaderValues values) {
+      if (values == null) {
+        return 0;
+      }
+      int size = 0;
+      for (String value : values) {
+        size += values.getHeaderName().length() + value.length() + 4;
+      }
+      return size;
+    }
+
+    // Undertow keeps header bytes as ISO-8859-1 chars, so each char is written back as its byte
+    private void putFramingFields(ByteBuffer block, HeaderValues values) {
+      if (values == null) {
+        return;
+      }
+      String name = values.getHeaderName().toString();
+      for (String value : values) {
+        for (int i = 0; i < name.length(); i++) {
+          block.put((byte) name.charAt(i));
+        }
+        block.put((byte) ':').put((byte) ' ');
+        for (int i = 0; i < value.length(); i++) {
+          block.put((byte) value.charAt(i));
+        }
+        block.put((byte) '\r').put((byte) '\n');
+      }
+    }
+
+    /**
+     * Answers a request with ambiguous framing with 400 and closes the connection, since the
+     * position of the next request on it is unknown.
+     *
+     * @param exchange the HTTP exchange
+     * @param code the framing error code
+     */
+    private void rejectFraming(HttpServerExchange exchange, int code) {
+      exchange.setStatusCode(HTTP_BAD_REQUEST);
+      exchange.setPersistent(false);
+      exchange.getResponseHeaders().put(Headers.CONTENT_TYPE, "application/json");
+      exchange
+          .getResponseSender()
+          .send(
+              "{\"error\": \"Bad Request\", \"message\": \""
+                  + HeaderFramingException.reason(code)
+                  + "\"}");
+    }
+
     /**
      * Ultra-fast path processing that skips almost all checks and overhead. This is the absolute
      * fastest path for simple GET requests to known routes.
@@ -1086,28 +1182,29 @@ public class Blyfast {
       Response response = getResponse(exchange);
       Context context = getContext(request, response);
 
-      // Find route (avoid full middleware processing for the fast path)
-      String method = request.getMethod();
-      String path = request.getPath();
-      Route route = router.findRoute(method, path);
+      try {
+        // Find route (avoid full middleware processing for the fast path)
+        String method = request.getMethod();
+        String path = request.getPath();
+        Route route = router.findRoute(method, path);
 
-      if (route != null) {
-        // Extract path parameters
-        router.resolveParams(request, route);
+        if (route != null) {
+          // Extract path parameters
+          router.resolveParams(request, route);
 
-        // Execute handler directly
-        try {
-          route.getHandler().handle(context);
-          recordSuccess();
-        } catch (Exception e) {
-          recordFailure();
-          throw e;
-        } finally {
-          recycleObjects(context, request, response);
+          // Execute handler directly
+          try {
+            route.getHandler().handle(context);
+            recordSuccess();
+          } catch (Exception e) {
+            recordFailure();
+            throw e;
+          }
+        } else {
+          // No route found - return 404
+          response.status(HTTP_NOT_FOUND).json("{\"error\": \"Not Found\"}");
         }
-      } else {
-        // No route found - return 404
-        response.status(HTTP_NOT_FOUND).json("{\"error\": \"Not Found\"}");
+      } finally {
         recycleObjects(context, request, response);
       }
     }
@@ -1144,12 +1241,14 @@ public class Blyfast {
      * @param exchange the HTTP exchange
      */
     private void processRequest(HttpServerExchange exchange) {
-      try {
-        // Create request and response objects
-        Request request = getRequest(exchange);
-        Response response = getResponse(exchange);
-        Context context = getContext(request, response);
+      // Create request and response objects
+      Request request = getRequest(exchange);
+      Response response = getResponse(exchange);
+      Context context = getContext(request, response);
 
+      // Whether another thread continues with the request and recycles it
+      boolean handedOff = false;
+      try {
         if (enableAsyncMiddleware && !globalMiddleware.isEmpty()) {
           // Process global middleware asynchronously
           processMiddlewareAsync(
@@ -1159,12 +1258,18 @@ public class Blyfast {
               globalMiddleware,
               () -> {
                 // Continue with route processing after middleware
-                if (!response.isSent()) {
-                  processRoute(context, request, response);
-                } else {
-                  recycleObjects(context, request, response);
+                boolean routeHandedOff = false;
+                try {
+                  if (!response.isSent()) {
+                    routeHandedOff = processRoute(context, request, response);
+                  }
+                } finally {
+                  if (!routeHandedOff) {
+                    recycleObjects(context, request, response);
+                  }
                 }
               });
+          handedOff = true;
         } else {
           // Process global middleware synchronously (original behavior)
           for (Middleware middleware : globalMiddleware) {
@@ -1176,18 +1281,16 @@ public class Blyfast {
               response
                   .status(HTTP_INTERNAL_SERVER_ERROR)
                   .json("{\"error\": \"Internal Server Error\"}");
-              recycleObjects(context, request, response);
               return; // Exit early on error
             }
 
             if (!continueProcessing || response.isSent()) {
-              recycleObjects(context, request, response);
               return; // Middleware chain was interrupted or response was sent
             }
           }
 
           // Process the route
-          processRoute(context, request, response);
+          handedOff = processRoute(context, request, response);
         }
       } catch (Exception e) {
         logger.error(LogUtil.error("Error processing request: " + e.getMessage()), e);
@@ -1198,17 +1301,25 @@ public class Blyfast {
         } catch (Exception ex) {
           logger.error(LogUtil.error("Error sending error response: " + ex.getMessage()), ex);
         }
+      } finally {
+        // Also after errors, so that the body buffer goes back to the pool
+        if (!handedOff) {
+          recycleObjects(context, request, response);
+        }
       }
     }
 
     /**
-     * Processes the route after middleware execution.
+     * Processes the route after middleware execution. The caller recycles the request objects
+     * unless route middleware continues asynchronously.
      *
      * @param context the request context
      * @param request the request
      * @param response the response
+     * @return true if the request was handed to asynchronous middleware, which recycles the
+     *     request objects when it completes
      */
-    private void processRoute(Context context, Request request, Response response) {
+    private boolean processRoute(Context context, Request request, Response response) {
       String method = request.getMethod();
       String path = request.getPath();
 
@@ -1245,12 +1356,16 @@ public class Blyfast {
               response,
               route.getMiddleware(),
               () -> {
-                // Execute the route handler if response hasn't been sent
-                if (!response.isSent()) {
-                  executeRouteHandler(context, response, route);
+                try {
+                  // Execute the route handler if response hasn't been sent
+                  if (!response.isSent()) {
+                    executeRouteHandler(context, response, route);
+                  }
+                } finally {
+                  recycleObjects(context, request, response);
                 }
-                recycleObjects(context, request, response);
               });
+          return true;
         } else {
           // Process route-specific middleware synchronously (original behavior)
           for (Middleware middleware : route.getMiddleware()) {
@@ -1262,25 +1377,22 @@ public class Blyfast {
               response
                   .status(HTTP_INTERNAL_SERVER_ERROR)
                   .json("{\"error\": \"Internal Server Error\"}");
-              recycleObjects(context, request, response);
-              return; // Exit early on error
+              return false; // Exit early on error
             }
 
             if (!continueProcessing || response.isSent()) {
-              recycleObjects(context, request, response);
-              return; // Middleware chain was interrupted or response was sent
+              return false; // Middleware chain was interrupted or response was sent
             }
           }
 
           // Execute the route handler
           executeRouteHandler(context, response, route);
-          recycleObjects(context, request, response);
         }
       } else {
         // No route found - return 404
         response.status(HTTP_NOT_FOUND).json("{\"error\": \"Not Found\"}");
-        recycleObjects(context, request, response);
       }
+      return false;
     }
 
     /**
@@ -1315,7 +1427,8 @@ public class Blyfast {
      * @param request the request
      * @param response the response
      * @param middlewareList the list of middleware to process
-     * @param completionCallback the callback to execute after all middleware is processed
+     * @param completionCallback the callback to execute after all middleware is processed, which
+     *     recycles the request objects
      */
     private void processMiddlewareAsync(
         Context context,
@@ -1332,31 +1445,41 @@ public class Blyfast {
       // Use the thread pool for async processing
       threadPool.execute(
           () -> {
-            // Process each middleware in sequence
-            for (Middleware middleware : middlewareList) {
-              if (response.isSent()) {
-                break; // Stop if response already sent
-              }
+            // The completion callback recycles the request objects; until it runs, this does
+            boolean completing = false;
+            try {
+              // Process each middleware in sequence
+              for (Middleware middleware : middlewareList) {
+                if (response.isSent()) {
+                  break; // Stop if response already sent
+                }
 
-              boolean continueProcessing;
-              try {
-                continueProcessing = middleware.handle(context);
-              } catch (Exception e) {
-                logger.error(LogUtil.error("Error in async middleware: " + e.getMessage()), e);
-                response
-                    .status(HTTP_INTERNAL_SERVER_ERROR)
-                    .json("{\"error\": \"Internal Server Error\"}");
-                completionCallback.run();
-                return; // Exit early on error
+                boolean continueProcessing;
+                try {
+                  continueProcessing = middleware.handle(context);
+                } catch (Exception e) {
+                  logger.error(LogUtil.error("Error in async middleware: " + e.getMessage()), e);
+                  response
+                      .status(HTTP_INTERNAL_SERVER_ERROR)
+                      .json("{\"error\": \"Internal Server Error\"}");
+                  completing = true;
+                  completionCallback.run();
+                  return; // Exit early on error
+                }
+
+                if (!continueProcessing) {
+                  break; // Stop middleware chain if requested
+                }
               }
 
-              if (!continueProcessing) {
-                break; // Stop middleware chain if requested
+              // Call the completion callback
+              completing = true;
+              completionCallback.run();
+            } finally {
+              if (!completing) {
+                recycleObjects(context, request, response);
               }
             }
-
-            // Call the completion callback
-            completionCallback.run();
           });
     }
   }
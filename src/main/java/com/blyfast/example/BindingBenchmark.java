@@ -0,0 +1,90 @@
+package com.blyfast.example;
+
+import com.blyfast.nativeopt.NativeBindings;
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Benchmark for the cost of a native call. Runs the short calls made on every request through the
+ * JNI binding and, on Java 22 and later, the FFM binding, call for call on the same input. Run
+ * with {@code --enable-native-access=ALL-UNNAMED} to avoid the FFM access warning.
+ */
+public class BindingBenchmark {
+
+  private static final String CONTENT_TYPE = "application/json; charset=utf-8";
+  private static final byte[] BODY =
+      "{\"id\":42,\"name\":\"widget\",\"tags\":[\"a\",\"b\"]}".getBytes(StandardCharsets.US_ASCII);
+  private static final byte[] COOKIE_HEADER =
+      "session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; lang=en-US; _ga=GA1.2.3.4"
+          .getBytes(StandardCharsets.ISO_8859_1);
+  private static final byte[] QUERY =
+      "q=native+calls&page=2&sort=desc&filter%5Bstatus%5D=open&limit=50"
+          .getBytes(StandardCharsets.ISO_8859_1);
+
+  private static final int WARMUP_CALLS = 1_000_000;
+  private static final int MEASURED_CALLS = 10_000_000;
+
+  public static void main(String[] args) throws Exception {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      System.out.println("Native library not available; nothing to benchmark");
+      return;
+    }
+
+    NativeBindings jni = NativeBindings.jni();
+    NativeBindings ffm = NativeBindings.ffm();
+    System.out.println("Running native binding benchmarks...");
+    System.out.println("Selected binding: " + NativeBindings.get().getName());
+    if (ffm == null) {
+      System.out.println("FFM binding not available (Java " + Runtime.version().feature() + ")");
+    }
+    System.out.println();
+
+    for (NativeBindings bindings : new NativeBindings[] {jni, ffm}) {
+      if (bindings == null) {
+        continue;
+      }
+      System.out.println("=== " + bindings.getName() + " ===");
+      runAll(bindings);
+      System.out.println();
+    }
+  }
+
+  private static void runAll(NativeBindings bindings) {
+    ByteBuffer body = ByteBuffer.allocateDirect(BODY.length);
+    body.put(BODY).flip();
+    int[] cookieIndex = new int[16 * 4];
+    int[] queryIndex = new int[16 * 5];
+    byte[] decoded = new byte[QUERY.length];
+
+    report("analyzeHttpBody", () -> bindings.analyzeHttpBody(body, BODY.length, CONTENT_TYPE));
+    report("detectContentType", () -> bindings.detectContentType(body, BODY.length));
+    report(
+        "parseCookies",
+        () -> bindings.parseCookies(COOKIE_HEADER, COOKIE_HEADER.length, cookieIndex));
+    report("parseQuery", () -> bindings.parseQuery(QUERY, QUERY.length, queryIndex));
+    report("percentDecode", () -> bindings.percentDecode(QUERY, 0, QUERY.length, decoded, true));
+  }
+
+  private static void report(String name, Call call) {
+    long sink = 0;
+    for (int i = 0; i < WARMUP_CALLS; i++) {
+      sink += call.run();
+    }
+
+    long start = System.nanoTime();
+    for (int i = 0; i < MEASURED_CALLS; i++) {
+      sink += call.run();
+    }
+    long elapsed = System.nanoTime() - start;
+
+    System.out.printf(
+        "  %-20s %8.1f ns per call  (checksum %d)%n",
+        name, (double) elapsed / MEASURED_CALLS, sink);
+  }
+
+  @FunctionalInterface
+  private interface Call {
+    int run();
+  }
+}
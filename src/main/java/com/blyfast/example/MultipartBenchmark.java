@@ -0,0 +1,185 @@
+package com.blyfast.example;
+
+import com.blyfast.nativeopt.MultipartParser;
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Random;
+
+/**
+ * Benchmark for multipart/form-data parsing. Bodies with large binary parts measure the boundary
+ * search; forms with thousands of small fields, like bulk-edit submissions, measure per-part
+ * bookkeeping. Compares a per-offset boundary comparison (the cost of an O(n * m) scan) with the
+ * native whole-body parser, the zero-copy part index and the native streaming parser.
+ */
+public class MultipartBenchmark {
+
+  private static final String BOUNDARY = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+
+  // Part sizes to benchmark
+  private static final int[] PART_SIZES = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+
+  // Field counts for forms of small fields
+  private static final int[] FIELD_COUNTS = {100, 1000, 10000};
+
+  // Chunk size for the streaming parser, as read from the socket
+  private static final int STREAM_CHUNK_SIZE = 64 * 1024;
+
+  private static final int WARMUP_ITERATIONS = 5;
+  private static final int MEASURED_ITERATIONS = 20;
+
+  public static void main(String[] args) throws Exception {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      System.out.println("Native library not available; nothing to benchmark");
+      return;
+    }
+
+    System.out.println("Running multipart benchmarks...");
+    System.out.println("Boundary: " + BOUNDARY);
+    System.out.println();
+
+    for (int partSize : PART_SIZES) {
+      System.out.println("=== Binary part of " + (partSize / 1024) + " KB ===");
+      runAll(buildBody(partSize));
+    }
+    for (int fieldCount : FIELD_COUNTS) {
+      System.out.println("=== " + fieldCount + " small fields ===");
+      runAll(buildForm(fieldCount));
+    }
+  }
+
+  private static void runAll(byte[] body) throws Exception {
+    ByteBuffer direct = ByteBuffer.allocateDirect(body.length);
+    direct.put(body).flip();
+
+    report("Per-offset comparison", body.length, () -> naiveScan(body));
+    report(
+        "Native whole-body parser",
+        body.length,
+        () -> {
+          ByteBuffer parsed =
+              NativeOptimizer.nativeParseMultipartForm(direct, body.length, BOUNDARY);
+          return parsed != null ? parsed.capacity() : 0;
+        });
+    report(
+        "Native part index",
+        body.length,
+        () -> {
+          // Eight ints per part; a negative count asks for a larger array
+          int[] index = new int[16 * 8];
+          int count =
+              NativeOptimizer.nativeIndexMultipartForm(direct, body.length, BOUNDARY, index);
+          if (count < 0) {
+            index = new int[-count * 8];
+            count =
+                NativeOptimizer.nativeIndexMultipartForm(direct, body.length, BOUNDARY, index);
+          }
+          return count;
+        });
+    report("Native streaming parser", body.length, () -> stream(direct, body.length));
+    System.out.println();
+  }
+
+  /** Builds a body with a small text field and one part of random binary data. */
+  private static byte[] buildBody(int partSize) {
+    byte[] head =
+        ("--"
+                + BOUNDARY
+                + "\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nupload\r\n--"
+                + BOUNDARY
+                + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"data.bin\"\r\n"
+                + "Content-Type: application/octet-stream\r\n\r\n")
+            .getBytes(StandardCharsets.US_ASCII);
+    byte[] tail = ("\r\n--" + BOUNDARY + "--\r\n").getBytes(StandardCharsets.US_ASCII);
+
+    byte[] body = new byte[head.length + partSize + tail.length];
+    System.arraycopy(head, 0, body, 0, head.length);
+    byte[] content = new byte[partSize];
+    new Random(42).nextBytes(content);
+    System.arraycopy(content, 0, body, head.length, partSize);
+    System.arraycopy(tail, 0, body, head.length + partSize, tail.length);
+    return body;
+  }
+
+  /** Builds a form of short text fields, as submitted by a bulk-edit table. */
+  private static byte[] buildForm(int fieldCount) {
+    StringBuilder form = new StringBuilder(fieldCount * 100);
+    for (int i = 0; i < fieldCount; i++) {
+      form.append("--").append(BOUNDARY).append("\r\n");
+      form.append("Content-Disposition: form-data; name=\"rows[").append(i / 4);
+      form.append("][col").append(i % 4).append("]\"\r\n\r\n");
+      form.append("value ").append(i).append("\r\n");
+    }
+    form.append("--").append(BOUNDARY).append("--\r\n");
+    return form.toString().getBytes(StandardCharsets.US_ASCII);
+  }
+
+  /** Finds every delimiter by comparing it at each offset, as a baseline. */
+  private static long naiveScan(byte[] body) {
+    byte[] delimiter = ("--" + BOUNDARY).getBytes(StandardCharsets.US_ASCII);
+    long found = 0;
+    for (int i = 0; i + delimiter.length <= body.length; i++) {
+      int j = 0;
+      while (j < delimiter.length && body[i + j] == delimiter[j]) {
+        j++;
+      }
+      if (j == delimiter.length) {
+        found++;
+      }
+    }
+    return found;
+  }
+
+  /** Feeds the body to the streaming parser in socket-sized chunks. */
+  private static long stream(ByteBuffer body, int length) throws IOException {
+    long[] dataBytes = new long[1];
+    MultipartParser.Listener listener =
+        new MultipartParser.Listener() {
+          @Override
+          public void partBegin(String name, String filename, String contentType) {}
+
+          @Override
+          public void partData(ByteBuffer buffer, int offset, int dataLength) {
+            dataBytes[0] += dataLength;
+          }
+
+          @Override
+          public void partEnd() {}
+        };
+
+    try (MultipartParser parser = new MultipartParser(BOUNDARY)) {
+      int offset = 0;
+      int received = 0;
+      while (received < length && !parser.isComplete()) {
+        received = Math.min(received + STREAM_CHUNK_SIZE, length);
+        // Unconsumed bytes are passed again together with the next chunk
+        offset += parser.parse(body, offset, received - offset, listener);
+      }
+    }
+    return dataBytes[0];
+  }
+
+  private static void report(String name, int bodyLength, Task task) throws Exception {
+    long sink = 0;
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+      sink += task.run();
+    }
+
+    long start = System.nanoTime();
+    for (int i = 0; i < MEASURED_ITERATIONS; i++) {
+      sink += task.run();
+    }
+    double seconds = (System.nanoTime() - start) / 1_000_000_000.0;
+
+    double megabytes = (double) bodyLength * MEASURED_ITERATIONS / (1024 * 1024);
+    System.out.printf(
+        "  %-28s %10.1f MB/s  (%.3f ms per body, checksum %d)%n",
+        name, megabytes / seconds, seconds * 1000 / MEASURED_ITERATIONS, sink);
+  }
+
+  @FunctionalInterface
+  private interface Task {
+    long run() throws Exception;
+  }
+}
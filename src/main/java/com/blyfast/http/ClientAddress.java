@@ -0,0 +1,361 @@
+package com.blyfast.http;
+
+import java.net.InetAddress;
+import java.net.UnknownHostException;
+
+/**
+ * An IPv4 or IPv6 address held as a 128-bit value, IPv4 mapped into {@code ::ffff:0:0/96}.
+ *
+ * <p>Instances compare and hash by value, so they can key maps such as rate limiter buckets
+ * directly; the textual form is only built when {@link #toString} is called.
+ */
+public final class ClientAddress {
+  private static final long IPV4_MAPPED_PREFIX = 0x0000FFFF00000000L;
+  private static final int MAX_NODE_LENGTH = 64;
+
+  private final long high;
+  private final long low;
+  private String text;
+
+  /**
+   * Creates an address from its 128-bit value.
+   *
+   * @param high the upper 64 bits
+   * @param low the lower 64 bits
+   */
+  public ClientAddress(long high, long low) {
+    this.high = high;
+    this.low = low;
+  }
+
+  /**
+   * Converts an {@link InetAddress} without any name lookup.
+   *
+   * @param address the address
+   * @return the client address
+   */
+  public static ClientAddress of(InetAddress address) {
+    return of(address.getAddress());
+  }
+
+  /**
+   * Converts a raw IPv4 (4 bytes) or IPv6 (16 bytes) address.
+   *
+   * @param bytes the address bytes in network order
+   * @return the client address
+   * @throws IllegalArgumentException if the length is neither 4 nor 16
+   */
+  public static ClientAddress of(byte[] bytes) {
+    if (bytes.length == 4) {
+      return new ClientAddress(0, IPV4_MAPPED_PREFIX | (readInt(bytes, 0) & 0xFFFFFFFFL));
+    }
+    if (bytes.length == 16) {
+      return new ClientAddress(
+          (long) readInt(bytes, 0) << 32 | (readInt(bytes, 4) & 0xFFFFFFFFL),
+          (long) readInt(bytes, 8) << 32 | (readInt(bytes, 12) & 0xFFFFFFFFL));
+    }
+    throw new IllegalArgumentException("Invalid address length: " + bytes.length);
+  }
+
+  /**
+   * Parses an address literal as found in forwarding headers: IPv4, IPv6, either with a port, and
+   * IPv6 in brackets. Never performs a name lookup.
+   *
+   * @param s the text
+   * @return the address, or null if the text is not an address literal
+   */
+  public static ClientAddress parse(CharSequence s) {
+    return parseNode(s, 0, s.length());
+  }
+
+  /**
+   * Gets the upper 64 bits of the address.
+   *
+   * @return the upper bits
+   */
+  public long getHigh() {
+    return high;
+  }
+
+  /**
+   * Gets the lower 64 bits of the address.
+   *
+   * @return the lower bits
+   */
+  public long getLow() {
+    return low;
+  }
+
+  /**
+   * Checks whether this is an IPv4 address.
+   *
+   * @return true for IPv4 (IPv4-mapped) addresses
+   */
+  public boolean isIpv4() {
+    return high == 0 && (low & 0xFFFFFFFF00000000L) == IPV4_MAPPED_PREFIX;
+  }
+
+  /**
+   * Converts the address to an {@link InetAddress} without any name lookup.
+   *
+   * @return the address
+   */
+  public InetAddress toInetAddress() {
+    byte[] bytes;
+    if (isIpv4()) {
+      bytes = new byte[4];
+      writeInt(bytes, 0, (int) low);
+    } else {
+      bytes = new byte[16];
+      writeInt(bytes, 0, (int) (high >>> 32));
+      writeInt(bytes, 4, (int) high);
+      writeInt(bytes, 8, (int) (low >>> 32));
+      writeInt(bytes, 12, (int) low);
+    }
+    try {
+      return InetAddress.getByAddress(bytes);
+    } catch (UnknownHostException e) {
+      throw new IllegalStateException(e); // Unreachable: the length is always valid
+    }
+  }
+
+  @Override
+  public boolean equals(Object o) {
+    if (this == o) {
+      return true;
+    }
+    if (!(o instanceof ClientAddress)) {
+      return false;
+    }
+    ClientAddress other = (ClientAddress) o;
+    return high == other.high && low == other.low;
+  }
+
+  @Override
+  public int hashCode() {
+    return Long.hashCode(high * 31 + low);
+  }
+
+  /**
+   * Formats the address: dotted quad for IPv4, RFC 5952 form for IPv6.
+   *
+   * @return the textual address
+   */
+  @Override
+  public String toString() {
+    if (text == null) {
+      text = isIpv4() ? formatIpv4((int) low) : formatIpv6();
+    }
+    return text;
+  }
+
+  private String formatIpv6() {
+    int[] groups = new int[8];
+    for (int i = 0; i < 4; i++) {
+      groups[i] = (int) (high >>> (48 - i * 16)) & 0xFFFF;
+      groups[i + 4] = (int) (low >>> (48 - i * 16)) & 0xFFFF;
+    }
+
+    // Compress the longest run of two or more zero groups, the first one on ties
+    int bestStart = -1;
+    int bestLength = 1;
+    for (int i = 0; i < 8; ) {
+      if (groups[i] != 0) {
+        i++;
+        continue;
+      }
+      int start = i;
+      while (i < 8 && groups[i] == 0) {
+        i++;
+      }
+      if (i - start > bestLength) {
+        bestStart = start;
+        bestLength = i - start;
+      }
+    }
+
+    StringBuilder sb = new StringBuilder(39);
+    for (int i = 0; i < 8; i++) {
+      if (i == bestStart) {
+        sb.append("::");
+        i += bestLength - 1;
+        continue;
+      }
+      if (sb.length() > 0 && sb.charAt(sb.length() - 1) != ':') {
+        sb.append(':');
+      }
+      sb.append(Integer.toHexString(groups[i]));
+    }
+    return sb.toString();
+  }
+
+  private static String formatIpv4(int v4) {
+    return (v4 >>> 24) + "." + ((v4 >>> 16) & 0xFF) + "." + ((v4 >>> 8) & 0xFF) + "." + (v4 & 0xFF);
+  }
+
+  /** Parses a forwarded node between start and end; mirrors parseNode in client_address.c. */
+  static ClientAddress parseNode(CharSequence s, int start, int end) {
+    int len = end - start;
+    if (len <= 0 || len > MAX_NODE_LENGTH) {
+      return null;
+    }
+    if (s.charAt(start) == '[') {
+      int close = indexOf(s, ']', start, end);
+      if (close < 0 || (close + 1 < end && s.charAt(close + 1) != ':')) {
+        return null;
+      }
+      return parseIpv6(s, start + 1, close);
+    }
+
+    int colon = indexOf(s, ':', start, end);
+    if (colon >= 0 && indexOf(s, ':', colon + 1, end) >= 0) {
+      return parseIpv6(s, start, end);
+    }
+    long v4 = parseIpv4(s, start, colon >= 0 ? colon : end);
+    return v4 < 0 ? null : new ClientAddress(0, IPV4_MAPPED_PREFIX | v4);
+  }
+
+  /** Parses a dotted quad without leading zeros, returning -1 if invalid. */
+  private static long parseIpv4(CharSequence s, int start, int end) {
+    long address = 0;
+    int pos = start;
+    for (int part = 0; part < 4; part++) {
+      if (part > 0) {
+        if (pos >= end || s.charAt(pos) != '.') {
+          return -1;
+        }
+        pos++;
+      }
+      int digitsStart = pos;
+      int octet = 0;
+      while (pos < end && pos - digitsStart < 3 && isDigit(s.charAt(pos))) {
+        octet = octet * 10 + (s.charAt(pos) - '0');
+        pos++;
+      }
+      if (pos == digitsStart
+          || octet > 255
+          || (pos - digitsStart > 1 && s.charAt(digitsStart) == '0')) {
+        return -1;
+      }
+      address = (address << 8) | octet;
+    }
+    return pos == end ? address : -1;
+  }
+
+  private static ClientAddress parseIpv6(CharSequence s, int start, int end) {
+    int[] groups = new int[8];
+    int count = 0;
+    int gap = -1;
+    int pos = start;
+
+    if (end - start >= 2 && s.charAt(start) == ':' && s.charAt(start + 1) == ':') {
+      gap = 0;
+      pos += 2;
+    } else if (end > start && s.charAt(start) == ':') {
+      return null;
+    }
+
+    while (pos < end) {
+      if (count == 8) {
+        return null;
+      }
+      int groupStart = pos;
+      int group = 0;
+      while (pos < end && pos - groupStart < 4 && hexValue(s.charAt(pos)) >= 0) {
+        group = (group << 4) | hexValue(s.charAt(pos));
+        pos++;
+      }
+      if (pos < end && s.charAt(pos) == '.') {
+        // Embedded IPv4 takes the last two groups
+        long v4 = count > 6 ? -1 : parseIpv4(s, groupStart, end);
+        if (v4 < 0) {
+          return null;
+        }
+        groups[count++] = (int) (v4 >>> 16);
+        groups[count++] = (int) v4 & 0xFFFF;
+        pos = end;
+        break;
+      }
+      if (pos == groupStart) {
+        return null;
+      }
+      groups[count++] = group;
+      if (pos == end) {
+        break;
+      }
+      if (s.charAt(pos) != ':') {
+        return null;
+      }
+      pos++;
+      if (pos < end && s.charAt(pos) == ':') {
+        if (gap >= 0) {
+          return null;
+        }
+        gap = count;
+        pos++;
+      } else if (pos == end) {
+        return null; // Trailing single colon
+      }
+    }
+
+    if ((gap < 0 && count != 8) || (gap >= 0 && count > 7)) {
+      return null;
+    }
+
+    int[] full = new int[8];
+    if (gap < 0) {
+      full = groups;
+    } else {
+      System.arraycopy(groups, 0, full, 0, gap);
+      int tail = count - gap;
+      System.arraycopy(groups, gap, full, 8 - tail, tail);
+    }
+    long high = 0;
+    long low = 0;
+    for (int i = 0; i < 4; i++) {
+      high = (high << 16) | full[i];
+      low = (low << 16) | full[i + 4];
+    }
+    return new ClientAddress(high, low);
+  }
+
+  private static boolean isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  private static int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  private static int indexOf(CharSequence s, char c, int start, int end) {
+    for (int i = start; i < end; i++) {
+      if (s.charAt(i) == c) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  private static int readInt(byte[] b, int offset) {
+    return (b[offset] & 0xFF) << 24
+        | (b[offset + 1] & 0xFF) << 16
+        | (b[offset + 2] & 0xFF) << 8
+        | (b[offset + 3] & 0xFF);
+  }
+
+  private static void writeInt(byte[] b, int offset, int value) {
+    b[offset] = (byte) (value >>> 24);
+    b[offset + 1] = (byte) (value >>> 16);
+    b[offset + 2] = (byte) (value >>> 8);
+    b[offset + 3] = (byte) value;
+  }
+}
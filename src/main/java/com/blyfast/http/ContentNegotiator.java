@@ -0,0 +1,255 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.util.Arrays;
+import java.util.Iterator;
+import java.util.Locale;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+
+/**
+ * Selects the best of a fixed list of offers for an Accept, Accept-Encoding or Accept-Language
+ * header (RFC 9110 12.5).
+ *
+ * <p>Each offer takes the q-value of the most specific range that matches it; the offer with the
+ * highest non-zero q-value wins and earlier offers win ties. Clients send the same few header
+ * values over and over, so results are cached per header value (up to 256 values, evicting an
+ * arbitrary one when full) and a repeated value costs one map lookup. Offers are compiled into the
+ * native library when it is available, once per distinct offer list.
+ */
+public final class ContentNegotiator {
+  private static final int MEDIA_TYPE = 0;
+  private static final int ENCODING = 1;
+  private static final int LANGUAGE = 2;
+
+  // Distinct header values remembered per negotiator; bounded since values are client-controlled
+  private static final int CACHE_SIZE = 256;
+
+  // Native offer sets are never freed and the registry is small, so every negotiator with the same
+  // kind and offers shares one set
+  private static final Map<String, Integer> nativeOfferSets = new ConcurrentHashMap<>();
+
+  private final int kind;
+  private final String[] offers;
+  private final String[] normalizedOffers;
+  private final int nativeOfferSetId;
+  private final Map<String, Integer> cache = new ConcurrentHashMap<>(64);
+
+  private ContentNegotiator(int kind, String[] offers) {
+    if (offers.length == 0) {
+      throw new IllegalArgumentException("At least one offer is required");
+    }
+    this.kind = kind;
+    this.offers = offers.clone();
+    this.normalizedOffers = new String[offers.length];
+    for (int i = 0; i < offers.length; i++) {
+      String offer = offers[i].toLowerCase(Locale.ROOT);
+      if (offer.isEmpty() || (kind == MEDIA_TYPE && offer.indexOf('/') < 0)) {
+        throw new IllegalArgumentException("Invalid offer: " + offers[i]);
+      }
+      normalizedOffers[i] = offer;
+    }
+    this.nativeOfferSetId =
+        NativeOptimizer.isNativeOptimizationAvailable() ? nativeOfferSet(kind, this.offers) : 0;
+  }
+
+  private static int nativeOfferSet(int kind, String[] offers) {
+    String key = kind + "\n" + String.join("\n", offers);
+    return nativeOfferSets.computeIfAbsent(
+        key, k -> NativeOptimizer.nativeCompileOffers(kind, offers));
+  }
+
+  /**
+   * Creates a negotiator for the Accept header.
+   *
+   * @param mediaTypes the media types the server can produce, most preferred first
+   * @return the negotiator
+   */
+  public static ContentNegotiator mediaTypes(String... mediaTypes) {
+    return new ContentNegotiator(MEDIA_TYPE, mediaTypes);
+  }
+
+  /**
+   * Creates a negotiator for the Accept-Encoding header. Include {@code "identity"} to allow an
+   * uncompressed response when the client accepts none of the other codings.
+   *
+   * @param encodings the content codings the server can apply, most preferred first
+   * @return the negotiator
+   */
+  public static ContentNegotiator encodings(String... encodings) {
+    return new ContentNegotiator(ENCODING, encodings);
+  }
+
+  /**
+   * Creates a negotiator for the Accept-Language header.
+   *
+   * @param languages the language tags the server can produce, most preferred first
+   * @return the negotiator
+   */
+  public static ContentNegotiator languages(String... languages) {
+    return new ContentNegotiator(LANGUAGE, languages);
+  }
+
+  /**
+   * Selects the best offer for a header value.
+   *
+   * @param header the header value, or null if the request did not send the header
+   * @return the index of the selected offer, or -1 if none is acceptable
+   */
+  public int select(String header) {
+    // Without the header (or, for Accept and Accept-Language, with an empty one) anything goes
+    if (header == null || (header.isEmpty() && kind != ENCODING)) {
+      return 0;
+    }
+
+    Integer cached = cache.get(header);
+    if (cached != null) {
+      return cached;
+    }
+
+    int selected =
+        nativeOfferSetId != 0
+            ? NativeOptimizer.nativeNegotiate(nativeOfferSetId, header)
+            : negotiate(header);
+    if (cache.size() >= CACHE_SIZE) {
+      // Evict an arbitrary entry; the values a client population repeats come straight back
+      Iterator<String> keys = cache.keySet().iterator();
+      if (keys.hasNext()) {
+        cache.remove(keys.next());
+      }
+    }
+    cache.putIfAbsent(header, selected);
+    return selected;
+  }
+
+  /**
+   * Selects the best offer for a header value.
+   *
+   * @param header the header value, or null if the request did not send the header
+   * @return the selected offer as it was given to the factory, or null if none is acceptable
+   */
+  public String selectOffer(String header) {
+    int selected = select(header);
+    return selected >= 0 ? offers[selected] : null;
+  }
+
+  /** Java fallback for the native negotiation, with the same matching rules. */
+  private int negotiate(String header) {
+    int[] quality = new int[offers.length];
+    int[] specificity = new int[offers.length];
+    Arrays.fill(quality, -1);
+    Arrays.fill(specificity, -1);
+
+    for (String element : header.split(",")) {
+      String[] parts = element.split(";");
+      String range = parts[0].trim();
+      if (range.isEmpty()) {
+        continue;
+      }
+
+      int q = 1000;
+      for (int p = 1; p < parts.length; p++) {
+        String param = parts[p].trim();
+        if (param.length() >= 2
+            && (param.charAt(0) == 'q' || param.charAt(0) == 'Q')
+            && param.charAt(1) == '=') {
+          q = parseQValue(param.substring(2));
+        }
+      }
+      if (q < 0) {
+        continue;
+      }
+
+      range = range.toLowerCase(Locale.ROOT);
+      for (int i = 0; i < offers.length; i++) {
+        int s = specificity(range, normalizedOffers[i]);
+        if (s > specificity[i]) {
+          specificity[i] = s;
+          quality[i] = q;
+        }
+      }
+    }
+
+    int best = -1;
+    int bestQuality = 0;
+    for (int i = 0; i < offers.length; i++) {
+      int q = quality[i];
+      // identity is acceptable unless excluded explicitly or by "*;q=0" (RFC 9110 12.5.3)
+      if (q < 0 && kind == ENCODING && normalizedOffers[i].equals("identity")) {
+        q = 1;
+      }
+      if (q > bestQuality) {
+        best = i;
+        bestQuality = q;
+      }
+    }
+    return best;
+  }
+
+  private int specificity(String range, String offer) {
+    switch (kind) {
+      case MEDIA_TYPE:
+        {
+          if (range.equals("*/*")) {
+            return 1;
+          }
+          int slash = range.indexOf('/');
+          int offerSlash = offer.indexOf('/');
+          if (slash < 0 || slash != offerSlash || !range.regionMatches(0, offer, 0, slash)) {
+            return -1;
+          }
+          String subtype = range.substring(slash + 1);
+          if (subtype.equals("*")) {
+            return 2;
+          }
+          return subtype.equals(offer.substring(offerSlash + 1)) ? 3 : -1;
+        }
+
+      case ENCODING:
+        if (range.equals("*")) {
+          return 1;
+        }
+        return range.equals(offer) ? 2 : -1;
+
+      case LANGUAGE:
+        // Basic filtering (RFC 4647 3.3.1): "en" matches "en" and "en-us"
+        if (range.equals("*")) {
+          return 0;
+        }
+        if (!offer.startsWith(range)) {
+          return -1;
+        }
+        return range.length() == offer.length() || offer.charAt(range.length()) == '-'
+            ? range.length()
+            : -1;
+
+      default:
+        return -1;
+    }
+  }
+
+  // Parses a qvalue (RFC 9110 12.4.2) as thousandths; returns -1 if malformed
+  private static int parseQValue(String s) {
+    if (s.isEmpty() || (s.charAt(0) != '0' && s.charAt(0) != '1')) {
+      return -1;
+    }
+    int value = (s.charAt(0) - '0') * 1000;
+    if (s.length() == 1) {
+      return value;
+    }
+    if (s.charAt(1) != '.' || s.length() > 5) {
+      return -1;
+    }
+
+    int scale = 100;
+    for (int i = 2; i < s.length(); i++) {
+      char c = s.charAt(i);
+      if (c < '0' || c > '9') {
+        return -1;
+      }
+      value += (c - '0') * scale;
+      scale /= 10;
+    }
+    return value <= 1000 ? value : -1;
+  }
+}
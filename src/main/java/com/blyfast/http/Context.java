@@ -1,5 +1,6 @@
 package com.blyfast.http;
 
+import com.blyfast.nativeopt.MultipartParser;
 import com.fasterxml.jackson.databind.JsonNode;
 import io.undertow.server.HttpServerExchange;
 import java.io.IOException;
@@ -79,6 +80,25 @@ public class Context {
     return request.getPathParam(name);
   }
 
+  /**
+   * Gets the query parameters, with typed accessors and multi-value iteration.
+   *
+   * @return the query parameters
+   */
+  public QueryParams query() {
+    return request.getQuery();
+  }
+
+  /**
+   * Gets the address of the client, looking through the given trusted proxies.
+   *
+   * @param proxies the proxies whose forwarding headers are believed
+   * @return the client address, or null if the peer address is unknown
+   */
+  public ClientAddress clientAddress(TrustedProxies proxies) {
+    return request.getClientAddress(proxies);
+  }
+
   /**
    * Gets a query parameter by name.
    *
@@ -158,6 +178,16 @@ public class Context {
     return request.getHeader(name);
   }
 
+  /**
+   * Gets a cookie value by name.
+   *
+   * @param name the cookie name
+   * @return the cookie value or null if not present
+   */
+  public String cookie(String name) {
+    return request.getCookie(name);
+  }
+
   /**
    * Gets the request body as a string.
    *
@@ -178,6 +208,47 @@ public class Context {
     return request.getJsonBody();
   }
 
+  /**
+   * Gets the parsed Content-Type header.
+   *
+   * @return the media type, or null if the header is absent or malformed
+   */
+  public MediaType mediaType() {
+    return request.getMediaType();
+  }
+
+  /**
+   * Gets the request body as urlencoded form fields, with multi-value access.
+   *
+   * @return the form fields
+   * @throws IOException if an I/O error occurs
+   */
+  public FormData form() throws IOException {
+    return request.getFormData();
+  }
+
+  /**
+   * Gets the multipart/form-data fields and files, writing files larger than the threshold to
+   * temporary files instead of memory.
+   *
+   * @param spillThreshold the largest file size kept in memory, in bytes
+   * @return the form fields and files
+   * @throws IOException if an I/O error occurs or the body is malformed
+   */
+  public Request.MultipartData multipart(long spillThreshold) throws IOException {
+    return request.parseMultipartData(spillThreshold);
+  }
+
+  /**
+   * Streams a multipart/form-data body to a listener while it is read.
+   *
+   * @param listener receives the parts
+   * @throws IOException if an I/O error occurs or the body is malformed
+   */
+  public void streamMultipart(MultipartParser.Listener listener) throws IOException {
+    request.streamMultipart(listener);
+  }
+
   /**
    * Parses the request body into an object of the specified type.
    *
@@ -257,6 +328,17 @@ public class Context {
     return this;
   }
 
+  /**
+   * Sends a multipart response body.
+   *
+   * @param body the multipart body
+   * @return this context for method chaining
+   */
+  public Context multipart(MultipartResponse body) {
+    response.multipart(body);
+    return this;
+  }
+
   /**
    * Stores a value in the context locals for the current request/response cycle.
    *
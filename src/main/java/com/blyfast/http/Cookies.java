@@ -0,0 +1,255 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeBindings;
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.io.ByteArrayOutputStream;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Read-only view over a request's Cookie header.
+ *
+ * <p>The header is tokenized once into an offset index of name/value pairs. Lookups compare names
+ * against the header bytes directly, and only the value that is returned becomes a String, so a
+ * large session header costs nothing for the cookies a handler never reads. Values are read as
+ * UTF-8 and percent-decoded on read if they contain {@code %}.
+ */
+public final class Cookies {
+  private static final int ENTRY_INTS = 4;
+  private static final int INITIAL_CAPACITY = 16;
+  private static final Cookies EMPTY = new Cookies(new byte[0], new int[0], 0);
+
+  private final byte[] header;
+  private final int[] index;
+  private final int count;
+
+  private Cookies(byte[] header, int[] index, int count) {
+    this.header = header;
+    this.index = index;
+    this.count = count;
+  }
+
+  /**
+   * Tokenizes a Cookie header value.
+   *
+   * @param headerValue the header value, or null
+   * @return the cookies, empty if the header is absent
+   */
+  public static Cookies parse(String headerValue) {
+    if (headerValue == null || headerValue.isEmpty()) {
+      return EMPTY;
+    }
+
+    // Undertow decodes header bytes as ISO-8859-1, so this recovers the original bytes
+    byte[] bytes = headerValue.getBytes(StandardCharsets.ISO_8859_1);
+    int[] index = new int[INITIAL_CAPACITY * ENTRY_INTS];
+    int count;
+
+    if (NativeOptimizer.isNativeOptimizationAvailable()) {
+      count = NativeBindings.get().parseCookies(bytes, bytes.length, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = NativeBindings.get().parseCookies(bytes, bytes.length, index);
+      }
+    } else {
+      count = tokenize(bytes, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = tokenize(bytes, index);
+      }
+    }
+
+    return new Cookies(bytes, index, count);
+  }
+
+  /**
+   * Gets the number of cookies.
+   *
+   * @return the cookie count
+   */
+  public int size() {
+    return count;
+  }
+
+  /**
+   * Gets the name of the cookie at the given position.
+   *
+   * @param i the position in header order
+   * @return the cookie name
+   */
+  public String name(int i) {
+    int entry = entryOffset(i);
+    return new String(header, index[entry], index[entry + 1], StandardCharsets.ISO_8859_1);
+  }
+
+  /**
+   * Gets the decoded value of the cookie at the given position.
+   *
+   * @param i the position in header order
+   * @return the cookie value
+   */
+  public String value(int i) {
+    int entry = entryOffset(i);
+    return decode(index[entry + 2], index[entry + 3]);
+  }
+
+  /**
+   * Gets the decoded value of the first cookie with the given name. Names are case-sensitive.
+   *
+   * @param name the cookie name
+   * @return the cookie value or null if not present
+   */
+  public String get(String name) {
+    int i = indexOf(name);
+    return i >= 0 ? value(i) : null;
+  }
+
+  /**
+   * Gets the value of a cookie exactly as sent, without percent-decoding.
+   *
+   * @param name the cookie name
+   * @return the raw cookie value or null if not present
+   */
+  public String getRaw(String name) {
+    int i = indexOf(name);
+    if (i < 0) {
+      return null;
+    }
+    int entry = i * ENTRY_INTS;
+    return new String(header, index[entry + 2], index[entry + 3], StandardCharsets.ISO_8859_1);
+  }
+
+  /**
+   * Checks whether a cookie is present.
+   *
+   * @param name the cookie name
+   * @return true if the cookie is present
+   */
+  public boolean contains(String name) {
+    return indexOf(name) >= 0;
+  }
+
+  private int indexOf(String name) {
+    int nameLength = name.length();
+    for (int i = 0; i < count; i++) {
+      int entry = i * ENTRY_INTS;
+      if (index[entry + 1] == nameLength && nameEquals(index[entry], name)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  private boolean nameEquals(int offset, String name) {
+    for (int i = 0; i < name.length(); i++) {
+      if ((header[offset + i] & 0xFF) != name.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private int entryOffset(int i) {
+    if (i < 0 || i >= count) {
+      throw new IndexOutOfBoundsException("Cookie index " + i + " out of range " + count);
+    }
+    return i * ENTRY_INTS;
+  }
+
+  private String decode(int offset, int length) {
+    int percent = -1;
+    for (int i = offset; i < offset + length; i++) {
+      if (header[i] == '%') {
+        percent = i;
+        break;
+      }
+    }
+    // Raw and escaped bytes are both read as UTF-8, so an escape does not change what the rest of
+    // the value means
+    if (percent < 0) {
+      return new String(header, offset, length, StandardCharsets.UTF_8);
+    }
+
+    // Cookie values do not use '+' for spaces, so only %XX escapes are decoded
+    ByteArrayOutputStream out = new ByteArrayOutputStream(length);
+    out.write(header, offset, percent - offset);
+    for (int i = percent; i < offset + length; i++) {
+      int c = header[i] & 0xFF;
+      if (c == '%' && i + 2 < offset + length) {
+        int hi = Character.digit(header[i + 1], 16);
+        int lo = Character.digit(header[i + 2], 16);
+        if (hi >= 0 && lo >= 0) {
+          out.write((hi << 4) | lo);
+          i += 2;
+          continue;
+        }
+      }
+      out.write(c);
+    }
+    return new String(out.toByteArray(), StandardCharsets.UTF_8);
+  }
+
+  /** Java fallback for the native tokenizer, with the same index layout and trimming rules. */
+  private static int tokenize(byte[] header, int[] index) {
+    int maxCookies = index.length / ENTRY_INTS;
+    int count = 0;
+    int pos = 0;
+
+    while (pos < header.length) {
+      int segmentEnd = pos;
+      while (segmentEnd < header.length && header[segmentEnd] != ';') {
+        segmentEnd++;
+      }
+
+      int start = pos;
+      int end = segmentEnd;
+      while (start < end && isSpace(header[start])) {
+        start++;
+      }
+      while (end > start && isSpace(header[end - 1])) {
+        end--;
+      }
+
+      int equals = start;
+      while (equals < end && header[equals] != '=') {
+        equals++;
+      }
+      if (equals < end) {
+        int nameEnd = equals;
+        int valueStart = equals + 1;
+        while (nameEnd > start && isSpace(header[nameEnd - 1])) {
+          nameEnd--;
+        }
+        while (valueStart < end && isSpace(header[valueStart])) {
+          valueStart++;
+        }
+
+        int valueEnd = end;
+        if (valueEnd - valueStart >= 2
+            && header[valueStart] == '"'
+            && header[valueEnd - 1] == '"') {
+          valueStart++;
+          valueEnd--;
+        }
+
+        if (nameEnd > start) {
+          if (count < maxCookies) {
+            int entry = count * ENTRY_INTS;
+            index[entry] = start;
+            index[entry + 1] = nameEnd - start;
+            index[entry + 2] = valueStart;
+            index[entry + 3] = valueEnd - valueStart;
+          }
+          count++;
+        }
+      }
+
+      pos = segmentEnd + 1;
+    }
+
+    return count <= maxCookies ? count : -count;
+  }
+
+  private static boolean isSpace(byte b) {
+    return b == ' ' || b == '\t';
+  }
+}
@@ -0,0 +1,277 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.function.BiConsumer;
+
+/**
+ * Read-only view over an {@code application/x-www-form-urlencoded} request body.
+ *
+ * <p>The body is tokenized in place into an offset index with the layout of {@link QueryParams}, so
+ * no field is copied until it is read. Names and values become Strings on first access and are
+ * kept for later reads; only those that contain escapes are percent-decoded, straight from the
+ * body buffer. Repeated fields ({@code tag=a&tag=b}) are all kept, in body order.
+ */
+public final class FormData {
+  private static final int ENTRY_INTS = 5;
+  private static final int NAME_ENCODED = 1;
+  private static final int VALUE_ENCODED = 2;
+  private static final int INITIAL_CAPACITY = 8;
+  private static final FormData EMPTY = new FormData(ByteBuffer.allocate(0), new int[0], 0);
+
+  private final ByteBuffer body;
+  private final int[] index;
+  private final int count;
+  private final String[] strings;
+
+  private FormData(ByteBuffer body, int[] index, int count) {
+    this.body = body;
+    this.index = index;
+    this.count = count;
+    this.strings = new String[count * 2];
+  }
+
+  /**
+   * Tokenizes a urlencoded body. The view reads from the buffer, which must not be modified while
+   * the view is in use; its position and limit are ignored.
+   *
+   * @param body the body, starting at index 0
+   * @param length the number of body bytes
+   * @return the form fields, empty if the body is empty
+   */
+  public static FormData parse(ByteBuffer body, int length) {
+    if (body == null || length <= 0) {
+      return EMPTY;
+    }
+    if (length > body.capacity()) {
+      throw new IndexOutOfBoundsException("Form body length " + length + " exceeds the buffer");
+    }
+
+    int[] index = new int[INITIAL_CAPACITY * ENTRY_INTS];
+    int count;
+
+    if (body.isDirect() && NativeOptimizer.isNativeOptimizationAvailable()) {
+      count = NativeOptimizer.nativeParseFormIndex(body, length, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = NativeOptimizer.nativeParseFormIndex(body, length, index);
+      }
+    } else {
+      count = tokenize(body, length, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = tokenize(body, length, index);
+      }
+    }
+
+    return new FormData(body, index, count);
+  }
+
+  /**
+   * Gets the number of fields, counting repeated names once per occurrence.
+   *
+   * @return the field count
+   */
+  public int size() {
+    return count;
+  }
+
+  /**
+   * Gets the decoded name of the field at the given position.
+   *
+   * @param i the position in body order
+   * @return the field name
+   */
+  public String name(int i) {
+    int entry = entryOffset(i);
+    String name = strings[i * 2];
+    if (name == null) {
+      name = decode(index[entry], index[entry + 1], (index[entry + 4] & NAME_ENCODED) != 0);
+      strings[i * 2] = name;
+    }
+    return name;
+  }
+
+  /**
+   * Gets the decoded value of the field at the given position.
+   *
+   * @param i the position in body order
+   * @return the field value, empty if the field has no '='
+   */
+  public String value(int i) {
+    int entry = entryOffset(i);
+    String value = strings[i * 2 + 1];
+    if (value == null) {
+      value = decode(index[entry + 2], index[entry + 3], (index[entry + 4] & VALUE_ENCODED) != 0);
+      strings[i * 2 + 1] = value;
+    }
+    return value;
+  }
+
+  /**
+   * Gets the value of the first field with the given name.
+   *
+   * @param name the field name
+   * @return the field value or null if not present
+   */
+  public String get(String name) {
+    int i = indexOf(name, 0);
+    return i >= 0 ? value(i) : null;
+  }
+
+  /**
+   * Gets every value of a field, in body order.
+   *
+   * @param name the field name
+   * @return the values, empty if the field is not present
+   */
+  public List<String> getAll(String name) {
+    int i = indexOf(name, 0);
+    if (i < 0) {
+      return Collections.emptyList();
+    }
+    List<String> values = new ArrayList<>(2);
+    for (; i >= 0; i = indexOf(name, i + 1)) {
+      values.add(value(i));
+    }
+    return values;
+  }
+
+  /**
+   * Checks whether a field is present.
+   *
+   * @param name the field name
+   * @return true if the field is present
+   */
+  public boolean contains(String name) {
+    return indexOf(name, 0) >= 0;
+  }
+
+  /**
+   * Calls the action for every field in body order, including repeated names.
+   *
+   * @param action receives each decoded name and value
+   */
+  public void forEach(BiConsumer<String, String> action) {
+    for (int i = 0; i < count; i++) {
+      action.accept(name(i), value(i));
+    }
+  }
+
+  private int indexOf(String name, int from) {
+    int nameLength = name.length();
+    boolean ascii = isAscii(name);
+    for (int i = from; i < count; i++) {
+      int entry = i * ENTRY_INTS;
+      if (!ascii || strings[i * 2] != null || (index[entry + 4] & NAME_ENCODED) != 0) {
+        if (name(i).equals(name)) {
+          return i;
+        }
+      } else if (index[entry + 1] == nameLength && nameEquals(index[entry], name)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Compares raw name bytes with an ASCII name without materializing the field name
+  private boolean nameEquals(int offset, String name) {
+    for (int i = 0; i < name.length(); i++) {
+      if (body.get(offset + i) != name.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private static boolean isAscii(String s) {
+    for (int i = 0; i < s.length(); i++) {
+      if (s.charAt(i) >= 0x80) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private int entryOffset(int i) {
+    if (i < 0 || i >= count) {
+      throw new IndexOutOfBoundsException("Form field index " + i + " out of range " + count);
+    }
+    return i * ENTRY_INTS;
+  }
+
+  private String decode(int offset, int length, boolean encoded) {
+    if (length == 0) {
+      return "";
+    }
+    byte[] scratch = PercentDecoder.scratch(length);
+    if (encoded) {
+      int decodedLength;
+      if (body.isDirect() && NativeOptimizer.isNativeOptimizationAvailable()) {
+        decodedLength =
+            NativeOptimizer.nativePercentDecodeDirect(body, offset, length, scratch, true);
+      } else {
+        byte[] raw = new byte[length];
+        body.get(offset, raw, 0, length);
+        decodedLength = PercentDecoder.decode(raw, 0, length, true, scratch);
+      }
+      if (decodedLength >= 0) {
+        return new String(scratch, 0, decodedLength, StandardCharsets.UTF_8);
+      }
+    }
+    body.get(offset, scratch, 0, length);
+    return new String(scratch, 0, length, StandardCharsets.UTF_8);
+  }
+
+  /** Java fallback for the native tokenizer, with the same index layout. */
+  private static int tokenize(ByteBuffer body, int length, int[] index) {
+    int maxFields = index.length / ENTRY_INTS;
+    int count = 0;
+    int pos = 0;
+
+    while (pos < length) {
+      int segmentEnd = pos;
+      while (segmentEnd < length && body.get(segmentEnd) != '&') {
+        segmentEnd++;
+      }
+
+      int nameEnd = pos;
+      while (nameEnd < segmentEnd && body.get(nameEnd) != '=') {
+        nameEnd++;
+      }
+      int valueStart = nameEnd < segmentEnd ? nameEnd + 1 : segmentEnd;
+
+      if (nameEnd > pos) {
+        if (count < maxFields) {
+          int entry = count * ENTRY_INTS;
+          index[entry] = pos;
+          index[entry + 1] = nameEnd - pos;
+          index[entry + 2] = valueStart;
+          index[entry + 3] = segmentEnd - valueStart;
+          index[entry + 4] =
+              (isEncoded(body, pos, nameEnd) ? NAME_ENCODED : 0)
+                  | (isEncoded(body, valueStart, segmentEnd) ? VALUE_ENCODED : 0);
+        }
+        count++;
+      }
+
+      pos = segmentEnd + 1;
+    }
+
+    return count <= maxFields ? count : -count;
+  }
+
+  private static boolean isEncoded(ByteBuffer body, int start, int end) {
+    for (int i = start; i < end; i++) {
+      byte b = body.get(i);
+      if (b == '%' || b == '+') {
+        return true;
+      }
+    }
+    return false;
+  }
+}
@@ -0,0 +1,229 @@
+package com.blyfast.http;
+
+import java.util.Locale;
+
+/**
+ * A parsed media type such as a Content-Type value: {@code type/subtype} followed by parameters,
+ * whose values may be tokens or quoted strings (RFC 9110 8.3.1).
+ *
+ * <p>Type, subtype and parameter names are case-insensitive and kept in lower case; parameter
+ * values are kept as sent, with quoted-pairs resolved. The multipart {@code boundary} and the
+ * {@code charset} have their own accessors.
+ */
+public final class MediaType {
+  private static final String[] NO_PARAMETERS = new String[0];
+
+  private final String type;
+  private final String subtype;
+  private final String[] parameters; // Alternating names and values, in header order
+
+  private MediaType(String type, String subtype, String[] parameters) {
+    this.type = type;
+    this.subtype = subtype;
+    this.parameters = parameters;
+  }
+
+  /**
+   * Parses a media type.
+   *
+   * @param value the header value
+   * @return the media type, or null if the value is null or not a media type
+   */
+  public static MediaType parse(String value) {
+    if (value == null) {
+      return null;
+    }
+    int length = value.length();
+    int pos = skipWhitespace(value, 0);
+    int typeEnd = scanToken(value, pos);
+    if (typeEnd == pos || typeEnd >= length || value.charAt(typeEnd) != '/') {
+      return null;
+    }
+    String type = value.substring(pos, typeEnd).toLowerCase(Locale.ROOT);
+    pos = typeEnd + 1;
+    int subtypeEnd = scanToken(value, pos);
+    if (subtypeEnd == pos) {
+      return null;
+    }
+    String subtype = value.substring(pos, subtypeEnd).toLowerCase(Locale.ROOT);
+    pos = subtypeEnd;
+
+    String[] parameters = NO_PARAMETERS;
+    int count = 0;
+    while (true) {
+      pos = skipWhitespace(value, pos);
+      if (pos == length) {
+        break;
+      }
+      if (value.charAt(pos) != ';') {
+        return null;
+      }
+      pos = skipWhitespace(value, pos + 1);
+      if (pos == length || value.charAt(pos) == ';') {
+        continue; // Empty parameter
+      }
+
+      int nameEnd = scanToken(value, pos);
+      if (nameEnd == pos || nameEnd >= length || value.charAt(nameEnd) != '=') {
+        return null;
+      }
+      String name = value.substring(pos, nameEnd).toLowerCase(Locale.ROOT);
+      pos = nameEnd + 1;
+
+      String parameterValue;
+      if (pos < length && value.charAt(pos) == '"') {
+        StringBuilder quoted = null;
+        int start = ++pos;
+        while (pos < length && value.charAt(pos) != '"') {
+          if (value.charAt(pos) == '\\') {
+            if (quoted == null) {
+              quoted = new StringBuilder(value.length()).append(value, start, pos);
+            }
+            if (++pos == length) {
+              return null;
+            }
+          }
+          if (quoted != null) {
+            quoted.append(value.charAt(pos));
+          }
+          pos++;
+        }
+        if (pos == length) {
+          return null; // Unterminated quoted string
+        }
+        parameterValue = quoted != null ? quoted.toString() : value.substring(start, pos);
+        pos++;
+      } else {
+        int valueEnd = scanToken(value, pos);
+        if (valueEnd == pos) {
+          return null;
+        }
+        parameterValue = value.substring(pos, valueEnd);
+        pos = valueEnd;
+      }
+
+      if (count * 2 == parameters.length) {
+        String[] grown = new String[Math.max(4, parameters.length * 2)];
+        System.arraycopy(parameters, 0, grown, 0, parameters.length);
+        parameters = grown;
+      }
+      parameters[count * 2] = name;
+      parameters[count * 2 + 1] = parameterValue;
+      count++;
+    }
+
+    if (count * 2 < parameters.length) {
+      String[] trimmed = new String[count * 2];
+      System.arraycopy(parameters, 0, trimmed, 0, trimmed.length);
+      parameters = trimmed;
+    }
+    return new MediaType(type, subtype, parameters);
+  }
+
+  /**
+   * Gets the top-level type, such as {@code multipart}.
+   *
+   * @return the type, in lower case
+   */
+  public String getType() {
+    return type;
+  }
+
+  /**
+   * Gets the subtype, such as {@code form-data}.
+   *
+   * @return the subtype, in lower case
+   */
+  public String getSubtype() {
+    return subtype;
+  }
+
+  /**
+   * Checks the type and subtype, ignoring case.
+   *
+   * @param type the type
+   * @param subtype the subtype, or {@code *} for any
+   * @return true if this media type matches
+   */
+  public boolean is(String type, String subtype) {
+    return this.type.equalsIgnoreCase(type)
+        && (subtype.equals("*") || this.subtype.equalsIgnoreCase(subtype));
+  }
+
+  /**
+   * Gets a parameter value. If the parameter is repeated, the first value is returned.
+   *
+   * @param name the parameter name, in any case
+   * @return the value, or null if the parameter is absent
+   */
+  public String getParameter(String name) {
+    for (int i = 0; i < parameters.length; i += 2) {
+      if (parameters[i].equalsIgnoreCase(name)) {
+        return parameters[i + 1];
+      }
+    }
+    return null;
+  }
+
+  /**
+   * Gets the {@code boundary} parameter of a multipart media type.
+   *
+   * @return the boundary, or null if absent
+   */
+  public String getBoundary() {
+    return getParameter("boundary");
+  }
+
+  /**
+   * Gets the {@code charset} parameter.
+   *
+   * @return the charset name, or null if absent
+   */
+  public String getCharset() {
+    return getParameter("charset");
+  }
+
+  @Override
+  public String toString() {
+    StringBuilder text = new StringBuilder(type).append('/').append(subtype);
+    for (int i = 0; i < parameters.length; i += 2) {
+      text.append("; ").append(parameters[i]).append('=');
+      String value = parameters[i + 1];
+      if (!value.isEmpty() && scanToken(value, 0) == value.length()) {
+        text.append(value);
+      } else {
+        text.append('"');
+        for (int j = 0; j < value.length(); j++) {
+          char c = value.charAt(j);
+          if (c == '"' || c == '\\') {
+            text.append('\\');
+          }
+          text.append(c);
+        }
+        text.append('"');
+      }
+    }
+    return text.toString();
+  }
+
+  private static int skipWhitespace(String s, int pos) {
+    while (pos < s.length() && (s.charAt(pos) == ' ' || s.charAt(pos) == '\t')) {
+      pos++;
+    }
+    return pos;
+  }
+
+  private static int scanToken(String s, int pos) {
+    while (pos < s.length() && isTokenChar(s.charAt(pos))) {
+      pos++;
+    }
+    return pos;
+  }
+
+  private static boolean isTokenChar(char c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+      return true;
+    }
+    return "!#$%&'*+-.^_`|~".indexOf(c) >= 0;
+  }
+}
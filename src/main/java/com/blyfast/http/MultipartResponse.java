@@ -0,0 +1,374 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ThreadLocalRandom;
+
+/**
+ * A multipart response body (RFC 2046 5.1), such as {@code multipart/mixed} for batch APIs or
+ * {@code multipart/byteranges} for range requests, sent with {@link Response#multipart}.
+ *
+ * <p>Part bodies are never copied. Only the framing (delimiter lines and part headers) is
+ * serialized, with one native call; the body is sent as a gathering write of the framing slices
+ * interleaved with the part buffers. File regions are memory-mapped rather than read.
+ */
+public final class MultipartResponse {
+  private static final int BOUNDARY_LENGTH = 32;
+  private static final String BOUNDARY_CHARS =
+      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+  // Longest boundary allowed by RFC 2046 5.1.1
+  private static final int MAX_BOUNDARY_LENGTH = 70;
+
+  private final String subtype;
+  private final String boundary;
+  private final List<String[]> partHeaders = new ArrayList<>();
+  private final List<ByteBuffer[]> partBodies = new ArrayList<>();
+  private int headerCount;
+
+  // Serialized framing, one buffer per frame; rebuilt after a part is added
+  private ByteBuffer[] frames;
+
+  private MultipartResponse(String subtype, String boundary) {
+    if (!isValidBoundary(boundary)) {
+      throw new IllegalArgumentException("Invalid multipart boundary: " + boundary);
+    }
+    this.subtype = subtype;
+    this.boundary = boundary;
+  }
+
+  /**
+   * Creates a {@code multipart/mixed} body with a random boundary.
+   *
+   * @return the body, without parts
+   */
+  public static MultipartResponse mixed() {
+    return new MultipartResponse("mixed", randomBoundary());
+  }
+
+  /**
+   * Creates a {@code multipart/byteranges} body with a random boundary, for a 206 response.
+   *
+   * @return the body, without parts
+   */
+  public static MultipartResponse byteRanges() {
+    return new MultipartResponse("byteranges", randomBoundary());
+  }
+
+  /**
+   * Creates a multipart body.
+   *
+   * @param subtype the multipart subtype, such as {@code related}
+   * @param boundary the boundary, 1 to 70 characters allowed by RFC 2046
+   * @return the body, without parts
+   * @throws IllegalArgumentException if the boundary is invalid
+   */
+  public static MultipartResponse of(String subtype, String boundary) {
+    return new MultipartResponse(subtype, boundary);
+  }
+
+  /**
+   * Adds a part whose body is the remaining content of a buffer. The buffer is sent as it is when
+   * the response is written, so it must not be modified until then.
+   *
+   * @param body the part body
+   * @param namesAndValues the part headers as alternating names and values
+   * @return this body for method chaining
+   */
+  public MultipartResponse part(ByteBuffer body, String... namesAndValues) {
+    return addPart(namesAndValues, body.duplicate());
+  }
+
+  /**
+   * Adds a part.
+   *
+   * @param body the part body
+   * @param namesAndValues the part headers as alternating names and values
+   * @return this body for method chaining
+   */
+  public MultipartResponse part(byte[] body, String... namesAndValues) {
+    return addPart(namesAndValues, ByteBuffer.wrap(body));
+  }
+
+  /**
+   * Adds a part whose body is a region of a file, which is mapped rather than read.
+   *
+   * @param file the file
+   * @param position the offset of the region
+   * @param length the length of the region
+   * @param namesAndValues the part headers as alternating names and values
+   * @return this body for method chaining
+   * @throws IOException if the region cannot be mapped
+   */
+  public MultipartResponse part(
+      FileChannel file, long position, long length, String... namesAndValues)
+      throws IOException {
+    return addPart(namesAndValues, map(file, position, length));
+  }
+
+  /**
+   * Adds a byte range of a file with its {@code Content-Type} and {@code Content-Range} headers.
+   *
+   * @param contentType the content type of the file
+   * @param file the file
+   * @param first the first byte of the range
+   * @param last the last byte of the range, inclusive
+   * @return this body for method chaining
+   * @throws IOException if the range cannot be mapped
+   * @throws IllegalArgumentException if the range is not within the file
+   */
+  public MultipartResponse range(String contentType, FileChannel file, long first, long last)
+      throws IOException {
+    long size = file.size();
+    if (first < 0 || last < first || last >= size) {
+      throw new IllegalArgumentException("Invalid byte range " + first + "-" + last);
+    }
+    return addPart(
+        rangeHeaders(contentType, first, last, size), map(file, first, last - first + 1));
+  }
+
+  /**
+   * Adds a byte range of content held in a buffer, with its {@code Content-Type} and {@code
+   * Content-Range} headers.
+   *
+   * @param contentType the content type of the content
+   * @param content the complete content, from position 0 to its limit
+   * @param first the first byte of the range
+   * @param last the last byte of the range, inclusive
+   * @return this body for method chaining
+   * @throws IllegalArgumentException if the range is not within the content
+   */
+  public MultipartResponse range(String contentType, ByteBuffer content, int first, int last) {
+    if (first < 0 || last < first || last >= content.limit()) {
+      throw new IllegalArgumentException("Invalid byte range " + first + "-" + last);
+    }
+    return addPart(
+        rangeHeaders(contentType, first, last, content.limit()),
+        content.slice(first, last - first + 1));
+  }
+
+  /**
+   * Gets the Content-Type of the body, including its boundary.
+   *
+   * @return the content type
+   */
+  public String getContentType() {
+    // Boundary characters that are not token characters need a quoted-string
+    for (int i = 0; i < boundary.length(); i++) {
+      if ("(),/:=? ".indexOf(boundary.charAt(i)) >= 0) {
+        return "multipart/" + subtype + "; boundary=\"" + boundary + "\"";
+      }
+    }
+    return "multipart/" + subtype + "; boundary=" + boundary;
+  }
+
+  /**
+   * Gets the boundary.
+   *
+   * @return the boundary
+   */
+  public String getBoundary() {
+    return boundary;
+  }
+
+  /**
+   * Gets the number of parts.
+   *
+   * @return the part count
+   */
+  public int getPartCount() {
+    return partBodies.size();
+  }
+
+  /**
+   * Gets the length of the complete body.
+   *
+   * @return the length in bytes
+   * @throws IllegalStateException if there are no parts
+   * @throws IllegalArgumentException if a part header contains CR or LF
+   */
+  public long getContentLength() {
+    long length = 0;
+    for (ByteBuffer frame : frames()) {
+      length += frame.remaining();
+    }
+    for (ByteBuffer[] body : partBodies) {
+      for (ByteBuffer buffer : body) {
+        length += buffer.remaining();
+      }
+    }
+    return length;
+  }
+
+  /**
+   * Gets the body as a list of buffers for a gathering write: each part's framing followed by its
+   * body, then the close delimiter. The buffers are fresh views, so the list can be written once
+   * per call.
+   *
+   * @return the buffers, in order
+   * @throws IllegalStateException if there are no parts
+   * @throws IllegalArgumentException if a part header contains CR or LF
+   */
+  public ByteBuffer[] toBuffers() {
+    ByteBuffer[] framing = frames();
+    List<ByteBuffer> buffers = new ArrayList<>(partBodies.size() * 2 + 1);
+    for (int i = 0; i < partBodies.size(); i++) {
+      buffers.add(framing[i].duplicate());
+      for (ByteBuffer buffer : partBodies.get(i)) {
+        buffers.add(buffer.duplicate());
+      }
+    }
+    buffers.add(framing[framing.length - 1].duplicate());
+    return buffers.toArray(new ByteBuffer[0]);
+  }
+
+  private MultipartResponse addPart(String[] namesAndValues, ByteBuffer... body) {
+    if (namesAndValues.length % 2 != 0) {
+      throw new IllegalArgumentException("Expected alternating header names and values");
+    }
+    partHeaders.add(namesAndValues);
+    partBodies.add(body);
+    headerCount += namesAndValues.length;
+    frames = null;
+    return this;
+  }
+
+  private ByteBuffer[] frames() {
+    if (partBodies.isEmpty()) {
+      throw new IllegalStateException("A multipart body needs at least one part");
+    }
+    if (frames == null) {
+      frames = NativeOptimizer.isNativeOptimizationAvailable() ? nativeFrames() : javaFrames();
+    }
+    return frames;
+  }
+
+  private ByteBuffer[] nativeFrames() {
+    int partCount = partHeaders.size();
+    int[] headerLengths = new int[headerCount];
+    int[] headerCounts = new int[partCount];
+    int[] frameEnds = new int[partCount + 1];
+
+    // Header text is encoded here rather than read as modified UTF-8 in native code, so both
+    // paths produce the same bytes
+    ByteArrayOutputStream headerText = new ByteArrayOutputStream(headerCount * 16);
+    int next = 0;
+    for (int i = 0; i < partCount; i++) {
+      String[] namesAndValues = partHeaders.get(i);
+      for (String text : namesAndValues) {
+        byte[] bytes = text.getBytes(StandardCharsets.UTF_8);
+        headerText.write(bytes, 0, bytes.length);
+        headerLengths[next++] = bytes.length;
+      }
+      headerCounts[i] = namesAndValues.length / 2;
+    }
+    byte[] headers = headerText.toByteArray();
+    int estimate = (partCount + 1) * (boundary.length() + 8) + headers.length + headerCount * 2;
+
+    // The framing stays referenced by the frame slices until the response has been written
+    ByteBuffer framing = ByteBuffer.allocateDirect(estimate);
+    int written =
+        NativeOptimizer.nativeWriteMultipartFraming(
+            framing, boundary, headers, headerLengths, headerCounts, frameEnds);
+    if (written < 0) {
+      framing = ByteBuffer.allocateDirect(-written);
+      written =
+          NativeOptimizer.nativeWriteMultipartFraming(
+              framing, boundary, headers, headerLengths, headerCounts, frameEnds);
+    }
+    if (written <= 0) {
+      throw new IllegalArgumentException("Invalid multipart part headers");
+    }
+
+    ByteBuffer[] result = new ByteBuffer[partCount + 1];
+    int start = 0;
+    for (int i = 0; i <= partCount; i++) {
+      result[i] = framing.slice(start, frameEnds[i] - start).asReadOnlyBuffer();
+      start = frameEnds[i];
+    }
+    return result;
+  }
+
+  private ByteBuffer[] javaFrames() {
+    int partCount = partHeaders.size();
+    ByteBuffer[] result = new ByteBuffer[partCount + 1];
+    StringBuilder frame = new StringBuilder(256);
+    for (int i = 0; i < partCount; i++) {
+      frame.setLength(0);
+      if (i > 0) {
+        frame.append("\r\n");
+      }
+      frame.append("--").append(boundary).append("\r\n");
+      String[] namesAndValues = partHeaders.get(i);
+      for (int h = 0; h < namesAndValues.length; h += 2) {
+        String name = namesAndValues[h];
+        String value = namesAndValues[h + 1];
+        if (name.isEmpty() || hasLineBreak(name) || hasLineBreak(value)) {
+          throw new IllegalArgumentException("Invalid multipart part header: " + name);
+        }
+        frame.append(name).append(": ").append(value).append("\r\n");
+      }
+      frame.append("\r\n");
+      result[i] = ByteBuffer.wrap(frame.toString().getBytes(StandardCharsets.UTF_8));
+    }
+    result[partCount] =
+        ByteBuffer.wrap(("\r\n--" + boundary + "--\r\n").getBytes(StandardCharsets.US_ASCII));
+    return result;
+  }
+
+  private static String[] rangeHeaders(String contentType, long first, long last, long size) {
+    String contentRange = "bytes " + first + "-" + last + "/" + size;
+    if (contentType == null) {
+      return new String[] {"Content-Range", contentRange};
+    }
+    return new String[] {"Content-Type", contentType, "Content-Range", contentRange};
+  }
+
+  // A mapping is limited to 2 GB, so longer regions take several buffers
+  private static ByteBuffer[] map(FileChannel file, long position, long length)
+      throws IOException {
+    int count = (int) Math.max(1, (length + Integer.MAX_VALUE - 1) / Integer.MAX_VALUE);
+    ByteBuffer[] buffers = new ByteBuffer[count];
+    for (int i = 0; i < count; i++) {
+      long size = Math.min(length, Integer.MAX_VALUE);
+      buffers[i] = file.map(FileChannel.MapMode.READ_ONLY, position, size);
+      position += size;
+      length -= size;
+    }
+    return buffers;
+  }
+
+  private static String randomBoundary() {
+    ThreadLocalRandom random = ThreadLocalRandom.current();
+    char[] chars = new char[BOUNDARY_LENGTH];
+    for (int i = 0; i < chars.length; i++) {
+      chars[i] = BOUNDARY_CHARS.charAt(random.nextInt(BOUNDARY_CHARS.length()));
+    }
+    return new String(chars);
+  }
+
+  // bchars (RFC 2046 5.1.1); a boundary must not end with a space
+  private static boolean isValidBoundary(String boundary) {
+    int length = boundary.length();
+    if (length == 0 || length > MAX_BOUNDARY_LENGTH || boundary.charAt(length - 1) == ' ') {
+      return false;
+    }
+    for (int i = 0; i < length; i++) {
+      char c = boundary.charAt(i);
+      if (BOUNDARY_CHARS.indexOf(c) < 0 && "'()+_,-./:=? ".indexOf(c) < 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private static boolean hasLineBreak(String s) {
+    return s.indexOf('\r') >= 0 || s.indexOf('\n') >= 0;
+  }
+}
@@ -0,0 +1,150 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeBindings;
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Percent-decoding (RFC 3986) for paths, query strings and form bodies.
+ *
+ * <p>Input without anything to decode is reported as unchanged rather than copied, so callers can
+ * keep using the original bytes or String. Longer inputs are decoded natively, where the escapes
+ * are found a vector at a time and the clean runs between them are bulk-copied; short ones, where
+ * the JNI call would cost more than the work, are decoded in Java with the same rules.
+ */
+public final class PercentDecoder {
+  /** Returned by {@link #decode(byte[], int, int, boolean, byte[])} for input with no escapes. */
+  public static final int UNCHANGED = -1;
+
+  // Below this length the JNI transition costs more than decoding in Java
+  private static final int NATIVE_THRESHOLD = 64;
+
+  private static final boolean nativeAvailable = NativeOptimizer.isNativeOptimizationAvailable();
+  private static final ThreadLocal<byte[]> SCRATCH = ThreadLocal.withInitial(() -> new byte[256]);
+
+  private PercentDecoder() {}
+
+  /**
+   * Decodes %XX escapes and, optionally, '+' as a space. Malformed escapes are kept as they are.
+   *
+   * @param src the encoded bytes
+   * @param offset the offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @param plusAsSpace whether '+' means a space, as in query strings and form bodies
+   * @param dest receives the decoded bytes; must hold at least {@code length} bytes
+   * @return the decoded length, or {@link #UNCHANGED} if there was nothing to decode and {@code
+   *     dest} was not written
+   */
+  public static int decode(byte[] src, int offset, int length, boolean plusAsSpace, byte[] dest) {
+    if (offset < 0 || length < 0 || offset > src.length - length || dest.length < length) {
+      throw new IndexOutOfBoundsException("Invalid range for percent-decoding");
+    }
+    if (nativeAvailable && length >= NATIVE_THRESHOLD) {
+      return NativeBindings.get().percentDecode(src, offset, length, dest, plusAsSpace);
+    }
+    return javaDecode(src, offset, length, plusAsSpace, dest);
+  }
+
+  /**
+   * Decodes a percent-encoded component, reading the result as UTF-8.
+   *
+   * @param s the encoded text
+   * @param plusAsSpace whether '+' means a space, as in query strings and form bodies
+   * @return the decoded text, or {@code s} itself if it contains nothing to decode
+   */
+  public static String decode(String s, boolean plusAsSpace) {
+    // String.indexOf is vectorized by the JVM, so clean input is rejected without a copy
+    if (s.indexOf('%') < 0 && (!plusAsSpace || s.indexOf('+') < 0)) {
+      return s;
+    }
+    byte[] bytes = s.getBytes(StandardCharsets.UTF_8);
+    byte[] dest = scratch(bytes.length);
+    int length = decode(bytes, 0, bytes.length, plusAsSpace, dest);
+    return length == UNCHANGED ? s : new String(dest, 0, length, StandardCharsets.UTF_8);
+  }
+
+  /**
+   * Decodes a path or path segment; '+' is left as is.
+   *
+   * @param path the encoded path
+   * @return the decoded path, or {@code path} itself if it contains nothing to decode
+   */
+  public static String decodePath(String path) {
+    return decode(path, false);
+  }
+
+  /**
+   * Decodes a query or form component; '+' becomes a space.
+   *
+   * @param component the encoded name or value
+   * @return the decoded text, or {@code component} itself if it contains nothing to decode
+   */
+  public static String decodeQuery(String component) {
+    return decode(component, true);
+  }
+
+  /**
+   * Gets a per-thread scratch buffer of at least the given size, for decoding into before the
+   * result is turned into a String.
+   *
+   * @param size the required size
+   * @return the buffer
+   */
+  static byte[] scratch(int size) {
+    byte[] buffer = SCRATCH.get();
+    if (buffer.length < size) {
+      buffer = new byte[Math.max(size, buffer.length * 2)];
+      SCRATCH.set(buffer);
+    }
+    return buffer;
+  }
+
+  /** Java version of percentDecode in percent_decode.c. */
+  private static int javaDecode(
+      byte[] src, int offset, int length, boolean plusAsSpace, byte[] dest) {
+    int end = offset + length;
+    int pos = offset;
+    while (pos < end && src[pos] != '%' && (!plusAsSpace || src[pos] != '+')) {
+      pos++;
+    }
+    if (pos == end) {
+      return UNCHANGED;
+    }
+
+    int out = pos - offset;
+    System.arraycopy(src, offset, dest, 0, out);
+    while (pos < end) {
+      byte c = src[pos];
+      if (c == '+' && plusAsSpace) {
+        dest[out++] = ' ';
+        pos++;
+        continue;
+      }
+      if (c == '%' && pos + 2 < end) {
+        int high = hexValue(src[pos + 1]);
+        int low = hexValue(src[pos + 2]);
+        if (high >= 0 && low >= 0) {
+          dest[out++] = (byte) ((high << 4) | low);
+          pos += 3;
+          continue;
+        }
+      }
+      dest[out++] = c;
+      pos++;
+    }
+    return out;
+  }
+
+  private static int hexValue(byte c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+}
@@ -0,0 +1,439 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeBindings;
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.function.BiConsumer;
+
+/**
+ * Read-only view over a request's raw query string.
+ *
+ * <p>The query is tokenized once into an offset index of name/value pairs, with a flag per name
+ * and value telling whether it contains escapes. Lookups compare names against the raw bytes,
+ * typed accessors parse numbers and booleans straight from the bytes, and only values that are
+ * returned as strings are decoded (as UTF-8, with {@code +} as space), so parameters a handler
+ * never reads cost nothing.
+ */
+public final class QueryParams {
+  private static final int ENTRY_INTS = 5;
+  private static final int NAME_ENCODED = 1;
+  private static final int VALUE_ENCODED = 2;
+  private static final int INITIAL_CAPACITY = 8;
+  private static final QueryParams EMPTY = new QueryParams(new byte[0], new int[0], 0);
+
+  // Powers of ten that are exact doubles, for the fast decimal path
+  private static final double[] POWERS_OF_TEN = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+    1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  private final byte[] query;
+  private final int[] index;
+  private final int count;
+
+  private QueryParams(byte[] query, int[] index, int count) {
+    this.query = query;
+    this.index = index;
+    this.count = count;
+  }
+
+  /**
+   * Tokenizes a raw (still percent-encoded) query string.
+   *
+   * @param rawQuery the query string without the leading '?', or null
+   * @return the parameters, empty if there is no query
+   */
+  public static QueryParams parse(String rawQuery) {
+    if (rawQuery == null || rawQuery.isEmpty()) {
+      return EMPTY;
+    }
+
+    // The raw query is ASCII on the wire, so ISO-8859-1 recovers the original bytes
+    byte[] bytes = rawQuery.getBytes(StandardCharsets.ISO_8859_1);
+    int[] index = new int[INITIAL_CAPACITY * ENTRY_INTS];
+    int count;
+
+    if (NativeOptimizer.isNativeOptimizationAvailable()) {
+      count = NativeBindings.get().parseQuery(bytes, bytes.length, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = NativeBindings.get().parseQuery(bytes, bytes.length, index);
+      }
+    } else {
+      count = tokenize(bytes, index);
+      if (count < 0) {
+        index = new int[-count * ENTRY_INTS];
+        count = tokenize(bytes, index);
+      }
+    }
+
+    return new QueryParams(bytes, index, count);
+  }
+
+  /**
+   * Gets the number of parameters, counting repeated names once per occurrence.
+   *
+   * @return the parameter count
+   */
+  public int size() {
+    return count;
+  }
+
+  /**
+   * Gets the decoded name of the parameter at the given position.
+   *
+   * @param i the position in query order
+   * @return the parameter name
+   */
+  public String name(int i) {
+    int entry = entryOffset(i);
+    return decode(index[entry], index[entry + 1], (index[entry + 4] & NAME_ENCODED) != 0);
+  }
+
+  /**
+   * Gets the decoded value of the parameter at the given position.
+   *
+   * @param i the position in query order
+   * @return the parameter value, empty if the parameter has no '='
+   */
+  public String value(int i) {
+    int entry = entryOffset(i);
+    return decode(index[entry + 2], index[entry + 3], (index[entry + 4] & VALUE_ENCODED) != 0);
+  }
+
+  /**
+   * Gets the decoded value of the first parameter with the given name.
+   *
+   * @param name the parameter name
+   * @return the parameter value or null if not present
+   */
+  public String get(String name) {
+    int i = indexOf(name, 0);
+    return i >= 0 ? value(i) : null;
+  }
+
+  /**
+   * Gets every value of a parameter, in query order.
+   *
+   * @param name the parameter name
+   * @return the values, empty if the parameter is not present
+   */
+  public List<String> getAll(String name) {
+    int i = indexOf(name, 0);
+    if (i < 0) {
+      return Collections.emptyList();
+    }
+    List<String> values = new ArrayList<>(2);
+    for (; i >= 0; i = indexOf(name, i + 1)) {
+      values.add(value(i));
+    }
+    return values;
+  }
+
+  /**
+   * Checks whether a parameter is present.
+   *
+   * @param name the parameter name
+   * @return true if the parameter is present
+   */
+  public boolean contains(String name) {
+    return indexOf(name, 0) >= 0;
+  }
+
+  /**
+   * Calls the action for every parameter in query order, including repeated names.
+   *
+   * @param action receives each decoded name and value
+   */
+  public void forEach(BiConsumer<String, String> action) {
+    for (int i = 0; i < count; i++) {
+      action.accept(name(i), value(i));
+    }
+  }
+
+  /**
+   * Gets the first value of a parameter as an Integer.
+   *
+   * @param name the parameter name
+   * @return the value or null if not present or not a valid integer
+   */
+  public Integer getInt(String name) {
+    Long value = getLong(name);
+    return value != null && value >= Integer.MIN_VALUE && value <= Integer.MAX_VALUE
+        ? Integer.valueOf(value.intValue())
+        : null;
+  }
+
+  /**
+   * Gets the first value of a parameter as a Long.
+   *
+   * @param name the parameter name
+   * @return the value or null if not present or not a valid long
+   */
+  public Long getLong(String name) {
+    int i = indexOf(name, 0);
+    if (i < 0) {
+      return null;
+    }
+    int entry = i * ENTRY_INTS;
+    if ((index[entry + 4] & VALUE_ENCODED) != 0) {
+      try {
+        return Long.parseLong(value(i));
+      } catch (NumberFormatException e) {
+        return null;
+      }
+    }
+    return parseLong(index[entry + 2], index[entry + 3]);
+  }
+
+  /**
+   * Gets the first value of a parameter as a Double.
+   *
+   * @param name the parameter name
+   * @return the value or null if not present or not a valid double
+   */
+  public Double getDouble(String name) {
+    int i = indexOf(name, 0);
+    if (i < 0) {
+      return null;
+    }
+    int entry = i * ENTRY_INTS;
+    if ((index[entry + 4] & VALUE_ENCODED) == 0) {
+      Double fast = parseSimpleDouble(index[entry + 2], index[entry + 3]);
+      if (fast != null) {
+        return fast;
+      }
+    }
+    try {
+      return Double.parseDouble(value(i));
+    } catch (NumberFormatException e) {
+      return null;
+    }
+  }
+
+  /**
+   * Gets the first value of a parameter as a Boolean: true for "true", "yes", "1", "on" and false
+   * for "false", "no", "0", "off", ignoring case.
+   *
+   * @param name the parameter name
+   * @return the value or null if not present or not a valid boolean
+   */
+  public Boolean getBoolean(String name) {
+    int i = indexOf(name, 0);
+    if (i < 0) {
+      return null;
+    }
+    int entry = i * ENTRY_INTS;
+    int offset = index[entry + 2];
+    int length = index[entry + 3];
+    if ((index[entry + 4] & VALUE_ENCODED) != 0) {
+      byte[] decoded = value(i).getBytes(StandardCharsets.UTF_8);
+      return parseBoolean(decoded, 0, decoded.length);
+    }
+    return parseBoolean(query, offset, length);
+  }
+
+  private int indexOf(String name, int from) {
+    int nameLength = name.length();
+    for (int i = from; i < count; i++) {
+      int entry = i * ENTRY_INTS;
+      if ((index[entry + 4] & NAME_ENCODED) != 0) {
+        if (name(i).equals(name)) {
+          return i;
+        }
+      } else if (index[entry + 1] == nameLength && nameEquals(index[entry], name)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  private boolean nameEquals(int offset, String name) {
+    for (int i = 0; i < name.length(); i++) {
+      if ((query[offset + i] & 0xFF) != name.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private int entryOffset(int i) {
+    if (i < 0 || i >= count) {
+      throw new IndexOutOfBoundsException("Query parameter index " + i + " out of range " + count);
+    }
+    return i * ENTRY_INTS;
+  }
+
+  // Raw and escaped bytes are both read as UTF-8, so an escape does not change what the rest of
+  // the component means
+  private String decode(int offset, int length, boolean encoded) {
+    if (!encoded) {
+      return new String(query, offset, length, StandardCharsets.UTF_8);
+    }
+
+    byte[] decoded = PercentDecoder.scratch(length);
+    int decodedLength = PercentDecoder.decode(query, offset, length, true, decoded);
+    if (decodedLength == PercentDecoder.UNCHANGED) {
+      return new String(query, offset, length, StandardCharsets.UTF_8);
+    }
+    return new String(decoded, 0, decodedLength, StandardCharsets.UTF_8);
+  }
+
+  // Same syntax as Long.parseLong: optional sign, then decimal digits
+  private Long parseLong(int offset, int length) {
+    if (length == 0) {
+      return null;
+    }
+    int i = offset;
+    int end = offset + length;
+    boolean negative = query[i] == '-';
+    if (negative || query[i] == '+') {
+      if (++i == end) {
+        return null;
+      }
+    }
+
+    // Accumulate negatively so Long.MIN_VALUE parses without overflow
+    long limit = negative ? Long.MIN_VALUE : -Long.MAX_VALUE;
+    long multiplyMin = limit / 10;
+    long result = 0;
+    for (; i < end; i++) {
+      int digit = query[i] - '0';
+      if (digit < 0 || digit > 9 || result < multiplyMin) {
+        return null;
+      }
+      result *= 10;
+      if (result < limit + digit) {
+        return null;
+      }
+      result -= digit;
+    }
+    return negative ? result : -result;
+  }
+
+  /**
+   * Parses plain decimals such as {@code -12.5} exactly, when the digits fit in a double mantissa.
+   * Returns null for anything else (exponents, long mantissas, special values) so the caller falls
+   * back to {@link Double#parseDouble}.
+   */
+  private Double parseSimpleDouble(int offset, int length) {
+    int i = offset;
+    int end = offset + length;
+    boolean negative = i < end && query[i] == '-';
+    if (negative || (i < end && query[i] == '+')) {
+      i++;
+    }
+
+    long mantissa = 0;
+    int digits = 0;
+    int fractionDigits = -1;
+    for (; i < end; i++) {
+      byte b = query[i];
+      if (b == '.' && fractionDigits < 0) {
+        fractionDigits = 0;
+      } else if (b >= '0' && b <= '9') {
+        if (++digits > 15) {
+          return null;
+        }
+        mantissa = mantissa * 10 + (b - '0');
+        if (fractionDigits >= 0) {
+          fractionDigits++;
+        }
+      } else {
+        return null;
+      }
+    }
+    if (digits == 0) {
+      return null;
+    }
+
+    double value = mantissa;
+    if (fractionDigits > 0) {
+      value /= POWERS_OF_TEN[fractionDigits];
+    }
+    return negative ? -value : value;
+  }
+
+  private static Boolean parseBoolean(byte[] bytes, int offset, int length) {
+    if (matches(bytes, offset, length, "true")
+        || matches(bytes, offset, length, "yes")
+        || matches(bytes, offset, length, "1")
+        || matches(bytes, offset, length, "on")) {
+      return Boolean.TRUE;
+    }
+    if (matches(bytes, offset, length, "false")
+        || matches(bytes, offset, length, "no")
+        || matches(bytes, offset, length, "0")
+        || matches(bytes, offset, length, "off")) {
+      return Boolean.FALSE;
+    }
+    return null;
+  }
+
+  // ASCII case-insensitive comparison against a lowercase literal
+  private static boolean matches(byte[] bytes, int offset, int length, String literal) {
+    if (length != literal.length()) {
+      return false;
+    }
+    for (int i = 0; i < length; i++) {
+      int c = bytes[offset + i];
+      if (c >= 'A' && c <= 'Z') {
+        c += 'a' - 'A';
+      }
+      if (c != literal.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Java fallback for the native tokenizer, with the same index layout. */
+  private static int tokenize(byte[] query, int[] index) {
+    int maxParams = index.length / ENTRY_INTS;
+    int count = 0;
+    int pos = 0;
+
+    while (pos < query.length) {
+      int segmentEnd = pos;
+      while (segmentEnd < query.length && query[segmentEnd] != '&') {
+        segmentEnd++;
+      }
+
+      int nameEnd = pos;
+      while (nameEnd < segmentEnd && query[nameEnd] != '=') {
+        nameEnd++;
+      }
+      int valueStart = nameEnd < segmentEnd ? nameEnd + 1 : segmentEnd;
+
+      if (nameEnd > pos) {
+        if (count < maxParams) {
+          int entry = count * ENTRY_INTS;
+          index[entry] = pos;
+          index[entry + 1] = nameEnd - pos;
+          index[entry + 2] = valueStart;
+          index[entry + 3] = segmentEnd - valueStart;
+          index[entry + 4] =
+              (isEncoded(query, pos, nameEnd) ? NAME_ENCODED : 0)
+                  | (isEncoded(query, valueStart, segmentEnd) ? VALUE_ENCODED : 0);
+        }
+        count++;
+      }
+
+      pos = segmentEnd + 1;
+    }
+
+    return count <= maxParams ? count : -count;
+  }
+
+  private static boolean isEncoded(byte[] query, int start, int end) {
+    for (int i = start; i < end; i++) {
+      if (query[i] == '%' || query[i] == '+') {
+        return true;
+      }
+    }
+    return false;
+  }
+}
@@ -1,21 +1,32 @@
 package com.blyfast.http;
 
+import com.blyfast.nativeopt.DirectBufferPool;
+import com.blyfast.nativeopt.MultipartParser;
+import com.blyfast.nativeopt.NativeBindings;
+import com.blyfast.nativeopt.NativeHeaderMap;
 import com.blyfast.nativeopt.NativeOptimizer;
 import com.fasterxml.jackson.databind.JsonNode;
 import com.fasterxml.jackson.databind.ObjectMapper;
 import io.undertow.server.HttpServerExchange;
 import io.undertow.util.HeaderMap;
 import io.undertow.util.HeaderValues;
+import io.undertow.util.Headers;
 import java.io.ByteArrayInputStream;
 import java.io.IOException;
 import java.io.InputStream;
+import java.io.UncheckedIOException;
 import java.nio.ByteBuffer;
 import java.nio.channels.Channels;
+import java.nio.channels.FileChannel;
 import java.nio.channels.ReadableByteChannel;
 import java.nio.charset.StandardCharsets;
 import java.nio.file.Files;
 import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardOpenOption;
+import java.util.ArrayDeque;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.Collections;
 import java.util.Deque;
 import java.util.HashMap;
@@ -32,30 +43,41 @@ public class Request {
     MAPPER.findAndRegisterModules();
   }
 
-  // Buffer size for reading request bodies
+  // Initial capacity of request body buffers, doubled as the body is read
   private static final int BUFFER_SIZE = 8192;
 
-  // Reusable ByteBuffer for reading request bodies
-  // Note: ThreadLocal values persist for the thread's lifetime. For long-running applications
-  // with many threads, consider periodically clearing ThreadLocal values or using a bounded pool.
-  private static final ThreadLocal<ByteBuffer> bufferPool =
-      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(BUFFER_SIZE));
+  // Initial number of parts indexed by nativeIndexMultipartForm, and ints per part
+  private static final int MULTIPART_INDEX_CAPACITY = 16;
+  private static final int MULTIPART_INDEX_ENTRY_INTS = 8;
+
+  // Read buffer for streamed multipart bodies; must hold a whole part header block
+  private static final int MULTIPART_STREAM_BUFFER_SIZE = 65536;
 
   /**
-   * Clears the ThreadLocal ByteBuffer for the current thread. This helps prevent memory leaks in
-   * long-running applications with many threads. Should be called when a thread is done processing
-   * requests.
+   * Moves the body buffers cached by the current thread to the shared {@link DirectBufferPool}
+   * lists, where other threads can reuse them. Threads do this when they exit; call it when a
+   * long-lived thread is done processing requests for a while.
    */
   public static void clearThreadLocalBuffer() {
-    bufferPool.remove();
+    DirectBufferPool.flushThreadCache();
   }
 
   private HttpServerExchange exchange;
   private String body;
   private JsonNode jsonBody;
   private ByteBuffer rawBodyBuffer;
+  private DirectBufferPool.Lease rawBodyLease; // Null if the body buffer is not pooled
+  private boolean rawBodyShared; // Whether views of the body buffer were handed out
   private int bodyLength;
   private int bodyType = -1; // -1=unknown, >= 0 means analyzed
+  private Cookies cookies;
+  private QueryParams queryParams;
+  private FormData formData;
+  private MediaType mediaType;
+  private NativeHeaderMap nativeHeaders; // Null unless headers were parsed natively
+  private boolean mediaTypeParsed;
+  private ClientAddress clientAddress;
+  private TrustedProxies clientAddressProxies;
   private final Map<String, Object> attributes = new HashMap<>();
   private final Map<String, String> pathParams = new HashMap<>();
   private final Map<String, Object> parsedObjects = new HashMap<>();
@@ -87,6 +109,34 @@ public class Request {
     return exchange.getRequestPath();
   }
 
+  /**
+   * Gets the query parameters. The raw query string is tokenized on first access and values are
+   * decoded only when read.
+   *
+   * @return the query parameters, empty if the request has no query string
+   */
+  public QueryParams getQuery() {
+    if (queryParams == null) {
+      queryParams = QueryParams.parse(exchange.getQueryString());
+    }
+    return queryParams;
+  }
+
+  /**
+   * Gets the address of the client, looking through the given trusted proxies. The result is kept
+   * for the rest of the request, so middleware sharing the same proxies resolves it only once.
+   *
+   * @param proxies the proxies whose forwarding headers are believed
+   * @return the client address, or null if the peer address is unknown
+   */
+  public ClientAddress getClientAddress(TrustedProxies proxies) {
+    if (clientAddress == null || clientAddressProxies != proxies) {
+      clientAddress = proxies.resolve(exchange);
+      clientAddressProxies = proxies;
+    }
+    return clientAddress;
+  }
+
   /**
    * Gets a query parameter by name.
    *
@@ -94,8 +144,7 @@ public class Request {
    * @return the parameter value or null if not present
    */
   public String getQueryParam(String name) {
-    Deque<String> values = exchange.getQueryParameters().get(name);
-    return values != null && !values.isEmpty() ? values.getFirst() : null;
+    return getQuery().get(name);
   }
 
   /**
@@ -105,7 +154,8 @@ public class Request {
    * @return the list of parameter values or null if not present
    */
   public Deque<String> getQueryParamValues(String name) {
-    return exchange.getQueryParameters().get(name);
+    List<String> values = getQuery().getAll(name);
+    return values.isEmpty() ? null : new ArrayDeque<>(values);
   }
 
   /**
@@ -115,15 +165,7 @@ public class Request {
    * @return the parameter value as an Integer or null if not present or not a valid integer
    */
   public Integer getQueryParamAsInt(String name) {
-    String value = getQueryParam(name);
-    if (value == null) {
-      return null;
-    }
-    try {
-      return Integer.parseInt(value);
-    } catch (NumberFormatException e) {
-      return null;
-    }
+    return getQuery().getInt(name);
   }
 
   /**
@@ -133,15 +175,7 @@ public class Request {
    * @return the parameter value as a Long or null if not present or not a valid long
    */
   public Long getQueryParamAsLong(String name) {
-    String value = getQueryParam(name);
-    if (value == null) {
-      return null;
-    }
-    try {
-      return Long.parseLong(value);
-    } catch (NumberFormatException e) {
-      return null;
-    }
+    return getQuery().getLong(name);
   }
 
   /**
@@ -151,15 +185,7 @@ public class Request {
    * @return the parameter value as a Double or null if not present or not a valid double
    */
   public Double getQueryParamAsDouble(String name) {
-    String value = getQueryParam(name);
-    if (value == null) {
-      return null;
-    }
-    try {
-      return Double.parseDouble(value);
-    } catch (NumberFormatException e) {
-      return null;
-    }
+    return getQuery().getDouble(name);
   }
 
   /**
@@ -171,40 +197,31 @@ public class Request {
    * @return the parameter value as a Boolean or null if not present or not a valid boolean
    */
   public Boolean getQueryParamAsBoolean(String name) {
-    String value = getQueryParam(name);
-    if (value == null) {
-      return null;
-    }
-    value = value.toLowerCase();
-    if (value.equals("true") || value.equals("yes") || value.equals("1") || value.equals("on")) {
-      return true;
-    } else if (value.equals("false")
-        || value.equals("no")
-        || value.equals("0")
-        || value.equals("off")) {
-      return false;
-    }
-    return null;
+    return getQuery().getBoolean(name);
   }
 
   /**
-   * Gets all query parameters.
+   * Gets all query parameters. Repeated parameters map to their first value.
    *
    * @return a map of parameter names to values
    */
   public Map<String, String> getQueryParams() {
     Map<String, String> result = new HashMap<>();
-    exchange
-        .getQueryParameters()
-        .forEach(
-            (key, values) -> {
-              if (!values.isEmpty()) {
-                result.put(key, values.getFirst());
-              }
-            });
+    getQuery().forEach(result::putIfAbsent);
     return result;
   }
 
+  /**
+   * Serves header lookups from a natively parsed header set, such as an HPACK-decoded or strictly
+   * parsed block, instead of from Undertow's header map. The set is exported with a single JNI
+   * call, so lookups afterwards make none. Cleared when the request is recycled.
+   *
+   * @param headers the exported headers, or null to read Undertow's header map again
+   */
+  public void setNativeHeaders(NativeHeaderMap headers) {
+    this.nativeHeaders = headers;
+  }
+
   /**
    * Gets a header by name.
    *
@@ -212,12 +229,30 @@ public class Request {
    * @return the header value or null if not present
    */
   public String getHeader(String name) {
+    if (nativeHeaders != null) {
+      return nativeHeaders.get(name);
+    }
     HeaderValues values = exchange.getRequestHeaders().get(name);
     return values != null ? values.getFirst() : null;
   }
 
   /**
-   * Gets all headers.
+   * Gets every value of a header, in wire order.
+   *
+   * @param name the header name
+   * @return the header values, empty if not present
+   */
+  public List<String> getHeaders(String name) {
+    if (nativeHeaders != null) {
+      return nativeHeaders.getAll(name);
+    }
+    HeaderValues values = exchange.getRequestHeaders().get(name);
+    return values != null ? Collections.unmodifiableList(values) : Collections.emptyList();
+  }
+
+  /**
+   * Gets Undertow's header map. Lookups by name should use {@link #getHeader} or {@link
+   * #getHeaders(String)}, which read the native header set when one was set.
    *
    * @return the header map
    */
@@ -225,6 +260,34 @@ public class Request {
     return exchange.getRequestHeaders();
   }
 
+  /**
+   * Gets the request cookies. The Cookie header is tokenized on first access; repeated Cookie
+   * headers (as sent over HTTP/2) are treated as one.
+   *
+   * @return the cookies, empty if the request has none
+   */
+  public Cookies getCookies() {
+    if (cookies == null) {
+      List<String> values = getHeaders(Headers.COOKIE_STRING);
+      String header = null;
+      if (!values.isEmpty()) {
+        header = values.size() == 1 ? values.get(0) : String.join("; ", values);
+      }
+      cookies = Cookies.parse(header);
+    }
+    return cookies;
+  }
+
+  /**
+   * Gets a cookie value by name, percent-decoded.
+   *
+   * @param name the cookie name (case-sensitive)
+   * @return the cookie value or null if not present
+   */
+  public String getCookie(String name) {
+    return getCookies().get(name);
+  }
+
   /**
    * Gets the raw request body as a string. Uses lazy loading, caching, and optimized I/O for better
    * performance.
@@ -258,64 +321,83 @@ public class Request {
 
   /**
    * Loads the raw request body into a direct ByteBuffer. This is used internally by body parsing
-   * methods.
+   * methods. The buffer comes from the {@link DirectBufferPool} and is released with the request.
    *
-   * @throws IOException if an I/O error occurs
+   * @throws IOException if an I/O error occurs, or the buffer pool budget is exhausted
    */
   private void loadRawBody() throws IOException {
     if (!exchange.isBlocking()) {
       exchange.startBlocking();
     }
 
-    ByteBuffer buffer = bufferPool.get();
-    buffer.clear();
-
-    // First read, to see if we can fit it all in the initial buffer
+    DirectBufferPool.Lease lease = leaseBodyBuffer(BUFFER_SIZE);
+    ByteBuffer buffer = bodyBuffer(lease, BUFFER_SIZE);
     try (ReadableByteChannel channel = Channels.newChannel(exchange.getInputStream())) {
-      int bytesRead = channel.read(buffer);
-      if (bytesRead < 0) bytesRead = 0;
-
-      // If it all fits in the initial buffer
-      if (bytesRead >= 0
-          && buffer.position() < buffer.capacity()
-          && bytesRead < buffer.capacity()) {
-        bodyLength = bytesRead;
-        buffer.flip();
-        rawBodyBuffer = ByteBuffer.allocateDirect(bodyLength);
-        rawBodyBuffer.put(buffer);
-        rawBodyBuffer.flip();
-        return;
+      while (channel.read(buffer) >= 0) {
+        if (!buffer.hasRemaining()) {
+          // Double the buffer, returning the smaller one to the pool
+          if (buffer.capacity() > Integer.MAX_VALUE / 2) {
+            throw new IOException("Request body too large");
+          }
+          DirectBufferPool.Lease largerLease = leaseBodyBuffer(buffer.capacity() * 2);
+          ByteBuffer larger = bodyBuffer(largerLease, buffer.capacity() * 2);
+          buffer.flip();
+          larger.put(buffer);
+          releaseLease(lease);
+          lease = largerLease;
+          buffer = larger;
+        }
       }
+    } catch (IOException | RuntimeException e) {
+      releaseLease(lease);
+      throw e;
+    }
 
-      // If it doesn't fit, we need to resize
-      ByteBuffer resizedBuffer =
-          ByteBuffer.allocateDirect(Math.max(bytesRead * 2, 16384)); // At least double
-      buffer.flip();
-      resizedBuffer.put(buffer);
+    bodyLength = buffer.position();
+    buffer.flip();
+    rawBodyBuffer = buffer;
+    rawBodyLease = lease;
+  }
 
-      // Continue reading
-      while (true) {
-        buffer.clear();
-        int read = channel.read(buffer);
-        if (read <= 0) break;
+  // Pooled buffers up to the largest pool block; larger bodies, and all of them without the
+  // native library, get no lease and an ordinary direct buffer
+  private static DirectBufferPool.Lease leaseBodyBuffer(int capacity) throws IOException {
+    if (!DirectBufferPool.canPool(capacity)) {
+      return null;
+    }
+    DirectBufferPool.Lease lease = DirectBufferPool.acquire(capacity);
+    if (lease == null) {
+      throw new IOException("Direct buffer pool budget exhausted");
+    }
+    return lease;
+  }
 
-        buffer.flip();
+  private static ByteBuffer bodyBuffer(DirectBufferPool.Lease lease, int capacity) {
+    return lease != null ? lease.buffer() : ByteBuffer.allocateDirect(capacity);
+  }
 
-        // If resizedBuffer is too small, resize it again
-        if (resizedBuffer.position() + buffer.remaining() > resizedBuffer.capacity()) {
-          ByteBuffer newBuffer = ByteBuffer.allocateDirect(resizedBuffer.capacity() * 2);
-          resizedBuffer.flip();
-          newBuffer.put(resizedBuffer);
-          resizedBuffer = newBuffer;
-        }
+  private static void releaseLease(DirectBufferPool.Lease lease) {
+    if (lease != null) {
+      lease.release();
+    }
+  }
 
-        resizedBuffer.put(buffer);
+  /**
+   * Returns the raw body buffer to the {@link DirectBufferPool}. Called when the request is
+   * recycled. If the {@link FormData} or multipart file content views the buffer, it is returned
+   * only once those views are unreachable, so they stay valid for as long as they are held.
+   */
+  public void releaseBody() {
+    if (rawBodyLease != null) {
+      if (rawBodyShared) {
+        rawBodyLease.releaseWhenUnreachable();
+      } else {
+        rawBodyLease.release();
       }
-
-      bodyLength = resizedBuffer.position();
-      resizedBuffer.flip();
-      rawBodyBuffer = resizedBuffer;
     }
+    rawBodyLease = null;
+    rawBodyBuffer = null;
+    rawBodyShared = false;
   }
 
   /**
@@ -367,13 +449,13 @@ public class Request {
       // Try to get Content-Type header first
       String contentType = getHeader("Content-Type");
       if (contentType != null) {
-        bodyType = NativeOptimizer.nativeAnalyzeHttpBody(rawBodyBuffer, bodyLength, contentType);
+        bodyType = NativeBindings.get().analyzeHttpBody(rawBodyBuffer, bodyLength, contentType);
       }
 
       // If couldn't determine from Content-Type or no Content-Type header
       if (bodyType <= 0) {
         // Try to detect from content
-        bodyType = NativeOptimizer.nativeFastDetectContentType(rawBodyBuffer, bodyLength);
+        bodyType = NativeBindings.get().detectContentType(rawBodyBuffer, bodyLength);
       }
     } else {
       // Default to unknown
@@ -398,7 +480,7 @@ public class Request {
       return (T) cached;
     }
 
-    // Try native optimization for form data
+    // Form data (application/x-www-form-urlencoded), tokenized in place
     if (NativeOptimizer.isNativeOptimizationAvailable() && clazz == Map.class) {
       if (rawBodyBuffer == null) {
         loadRawBody();
@@ -406,19 +488,12 @@ public class Request {
 
       detectBodyType();
 
-      // Form data (application/x-www-form-urlencoded)
       if (bodyType == 2) {
-        try {
-          ByteBuffer parsedBuffer =
-              NativeOptimizer.nativeFastParseBody(rawBodyBuffer, bodyLength, bodyType);
-          if (parsedBuffer != null) {
-            Map<String, String> result = parseFormDataBuffer(parsedBuffer);
-            parsedObjects.put(clazz.getName(), result);
-            return (T) result;
-          }
-        } catch (Exception e) {
-          // Fallback to standard parsing
-        }
+        // Repeated fields keep their last value; getFormData() has all of them
+        Map<String, String> result = new HashMap<>();
+        getFormData().forEach(result::put);
+        parsedObjects.put(clazz.getName(), result);
+        return (T) result;
       }
     }
 
@@ -431,40 +506,34 @@ public class Request {
   }
 
   /**
-   * Parses a pre-processed form data buffer (from native code) into a Map.
+   * Gets the parsed Content-Type header.
    *
-   * @param buffer the buffer containing pre-processed form data
-   * @return a Map of form field names to values
+   * @return the media type, or null if the header is absent or malformed
    */
-  private Map<String, String> parseFormDataBuffer(ByteBuffer buffer) {
-    Map<String, String> result = new HashMap<>();
-    buffer.position(0);
-
-    while (buffer.hasRemaining()) {
-      // Read key length and value length
-      int keyLength = buffer.getInt();
-      if (!buffer.hasRemaining()) break;
-
-      // Read key
-      byte[] keyBytes = new byte[keyLength];
-      buffer.get(keyBytes);
-      String key = new String(keyBytes, StandardCharsets.UTF_8);
-
-      if (!buffer.hasRemaining()) break;
-
-      // Read value length
-      int valueLength = buffer.getInt();
-      if (!buffer.hasRemaining() && valueLength > 0) break;
-
-      // Read value
-      byte[] valueBytes = new byte[valueLength];
-      buffer.get(valueBytes);
-      String value = new String(valueBytes, StandardCharsets.UTF_8);
-
-      result.put(key, value);
+  public MediaType getMediaType() {
+    if (!mediaTypeParsed) {
+      mediaType = MediaType.parse(getHeader("Content-Type"));
+      mediaTypeParsed = true;
     }
+    return mediaType;
+  }
 
-    return result;
+  /**
+   * Gets the request body as urlencoded form fields. The body is tokenized in place on first
+   * access; fields are decoded only when read, and repeated fields keep every value.
+   *
+   * @return the form fields, empty if the body is empty
+   * @throws IOException if an I/O error occurs
+   */
+  public FormData getFormData() throws IOException {
+    if (formData == null) {
+      if (rawBodyBuffer == null) {
+        loadRawBody();
+      }
+      formData = FormData.parse(rawBodyBuffer, bodyLength);
+      rawBodyShared = true; // Fields are read from the buffer
+    }
+    return formData;
   }
 
   /**
@@ -535,82 +604,39 @@ public class Request {
       loadRawBody();
     }
 
-    // Detect body type if not already done
-    detectBodyType();
-
     MultipartData result = new MultipartData();
-
-    // If this is indeed multipart data and native optimization is available
-    if (bodyType == 3 && NativeOptimizer.isNativeOptimizationAvailable()) {
-      try {
-        ByteBuffer parsedBuffer =
-            NativeOptimizer.nativeFastParseBody(rawBodyBuffer, bodyLength, bodyType);
-        if (parsedBuffer != null) {
-          // Parse the pre-processed buffer from native code
-          parsedBuffer.position(0);
-
-          // Read part count
-          int partCount = parsedBuffer.getInt();
-
-          // Parse each part
-          for (int i = 0; i < partCount; i++) {
-            // Read header lengths and is_file flag
-            int nameLen = parsedBuffer.getInt();
-            int filenameLen = parsedBuffer.getInt();
-            int contentTypeLen = parsedBuffer.getInt();
-            int dataLen = parsedBuffer.getInt();
-            boolean isFile = parsedBuffer.get() != 0;
-
-            // Read name
-            String name = "";
-            if (nameLen > 0) {
-              byte[] nameBytes = new byte[nameLen];
-              parsedBuffer.get(nameBytes);
-              name = new String(nameBytes, StandardCharsets.UTF_8);
-            }
-
-            // Read filename if present
-            String filename = null;
-            if (filenameLen > 0) {
-              byte[] filenameBytes = new byte[filenameLen];
-              parsedBuffer.get(filenameBytes);
-              filename = new String(filenameBytes, StandardCharsets.UTF_8);
-            }
-
-            // Read content type if present
-            String contentType = null;
-            if (contentTypeLen > 0) {
-              byte[] contentTypeBytes = new byte[contentTypeLen];
-              parsedBuffer.get(contentTypeBytes);
-              contentType = new String(contentTypeBytes, StandardCharsets.UTF_8);
-            }
-
-            // Read data
-            byte[] data = new byte[dataLen];
-            parsedBuffer.get(data);
-
-            if (isFile) {
-              // Handle file part
-              MultipartFile file = new MultipartFile(name, filename, contentType, data);
-              result.addFile(name, file);
-            } else {
-              // Handle field part
-              String value = new String(data, StandardCharsets.UTF_8);
-              result.addField(name, value);
-            }
-
-            // Skip any alignment padding
-            while (parsedBuffer.position() % 4 != 0 && parsedBuffer.hasRemaining()) {
-              parsedBuffer.get();
-            }
+    String boundary = multipartBoundary();
+
+    // Natively, parts are only indexed: files become read-only slices of the body buffer and
+    // are never copied
+    if (boundary != null && NativeOptimizer.isNativeOptimizationAvailable()) {
+      int[] index = new int[MULTIPART_INDEX_CAPACITY * MULTIPART_INDEX_ENTRY_INTS];
+      int count =
+          NativeOptimizer.nativeIndexMultipartForm(rawBodyBuffer, bodyLength, boundary, index);
+      if (count < 0) {
+        index = new int[-count * MULTIPART_INDEX_ENTRY_INTS];
+        count =
+            NativeOptimizer.nativeIndexMultipartForm(rawBodyBuffer, bodyLength, boundary, index);
+      }
+      if (count > 0) {
+        ByteBuffer body = rawBodyBuffer.asReadOnlyBuffer();
+        rawBodyShared = true;
+        for (int i = 0; i < count; i++) {
+          int e = i * MULTIPART_INDEX_ENTRY_INTS;
+          String name = index[e + 1] >= 0 ? bodyText(index[e], index[e + 1]) : "";
+          if (index[e + 3] >= 0) {
+            String filename = bodyText(index[e + 2], index[e + 3]);
+            String contentType = index[e + 5] >= 0 ? bodyText(index[e + 4], index[e + 5]) : null;
+            ByteBuffer content = body.slice(index[e + 6], index[e + 7]);
+            result.addFile(name, new MultipartFile(name, filename, contentType, content));
+          } else {
+            result.addField(name, bodyText(index[e + 6], index[e + 7]));
           }
-
-          // Cache result
-          parsedObjects.put(MultipartData.class.getName(), result);
-          return result;
         }
-      } catch (Exception e) {
-        // Fallback to Java implementation
+
+        // Cache result
+        parsedObjects.put(MultipartData.class.getName(), result);
+        return result;
       }
     }
 
@@ -618,21 +644,6 @@ public class Request {
     // This is a simplified implementation - in a production environment
     // you would want a more robust multipart parser
 
-    // Extract boundary from Content-Type header
-    String contentType = getHeader("Content-Type");
-    String boundary = null;
-    if (contentType != null && contentType.contains("boundary=")) {
-      boundary = contentType.substring(contentType.indexOf("boundary=") + 9);
-      // Remove quotes if present
-      if (boundary.startsWith("\"") && boundary.endsWith("\"")) {
-        boundary = boundary.substring(1, boundary.length() - 1);
-      }
-      // In case there are additional parameters after the boundary
-      if (boundary.contains(";")) {
-        boundary = boundary.substring(0, boundary.indexOf(";"));
-      }
-    }
-
     if (boundary == null) {
       // Can't parse without a boundary
       return result;
@@ -752,6 +763,227 @@ public class Request {
     return result;
   }
 
+  /**
+   * Parses multipart form data like {@link #parseMultipartData()}, but streams the body instead of
+   * loading it, and writes uploaded files larger than the threshold to temporary files in the
+   * system temporary directory instead of the heap.
+   *
+   * @param spillThreshold the largest file size kept in memory, in bytes
+   * @return the form fields and files
+   * @throws IOException if an I/O error occurs or the body is malformed
+   */
+  public MultipartData parseMultipartData(long spillThreshold) throws IOException {
+    return parseMultipartData(spillThreshold, Paths.get(System.getProperty("java.io.tmpdir")));
+  }
+
+  /**
+   * Parses multipart form data like {@link #parseMultipartData()}, but streams the body instead of
+   * loading it, and writes uploaded files larger than the threshold to temporary files instead of
+   * the heap. Temporary files are deleted when the request completes unless they were saved with
+   * {@link MultipartFile#saveTo(Path)}, which moves them rather than copying when the target is
+   * on the same filesystem as the spill directory. Without native optimizations the whole body is
+   * parsed in memory.
+   *
+   * @param spillThreshold the largest file size kept in memory, in bytes
+   * @param spillDirectory the directory for temporary files
+   * @return the form fields and files
+   * @throws IOException if an I/O error occurs or the body is malformed
+   */
+  public MultipartData parseMultipartData(long spillThreshold, Path spillDirectory)
+      throws IOException {
+    Object cached = parsedObjects.get(MultipartData.class.getName());
+    if (cached instanceof MultipartData) {
+      return (MultipartData) cached;
+    }
+    if (!NativeOptimizer.isNativeOptimizationAvailable() || multipartBoundary() == null) {
+      return parseMultipartData();
+    }
+
+    MultipartData result = new MultipartData();
+    long sizeHint = exchange != null ? Math.max(exchange.getRequestContentLength(), 0) : 0;
+    SpillingCollector collector =
+        new SpillingCollector(result, spillThreshold, spillDirectory, sizeHint);
+    try {
+      streamMultipart(collector);
+    } catch (IOException | RuntimeException e) {
+      collector.abort();
+      result.release();
+      throw e;
+    }
+
+    parsedObjects.put(MultipartData.class.getName(), result);
+    if (collector.spilled && exchange != null) {
+      exchange.addExchangeCompleteListener(
+          (completed, next) -> {
+            result.release();
+            next.proceed();
+          });
+    }
+    return result;
+  }
+
+  // Collects streamed parts into MultipartData, moving file content past the threshold to disk
+  private static final class SpillingCollector implements MultipartParser.Listener {
+    private final MultipartData result;
+    private final long threshold;
+    private final Path directory;
+    private final long sizeHint;
+    private String name;
+    private String filename;
+    private String contentType;
+    private byte[] content = new byte[256];
+    private int contentLength;
+    private SpillFile spill;
+    boolean spilled;
+
+    SpillingCollector(MultipartData result, long threshold, Path directory, long sizeHint) {
+      this.result = result;
+      this.threshold = threshold;
+      this.directory = directory;
+      this.sizeHint = sizeHint;
+    }
+
+    @Override
+    public void partBegin(String name, String filename, String contentType) {
+      this.name = name;
+      this.filename = filename;
+      this.contentType = contentType;
+      this.contentLength = 0;
+    }
+
+    @Override
+    public void partData(ByteBuffer buffer, int offset, int length) throws IOException {
+      if (spill == null && filename != null && (long) contentLength + length > threshold) {
+        spill = SpillFile.create(directory, sizeHint);
+        spilled = true;
+        spill.write(ByteBuffer.wrap(content), 0, contentLength);
+      }
+      if (spill != null) {
+        spill.write(buffer, offset, length);
+        return;
+      }
+      if (contentLength + length > content.length) {
+        content = Arrays.copyOf(content, Math.max(content.length * 2, contentLength + length));
+      }
+      buffer.get(offset, content, contentLength, length);
+      contentLength += length;
+    }
+
+    @Override
+    public void partEnd() throws IOException {
+      if (spill != null) {
+        SpillFile file = spill;
+        spill = null;
+        if (name == null) {
+          file.close();
+          return;
+        }
+        file.finish();
+        result.addFile(name, new MultipartFile(name, filename, contentType, file));
+      } else if (name != null) {
+        if (filename != null) {
+          result.addFile(
+              name,
+              new MultipartFile(
+                  name, filename, contentType, Arrays.copyOf(content, contentLength)));
+        } else {
+          result.addField(name, new String(content, 0, contentLength, StandardCharsets.UTF_8));
+        }
+      }
+    }
+
+    // Discards a part left open by a failed parse
+    void abort() {
+      if (spill != null) {
+        spill.close();
+        spill = null;
+      }
+    }
+  }
+
+  /**
+   * Streams a multipart/form-data body to a listener while it is read, instead of holding it in
+   * memory. Parts are reported as they arrive and their content as slices of a fixed read buffer,
+   * so uploads of any size can be written to their destination with bounded memory. If the body
+   * was already read by another accessor, it is parsed from memory.
+   *
+   * @param listener receives the parts
+   * @throws IOException if an I/O error occurs, the request is not multipart or the body is
+   *     malformed or truncated
+   */
+  public void streamMultipart(MultipartParser.Listener listener) throws IOException {
+    String boundary = multipartBoundary();
+    if (boundary == null) {
+      throw new IOException("Request has no multipart boundary");
+    }
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      replayMultipart(parseMultipartData(), listener);
+      return;
+    }
+
+    try (MultipartParser parser = new MultipartParser(boundary)) {
+      if (rawBodyBuffer != null) {
+        parser.parse(rawBodyBuffer, 0, bodyLength, listener);
+      } else {
+        if (!exchange.isBlocking()) {
+          exchange.startBlocking();
+        }
+        DirectBufferPool.Lease lease = leaseBodyBuffer(MULTIPART_STREAM_BUFFER_SIZE);
+        ByteBuffer buffer = bodyBuffer(lease, MULTIPART_STREAM_BUFFER_SIZE);
+        try (ReadableByteChannel channel = Channels.newChannel(exchange.getInputStream())) {
+          while (!parser.isComplete() && channel.read(buffer) >= 0) {
+            int consumed = parser.parse(buffer, 0, buffer.position(), listener);
+            if (consumed == 0 && !buffer.hasRemaining()) {
+              throw new IOException("Multipart part does not fit the read buffer");
+            }
+            // Keep the unconsumed tail for the next read
+            buffer.flip().position(consumed);
+            buffer.compact();
+          }
+        } finally {
+          releaseLease(lease);
+        }
+      }
+      if (!parser.isComplete()) {
+        throw new IOException("Truncated multipart body");
+      }
+    }
+  }
+
+  // Without the native parser: parse the whole body, then report its parts in the same way
+  private static void replayMultipart(MultipartData data, MultipartParser.Listener listener)
+      throws IOException {
+    for (Map.Entry<String, String> field : data.getFields().entrySet()) {
+      byte[] value = field.getValue().getBytes(StandardCharsets.UTF_8);
+      listener.partBegin(field.getKey(), null, null);
+      listener.partData(ByteBuffer.wrap(value), 0, value.length);
+      listener.partEnd();
+    }
+    for (MultipartFile file : data.getFiles()) {
+      byte[] content = file.getData();
+      listener.partBegin(file.getFieldName(), file.getFilename(), file.getContentType());
+      listener.partData(ByteBuffer.wrap(content), 0, content.length);
+      listener.partEnd();
+    }
+  }
+
+  // Decodes UTF-8 text from the raw body without an intermediate array per value
+  private String bodyText(int offset, int length) {
+    byte[] scratch = PercentDecoder.scratch(length);
+    rawBodyBuffer.get(offset, scratch, 0, length);
+    return new String(scratch, 0, length, StandardCharsets.UTF_8);
+  }
+
+  /**
+   * Gets the boundary parameter of a multipart Content-Type header.
+   *
+   * @return the boundary, or null if there is none
+   */
+  private String multipartBoundary() {
+    MediaType type = getMediaType();
+    return type != null && type.getType().equals("multipart") ? type.getBoundary() : null;
+  }
+
   /**
    * Helper method to extract a quoted value from a string
    *
@@ -777,8 +1009,7 @@ public class Request {
 
   /**
    * Resets this request instance for reuse with a new exchange. Used for object pooling to minimize
-   * garbage collection. Note: This does not clear ThreadLocal ByteBuffers. For long-running
-   * threads, consider calling Request.clearThreadLocalBuffer() periodically.
+   * garbage collection.
    *
    * @param exchange the new exchange to use
    * @return this instance for method chaining
@@ -787,9 +1018,21 @@ public class Request {
     this.exchange = exchange;
     this.body = null;
     this.jsonBody = null;
-    this.rawBodyBuffer = null; // Reset to prevent memory leak
+    Object multipart = parsedObjects.get(MultipartData.class.getName());
+    if (multipart instanceof MultipartData) {
+      ((MultipartData) multipart).release(); // Delete uploads spilled to disk
+    }
+    releaseBody(); // Normally done when the request was recycled
     this.bodyLength = 0; // Reset body length
     this.bodyType = -1; // Reset body type detection
+    this.cookies = null;
+    this.queryParams = null;
+    this.formData = null;
+    this.mediaType = null;
+    this.nativeHeaders = null;
+    this.mediaTypeParsed = false;
+    this.clientAddress = null;
+    this.clientAddressProxies = null;
     this.attributes.clear();
     this.pathParams.clear();
     this.parsedObjects.clear();
@@ -890,14 +1133,28 @@ public class Request {
     public boolean hasFile(String name) {
       return files.containsKey(name);
     }
+
+    // Releases the temporary files of uploads that were spilled to disk
+    void release() {
+      for (MultipartFile file : allFiles) {
+        file.release();
+      }
+    }
   }
 
-  /** Represents a file uploaded via multipart/form-data */
+  /**
+   * Represents a file uploaded via multipart/form-data. Its content is either held in memory or,
+   * for large uploads parsed with a spill threshold, in a temporary file that is released with the
+   * request. Content in memory may be a read-only slice of the request body, which is only copied
+   * when {@link #getData()} is called; the body buffer is not reused while the slice is reachable.
+   */
   public static class MultipartFile {
     private final String fieldName;
     private final String filename;
     private final String contentType;
-    private final byte[] data;
+    private byte[] data;
+    private final ByteBuffer content;
+    private final SpillFile file;
 
     /**
      * Create a new MultipartFile
@@ -912,6 +1169,26 @@ public class Request {
       this.filename = filename;
       this.contentType = contentType;
       this.data = data;
+      this.content = null;
+      this.file = null;
+    }
+
+    // Creates a file whose content is a read-only slice of the request body
+    MultipartFile(String fieldName, String filename, String contentType, ByteBuffer content) {
+      this.fieldName = fieldName;
+      this.filename = filename;
+      this.contentType = contentType;
+      this.content = content;
+      this.file = null;
+    }
+
+    // Creates a file whose content was spilled to disk
+    MultipartFile(String fieldName, String filename, String contentType, SpillFile file) {
+      this.fieldName = fieldName;
+      this.filename = filename;
+      this.contentType = contentType;
+      this.content = null;
+      this.file = file;
     }
 
     /**
@@ -942,40 +1219,184 @@ public class Request {
     }
 
     /**
-     * Get the file data
+     * Get the file data. For a slice of the request body this copies the content once; for a
+     * file on disk it reads the whole content into memory. Prefer {@link #getInputStream()},
+     * {@link #map()} or {@link #saveTo(Path)} for large uploads.
      *
      * @return file data
+     * @throws UncheckedIOException if a file on disk cannot be read
      */
     public byte[] getData() {
-      return data;
+      if (content != null && data == null) {
+        data = new byte[content.remaining()];
+        content.get(content.position(), data);
+      }
+      if (file == null) {
+        return data;
+      }
+      try {
+        return Files.readAllBytes(file.path());
+      } catch (IOException e) {
+        throw new UncheckedIOException(e);
+      }
     }
 
     /**
      * Get the file size
      *
-     * @return file size in bytes
+     * @return file size in bytes, capped at Integer.MAX_VALUE; see {@link #getLength()}
      */
     public int getSize() {
+      return (int) Math.min(getLength(), Integer.MAX_VALUE);
+    }
+
+    /**
+     * Get the file size, including uploads larger than 2 GB.
+     *
+     * @return file size in bytes
+     */
+    public long getLength() {
+      if (file != null) {
+        return file.size();
+      }
+      if (content != null) {
+        return content.remaining();
+      }
       return data != null ? data.length : 0;
     }
 
     /**
-     * Save the file to a specified path
+     * Check whether the content is held in memory rather than in a temporary file.
+     *
+     * @return true if the content is in memory
+     */
+    public boolean isInMemory() {
+      return file == null;
+    }
+
+    /**
+     * Get the path of the temporary file holding the content. The path is only valid until the
+     * request completes; use {@link #saveTo(Path)} to keep the file.
+     *
+     * @return the path, or null if the content is in memory
+     */
+    public Path getPath() {
+      return file != null ? file.path() : null;
+    }
+
+    /**
+     * Save the file to a specified path, replacing an existing file. Content on disk is linked or
+     * renamed into place rather than copied when the path is on the same filesystem; a linked
+     * file shares its storage with the upload until the upload is released.
      *
      * @param path the destination path
      * @throws IOException if an I/O error occurs
      */
     public void saveTo(Path path) throws IOException {
-      Files.write(path, data);
+      if (file != null) {
+        file.saveTo(path);
+      } else if (content != null) {
+        try (FileChannel channel =
+            FileChannel.open(
+                path,
+                StandardOpenOption.CREATE,
+                StandardOpenOption.WRITE,
+                StandardOpenOption.TRUNCATE_EXISTING)) {
+          ByteBuffer source = content.duplicate();
+          while (source.hasRemaining()) {
+            channel.write(source);
+          }
+        }
+      } else {
+        Files.write(path, data);
+      }
     }
 
     /**
      * Get the file content as an input stream
      *
      * @return input stream containing the file data
+     * @throws UncheckedIOException if a file on disk cannot be opened
      */
     public InputStream getInputStream() {
-      return new ByteArrayInputStream(data);
+      if (content != null) {
+        return new BufferInputStream(content.duplicate());
+      }
+      if (file == null) {
+        return new ByteArrayInputStream(data);
+      }
+      try {
+        return Files.newInputStream(file.path());
+      } catch (IOException e) {
+        throw new UncheckedIOException(e);
+      }
+    }
+
+    /**
+     * Get the file content as a read-only buffer, memory-mapping content on disk.
+     *
+     * @return the content
+     * @throws IOException if a file on disk cannot be mapped or is larger than 2 GB
+     */
+    public ByteBuffer map() throws IOException {
+      if (content != null) {
+        return content.duplicate();
+      }
+      if (file == null) {
+        return ByteBuffer.wrap(data).asReadOnlyBuffer();
+      }
+      try (FileChannel channel = FileChannel.open(file.path(), StandardOpenOption.READ)) {
+        if (channel.size() > Integer.MAX_VALUE) {
+          throw new IOException("Uploaded file is too large to map: " + channel.size());
+        }
+        return channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size());
+      }
+    }
+
+    // Deletes the temporary file unless it was saved
+    void release() {
+      if (file != null) {
+        file.close();
+      }
+    }
+  }
+
+  /** Input stream over the remaining bytes of a buffer, which it consumes. */
+  private static final class BufferInputStream extends InputStream {
+    private final ByteBuffer buffer;
+
+    BufferInputStream(ByteBuffer buffer) {
+      this.buffer = buffer;
+    }
+
+    @Override
+    public int read() {
+      return buffer.hasRemaining() ? buffer.get() & 0xFF : -1;
+    }
+
+    @Override
+    public int read(byte[] bytes, int offset, int length) {
+      if (length == 0) {
+        return 0;
+      }
+      if (!buffer.hasRemaining()) {
+        return -1;
+      }
+      int count = Math.min(length, buffer.remaining());
+      buffer.get(bytes, offset, count);
+      return count;
+    }
+
+    @Override
+    public long skip(long n) {
+      int count = (int) Math.max(0, Math.min(n, buffer.remaining()));
+      buffer.position(buffer.position() + count);
+      return count;
+    }
+
+    @Override
+    public int available() {
+      return buffer.remaining();
     }
   }
 }
@@ -41,6 +41,10 @@ public class Response {
       new ConcurrentHashMap<>(64, 0.75f);
   private static final AtomicInteger responseCacheSize = new AtomicInteger(0);
 
+  // Application-defined header names seen by header(); bounded in case names are dynamic
+  private static final int HEADER_NAME_CACHE_SIZE = 256;
+  private static final Map<String, HttpString> headerNameCache = new ConcurrentHashMap<>(64);
+
   // Flag to determine if native optimizations are available
   private static final boolean nativeOptimizationsAvailable;
 
@@ -165,10 +169,29 @@ public class Response {
    * @return this response for method chaining
    */
   public Response header(String name, String value) {
-    exchange.getResponseHeaders().put(new HttpString(name), value);
+    exchange.getResponseHeaders().put(headerName(name), value);
     return this;
   }
 
+  /**
+   * Resolves a header name to a shared HttpString: Undertow's constant for well-known headers,
+   * otherwise a cached instance, so setting a header does not allocate.
+   */
+  private static HttpString headerName(String name) {
+    HttpString known = Headers.fromCache(name);
+    if (known != null) {
+      return known;
+    }
+    HttpString cached = headerNameCache.get(name);
+    if (cached == null) {
+      cached = new HttpString(name);
+      if (headerNameCache.size() < HEADER_NAME_CACHE_SIZE) {
+        headerNameCache.putIfAbsent(name, cached);
+      }
+    }
+    return cached;
+  }
+
   /**
    * Sets the Content-Type header.
    *
@@ -488,6 +511,29 @@ public class Response {
     return this;
   }
 
+  /**
+   * Sends a multipart body, such as a batch response or the byte ranges of a 206 response. Its
+   * framing and part bodies go out in one gathering write; part bodies are not copied.
+   *
+   * @param body the multipart body
+   * @return this response for method chaining
+   * @throws IllegalStateException if the body has no parts
+   * @throws IllegalArgumentException if a part header contains CR or LF
+   */
+  public Response multipart(MultipartResponse body) {
+    if (sent) {
+      logger.warn("Response already sent, ignoring subsequent multipart() call");
+      return this;
+    }
+
+    ByteBuffer[] buffers = body.toBuffers();
+    type(body.getContentType());
+    exchange.getResponseHeaders().put(Headers.CONTENT_LENGTH, body.getContentLength());
+    exchange.getResponseSender().send(buffers);
+    sent = true;
+    return this;
+  }
+
   /**
    * Sends a 204 No Content response.
    *
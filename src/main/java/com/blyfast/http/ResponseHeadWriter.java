@@ -0,0 +1,246 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.time.ZoneOffset;
+import java.time.ZonedDateTime;
+import java.time.format.DateTimeFormatter;
+import java.util.Arrays;
+import java.util.Locale;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+/**
+ * Serializes HTTP/1.1 response heads (status line plus headers) into a direct buffer with one
+ * native call.
+ *
+ * <p>Header sets that are identical on every response are registered once and copied verbatim.
+ * The {@code Date} header is formatted once per second by a background tick, so the per-response
+ * cost is a few memcpys. Output is meant for code that writes directly to a socket channel, such
+ * as the request fast path; a Java implementation is used when the native library is unavailable.
+ */
+public final class ResponseHeadWriter {
+  private static final Logger logger = LoggerFactory.getLogger(ResponseHeadWriter.class);
+  private static final int INITIAL_BUFFER_SIZE = 1024;
+  private static final DateTimeFormatter DATE_FORMAT =
+      DateTimeFormatter.ofPattern("EEE, dd MMM yyyy HH:mm:ss 'GMT'", Locale.US);
+
+  private static final ThreadLocal<ByteBuffer> HEAD_BUFFER =
+      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(INITIAL_BUFFER_SIZE));
+
+  // Registered sets: serialized bytes for the Java fallback, and their native IDs. Both arrays are
+  // replaced, never modified, so write() reads them without locking; register() publishes
+  // headerSets first, so any ID found in nativeHeaderSetIds is also in headerSets
+  private static volatile byte[][] headerSets = new byte[0][];
+  private static volatile int[] nativeHeaderSetIds = new int[0];
+
+  private static final boolean nativeAvailable = NativeOptimizer.isNativeOptimizationAvailable();
+
+  static {
+    if (nativeAvailable) {
+      ScheduledExecutorService dateTick =
+          Executors.newSingleThreadScheduledExecutor(
+              r -> {
+                Thread thread = new Thread(r, "blyfast-date-tick");
+                thread.setDaemon(true);
+                return thread;
+              });
+      dateTick.scheduleAtFixedRate(
+          () -> NativeOptimizer.nativeUpdateDateHeader(System.currentTimeMillis() / 1000),
+          0,
+          1,
+          TimeUnit.SECONDS);
+    }
+  }
+
+  private ResponseHeadWriter() {}
+
+  /**
+   * Registers a header set that is written verbatim on every response that uses it.
+   *
+   * @param namesAndValues alternating header names and values
+   * @return the header set ID
+   * @throws IllegalArgumentException if the set is empty, unbalanced or contains CR/LF
+   */
+  public static synchronized int register(String... namesAndValues) {
+    if (namesAndValues.length == 0 || namesAndValues.length % 2 != 0) {
+      throw new IllegalArgumentException("Expected alternating header names and values");
+    }
+
+    StringBuilder serialized = new StringBuilder();
+    for (int i = 0; i < namesAndValues.length; i += 2) {
+      appendHeader(serialized, namesAndValues[i], namesAndValues[i + 1]);
+    }
+
+    int nativeId = 0;
+    if (nativeAvailable) {
+      nativeId = NativeOptimizer.nativeRegisterResponseHeaders(namesAndValues);
+      if (nativeId == 0) {
+        logger.warn("Native response header registry is full, using Java serialization");
+      }
+    }
+
+    int count = nativeHeaderSetIds.length;
+    byte[][] sets = Arrays.copyOf(headerSets, count + 1);
+    sets[count] = serialized.toString().getBytes(StandardCharsets.UTF_8);
+    int[] ids = Arrays.copyOf(nativeHeaderSetIds, count + 1);
+    ids[count] = nativeId;
+    headerSets = sets;
+    nativeHeaderSetIds = ids;
+    return count + 1;
+  }
+
+  /**
+   * Serializes a response head.
+   *
+   * @param status the status code
+   * @param headerSetId a registered header set, or 0 for none
+   * @param contentLength the Content-Length to send, or -1 to omit it
+   * @param namesAndValues additional headers as alternating names and values
+   * @return the serialized head, valid until the next call on this thread
+   * @throws IllegalArgumentException if the arguments are invalid or a header contains CR/LF
+   */
+  public static ByteBuffer write(
+      int status, int headerSetId, long contentLength, String... namesAndValues) {
+    int nativeSetId = nativeSetId(headerSetId);
+    if (nativeAvailable && (headerSetId == 0 || nativeSetId != 0)) {
+      ByteBuffer out = HEAD_BUFFER.get();
+      int written =
+          NativeOptimizer.nativeWriteResponseHead(
+              out, 0, status, nativeSetId, contentLength, namesAndValues);
+      if (written < 0) {
+        out = ByteBuffer.allocateDirect(-written);
+        HEAD_BUFFER.set(out);
+        written =
+            NativeOptimizer.nativeWriteResponseHead(
+                out, 0, status, nativeSetId, contentLength, namesAndValues);
+      }
+      if (written <= 0) {
+        throw new IllegalArgumentException("Invalid response head");
+      }
+      ByteBuffer head = out.duplicate();
+      head.position(0).limit(written);
+      return head;
+    }
+
+    return javaWrite(status, headerSetId, contentLength, namesAndValues);
+  }
+
+  private static int nativeSetId(int headerSetId) {
+    int[] ids = nativeHeaderSetIds;
+    if (headerSetId < 0 || headerSetId > ids.length) {
+      throw new IllegalArgumentException("Unknown header set " + headerSetId);
+    }
+    return headerSetId == 0 ? 0 : ids[headerSetId - 1];
+  }
+
+  private static ByteBuffer javaWrite(
+      int status, int headerSetId, long contentLength, String... namesAndValues) {
+    if (status < 100 || status > 999 || namesAndValues.length % 2 != 0) {
+      throw new IllegalArgumentException("Invalid response head");
+    }
+
+    StringBuilder head = new StringBuilder(256);
+    head.append("HTTP/1.1 ").append(status).append(' ').append(reasonPhrase(status)).append("\r\n");
+    head.append("Date: ")
+        .append(DATE_FORMAT.format(ZonedDateTime.now(ZoneOffset.UTC)))
+        .append("\r\n");
+
+    byte[] headerSet = headerSetId > 0 ? headerSets[headerSetId - 1] : null;
+    if (headerSet != null) {
+      head.append(new String(headerSet, StandardCharsets.UTF_8));
+    }
+    if (contentLength >= 0) {
+      head.append("Content-Length: ").append(contentLength).append("\r\n");
+    }
+    for (int i = 0; i < namesAndValues.length; i += 2) {
+      appendHeader(head, namesAndValues[i], namesAndValues[i + 1]);
+    }
+    head.append("\r\n");
+
+    return ByteBuffer.wrap(head.toString().getBytes(StandardCharsets.UTF_8));
+  }
+
+  private static void appendHeader(StringBuilder out, String name, String value) {
+    if (name.isEmpty() || hasLineBreak(name) || hasLineBreak(value)) {
+      throw new IllegalArgumentException("Invalid header: " + name);
+    }
+    out.append(name).append(": ").append(value).append("\r\n");
+  }
+
+  private static boolean hasLineBreak(String s) {
+    return s.indexOf('\r') >= 0 || s.indexOf('\n') >= 0;
+  }
+
+  // Must match reasonPhrase() in response_head.c so both paths write the same status line
+  private static String reasonPhrase(int status) {
+    switch (status) {
+      case 100:
+        return "Continue";
+      case 101:
+        return "Switching Protocols";
+      case 200:
+        return "OK";
+      case 201:
+        return "Created";
+      case 202:
+        return "Accepted";
+      case 204:
+        return "No Content";
+      case 206:
+        return "Partial Content";
+      case 301:
+        return "Moved Permanently";
+      case 302:
+        return "Found";
+      case 303:
+        return "See Other";
+      case 304:
+        return "Not Modified";
+      case 307:
+        return "Temporary Redirect";
+      case 308:
+        return "Permanent Redirect";
+      case 400:
+        return "Bad Request";
+      case 401:
+        return "Unauthorized";
+      case 403:
+        return "Forbidden";
+      case 404:
+        return "Not Found";
+      case 405:
+        return "Method Not Allowed";
+      case 408:
+        return "Request Timeout";
+      case 409:
+        return "Conflict";
+      case 410:
+        return "Gone";
+      case 413:
+        return "Content Too Large";
+      case 415:
+        return "Unsupported Media Type";
+      case 422:
+        return "Unprocessable Content";
+      case 429:
+        return "Too Many Requests";
+      case 500:
+        return "Internal Server Error";
+      case 501:
+        return "Not Implemented";
+      case 502:
+        return "Bad Gateway";
+      case 503:
+        return "Service Unavailable";
+      case 504:
+        return "Gateway Timeout";
+      default:
+        return "";
+    }
+  }
+}
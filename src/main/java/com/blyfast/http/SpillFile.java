@@ -0,0 +1,170 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
+
+/**
+ * Temporary file holding the content of a large multipart part.
+ *
+ * <p>On Linux the file is an anonymous O_TMPFILE file written by the native library: it has no
+ * name until it is saved, saving links it instead of copying it, and it disappears when closed. It
+ * is read through {@code /proc/self/fd}. Elsewhere, or on filesystems without O_TMPFILE, it is a
+ * named temporary file that saving renames.
+ */
+final class SpillFile implements AutoCloseable {
+  private long handle;
+  private FileChannel channel;
+  private Path path;
+  private boolean temporary;
+  private long size;
+
+  private SpillFile(long handle, FileChannel channel, Path path) {
+    this.handle = handle;
+    this.channel = channel;
+    this.path = path;
+    this.temporary = true;
+  }
+
+  /**
+   * Creates a spill file.
+   *
+   * @param directory the directory for the file
+   * @param sizeHint an upper bound on the content size used to preallocate space, or 0
+   * @return the file, open for writing
+   * @throws IOException if the file cannot be created
+   */
+  static SpillFile create(Path directory, long sizeHint) throws IOException {
+    if (NativeOptimizer.isNativeOptimizationAvailable()) {
+      long handle = NativeOptimizer.nativeSpillFileCreate(directory.toString(), sizeHint);
+      if (handle != 0) {
+        int fd = NativeOptimizer.nativeSpillFileDescriptor(handle);
+        return new SpillFile(handle, null, Paths.get("/proc/self/fd/" + fd));
+      }
+    }
+    Path path = Files.createTempFile(directory, "blyfast-upload-", ".part");
+    try {
+      return new SpillFile(0, FileChannel.open(path, StandardOpenOption.WRITE), path);
+    } catch (IOException e) {
+      Files.deleteIfExists(path);
+      throw e;
+    }
+  }
+
+  /**
+   * Appends bytes to the file.
+   *
+   * @param buffer the buffer holding the bytes
+   * @param offset the absolute offset of the bytes
+   * @param length the number of bytes
+   * @throws IOException if the write fails
+   */
+  void write(ByteBuffer buffer, int offset, int length) throws IOException {
+    ByteBuffer slice = buffer.duplicate().limit(offset + length).position(offset);
+    if (handle == 0) {
+      while (slice.hasRemaining()) {
+        channel.write(slice);
+      }
+    } else {
+      if (!buffer.isDirect()) {
+        buffer = ByteBuffer.allocateDirect(length).put(slice).flip();
+        offset = 0;
+      }
+      int result = NativeOptimizer.nativeSpillFileWrite(handle, buffer, offset, length);
+      if (result < 0) {
+        throw new IOException("Failed to write upload spill file (errno " + -result + ")");
+      }
+    }
+    size += length;
+  }
+
+  /**
+   * Completes the file once the part has ended.
+   *
+   * @throws IOException if pending bytes cannot be written
+   */
+  void finish() throws IOException {
+    if (handle != 0) {
+      long result = NativeOptimizer.nativeSpillFileFinish(handle);
+      if (result < 0) {
+        throw new IOException("Failed to write upload spill file (errno " + -result + ")");
+      }
+    } else if (channel != null) {
+      channel.close();
+      channel = null;
+    }
+  }
+
+  /**
+   * Gets the path the content can be read from while the file is open.
+   *
+   * @return the path
+   * @throws IllegalStateException if the file has been closed
+   */
+  Path path() {
+    if (path == null) {
+      throw new IllegalStateException("Uploaded file has been released");
+    }
+    return path;
+  }
+
+  /**
+   * Gets the content size.
+   *
+   * @return the size in bytes
+   */
+  long size() {
+    return size;
+  }
+
+  /**
+   * Saves the content at a path, replacing an existing file. Anonymous files are linked and named
+   * files renamed; the content is only copied if the target is on another filesystem, or for
+   * later saves of a named file.
+   *
+   * @param target the destination path
+   * @throws IOException if the file cannot be saved
+   */
+  void saveTo(Path target) throws IOException {
+    Path source = path();
+    if (handle != 0) {
+      if (NativeOptimizer.nativeSpillFileLink(handle, target.toString()) != 0) {
+        Files.copy(source, target, StandardCopyOption.REPLACE_EXISTING);
+      }
+    } else if (temporary) {
+      path = Files.move(source, target, StandardCopyOption.REPLACE_EXISTING);
+      temporary = false;
+    } else {
+      Files.copy(source, target, StandardCopyOption.REPLACE_EXISTING);
+    }
+  }
+
+  /** Releases the file, deleting it unless it was saved. Saved copies are not affected. */
+  @Override
+  public void close() {
+    if (handle != 0) {
+      NativeOptimizer.nativeSpillFileFree(handle);
+      handle = 0;
+    } else {
+      try {
+        if (channel != null) {
+          channel.close();
+          channel = null;
+        }
+        if (temporary && path != null) {
+          Files.deleteIfExists(path);
+        }
+      } catch (IOException e) {
+        // Best effort: the file is in the temporary directory
+      }
+    }
+    // A /proc/self/fd path could now name another file
+    path = null;
+  }
+}
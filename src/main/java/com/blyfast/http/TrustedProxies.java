@@ -0,0 +1,261 @@
+package com.blyfast.http;
+
+import com.blyfast.nativeopt.NativeOptimizer;
+import io.undertow.server.HttpServerExchange;
+import io.undertow.util.HeaderValues;
+import io.undertow.util.Headers;
+import java.net.InetSocketAddress;
+
+/**
+ * The reverse proxies whose forwarding headers are believed when resolving a client address.
+ *
+ * <p>If a request comes from a trusted proxy, its {@code Forwarded} header (or {@code
+ * X-Forwarded-For} when there is none) is walked from the right, skipping further trusted proxies;
+ * the first untrusted address is the client. Headers from untrusted peers are ignored, so clients
+ * cannot choose their own address. Parsing and CIDR matching run natively on 128-bit addresses,
+ * with a Java implementation of the same rules when the native library is unavailable.
+ */
+public final class TrustedProxies {
+  private static final int CIDR_LONGS = 4;
+  private static final int MAX_CIDRS = 64;
+  private static final int MAX_HOPS = 64;
+  private static final TrustedProxies NONE = new TrustedProxies(new long[0], 0);
+
+  private static final ThreadLocal<long[]> RESULT = ThreadLocal.withInitial(() -> new long[2]);
+
+  private final long[] cidrs;
+  private final int nativeSetId;
+
+  private TrustedProxies(long[] cidrs, int nativeSetId) {
+    this.cidrs = cidrs;
+    this.nativeSetId = nativeSetId;
+  }
+
+  /**
+   * Gets an empty set: the client is always the connected peer.
+   *
+   * @return the empty set
+   */
+  public static TrustedProxies none() {
+    return NONE;
+  }
+
+  /**
+   * Creates a set of trusted proxies. Sets are registered natively, so create them once at
+   * configuration time rather than per request.
+   *
+   * @param cidrs addresses or CIDR ranges, such as {@code "10.0.0.0/8"} or {@code "::1"}
+   * @return the trusted proxies
+   * @throws IllegalArgumentException if a range is malformed or there are more than 64
+   */
+  public static TrustedProxies of(String... cidrs) {
+    if (cidrs.length == 0) {
+      return NONE;
+    }
+    if (cidrs.length > MAX_CIDRS) {
+      throw new IllegalArgumentException("At most " + MAX_CIDRS + " trusted proxy ranges");
+    }
+
+    long[] compiled = new long[cidrs.length * CIDR_LONGS];
+    for (int i = 0; i < cidrs.length; i++) {
+      compileCidr(cidrs[i], compiled, i * CIDR_LONGS);
+    }
+    int setId =
+        NativeOptimizer.isNativeOptimizationAvailable()
+            ? NativeOptimizer.nativeCompileTrustedProxies(compiled)
+            : 0;
+    return new TrustedProxies(compiled, setId);
+  }
+
+  /**
+   * Checks whether an address belongs to a trusted proxy.
+   *
+   * @param address the address
+   * @return true if the address is in one of the ranges
+   */
+  public boolean contains(ClientAddress address) {
+    for (int i = 0; i < cidrs.length; i += CIDR_LONGS) {
+      if ((address.getHigh() & cidrs[i + 2]) == cidrs[i]
+          && (address.getLow() & cidrs[i + 3]) == cidrs[i + 1]) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Resolves the client address of a request.
+   *
+   * @param exchange the HTTP exchange
+   * @return the client address, or null if the peer address is unknown
+   */
+  public ClientAddress resolve(HttpServerExchange exchange) {
+    InetSocketAddress source = exchange.getSourceAddress();
+    if (source == null || source.getAddress() == null) {
+      return null;
+    }
+    ClientAddress peer = ClientAddress.of(source.getAddress());
+    if (cidrs.length == 0 || !contains(peer)) {
+      return peer;
+    }
+
+    HeaderValues forwarded = exchange.getRequestHeaders().get(Headers.FORWARDED);
+    HeaderValues xForwardedFor = exchange.getRequestHeaders().get(Headers.X_FORWARDED_FOR);
+    if (forwarded == null && xForwardedFor == null) {
+      return peer;
+    }
+
+    if (nativeSetId > 0) {
+      long[] result = RESULT.get();
+      int resolved =
+          NativeOptimizer.nativeResolveClientAddress(
+              nativeSetId,
+              peer.getHigh(),
+              peer.getLow(),
+              forwarded != null ? forwarded.toArray() : null,
+              xForwardedFor != null ? xForwardedFor.toArray() : null,
+              result);
+      if (resolved >= 0) {
+        return resolved == 0 ? peer : new ClientAddress(result[0], result[1]);
+      }
+    }
+    return forwarded != null
+        ? walk(peer, forwarded.toArray(), true)
+        : walk(peer, xForwardedFor.toArray(), false);
+  }
+
+  // Java version of the native walk: rightmost untrusted hop, stopping at anything unparseable
+  private ClientAddress walk(ClientAddress current, String[] values, boolean forwarded) {
+    for (int v = values.length - 1; v >= 0; v--) {
+      String value = values[v];
+      int end = value.length();
+      for (int hops = 0; end > 0 && hops < MAX_HOPS; ) {
+        int start = hopStart(value, end);
+        int elementStart = trimStart(value, start, end);
+        int elementEnd = trimEnd(value, elementStart, end);
+        end = start - 1;
+        if (elementStart == elementEnd) {
+          continue; // Empty list element
+        }
+        hops++;
+
+        ClientAddress hop =
+            forwarded
+                ? parseForwardedElement(value, elementStart, elementEnd)
+                : ClientAddress.parseNode(value, elementStart, elementEnd);
+        if (hop == null) {
+          // The proxy vouched for something that is not an address; it is the best we know
+          return current;
+        }
+        current = hop;
+        if (!contains(hop)) {
+          return current;
+        }
+      }
+    }
+    return current;
+  }
+
+  private static int hopStart(String value, int end) {
+    boolean quoted = false;
+    for (int i = end - 1; i >= 0; i--) {
+      char c = value.charAt(i);
+      if (c == '"') {
+        quoted = !quoted;
+      } else if (c == ',' && !quoted) {
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  private static ClientAddress parseForwardedElement(String s, int start, int end) {
+    int pos = start;
+    while (pos < end) {
+      while (pos < end && (s.charAt(pos) == ' ' || s.charAt(pos) == '\t' || s.charAt(pos) == ';')) {
+        pos++;
+      }
+      int nameStart = pos;
+      while (pos < end && s.charAt(pos) != '=' && s.charAt(pos) != ';') {
+        pos++;
+      }
+      if (pos >= end || s.charAt(pos) != '=') {
+        continue;
+      }
+      boolean isFor = pos - nameStart == 3 && s.regionMatches(true, nameStart, "for", 0, 3);
+      pos++;
+
+      int valueStart = pos;
+      int valueEnd;
+      if (pos < end && s.charAt(pos) == '"') {
+        valueStart = ++pos;
+        while (pos < end && s.charAt(pos) != '"') {
+          pos++;
+        }
+        valueEnd = pos;
+        if (pos < end) {
+          pos++;
+        }
+      } else {
+        while (pos < end && s.charAt(pos) != ';') {
+          pos++;
+        }
+        valueEnd = trimEnd(s, valueStart, pos);
+      }
+      if (isFor) {
+        return ClientAddress.parseNode(s, valueStart, valueEnd);
+      }
+    }
+    return null;
+  }
+
+  private static int trimStart(String s, int start, int end) {
+    while (start < end && (s.charAt(start) == ' ' || s.charAt(start) == '\t')) {
+      start++;
+    }
+    return start;
+  }
+
+  private static int trimEnd(String s, int start, int end) {
+    while (end > start && (s.charAt(end - 1) == ' ' || s.charAt(end - 1) == '\t')) {
+      end--;
+    }
+    return end;
+  }
+
+  // Writes the masked address and mask of one range, IPv4 mapped into ::ffff:0:0/96
+  private static void compileCidr(String cidr, long[] out, int offset) {
+    int slash = cidr.indexOf('/');
+    String literal = slash >= 0 ? cidr.substring(0, slash) : cidr;
+    ClientAddress address = ClientAddress.parse(literal);
+    if (address == null || literal.indexOf('[') >= 0 || hasPort(literal)) {
+      throw new IllegalArgumentException("Invalid trusted proxy address: " + cidr);
+    }
+
+    int bits = address.isIpv4() && literal.indexOf(':') < 0 ? 32 : 128;
+    int prefix = bits;
+    if (slash >= 0) {
+      try {
+        prefix = Integer.parseInt(cidr.substring(slash + 1));
+      } catch (NumberFormatException e) {
+        prefix = -1;
+      }
+      if (prefix < 0 || prefix > bits) {
+        throw new IllegalArgumentException("Invalid trusted proxy prefix: " + cidr);
+      }
+    }
+    prefix += 128 - bits;
+
+    long maskHigh = prefix >= 64 ? -1L : prefix == 0 ? 0 : -1L << (64 - prefix);
+    long maskLow = prefix <= 64 ? 0 : prefix == 128 ? -1L : -1L << (128 - prefix);
+    out[offset] = address.getHigh() & maskHigh;
+    out[offset + 1] = address.getLow() & maskLow;
+    out[offset + 2] = maskHigh;
+    out[offset + 3] = maskLow;
+  }
+
+  private static boolean hasPort(String literal) {
+    int colon = literal.indexOf(':');
+    return colon >= 0 && literal.indexOf(':', colon + 1) < 0;
+  }
+}
@@ -1,6 +1,9 @@
 package com.blyfast.middleware;
 
+import com.blyfast.http.TrustedProxies;
+import java.util.Collections;
 import java.util.HashMap;
+import java.util.LinkedHashMap;
 import java.util.Map;
 import java.util.UUID;
 import java.util.concurrent.ConcurrentHashMap;
@@ -19,12 +22,35 @@ public class CommonMiddleware {
   private static final AtomicLong totalResponseTime = new AtomicLong(0);
   private static final Map<String, AtomicInteger> pathCounter = new ConcurrentHashMap<>();
 
+  /** Headers added by {@link #securityHeaders()}, in the order they are set. */
+  public static final Map<String, String> SECURITY_HEADERS;
+
+  static {
+    Map<String, String> headers = new LinkedHashMap<>();
+    headers.put("X-Content-Type-Options", "nosniff");
+    headers.put("X-Frame-Options", "DENY");
+    headers.put("X-XSS-Protection", "1; mode=block");
+    headers.put("Referrer-Policy", "no-referrer-when-downgrade");
+    SECURITY_HEADERS = Collections.unmodifiableMap(headers);
+  }
+
   /**
    * Creates a logging middleware that logs request information.
    *
    * @return the middleware
    */
   public static Middleware logger() {
+    return logger(TrustedProxies.none());
+  }
+
+  /**
+   * Creates a logging middleware that logs request information, including the client address as
+   * reported by the given trusted proxies.
+   *
+   * @param proxies the proxies whose forwarding headers are believed
+   * @return the middleware
+   */
+  public static Middleware logger(TrustedProxies proxies) {
     return ctx -> {
       long startTime = System.currentTimeMillis();
       String requestId = UUID.randomUUID().toString().substring(0, 8);
@@ -32,8 +58,13 @@ public class CommonMiddleware {
       ctx.request().setAttribute("requestId", requestId);
       ctx.request().setAttribute("startTime", startTime);
 
+      // The address is only formatted if the line is actually logged
       logger.info(
-          "[{}] {} {} started", requestId, ctx.request().getMethod(), ctx.request().getPath());
+          "[{}] {} {} from {} started",
+          requestId,
+          ctx.request().getMethod(),
+          ctx.request().getPath(),
+          ctx.clientAddress(proxies));
 
       // Continue processing
       return true;
@@ -118,10 +149,7 @@ public class CommonMiddleware {
    */
   public static Middleware securityHeaders() {
     return ctx -> {
-      ctx.header("X-Content-Type-Options", "nosniff");
-      ctx.header("X-Frame-Options", "DENY");
-      ctx.header("X-XSS-Protection", "1; mode=block");
-      ctx.header("Referrer-Policy", "no-referrer-when-downgrade");
+      SECURITY_HEADERS.forEach(ctx::header);
 
       // Continue processing
       return true;
@@ -0,0 +1,393 @@
+package com.blyfast.nativeopt;
+
+import com.blyfast.util.JsonUtil;
+import com.fasterxml.jackson.core.JsonProcessingException;
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * Base64 and base64url codecs (RFC 4648), for tokens, data URIs and binary fields in JSON.
+ *
+ * <p>Direct buffers are encoded and decoded natively, 24 bytes per vector iteration where the CPU
+ * supports AVX2; arrays of at least {@link #NATIVE_THRESHOLD} bytes go through per-thread direct
+ * buffers, and shorter ones are handled in Java, where the JNI call would cost more than it saves.
+ *
+ * <p>Decoding is strict by default: only alphabet characters, optional padding that completes the
+ * last group, and zero spare bits in the last character, so every byte string has exactly one
+ * accepted encoding (apart from padding). With {@link #LENIENT}, whitespace is skipped and spare
+ * bits are ignored, as for MIME bodies.
+ */
+public final class Base64Codec {
+  /** Use the URL and filename safe alphabet, with {@code -} and {@code _}. */
+  public static final int URL = 1;
+
+  /** Skip whitespace and ignore nonzero spare bits when decoding. */
+  public static final int LENIENT = 2;
+
+  /** Omit padding when encoding. */
+  public static final int NO_PADDING = 4;
+
+  /** Length below which arrays are encoded and decoded in Java. */
+  public static final int NATIVE_THRESHOLD = 128;
+
+  private static final byte[] ALPHABET =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+          .getBytes(StandardCharsets.US_ASCII);
+  private static final byte[] URL_ALPHABET =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+          .getBytes(StandardCharsets.US_ASCII);
+
+  private static final int INITIAL_SCRATCH_SIZE = 8 * 1024;
+
+  // Direct copies of array input and output for the native path
+  private static final ThreadLocal<ByteBuffer[]> SCRATCH =
+      ThreadLocal.withInitial(
+          () ->
+              new ByteBuffer[] {
+                ByteBuffer.allocateDirect(INITIAL_SCRATCH_SIZE),
+                ByteBuffer.allocateDirect(INITIAL_SCRATCH_SIZE)
+              });
+
+  private static final boolean nativeAvailable = NativeOptimizer.isNativeOptimizationAvailable();
+
+  private Base64Codec() {}
+
+  /**
+   * Gets the length of the encoding of {@code length} bytes.
+   *
+   * @param length the number of bytes
+   * @param flags {@link #NO_PADDING} to leave out padding
+   * @return the number of characters
+   */
+  public static int encodedLength(int length, int flags) {
+    if ((flags & NO_PADDING) != 0) {
+      return length / 3 * 4 + (length % 3 == 0 ? 0 : length % 3 + 1);
+    }
+    return (length + 2) / 3 * 4;
+  }
+
+  /**
+   * Gets the most bytes {@code length} characters of base64 can decode to.
+   *
+   * @param length the number of characters
+   * @return the maximum number of bytes
+   */
+  public static int maxDecodedLength(int length) {
+    return (int) (((long) length * 3 + 3) / 4);
+  }
+
+  /**
+   * Encodes the remaining bytes of {@code src} into {@code dst}, advancing both positions.
+   *
+   * @param src the bytes
+   * @param dst the buffer for the text, with room for {@link #encodedLength} characters
+   * @param flags {@link #URL} and {@link #NO_PADDING}
+   * @return the number of characters written
+   * @throws BufferOverflowException if {@code dst} is too small
+   */
+  public static int encode(ByteBuffer src, ByteBuffer dst, int flags) {
+    int length = src.remaining();
+    int written = encodedLength(length, flags);
+    if (dst.remaining() < written) {
+      throw new BufferOverflowException();
+    }
+    if (nativeAvailable && src.isDirect() && dst.isDirect()) {
+      NativeOptimizer.nativeBase64Encode(src, src.position(), length, dst, dst.position(), flags);
+    } else {
+      javaEncode(src, src.position(), length, dst, dst.position(), flags);
+    }
+    src.position(src.position() + length);
+    dst.position(dst.position() + written);
+    return written;
+  }
+
+  /**
+   * Decodes the remaining text of {@code src} into {@code dst}, advancing both positions. The
+   * buffers may share content to decode in place, with {@code dst} starting at or before {@code
+   * src}.
+   *
+   * @param src the text
+   * @param dst the buffer for the bytes, with room for {@link #maxDecodedLength} bytes
+   * @param flags {@link #URL} and {@link #LENIENT}
+   * @return the number of bytes written
+   * @throws BufferOverflowException if {@code dst} is too small
+   * @throws IllegalArgumentException if the text is not valid base64
+   */
+  public static int decode(ByteBuffer src, ByteBuffer dst, int flags) {
+    int length = src.remaining();
+    if (dst.remaining() < maxDecodedLength(length)) {
+      throw new BufferOverflowException();
+    }
+    int written =
+        nativeAvailable && src.isDirect() && dst.isDirect()
+            ? NativeOptimizer.nativeBase64Decode(
+                src, src.position(), length, dst, dst.position(), flags)
+            : javaDecode(src, src.position(), length, dst, dst.position(), flags);
+    if (written < 0) {
+      throw new IllegalArgumentException("Illegal base64 character at index " + (-1 - written));
+    }
+    src.position(src.position() + length);
+    dst.position(dst.position() + written);
+    return written;
+  }
+
+  /**
+   * Encodes bytes.
+   *
+   * @param src the bytes
+   * @param flags {@link #URL} and {@link #NO_PADDING}
+   * @return the text as ASCII bytes
+   */
+  public static byte[] encode(byte[] src, int flags) {
+    byte[] text = new byte[encodedLength(src.length, flags)];
+    if (nativeAvailable && src.length >= NATIVE_THRESHOLD) {
+      ByteBuffer[] scratch = scratch(src.length, text.length);
+      scratch[0].put(src).flip();
+      encode(scratch[0], scratch[1], flags);
+      scratch[1].flip().get(text);
+    } else {
+      javaEncode(ByteBuffer.wrap(src), 0, src.length, ByteBuffer.wrap(text), 0, flags);
+    }
+    return text;
+  }
+
+  /**
+   * Encodes bytes to a string.
+   *
+   * @param src the bytes
+   * @param flags {@link #URL} and {@link #NO_PADDING}
+   * @return the text
+   */
+  public static String encodeToString(byte[] src, int flags) {
+    return new String(encode(src, flags), StandardCharsets.ISO_8859_1);
+  }
+
+  /**
+   * Decodes text given as ASCII bytes.
+   *
+   * @param src the text
+   * @param flags {@link #URL} and {@link #LENIENT}
+   * @return the bytes
+   * @throws IllegalArgumentException if the text is not valid base64
+   */
+  public static byte[] decode(byte[] src, int flags) {
+    int maxLength = maxDecodedLength(src.length);
+    if (nativeAvailable && src.length >= NATIVE_THRESHOLD) {
+      ByteBuffer[] scratch = scratch(src.length, maxLength);
+      scratch[0].put(src).flip();
+      decode(scratch[0], scratch[1], flags);
+      byte[] data = new byte[scratch[1].flip().remaining()];
+      scratch[1].get(data);
+      return data;
+    }
+    ByteBuffer data = ByteBuffer.allocate(maxLength);
+    decode(ByteBuffer.wrap(src), data, flags);
+    int written = data.position();
+    return written == maxLength ? data.array() : Arrays.copyOf(data.array(), written);
+  }
+
+  /**
+   * Decodes text.
+   *
+   * @param src the text
+   * @param flags {@link #URL} and {@link #LENIENT}
+   * @return the bytes
+   * @throws IllegalArgumentException if the text is not valid base64
+   */
+  public static byte[] decode(String src, int flags) {
+    return decode(src.getBytes(StandardCharsets.ISO_8859_1), flags);
+  }
+
+  /**
+   * Parses JSON, decoding the string values of the named object members as base64 into buffers
+   * instead of returning them as strings. Natively, each value is decoded from the parser's UTF-8
+   * copy of {@code json} into a direct buffer, without an intermediate string per value.
+   *
+   * @param json the JSON text
+   * @param flags {@link #URL} and {@link #LENIENT}
+   * @param base64Fields the names of the members holding base64
+   * @return the parsed value: maps, lists, strings, numbers, booleans and {@link ByteBuffer}s, or
+   *     null if the JSON is invalid
+   * @throws IllegalArgumentException if a named member is not valid base64
+   */
+  public static Object parseJson(String json, int flags, String... base64Fields) {
+    if (nativeAvailable) {
+      return NativeOptimizer.nativeParseJsonBase64(json, base64Fields, flags);
+    }
+    Object value;
+    try {
+      value = JsonUtil.getMapper().readValue(json, Object.class);
+    } catch (JsonProcessingException e) {
+      return null;
+    }
+    return decodeFields(value, Set.of(base64Fields), flags);
+  }
+
+  @SuppressWarnings("unchecked")
+  private static Object decodeFields(Object value, Set<String> fields, int flags) {
+    if (value instanceof Map) {
+      for (Map.Entry<String, Object> entry : ((Map<String, Object>) value).entrySet()) {
+        Object member = entry.getValue();
+        if (member instanceof String && fields.contains(entry.getKey())) {
+          entry.setValue(ByteBuffer.wrap(decode((String) member, flags)));
+        } else {
+          entry.setValue(decodeFields(member, fields, flags));
+        }
+      }
+    } else if (value instanceof List) {
+      List<Object> list = (List<Object>) value;
+      for (int i = 0; i < list.size(); i++) {
+        list.set(i, decodeFields(list.get(i), fields, flags));
+      }
+    }
+    return value;
+  }
+
+  private static ByteBuffer[] scratch(int srcLength, int dstLength) {
+    ByteBuffer[] scratch = SCRATCH.get();
+    if (scratch[0].capacity() < srcLength) {
+      scratch[0] = ByteBuffer.allocateDirect(srcLength);
+    }
+    if (scratch[1].capacity() < dstLength) {
+      scratch[1] = ByteBuffer.allocateDirect(dstLength);
+    }
+    scratch[0].clear();
+    scratch[1].clear();
+    return scratch;
+  }
+
+  private static void javaEncode(
+      ByteBuffer src, int srcOffset, int length, ByteBuffer dst, int dstOffset, int flags) {
+    byte[] alphabet = (flags & URL) != 0 ? URL_ALPHABET : ALPHABET;
+    int in = srcOffset;
+    int out = dstOffset;
+    int end = srcOffset + length / 3 * 3;
+    while (in < end) {
+      int group =
+          (src.get(in) & 0xFF) << 16 | (src.get(in + 1) & 0xFF) << 8 | (src.get(in + 2) & 0xFF);
+      dst.put(out, alphabet[group >>> 18]);
+      dst.put(out + 1, alphabet[(group >>> 12) & 0x3F]);
+      dst.put(out + 2, alphabet[(group >>> 6) & 0x3F]);
+      dst.put(out + 3, alphabet[group & 0x3F]);
+      in += 3;
+      out += 4;
+    }
+
+    int rest = length % 3;
+    if (rest > 0) {
+      int group = (src.get(in) & 0xFF) << 16 | (rest == 2 ? (src.get(in + 1) & 0xFF) << 8 : 0);
+      dst.put(out++, alphabet[group >>> 18]);
+      dst.put(out++, alphabet[(group >>> 12) & 0x3F]);
+      if (rest == 2) {
+        dst.put(out++, alphabet[(group >>> 6) & 0x3F]);
+      }
+      if ((flags & NO_PADDING) == 0) {
+        dst.put(out++, (byte) '=');
+        if (rest == 1) {
+          dst.put(out, (byte) '=');
+        }
+      }
+    }
+  }
+
+  // Same rules and results as the native decoder: bytes written or -1 - offset of the error
+  private static int javaDecode(
+      ByteBuffer src, int srcOffset, int length, ByteBuffer dst, int dstOffset, int flags) {
+    boolean url = (flags & URL) != 0;
+    boolean lenient = (flags & LENIENT) != 0;
+    int out = dstOffset;
+    int group = 0;
+    int count = 0;
+    int lastData = -1;
+    int i = 0;
+    while (i < length) {
+      int c = src.get(srcOffset + i) & 0xFF;
+      int value = decodeChar(c, url);
+      if (value >= 0) {
+        group = (group << 6) | value;
+        lastData = i;
+        if (++count == 4) {
+          dst.put(out, (byte) (group >> 16));
+          dst.put(out + 1, (byte) (group >> 8));
+          dst.put(out + 2, (byte) group);
+          out += 3;
+          group = 0;
+          count = 0;
+        }
+        i++;
+      } else if (lenient && isWhitespace(c)) {
+        i++;
+      } else if (c == '=') {
+        // Padding completes a group of two or three values and ends the input
+        if (count < 2) {
+          return -1 - i;
+        }
+        int missing = 4 - count;
+        for (; i < length && missing > 0; i++) {
+          int p = src.get(srcOffset + i);
+          if (p == '=') {
+            missing--;
+          } else if (!(lenient && isWhitespace(p))) {
+            return -1 - i;
+          }
+        }
+        if (missing > 0) {
+          return -1 - length;
+        }
+        for (; i < length; i++) {
+          if (!(lenient && isWhitespace(src.get(srcOffset + i)))) {
+            return -1 - i;
+          }
+        }
+      } else {
+        return -1 - i;
+      }
+    }
+
+    // A final group of two or three values holds one or two bytes; its spare bits must be zero
+    if (count == 1) {
+      return -1 - length;
+    }
+    if (count == 2) {
+      if (!lenient && (group & 0x0F) != 0) {
+        return -1 - lastData;
+      }
+      dst.put(out++, (byte) (group >> 4));
+    } else if (count == 3) {
+      if (!lenient && (group & 0x03) != 0) {
+        return -1 - lastData;
+      }
+      dst.put(out++, (byte) (group >> 10));
+      dst.put(out++, (byte) (group >> 2));
+    }
+    return out - dstOffset;
+  }
+
+  private static int decodeChar(int c, boolean url) {
+    if (c >= 'A' && c <= 'Z') {
+      return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+      return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+      return c - '0' + 52;
+    }
+    if (c == (url ? '-' : '+')) {
+      return 62;
+    }
+    if (c == (url ? '_' : '/')) {
+      return 63;
+    }
+    return -1;
+  }
+
+  private static boolean isWhitespace(int c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+}
@@ -0,0 +1,132 @@
+package com.blyfast.nativeopt;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+/**
+ * Streaming decoder for request bodies sent with {@code Transfer-Encoding: chunked}, backed by the
+ * native library.
+ *
+ * <p>Framing is stripped in place: after {@link #decode} the data bytes sit at the start of the
+ * decoded region, so a body can be read straight into a direct buffer and passed on without an
+ * intermediate copy. Reads may split the body at any byte; decoding resumes where the previous
+ * call stopped. Chunk extensions are skipped and trailer fields are available once the body is
+ * complete. Undertow already removes chunk framing for the bodies it reads, so this is meant for
+ * code that reads raw socket data.
+ */
+public final class ChunkedDecoder implements AutoCloseable {
+  private static final long FIELD_MASK = 0x7FFFFFFFL;
+  private static final int PRODUCED_SHIFT = 31;
+  private static final int COMPLETE_SHIFT = 62;
+
+  private static final String[] ERROR_REASONS = {
+    "unknown error",
+    "invalid chunk size",
+    "chunk size overflow",
+    "missing CRLF",
+    "chunk extension too long",
+    "trailer section too long",
+    "invalid trailer field",
+    "out of memory"
+  };
+
+  private long handle;
+  private int consumed;
+  private boolean complete;
+
+  /**
+   * Creates a decoder.
+   *
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public ChunkedDecoder() {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      throw new IllegalStateException("Chunked decoding requires the native library");
+    }
+    this.handle = NativeOptimizer.nativeChunkedDecoderCreate();
+    if (handle == 0) {
+      throw new IllegalStateException("Failed to allocate native chunked decoder");
+    }
+  }
+
+  /**
+   * Decodes the next part of a chunked body in place.
+   *
+   * @param buffer a direct buffer holding the encoded bytes
+   * @param offset the offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @return the number of data bytes now at {@code offset}
+   * @throws IOException if the framing is malformed
+   */
+  public int decode(ByteBuffer buffer, int offset, int length) throws IOException {
+    if (handle == 0) {
+      throw new IllegalStateException("Chunked decoder is closed");
+    }
+    long result = NativeOptimizer.nativeChunkedDecode(handle, buffer, offset, length);
+    if (result < 0) {
+      int code = (int) -result;
+      String reason = code < ERROR_REASONS.length ? ERROR_REASONS[code] : ERROR_REASONS[0];
+      throw new IOException("Malformed chunked body: " + reason);
+    }
+    consumed = (int) (result & FIELD_MASK);
+    complete = ((result >>> COMPLETE_SHIFT) & 1) != 0;
+    return (int) ((result >>> PRODUCED_SHIFT) & FIELD_MASK);
+  }
+
+  /**
+   * Gets the number of encoded bytes the last {@link #decode} call consumed. This is less than the
+   * length passed in only when the body ended early; the remaining bytes follow the body.
+   *
+   * @return the bytes consumed
+   */
+  public int consumed() {
+    return consumed;
+  }
+
+  /**
+   * Checks whether the last chunk and the trailer section have been read.
+   *
+   * @return true if the body is complete
+   */
+  public boolean isComplete() {
+    return complete;
+  }
+
+  /**
+   * Gets the trailer fields of a complete body. Can be called once per body.
+   *
+   * @return the trailer fields, or null if there were none or the body is not complete
+   */
+  public NativeHeaderMap trailers() {
+    if (handle == 0 || !complete) {
+      return null;
+    }
+    long headersId = NativeOptimizer.nativeChunkedDecoderTrailers(handle);
+    if (headersId == 0) {
+      return null;
+    }
+    try {
+      return NativeHeaderMap.export(headersId);
+    } finally {
+      NativeOptimizer.nativeFreeHeaders(headersId);
+    }
+  }
+
+  /** Prepares the decoder for the next body on the same connection. */
+  public void reset() {
+    if (handle != 0) {
+      NativeOptimizer.nativeChunkedDecoderReset(handle);
+    }
+    consumed = 0;
+    complete = false;
+  }
+
+  /** Releases the native decoder. */
+  @Override
+  public void close() {
+    if (handle != 0) {
+      NativeOptimizer.nativeChunkedDecoderFree(handle);
+      handle = 0;
+    }
+  }
+}
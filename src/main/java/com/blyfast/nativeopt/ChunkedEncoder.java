@@ -0,0 +1,135 @@
+package com.blyfast.nativeopt;
+
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Chunked transfer coding for streaming responses.
+ *
+ * <p>Data is framed where it already lies: callers leave {@link #HEADROOM} bytes free before the
+ * data and {@link #TAILROOM} bytes after it, and {@link #frame} writes the size line and CRLF
+ * around it. Each chunk is then one contiguous slice that can be written to the channel as is,
+ * whatever the buffer boundaries of the stream. A Java implementation is used when the native
+ * library is unavailable.
+ */
+public final class ChunkedEncoder {
+  /** Bytes to reserve before chunk data: up to eight hex digits plus CRLF. */
+  public static final int HEADROOM = 10;
+
+  /** Bytes to reserve after chunk data for its CRLF. */
+  public static final int TAILROOM = 2;
+
+  private static final byte[] HEX_DIGITS = "0123456789abcdef".getBytes(StandardCharsets.US_ASCII);
+  private static final ByteBuffer LAST_CHUNK =
+      ByteBuffer.wrap("0\r\n\r\n".getBytes(StandardCharsets.US_ASCII)).asReadOnlyBuffer();
+
+  private static final boolean nativeAvailable = NativeOptimizer.isNativeOptimizationAvailable();
+
+  private ChunkedEncoder() {}
+
+  /**
+   * Frames data as one chunk.
+   *
+   * @param buffer the buffer holding the data, direct for the native path
+   * @param dataOffset the offset of the data; at least {@link #HEADROOM} bytes may be overwritten
+   *     before it
+   * @param dataLength the length of the data, greater than 0
+   * @return a view of the framed chunk, sharing the buffer's content
+   * @throws IllegalArgumentException if the data is empty or there is no room for the framing
+   */
+  public static ByteBuffer frame(ByteBuffer buffer, int dataOffset, int dataLength) {
+    int start =
+        nativeAvailable && buffer.isDirect()
+            ? NativeOptimizer.nativeChunkedFrame(buffer, dataOffset, dataLength)
+            : javaFrame(buffer, dataOffset, dataLength);
+    if (start < 0) {
+      throw new IllegalArgumentException("No room to frame " + dataLength + " bytes as a chunk");
+    }
+    ByteBuffer chunk = buffer.duplicate();
+    chunk.limit(dataOffset + dataLength + TAILROOM).position(start);
+    return chunk;
+  }
+
+  /**
+   * Serializes the last chunk that ends a chunked body.
+   *
+   * @param trailers trailer fields as alternating names and values
+   * @return the serialized last chunk and trailer section
+   * @throws IllegalArgumentException if the trailers are unbalanced or contain CR/LF
+   */
+  public static ByteBuffer lastChunk(String... trailers) {
+    if (trailers.length == 0) {
+      return LAST_CHUNK.duplicate();
+    }
+    if (trailers.length % 2 != 0) {
+      throw new IllegalArgumentException("Expected alternating trailer names and values");
+    }
+
+    if (nativeAvailable) {
+      // Encoded here rather than read as modified UTF-8 in native code, so both paths produce
+      // the same bytes
+      int[] trailerLengths = new int[trailers.length];
+      byte[][] encoded = new byte[trailers.length][];
+      int textLength = 0;
+      for (int i = 0; i < trailers.length; i++) {
+        encoded[i] = trailers[i].getBytes(StandardCharsets.UTF_8);
+        trailerLengths[i] = encoded[i].length;
+        textLength += encoded[i].length;
+      }
+      byte[] trailerText = new byte[textLength];
+      int pos = 0;
+      for (byte[] bytes : encoded) {
+        System.arraycopy(bytes, 0, trailerText, pos, bytes.length);
+        pos += bytes.length;
+      }
+
+      ByteBuffer out = ByteBuffer.allocateDirect(3 + textLength + trailers.length * 2 + 2);
+      int written =
+          NativeOptimizer.nativeChunkedWriteLastChunk(out, 0, trailerText, trailerLengths);
+      if (written <= 0) {
+        throw new IllegalArgumentException("Invalid trailer fields");
+      }
+      out.limit(written);
+      return out;
+    }
+
+    StringBuilder out = new StringBuilder("0\r\n");
+    for (int i = 0; i < trailers.length; i += 2) {
+      String name = trailers[i];
+      String value = trailers[i + 1];
+      if (name.isEmpty() || hasLineBreak(name) || hasLineBreak(value)) {
+        throw new IllegalArgumentException("Invalid trailer field: " + name);
+      }
+      out.append(name).append(": ").append(value).append("\r\n");
+    }
+    out.append("\r\n");
+    return ByteBuffer.wrap(out.toString().getBytes(StandardCharsets.UTF_8));
+  }
+
+  private static int javaFrame(ByteBuffer buffer, int dataOffset, int dataLength) {
+    if (dataLength <= 0
+        || dataOffset < 0
+        || (long) dataOffset + dataLength + TAILROOM > buffer.capacity()) {
+      return -1;
+    }
+    int digits = (32 - Integer.numberOfLeadingZeros(dataLength) + 3) / 4;
+    int start = dataOffset - digits - 2;
+    if (start < 0) {
+      return -1;
+    }
+
+    for (int i = 0; i < digits; i++) {
+      int shift = (digits - 1 - i) * 4;
+      buffer.put(start + i, HEX_DIGITS[(dataLength >>> shift) & 0xF]);
+    }
+    buffer.put(dataOffset - 2, (byte) '\r');
+    buffer.put(dataOffset - 1, (byte) '\n');
+    buffer.put(dataOffset + dataLength, (byte) '\r');
+    buffer.put(dataOffset + dataLength + 1, (byte) '\n');
+    return start;
+  }
+
+  private static boolean hasLineBreak(String s) {
+    return s.indexOf('\r') >= 0 || s.indexOf('\n') >= 0;
+  }
+}
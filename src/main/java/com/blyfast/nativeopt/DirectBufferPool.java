@@ -0,0 +1,356 @@
+package com.blyfast.nativeopt;
+
+import java.lang.ref.Cleaner;
+import java.nio.ByteBuffer;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Native pool of direct buffers, for request bodies and other per-request buffers.
+ *
+ * <p>{@link ByteBuffer#allocateDirect} on every request costs a zeroed allocation, fresh page
+ * faults and a Cleaner that frees the memory only after a garbage collection, all counted against
+ * {@code -XX:MaxDirectMemorySize}. Buffers from this pool come in power-of-two sizes from {@link
+ * #MIN_BLOCK_SIZE} to {@link #MAX_BLOCK_SIZE}, are released explicitly, and are reused: from a
+ * small cache of the releasing thread, or from shared free lists. They are not zeroed.
+ *
+ * <p>A buffer is held through a {@link Lease}, which is the only way to return it. The pool checks
+ * each release against the lease's generation of the block, so releasing twice, or after the
+ * block was handed out again, is refused rather than freeing another holder's buffer. A lease that
+ * is never released is reclaimed once its buffer is garbage collected, so a missed release delays
+ * reuse of the block but does not take its memory out of the budget for good.
+ *
+ * <p>Memory mapped by the pool is bounded by a global budget, {@link #DEFAULT_BUDGET} unless set
+ * with the {@code blyfast.bufferPool.budget} system property (in bytes) or {@link #setBudget}.
+ * When the budget is exhausted, {@link #acquire} returns null rather than allocating more.
+ */
+public final class DirectBufferPool {
+  /** Capacity of the smallest buffer. */
+  public static final int MIN_BLOCK_SIZE = 4 * 1024;
+
+  /** Capacity of the largest buffer. */
+  public static final int MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+  /** Budget used unless configured otherwise. */
+  public static final long DEFAULT_BUDGET = 256L * 1024 * 1024;
+
+  private static final int SIZE_CLASSES = 13;
+  private static final int STAT_COUNT = 10 + SIZE_CLASSES;
+
+  private static final boolean nativeAvailable = NativeOptimizer.isNativeOptimizationAvailable();
+
+  // Created on the first acquisition
+  private static volatile Cleaner cleaner;
+
+  static {
+    if (nativeAvailable) {
+      NativeOptimizer.nativeBufferPoolSetBudget(
+          Long.getLong("blyfast.bufferPool.budget", DEFAULT_BUDGET));
+    }
+  }
+
+  private DirectBufferPool() {}
+
+  /**
+   * Checks whether the pool can serve buffers of a given size.
+   *
+   * @param size the minimum capacity
+   * @return true if the native library is available and {@code size} is at most {@link
+   *     #MAX_BLOCK_SIZE}
+   */
+  public static boolean canPool(int size) {
+    return nativeAvailable && size >= 0 && size <= MAX_BLOCK_SIZE;
+  }
+
+  /**
+   * Acquires a buffer, which should be returned with {@link Lease#release} once it is no longer
+   * used. A buffer that is not released goes back to the pool only after it is garbage collected.
+   *
+   * @param size the minimum capacity
+   * @return the lease of a buffer with position 0 and its limit at its capacity, which is {@code
+   *     size} rounded up to a power of two of at least {@link #MIN_BLOCK_SIZE}; or null if the
+   *     pool cannot serve {@code size} (see {@link #canPool}) or the budget is exhausted
+   */
+  public static Lease acquire(int size) {
+    if (!canPool(size)) {
+      return null;
+    }
+    long handle = NativeOptimizer.nativeBufferPoolAcquire(size);
+    if (handle == 0) {
+      return null;
+    }
+    ByteBuffer buffer = NativeOptimizer.nativeBufferPoolBuffer(handle);
+    if (buffer == null) {
+      NativeOptimizer.nativeBufferPoolRelease(handle);
+      return null;
+    }
+    Reclaim reclaim = new Reclaim(handle);
+    return new Lease(buffer, reclaim, cleaner().register(buffer, reclaim));
+  }
+
+  /**
+   * Sets the budget for memory mapped by the pool, returning free memory to the OS if more is
+   * mapped. Buffers in use are not affected.
+   *
+   * @param bytes the budget
+   */
+  public static void setBudget(long bytes) {
+    if (bytes < 0) {
+      throw new IllegalArgumentException("budget must not be negative");
+    }
+    if (nativeAvailable) {
+      NativeOptimizer.nativeBufferPoolSetBudget(bytes);
+    }
+  }
+
+  /**
+   * Returns the memory of free buffers on the shared lists to the OS.
+   *
+   * @return the number of bytes released
+   */
+  public static long trim() {
+    return nativeAvailable ? NativeOptimizer.nativeBufferPoolTrim() : 0;
+  }
+
+  /**
+   * Moves the buffers cached by the current thread to the shared lists, where other threads can
+   * reuse them and {@link #trim} can release them. Threads do this when they exit.
+   */
+  public static void flushThreadCache() {
+    if (nativeAvailable) {
+      NativeOptimizer.nativeBufferPoolFlushThreadCache();
+    }
+  }
+
+  /**
+   * Reads the pool statistics.
+   *
+   * @return the statistics, all zero if native optimizations are unavailable
+   */
+  public static Stats stats() {
+    long[] values = new long[STAT_COUNT];
+    if (nativeAvailable) {
+      NativeOptimizer.nativeBufferPoolStats(values);
+    }
+    return new Stats(values);
+  }
+
+  private static Cleaner cleaner() {
+    Cleaner c = cleaner;
+    if (c == null) {
+      synchronized (DirectBufferPool.class) {
+        c = cleaner;
+        if (c == null) {
+          cleaner = c = Cleaner.create();
+        }
+      }
+    }
+    return c;
+  }
+
+  // Returns a block once its buffer is unreachable, unless the lease took the handle to release
+  // it explicitly. Must not refer to the buffer or the lease, which would keep them reachable
+  private static final class Reclaim implements Runnable {
+    private final AtomicLong handle;
+
+    Reclaim(long handle) {
+      this.handle = new AtomicLong(handle);
+    }
+
+    long take() {
+      return handle.getAndSet(0);
+    }
+
+    @Override
+    public void run() {
+      long h = take();
+      if (h != 0) {
+        NativeOptimizer.nativeBufferPoolRelease(h);
+        // The cleaner thread never acquires, so hand the block to threads that do
+        NativeOptimizer.nativeBufferPoolFlushThreadCache();
+      }
+    }
+  }
+
+  /** A buffer acquired from the pool, and the right to return it. */
+  public static final class Lease implements AutoCloseable {
+    private final ByteBuffer buffer;
+    private final Reclaim reclaim;
+    private final Cleaner.Cleanable cleanable;
+    private final AtomicBoolean settled = new AtomicBoolean();
+
+    private Lease(ByteBuffer buffer, Reclaim reclaim, Cleaner.Cleanable cleanable) {
+      this.buffer = buffer;
+      this.reclaim = reclaim;
+      this.cleanable = cleanable;
+    }
+
+    /**
+     * Gets the buffer.
+     *
+     * @return the buffer, which must not be used after the lease is released
+     */
+    public ByteBuffer buffer() {
+      return buffer;
+    }
+
+    /**
+     * Returns the buffer to the pool. Neither the buffer nor any view of it may be used
+     * afterwards: its memory is handed out again.
+     *
+     * @return true if the buffer was returned, false if this lease was already released
+     */
+    public boolean release() {
+      if (!settled.compareAndSet(false, true)) {
+        return false;
+      }
+      long h = reclaim.take();
+      cleanable.clean(); // Unregisters; the handle is already taken
+      return h != 0 && NativeOptimizer.nativeBufferPoolRelease(h);
+    }
+
+    /**
+     * Returns the buffer to the pool once the garbage collector finds it unreachable, for buffers
+     * that may still be read through views. Slices, duplicates and read-only views of the buffer
+     * keep it reachable, so the block is not handed out again while any of them is in use. The
+     * lease can no longer be released explicitly afterwards.
+     *
+     * @return true if the release was deferred, false if this lease was already released
+     */
+    public boolean releaseWhenUnreachable() {
+      // Every lease is reclaimed when its buffer is unreachable; this only gives up the explicit
+      // release
+      return settled.compareAndSet(false, true);
+    }
+
+    /** Releases the buffer, like {@link #release}. */
+    @Override
+    public void close() {
+      release();
+    }
+  }
+
+  /** Snapshot of the pool statistics. */
+  public static final class Stats {
+    private final long[] values;
+
+    private Stats(long[] values) {
+      this.values = values;
+    }
+
+    /** Budget for mapped memory, in bytes. */
+    public long getBudget() {
+      return values[0];
+    }
+
+    /** Memory mapped by the pool, in use or cached, in bytes. */
+    public long getReservedBytes() {
+      return values[1];
+    }
+
+    /** Memory of buffers in use, in bytes. */
+    public long getInUseBytes() {
+      return values[2];
+    }
+
+    /** Highest memory in use at once, in bytes. */
+    public long getPeakInUseBytes() {
+      return values[3];
+    }
+
+    /** Buffers acquired. */
+    public long getAcquired() {
+      return values[4];
+    }
+
+    /** Acquisitions served from the acquiring thread's cache. */
+    public long getThreadCacheHits() {
+      return values[5];
+    }
+
+    /** Acquisitions served from the shared free lists. */
+    public long getSharedHits() {
+      return values[6];
+    }
+
+    /** Buffers mapped from the OS. */
+    public long getMapped() {
+      return values[7];
+    }
+
+    /** Acquisitions refused because the budget was exhausted. */
+    public long getRejected() {
+      return values[8];
+    }
+
+    /** Free buffers returned to the OS. */
+    public long getTrimmed() {
+      return values[9];
+    }
+
+    /**
+     * Gets the number of buffers in use of one size class.
+     *
+     * @param capacity the capacity of the class, a power of two from {@link #MIN_BLOCK_SIZE} to
+     *     {@link #MAX_BLOCK_SIZE}
+     * @return the number of buffers
+     */
+    public long getInUse(int capacity) {
+      int sizeClass = Integer.numberOfTrailingZeros(capacity) - 12;
+      if (Integer.bitCount(capacity) != 1 || sizeClass < 0 || sizeClass >= SIZE_CLASSES) {
+        throw new IllegalArgumentException("Not a buffer pool size class: " + capacity);
+      }
+      return values[10 + sizeClass];
+    }
+
+    /**
+     * Gets the share of the budget in use.
+     *
+     * @return the occupancy between 0 and 1, or 0 without a budget
+     */
+    public double getOccupancy() {
+      return getBudget() > 0 ? Math.min(1.0, (double) getInUseBytes() / getBudget()) : 0;
+    }
+
+    /**
+     * Gets the share of acquisitions served without mapping memory.
+     *
+     * @return the reuse rate between 0 and 1
+     */
+    public double getReuseRate() {
+      long acquired = getAcquired();
+      return acquired > 0 ? (double) (getThreadCacheHits() + getSharedHits()) / acquired : 0;
+    }
+
+    /**
+     * Converts the statistics to a map for monitoring output.
+     *
+     * @return the statistics by name, with buffers in use by size class under {@code inUseByClass}
+     */
+    public Map<String, Object> toMap() {
+      Map<String, Object> map = new LinkedHashMap<>();
+      map.put("budget", getBudget());
+      map.put("reservedBytes", getReservedBytes());
+      map.put("inUseBytes", getInUseBytes());
+      map.put("peakInUseBytes", getPeakInUseBytes());
+      map.put("occupancy", getOccupancy());
+      map.put("acquired", getAcquired());
+      map.put("threadCacheHits", getThreadCacheHits());
+      map.put("sharedHits", getSharedHits());
+      map.put("reuseRate", getReuseRate());
+      map.put("mapped", getMapped());
+      map.put("rejected", getRejected());
+      map.put("trimmed", getTrimmed());
+      Map<String, Object> byClass = new LinkedHashMap<>();
+      for (int c = 0; c < SIZE_CLASSES; c++) {
+        if (values[10 + c] != 0) {
+          byClass.put(String.valueOf(MIN_BLOCK_SIZE << c), values[10 + c]);
+        }
+      }
+      map.put("inUseByClass", byClass);
+      return map;
+    }
+  }
+}
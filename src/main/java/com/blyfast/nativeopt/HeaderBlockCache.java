@@ -0,0 +1,124 @@
+package com.blyfast.nativeopt;
+
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * Controls the native header block dedup cache.
+ *
+ * <p>Keep-alive clients such as internal services often send identical header blocks on every
+ * request, except for a few fields like a request ID. With the cache enabled, a block that repeats
+ * apart from the volatile headers reuses the parsed and indexed set from its first occurrence, and
+ * only the volatile lines are parsed again. Headers from such a set are listed volatile ones
+ * first. The cache is global and disabled by default.
+ */
+public final class HeaderBlockCache {
+  private static final int STAT_COUNT = 5;
+
+  private HeaderBlockCache() {}
+
+  /**
+   * Enables the cache, replacing any previous configuration and clearing the statistics.
+   *
+   * @param entries the number of distinct header blocks to keep (rounded up to a power of two)
+   * @param volatileHeaders names of headers that change on every request
+   * @return true if the cache was enabled
+   */
+  public static boolean enable(int entries, String... volatileHeaders) {
+    if (entries <= 0) {
+      throw new IllegalArgumentException("entries must be positive");
+    }
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      return false;
+    }
+    return NativeOptimizer.nativeConfigureHeaderCache(entries, volatileHeaders) > 0;
+  }
+
+  /** Disables the cache and releases the cached header sets. */
+  public static void disable() {
+    if (NativeOptimizer.isNativeOptimizationAvailable()) {
+      NativeOptimizer.nativeConfigureHeaderCache(0, null);
+    }
+  }
+
+  /**
+   * Reads the cache statistics since it was last enabled.
+   *
+   * @return the statistics, all zero if native optimizations are unavailable
+   */
+  public static Stats stats() {
+    long[] values = new long[STAT_COUNT];
+    if (NativeOptimizer.isNativeOptimizationAvailable()) {
+      NativeOptimizer.nativeHeaderCacheStats(values);
+    }
+    return new Stats(values[0], values[1], values[2], values[3], values[4]);
+  }
+
+  /** Snapshot of the cache statistics. */
+  public static final class Stats {
+    private final long hits;
+    private final long misses;
+    private final long bypasses;
+    private final long evictions;
+    private final long bytesReused;
+
+    private Stats(long hits, long misses, long bypasses, long evictions, long bytesReused) {
+      this.hits = hits;
+      this.misses = misses;
+      this.bypasses = bypasses;
+      this.evictions = evictions;
+      this.bytesReused = bytesReused;
+    }
+
+    /** Blocks served from the cache. */
+    public long getHits() {
+      return hits;
+    }
+
+    /** Blocks parsed and added to the cache. */
+    public long getMisses() {
+      return misses;
+    }
+
+    /** Blocks parsed without the cache: too many lines, or nothing but volatile headers. */
+    public long getBypasses() {
+      return bypasses;
+    }
+
+    /** Cached blocks replaced by a different block hashing to the same slot. */
+    public long getEvictions() {
+      return evictions;
+    }
+
+    /** Header bytes that did not have to be parsed thanks to cache hits. */
+    public long getBytesReused() {
+      return bytesReused;
+    }
+
+    /**
+     * Gets the share of cacheable blocks that were hits.
+     *
+     * @return the hit rate between 0 and 1
+     */
+    public double getHitRate() {
+      long lookups = hits + misses;
+      return lookups > 0 ? (double) hits / lookups : 0;
+    }
+
+    /**
+     * Converts the statistics to a map for monitoring output.
+     *
+     * @return the statistics by name
+     */
+    public Map<String, Object> toMap() {
+      Map<String, Object> map = new LinkedHashMap<>();
+      map.put("hits", hits);
+      map.put("misses", misses);
+      map.put("bypasses", bypasses);
+      map.put("evictions", evictions);
+      map.put("bytesReused", bytesReused);
+      map.put("hitRate", getHitRate());
+      return map;
+    }
+  }
+}
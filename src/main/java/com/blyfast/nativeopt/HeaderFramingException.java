@@ -0,0 +1,232 @@
+package com.blyfast.nativeopt;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+/**
+ * Signals a request header block whose message framing is ambiguous or malformed. Such requests
+ * must be answered with 400 Bad Request before any body is read, since intermediaries may disagree
+ * about where the body ends.
+ *
+ * <p>The codes match those returned negated by {@link
+ * NativeOptimizer#nativeParseHttpHeadersStrict}. The rules are those of the native header scanner;
+ * {@link #check} applies them in Java only when the native library is unavailable.
+ */
+public class HeaderFramingException extends IOException {
+  private static final long serialVersionUID = 1L;
+
+  /** A CR not followed by LF. */
+  public static final int BARE_CR = 1;
+
+  /** A line folded onto the previous one (obs-fold). */
+  public static final int OBS_FOLD = 2;
+
+  /** A NUL byte in the header block. */
+  public static final int NUL = 3;
+
+  /** A line without a colon, with an empty name, or with whitespace before the colon. */
+  public static final int INVALID_FIELD = 4;
+
+  /** More than one Content-Length field. */
+  public static final int DUPLICATE_CONTENT_LENGTH = 5;
+
+  /** A Content-Length value that is not a plain decimal number. */
+  public static final int INVALID_CONTENT_LENGTH = 6;
+
+  /** Content-Length together with Transfer-Encoding. */
+  public static final int CONTENT_LENGTH_WITH_TRANSFER_ENCODING = 7;
+
+  private static final int BAD_REQUEST = 400;
+
+  private static final String[] REASONS = {
+    "Invalid header framing",
+    "Bare CR in header block",
+    "Obsolete line folding in header block",
+    "NUL byte in header block",
+    "Malformed header field",
+    "Duplicate Content-Length",
+    "Invalid Content-Length",
+    "Content-Length with Transfer-Encoding"
+  };
+
+  private final int code;
+
+  /**
+   * Creates an exception for a framing error code.
+   *
+   * @param code the error code
+   */
+  public HeaderFramingException(int code) {
+    super(reason(code));
+    this.code = code;
+  }
+
+  /**
+   * Gets the framing error code.
+   *
+   * @return the error code
+   */
+  public int getCode() {
+    return code;
+  }
+
+  /**
+   * Gets the HTTP status code the request should be answered with.
+   *
+   * @return 400
+   */
+  public int getStatusCode() {
+    return BAD_REQUEST;
+  }
+
+  /**
+   * Describes a framing error code.
+   *
+   * @param code the error code
+   * @return a short description, suitable for an error response
+   */
+  public static String reason(int code) {
+    return code > 0 && code < REASONS.length ? REASONS[code] : REASONS[0];
+  }
+
+  /**
+   * Checks a header block for ambiguous framing without parsing it, with the rules of {@link
+   * #parseStrict}: no bare CR, NUL or obs-fold, well-formed field lines, and a single all-digit
+   * Content-Length that never appears together with Transfer-Encoding.
+   *
+   * @param headerBytes the header bytes, without the request line; direct for the native scanner
+   * @param length the length of the data
+   * @return the error code, or 0 if the framing is unambiguous
+   * @throws IllegalArgumentException if {@code length} exceeds the buffer
+   */
+  public static int check(ByteBuffer headerBytes, int length) {
+    if (length < 0 || length > headerBytes.capacity()) {
+      throw new IllegalArgumentException("Invalid header block length: " + length);
+    }
+    if (headerBytes.isDirect() && NativeOptimizer.isNativeOptimizationAvailable()) {
+      return NativeOptimizer.nativeCheckHeaderFraming(headerBytes, length);
+    }
+    return javaCheck(headerBytes, length);
+  }
+
+  // Fallback for check, line by line like findHeaderLineEnd and checkHeaderFraming in native code
+  static int javaCheck(ByteBuffer block, int length) {
+    int contentLengths = 0;
+    int transferEncodings = 0;
+    int pos = 0;
+    while (pos < length) {
+      int lineEnd = pos;
+      while (lineEnd < length) {
+        byte b = block.get(lineEnd);
+        if (b == '\r' || b == '\n') {
+          break;
+        }
+        if (b == 0) {
+          return NUL;
+        }
+        lineEnd++;
+      }
+      if (lineEnd < length
+          && block.get(lineEnd) == '\r'
+          && (lineEnd + 1 == length || block.get(lineEnd + 1) != '\n')) {
+        return BARE_CR;
+      }
+
+      if (lineEnd > pos) {
+        byte first = block.get(pos);
+        if (first == ' ' || first == '\t') {
+          return OBS_FOLD;
+        }
+        int colon = pos;
+        while (colon < lineEnd && block.get(colon) != ':') {
+          colon++;
+        }
+        if (colon == lineEnd
+            || colon == pos
+            || block.get(colon - 1) == ' '
+            || block.get(colon - 1) == '\t') {
+          return INVALID_FIELD;
+        }
+
+        if (isName(block, pos, colon, "content-length")) {
+          if (++contentLengths > 1) {
+            return DUPLICATE_CONTENT_LENGTH;
+          }
+          int value = colon + 1;
+          int valueEnd = lineEnd;
+          while (value < valueEnd && isBlank(block.get(value))) {
+            value++;
+          }
+          while (valueEnd > value && isBlank(block.get(valueEnd - 1))) {
+            valueEnd--;
+          }
+          if (value == valueEnd) {
+            return INVALID_CONTENT_LENGTH;
+          }
+          for (int i = value; i < valueEnd; i++) {
+            byte b = block.get(i);
+            if (b < '0' || b > '9') {
+              return INVALID_CONTENT_LENGTH;
+            }
+          }
+        } else if (isName(block, pos, colon, "transfer-encoding")) {
+          transferEncodings++;
+        }
+        if (contentLengths > 0 && transferEncodings > 0) {
+          return CONTENT_LENGTH_WITH_TRANSFER_ENCODING;
+        }
+      }
+
+      if (lineEnd < length && block.get(lineEnd) == '\r') {
+        lineEnd++;
+      }
+      if (lineEnd < length && block.get(lineEnd) == '\n') {
+        lineEnd++;
+      }
+      pos = lineEnd;
+    }
+    return 0;
+  }
+
+  private static boolean isBlank(byte b) {
+    return b == ' ' || b == '\t';
+  }
+
+  // Case-insensitive comparison with a lowercase ASCII name
+  private static boolean isName(ByteBuffer block, int start, int end, String name) {
+    if (end - start != name.length()) {
+      return false;
+    }
+    for (int i = 0; i < name.length(); i++) {
+      int b = block.get(start + i);
+      if (b >= 'A' && b <= 'Z') {
+        b += 'a' - 'A';
+      }
+      if (b != name.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Parses a header block, rejecting ambiguous framing.
+   *
+   * @param headerBytes a direct buffer holding the header bytes, without the request line
+   * @param length the length of the data
+   * @return the ID of the parsed headers, to be released with {@link
+   *     NativeOptimizer#nativeFreeHeaders}, or 0 if the block could not be stored
+   * @throws HeaderFramingException if the framing is invalid
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public static long parseStrict(ByteBuffer headerBytes, int length) throws HeaderFramingException {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      throw new IllegalStateException("Strict header parsing requires the native library");
+    }
+    long result = NativeOptimizer.nativeParseHttpHeadersStrict(headerBytes, length);
+    if (result < 0) {
+      throw new HeaderFramingException((int) -result);
+    }
+    return result;
+  }
+}
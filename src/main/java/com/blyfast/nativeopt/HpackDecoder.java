@@ -0,0 +1,116 @@
+package com.blyfast.nativeopt;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+/**
+ * Per-connection HPACK decoder for HTTP/2 header blocks, backed by the native library.
+ *
+ * <p>The dynamic table is connection state, so header blocks must be decoded in the order they
+ * were received and from one thread at a time. Any decoding error is a connection-level
+ * COMPRESSION_ERROR: the decoder is no longer in sync with the peer and must not be reused.
+ */
+public final class HpackDecoder implements AutoCloseable {
+  /** Default SETTINGS_HEADER_TABLE_SIZE from RFC 7540. */
+  public static final int DEFAULT_TABLE_SIZE = 4096;
+
+  private static final String[] ERROR_REASONS = {
+    "unknown error",
+    "truncated header block",
+    "integer overflow",
+    "invalid table index",
+    "invalid Huffman code",
+    "invalid dynamic table size update",
+    "string literal too long",
+    "out of memory",
+    "no free header slot"
+  };
+
+  private long handle;
+
+  /**
+   * Creates a decoder with the default table size.
+   *
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public HpackDecoder() {
+    this(DEFAULT_TABLE_SIZE);
+  }
+
+  /**
+   * Creates a decoder.
+   *
+   * @param maxTableSize the SETTINGS_HEADER_TABLE_SIZE advertised to the peer
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public HpackDecoder(int maxTableSize) {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      throw new IllegalStateException("HPACK decoding requires the native library");
+    }
+    this.handle = NativeOptimizer.nativeHpackDecoderCreate(maxTableSize);
+    if (handle == 0) {
+      throw new IllegalStateException("Failed to allocate native HPACK decoder");
+    }
+  }
+
+  /**
+   * Decodes a complete header block (a HEADERS payload plus any CONTINUATION payloads).
+   *
+   * @param block a direct buffer holding the header block
+   * @param offset the offset of the block in the buffer
+   * @param length the length of the block
+   * @return the headers ID; release it with {@link NativeOptimizer#nativeFreeHeaders(long)}
+   * @throws IOException if the block is malformed (COMPRESSION_ERROR)
+   */
+  public long decode(ByteBuffer block, int offset, int length) throws IOException {
+    if (handle == 0) {
+      throw new IllegalStateException("HPACK decoder is closed");
+    }
+    long result = NativeOptimizer.nativeHpackDecode(handle, block, offset, length);
+    if (result < 0) {
+      int code = (int) -result;
+      String reason = code < ERROR_REASONS.length ? ERROR_REASONS[code] : ERROR_REASONS[0];
+      throw new IOException("HPACK COMPRESSION_ERROR: " + reason);
+    }
+    return result;
+  }
+
+  /**
+   * Decodes a header block and exports it in one step.
+   *
+   * @param block a direct buffer holding the header block
+   * @param offset the offset of the block in the buffer
+   * @param length the length of the block
+   * @return the decoded headers
+   * @throws IOException if the block is malformed (COMPRESSION_ERROR)
+   */
+  public NativeHeaderMap decodeToMap(ByteBuffer block, int offset, int length)
+      throws IOException {
+    long headersId = decode(block, offset, length);
+    try {
+      return NativeHeaderMap.export(headersId);
+    } finally {
+      NativeOptimizer.nativeFreeHeaders(headersId);
+    }
+  }
+
+  /**
+   * Applies a new SETTINGS_HEADER_TABLE_SIZE value acknowledged by the peer.
+   *
+   * @param maxTableSize the new maximum size in bytes
+   */
+  public void setMaxTableSize(int maxTableSize) {
+    if (handle != 0) {
+      NativeOptimizer.nativeHpackDecoderSetMaxTableSize(handle, maxTableSize);
+    }
+  }
+
+  /** Releases the native decoder. */
+  @Override
+  public void close() {
+    if (handle != 0) {
+      NativeOptimizer.nativeHpackDecoderFree(handle);
+      handle = 0;
+    }
+  }
+}
@@ -0,0 +1,141 @@
+package com.blyfast.nativeopt;
+
+import com.blyfast.middleware.CommonMiddleware;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Per-connection HPACK encoder for HTTP/2 response header blocks, backed by the native library.
+ *
+ * <p>Header sets that repeat on most responses can be registered once with {@link
+ * #registerHeaderSet(String...)}. The first response on a connection inserts them into the dynamic
+ * table; later responses refer to them with one-byte indexed fields.
+ *
+ * <p>Like the peer's decoder, an encoder is connection state: blocks must be encoded in the order
+ * they are sent, from one thread at a time.
+ */
+public final class HpackEncoder implements AutoCloseable {
+  private static final int INITIAL_BUFFER_SIZE = 4 * 1024;
+
+  private static volatile int jsonResponseHeaders;
+
+  private long handle;
+  private ByteBuffer buffer = ByteBuffer.allocateDirect(INITIAL_BUFFER_SIZE);
+
+  /**
+   * Creates an encoder for a peer using the default table size.
+   *
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public HpackEncoder() {
+    this(HpackDecoder.DEFAULT_TABLE_SIZE);
+  }
+
+  /**
+   * Creates an encoder.
+   *
+   * @param maxTableSize the peer's SETTINGS_HEADER_TABLE_SIZE
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public HpackEncoder(int maxTableSize) {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      throw new IllegalStateException("HPACK encoding requires the native library");
+    }
+    this.handle = NativeOptimizer.nativeHpackEncoderCreate(maxTableSize);
+    if (handle == 0) {
+      throw new IllegalStateException("Failed to allocate native HPACK encoder");
+    }
+  }
+
+  /**
+   * Registers a header set shared by all encoders.
+   *
+   * @param namesAndValues alternating header names and values
+   * @return the header set ID
+   * @throws IllegalStateException if the set cannot be registered
+   */
+  public static int registerHeaderSet(String... namesAndValues) {
+    int id = NativeOptimizer.nativeHpackRegisterHeaderSet(namesAndValues);
+    if (id == 0) {
+      throw new IllegalStateException("Failed to register HPACK header set");
+    }
+    return id;
+  }
+
+  /**
+   * Gets the header set for JSON responses: {@code content-type: application/json} plus the
+   * headers added by {@link CommonMiddleware#securityHeaders()}.
+   *
+   * @return the header set ID
+   */
+  public static int jsonResponseHeaders() {
+    int id = jsonResponseHeaders;
+    if (id == 0) {
+      synchronized (HpackEncoder.class) {
+        id = jsonResponseHeaders;
+        if (id == 0) {
+          List<String> headers = new ArrayList<>();
+          headers.add("content-type");
+          headers.add("application/json");
+          for (Map.Entry<String, String> header : CommonMiddleware.SECURITY_HEADERS.entrySet()) {
+            headers.add(header.getKey());
+            headers.add(header.getValue());
+          }
+          id = registerHeaderSet(headers.toArray(new String[0]));
+          jsonResponseHeaders = id;
+        }
+      }
+    }
+    return id;
+  }
+
+  /**
+   * Encodes a header block. Pseudo-header fields such as {@code :status} among the additional
+   * headers are emitted first, ahead of the registered set, as RFC 7540 section 8.1.2.1 requires.
+   *
+   * @param headerSetId a registered header set, or 0 for none
+   * @param namesAndValues additional headers as alternating names and values
+   * @return the encoded block, valid until the next call on this encoder
+   */
+  public ByteBuffer encode(int headerSetId, String... namesAndValues) {
+    if (handle == 0) {
+      throw new IllegalStateException("HPACK encoder is closed");
+    }
+
+    int written = NativeOptimizer.nativeHpackEncode(handle, headerSetId, namesAndValues, buffer, 0);
+    if (written < 0) {
+      // Nothing was encoded; retry with room for the worst case
+      buffer = ByteBuffer.allocateDirect(-written);
+      written = NativeOptimizer.nativeHpackEncode(handle, headerSetId, namesAndValues, buffer, 0);
+    }
+    if (written <= 0 && (headerSetId != 0 || namesAndValues.length > 0)) {
+      throw new IllegalStateException("HPACK encoding failed");
+    }
+
+    ByteBuffer block = buffer.duplicate();
+    block.position(0).limit(Math.max(written, 0));
+    return block;
+  }
+
+  /**
+   * Applies a new SETTINGS_HEADER_TABLE_SIZE received from the peer.
+   *
+   * @param maxTableSize the new maximum size in bytes
+   */
+  public void setMaxTableSize(int maxTableSize) {
+    if (handle != 0) {
+      NativeOptimizer.nativeHpackEncoderSetMaxTableSize(handle, maxTableSize);
+    }
+  }
+
+  /** Releases the native encoder. */
+  @Override
+  public void close() {
+    if (handle != 0) {
+      NativeOptimizer.nativeHpackEncoderFree(handle);
+      handle = 0;
+    }
+  }
+}
@@ -0,0 +1,180 @@
+package com.blyfast.nativeopt;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Streaming {@code multipart/form-data} parser backed by the native library.
+ *
+ * <p>The body is passed in chunks as it is read, and parts are reported to a {@link Listener} as
+ * they are found: the start of each part with its name, filename and content type, its content as
+ * slices of the chunk buffer, and its end. Nothing is copied, so memory stays bounded by the read
+ * buffer whatever the size of the uploads. A call may leave bytes unconsumed at the end of a chunk
+ * (a split header block or what may be the start of a boundary); keep them and pass them again in
+ * front of the next chunk.
+ */
+public final class MultipartParser implements AutoCloseable {
+  private static final long FIELD_MASK = 0x7FFFFFFFL;
+  private static final int EVENTS_SHIFT = 31;
+  private static final int COMPLETE_SHIFT = 62;
+
+  private static final int EVENT_INTS = 7;
+  private static final int EVENT_CAPACITY = 64;
+  private static final int PART_BEGIN = 1;
+  private static final int DATA = 2;
+  private static final int PART_END = 3;
+
+  private static final String[] ERROR_REASONS = {
+    "unknown error", "invalid arguments", "invalid delimiter", "invalid part header",
+    "part headers too long"
+  };
+
+  /** Receives the parts of a multipart body as they are parsed. */
+  public interface Listener {
+    /**
+     * Called at the start of a part.
+     *
+     * @param name the form field name, or null if the part has none
+     * @param filename the filename for file uploads, or null
+     * @param contentType the part's content type, or null
+     * @throws IOException to abort parsing
+     */
+    void partBegin(String name, String filename, String contentType) throws IOException;
+
+    /**
+     * Called with the next slice of the current part's content. The bytes are only valid during
+     * the call.
+     *
+     * @param buffer the buffer holding the slice
+     * @param offset the absolute offset of the slice
+     * @param length the length of the slice
+     * @throws IOException to abort parsing
+     */
+    void partData(ByteBuffer buffer, int offset, int length) throws IOException;
+
+    /**
+     * Called at the end of a part.
+     *
+     * @throws IOException to abort parsing
+     */
+    void partEnd() throws IOException;
+  }
+
+  private final int[] events = new int[EVENT_CAPACITY * EVENT_INTS];
+  private long handle;
+  private boolean complete;
+
+  /**
+   * Creates a parser.
+   *
+   * @param boundary the boundary parameter of the Content-Type header
+   * @throws IllegalArgumentException if the boundary is empty or too long
+   * @throws IllegalStateException if native optimizations are unavailable
+   */
+  public MultipartParser(String boundary) {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      throw new IllegalStateException("Streaming multipart parsing requires the native library");
+    }
+    this.handle = NativeOptimizer.nativeMultipartParserCreate(boundary);
+    if (handle == 0) {
+      throw new IllegalArgumentException("Invalid multipart boundary");
+    }
+  }
+
+  /**
+   * Parses the next chunk of the body, reporting parts to the listener.
+   *
+   * @param buffer a direct buffer holding the chunk
+   * @param offset the offset of the chunk
+   * @param length the length of the chunk
+   * @param listener receives the parts
+   * @return the number of bytes consumed; the rest must be passed again with the next chunk
+   * @throws IOException if the body is malformed or the listener fails
+   */
+  public int parse(ByteBuffer buffer, int offset, int length, Listener listener)
+      throws IOException {
+    if (handle == 0) {
+      throw new IllegalStateException("Multipart parser is closed");
+    }
+
+    int total = 0;
+    while (total < length && !complete) {
+      long result =
+          NativeOptimizer.nativeMultipartParse(
+              handle, buffer, offset + total, length - total, events);
+      if (result < 0) {
+        int code = (int) -result;
+        String reason = code < ERROR_REASONS.length ? ERROR_REASONS[code] : ERROR_REASONS[0];
+        throw new IOException("Malformed multipart body: " + reason);
+      }
+      int consumed = (int) (result & FIELD_MASK);
+      int eventCount = (int) ((result >>> EVENTS_SHIFT) & FIELD_MASK);
+      complete = ((result >>> COMPLETE_SHIFT) & 1) != 0;
+
+      dispatch(buffer, eventCount, listener);
+      total += consumed;
+      if (consumed == 0 && eventCount == 0) {
+        break;
+      }
+    }
+    return total;
+  }
+
+  /**
+   * Checks whether the close delimiter has been read.
+   *
+   * @return true if the body is complete
+   */
+  public boolean isComplete() {
+    return complete;
+  }
+
+  /** Prepares the parser for another body with the same boundary. */
+  public void reset() {
+    if (handle != 0) {
+      NativeOptimizer.nativeMultipartParserReset(handle);
+    }
+    complete = false;
+  }
+
+  /** Releases the native parser. */
+  @Override
+  public void close() {
+    if (handle != 0) {
+      NativeOptimizer.nativeMultipartParserFree(handle);
+      handle = 0;
+    }
+  }
+
+  private void dispatch(ByteBuffer buffer, int eventCount, Listener listener) throws IOException {
+    for (int i = 0; i < eventCount; i++) {
+      int e = i * EVENT_INTS;
+      switch (events[e]) {
+        case PART_BEGIN:
+          listener.partBegin(
+              text(buffer, events[e + 1], events[e + 2]),
+              text(buffer, events[e + 3], events[e + 4]),
+              text(buffer, events[e + 5], events[e + 6]));
+          break;
+        case DATA:
+          listener.partData(buffer, events[e + 1], events[e + 2]);
+          break;
+        case PART_END:
+          listener.partEnd();
+          break;
+        default:
+          break; // Close delimiter, reported through isComplete()
+      }
+    }
+  }
+
+  private static String text(ByteBuffer buffer, int offset, int length) {
+    if (length < 0) {
+      return null;
+    }
+    byte[] bytes = new byte[length];
+    buffer.get(offset, bytes, 0, length);
+    return new String(bytes, StandardCharsets.UTF_8);
+  }
+}
@@ -0,0 +1,175 @@
+package com.blyfast.nativeopt;
+
+import java.nio.ByteBuffer;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+/**
+ * The binding used for native calls on request hot paths: body classification, cookie and query
+ * tokenizing and percent-decoding. These calls do so little work that the transition into native
+ * code is a large part of what they cost.
+ *
+ * <p>JNI works on every Java version. On Java 22 and later, the same functions can be called as
+ * {@code java.lang.foreign} downcalls with the critical linker option, which passes arrays and
+ * buffers as memory segments and skips the JNI state transitions. The binding is chosen at
+ * startup with the {@code blyfast.native.bindings} system property: {@code ffm}, {@code jni}, or
+ * {@code auto} (the default) for FFM where it is available. FFM downcalls log a warning unless
+ * native access is enabled with {@code --enable-native-access=ALL-UNNAMED}.
+ *
+ * <p>All methods require the native library; see {@link
+ * NativeOptimizer#isNativeOptimizationAvailable()}.
+ */
+public abstract class NativeBindings {
+  private static final Logger logger = LoggerFactory.getLogger(NativeBindings.class);
+
+  // Only on the Java 22 path of the multi-release jar
+  private static final String FFM_BINDINGS_CLASS = "com.blyfast.nativeopt.FfmBindings";
+
+  private static final NativeBindings JNI = new JniBindings();
+  private static final NativeBindings FFM = loadFfm();
+  private static final NativeBindings SELECTED = select();
+
+  /**
+   * Gets the binding selected at startup.
+   *
+   * @return the binding
+   */
+  public static NativeBindings get() {
+    return SELECTED;
+  }
+
+  /**
+   * Gets the JNI binding.
+   *
+   * @return the binding
+   */
+  public static NativeBindings jni() {
+    return JNI;
+  }
+
+  /**
+   * Gets the FFM binding.
+   *
+   * @return the binding, or null before Java 22 or without the native library
+   */
+  public static NativeBindings ffm() {
+    return FFM;
+  }
+
+  /**
+   * Gets the name of this binding.
+   *
+   * @return {@code jni} or {@code ffm}
+   */
+  public abstract String getName();
+
+  /**
+   * Classifies a body by its Content-Type, like {@link NativeOptimizer#nativeAnalyzeHttpBody}.
+   *
+   * @param body the buffer holding the body from index 0; direct, or heap as well with FFM
+   * @param length the length of the body, at most the buffer's limit
+   * @param contentType the Content-Type header value
+   * @return the body type, 0 if unknown
+   */
+  public abstract int analyzeHttpBody(ByteBuffer body, int length, String contentType);
+
+  /**
+   * Detects the type of a body from its first bytes, like {@link
+   * NativeOptimizer#nativeFastDetectContentType}.
+   *
+   * @param body the buffer holding the body from index 0; direct, or heap as well with FFM
+   * @param length the length of the body, at most the buffer's limit
+   * @return the body type, 0 if unknown
+   */
+  public abstract int detectContentType(ByteBuffer body, int length);
+
+  /**
+   * Tokenizes a Cookie header, like {@link NativeOptimizer#nativeParseCookies}.
+   *
+   * @param header the raw header bytes
+   * @param length the number of bytes to tokenize
+   * @param index receives four ints per cookie
+   * @return the number of cookies, or the negated count if {@code index} is too small
+   */
+  public abstract int parseCookies(byte[] header, int length, int[] index);
+
+  /**
+   * Tokenizes a raw query string, like {@link NativeOptimizer#nativeParseQuery}.
+   *
+   * @param query the raw query bytes
+   * @param length the number of bytes to tokenize
+   * @param index receives five ints per parameter
+   * @return the number of parameters, or the negated count if {@code index} is too small
+   */
+  public abstract int parseQuery(byte[] query, int length, int[] index);
+
+  /**
+   * Percent-decodes bytes, like {@link NativeOptimizer#nativePercentDecode}.
+   *
+   * @param src the encoded bytes
+   * @param offset the offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @param dest receives the decoded bytes; must hold at least {@code length} bytes
+   * @param plusAsSpace whether '+' means a space
+   * @return the decoded length, -1 if there was nothing to decode, or -2 if the arguments are
+   *     invalid
+   */
+  public abstract int percentDecode(
+      byte[] src, int offset, int length, byte[] dest, boolean plusAsSpace);
+
+  private static NativeBindings loadFfm() {
+    if (Runtime.version().feature() < 22 || !NativeOptimizer.isNativeOptimizationAvailable()) {
+      return null;
+    }
+    try {
+      return (NativeBindings)
+          Class.forName(FFM_BINDINGS_CLASS).getDeclaredConstructor().newInstance();
+    } catch (ReflectiveOperationException | LinkageError | RuntimeException e) {
+      logger.warn("FFM native bindings are not available: {}", e.toString());
+      return null;
+    }
+  }
+
+  private static NativeBindings select() {
+    String requested = System.getProperty("blyfast.native.bindings", "auto");
+    if (requested.equals("ffm") && FFM == null) {
+      logger.warn("FFM native bindings need Java 22 or later; using JNI");
+    }
+    NativeBindings bindings = requested.equals("jni") || FFM == null ? JNI : FFM;
+    logger.debug("Native bindings: {}", bindings.getName());
+    return bindings;
+  }
+
+  /** Binding through the JNI functions of {@link NativeOptimizer}. */
+  private static final class JniBindings extends NativeBindings {
+    @Override
+    public String getName() {
+      return "jni";
+    }
+
+    @Override
+    public int analyzeHttpBody(ByteBuffer body, int length, String contentType) {
+      return NativeOptimizer.nativeAnalyzeHttpBody(body, length, contentType);
+    }
+
+    @Override
+    public int detectContentType(ByteBuffer body, int length) {
+      return NativeOptimizer.nativeFastDetectContentType(body, length);
+    }
+
+    @Override
+    public int parseCookies(byte[] header, int length, int[] index) {
+      return NativeOptimizer.nativeParseCookies(header, length, index);
+    }
+
+    @Override
+    public int parseQuery(byte[] query, int length, int[] index) {
+      return NativeOptimizer.nativeParseQuery(query, length, index);
+    }
+
+    @Override
+    public int percentDecode(byte[] src, int offset, int length, byte[] dest, boolean plusAsSpace) {
+      return NativeOptimizer.nativePercentDecode(src, offset, length, dest, plusAsSpace);
+    }
+  }
+}
@@ -0,0 +1,185 @@
+package com.blyfast.nativeopt;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * Read-only view over a header set exported by {@link NativeOptimizer#nativeExportHeaders(long,
+ * ByteBuffer)}. The export is a single JNI call; lookups afterwards compare names directly against
+ * the exported bytes and values are only decoded into Strings the first time they are read.
+ *
+ * <p>Export layout (native byte order, offsets relative to the start of the buffer):
+ *
+ * <pre>
+ * [count:4][pool_len:4]
+ * count x [name_off:4][name_len:4][value_off:4][value_len:4]
+ * [string pool: names and values, not NUL-terminated]
+ * </pre>
+ *
+ * Headers appear in wire order, so repeated headers keep their original ordering.
+ */
+public final class NativeHeaderMap {
+  private static final int PREAMBLE_SIZE = 8;
+  private static final int ENTRY_SIZE = 16;
+  private static final int INITIAL_EXPORT_BUFFER_SIZE = 8 * 1024; // 8KB covers typical requests
+
+  // Scratch buffer the native side writes into; grown on demand when a header set is larger
+  private static final ThreadLocal<ByteBuffer> EXPORT_BUFFER =
+      ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(INITIAL_EXPORT_BUFFER_SIZE));
+
+  private final ByteBuffer data;
+  private final int count;
+  private final String[] values;
+
+  private NativeHeaderMap(byte[] exported) {
+    this.data = ByteBuffer.wrap(exported).order(ByteOrder.nativeOrder());
+    this.count = data.getInt(0);
+    this.values = new String[count];
+  }
+
+  /**
+   * Exports a previously parsed header set with one native call.
+   *
+   * @param headersId the ID returned by {@link NativeOptimizer#nativeParseHttpHeaders}
+   * @return the header map, or null if native optimizations are unavailable or the ID is unknown
+   */
+  public static NativeHeaderMap export(long headersId) {
+    if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+      return null;
+    }
+
+    ByteBuffer out = EXPORT_BUFFER.get();
+    int written = NativeOptimizer.nativeExportHeaders(headersId, out);
+    if (written < 0) {
+      // Buffer too small: the native side reported the exact size it needs
+      out = ByteBuffer.allocateDirect(-written);
+      EXPORT_BUFFER.set(out);
+      written = NativeOptimizer.nativeExportHeaders(headersId, out);
+    }
+    if (written <= 0) {
+      return null;
+    }
+
+    byte[] exported = new byte[written];
+    out.get(0, exported, 0, written);
+    return new NativeHeaderMap(exported);
+  }
+
+  /**
+   * Gets the number of headers, counting repeated headers individually.
+   *
+   * @return the header count
+   */
+  public int size() {
+    return count;
+  }
+
+  /**
+   * Gets the name of the header at the given position.
+   *
+   * @param index the header position in wire order
+   * @return the header name
+   */
+  public String name(int index) {
+    int entry = entryOffset(index);
+    return decode(data.getInt(entry), data.getInt(entry + 4));
+  }
+
+  /**
+   * Gets the value of the header at the given position, decoding it on first access.
+   *
+   * @param index the header position in wire order
+   * @return the header value
+   */
+  public String value(int index) {
+    String value = values[index];
+    if (value == null) {
+      int entry = entryOffset(index);
+      value = decode(data.getInt(entry + 8), data.getInt(entry + 12));
+      values[index] = value;
+    }
+    return value;
+  }
+
+  /**
+   * Gets the first value of a header, matching the name case-insensitively.
+   *
+   * @param name the header name
+   * @return the header value or null if not present
+   */
+  public String get(String name) {
+    int index = indexOf(name, 0);
+    return index >= 0 ? value(index) : null;
+  }
+
+  /**
+   * Gets all values of a header in wire order.
+   *
+   * @param name the header name
+   * @return the header values, empty if not present
+   */
+  public List<String> getAll(String name) {
+    int index = indexOf(name, 0);
+    if (index < 0) {
+      return Collections.emptyList();
+    }
+    List<String> result = new ArrayList<>(2);
+    while (index >= 0) {
+      result.add(value(index));
+      index = indexOf(name, index + 1);
+    }
+    return result;
+  }
+
+  /**
+   * Checks whether a header is present.
+   *
+   * @param name the header name
+   * @return true if the header is present
+   */
+  public boolean contains(String name) {
+    return indexOf(name, 0) >= 0;
+  }
+
+  private int indexOf(String name, int from) {
+    int nameLength = name.length();
+    for (int i = from; i < count; i++) {
+      int entry = entryOffset(i);
+      if (data.getInt(entry + 4) == nameLength && nameEquals(data.getInt(entry), name)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  private boolean nameEquals(int offset, String name) {
+    // Header names are ASCII tokens, so a byte-wise ASCII case fold is sufficient
+    for (int i = 0; i < name.length(); i++) {
+      int a = data.get(offset + i) & 0xFF;
+      int b = name.charAt(i);
+      if (a != b && toLowerAscii(a) != toLowerAscii(b)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  private static int toLowerAscii(int c) {
+    return c >= 'A' && c <= 'Z' ? c + 32 : c;
+  }
+
+  private int entryOffset(int index) {
+    if (index < 0 || index >= count) {
+      throw new IndexOutOfBoundsException("Header index " + index + " out of range " + count);
+    }
+    return PREAMBLE_SIZE + index * ENTRY_SIZE;
+  }
+
+  private String decode(int offset, int length) {
+    return new String(data.array(), offset, length, StandardCharsets.UTF_8);
+  }
+}
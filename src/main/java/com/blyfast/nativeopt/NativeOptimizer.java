@@ -59,6 +59,7 @@ public class NativeOptimizer {
         // Simple test call to verify linking
         String testResult = nativeEscapeJson("test");
         logger.debug("Native method test successful: {}", testResult != null);
+        logger.info("Native SIMD kernels: {}", nativeSimdVariant());
       } catch (UnsatisfiedLinkError e) {
         // If this fails, reset the loaded flag
         NATIVE_LOADED.set(false);
@@ -100,6 +101,13 @@ public class NativeOptimizer {
 
   // Native method declarations - these would be implemented in C
 
+  /**
+   * Gets the SIMD kernel variant selected when the library was loaded.
+   *
+   * @return the variant name
+   */
+  public static native String nativeSimdVariant();
+
   /**
    * Fast native JSON string escaping.
    *
@@ -116,6 +124,19 @@ public class NativeOptimizer {
    */
   public static native ByteBuffer nativeParseJson(String input);
 
+  /**
+   * Parses JSON into maps, lists, strings, numbers and booleans, decoding the string values of
+   * the named object members as base64 into direct buffers. The input is copied to UTF-8 once,
+   * and the values are decoded from that copy without a String per value.
+   *
+   * @param input the JSON string to parse
+   * @param base64Fields the names of the members holding base64, as written in the JSON
+   * @param flags the {@link Base64Codec} flags for those members
+   * @return the parsed value, or null if the JSON is invalid
+   * @throws IllegalArgumentException if a named member is not valid base64
+   */
+  public static native Object nativeParseJsonBase64(String input, String[] base64Fields, int flags);
+
   /**
    * Fast native HTTP header parsing.
    *
@@ -125,6 +146,30 @@ public class NativeOptimizer {
    */
   public static native long nativeParseHttpHeaders(ByteBuffer headerBytes, int length);
 
+  /**
+   * Parses HTTP headers like {@link #nativeParseHttpHeaders} while rejecting ambiguous framing in
+   * the same scan: bare CR, NUL, obs-fold, malformed field lines, duplicate or non-numeric
+   * Content-Length, and Content-Length together with Transfer-Encoding.
+   *
+   * @param headerBytes the header bytes, without the request line
+   * @param length the length of the data
+   * @return object ID for the parsed headers, the negated {@link HeaderFramingException} code for
+   *     a framing violation, or 0 on failure
+   */
+  public static native long nativeParseHttpHeadersStrict(ByteBuffer headerBytes, int length);
+
+  /**
+   * Checks HTTP headers for ambiguous framing with the rules of {@link
+   * #nativeParseHttpHeadersStrict}, without parsing them. Use {@link HeaderFramingException#check}
+   * instead, which also works without the native library.
+   *
+   * @param headerBytes the header bytes, without the request line
+   * @param length the length of the data
+   * @return the {@link HeaderFramingException} code, 0 if the framing is unambiguous, or -1 on
+   *     invalid arguments
+   */
+  public static native int nativeCheckHeaderFraming(ByteBuffer headerBytes, int length);
+
   /**
    * Retrieves a header value by name from previously parsed headers.
    *
@@ -134,6 +179,16 @@ public class NativeOptimizer {
    */
   public static native String nativeGetHeader(long headersId, String headerName);
 
+  /**
+   * Retrieves every value of a repeated header (e.g. Set-Cookie, X-Forwarded-For) in wire order.
+   * Large header sets are looked up through a hashed name index built at parse time.
+   *
+   * @param headersId the ID of the parsed headers
+   * @param headerName the name of the header to retrieve
+   * @return the header values in wire order, or null if not found
+   */
+  public static native String[] nativeGetHeaderValues(long headersId, String headerName);
+
   /**
    * Releases resources associated with previously parsed headers.
    *
@@ -141,6 +196,538 @@ public class NativeOptimizer {
    */
   public static native void nativeFreeHeaders(long headersId);
 
+  /**
+   * Serializes every header of a previously parsed header set into a direct buffer, so the whole
+   * set crosses the JNI boundary once. See {@link NativeHeaderMap} for the layout.
+   *
+   * @param headersId the ID of the parsed headers
+   * @param out the direct buffer to write into
+   * @return the number of bytes written, the negated required capacity if {@code out} is too
+   *     small, or 0 if the headers ID is unknown
+   */
+  public static native int nativeExportHeaders(long headersId, ByteBuffer out);
+
+  /**
+   * Configures the header block dedup cache used by {@link #nativeParseHttpHeaders}. Blocks that
+   * repeat apart from the volatile headers reuse a shared parsed set.
+   *
+   * @param entries the number of cache slots (rounded up to a power of two), or 0 to disable
+   * @param volatileHeaders names of headers that change on every request, such as a request ID
+   * @return the number of slots, or 0 if the cache is disabled
+   */
+  public static native int nativeConfigureHeaderCache(int entries, String[] volatileHeaders);
+
+  /**
+   * Reads the header block cache statistics.
+   *
+   * @param out receives hits, misses, bypasses, evictions and bytes reused, in that order
+   */
+  public static native void nativeHeaderCacheStats(long[] out);
+
+  /**
+   * Creates a per-connection HPACK decoder (RFC 7541) for HTTP/2 header blocks.
+   *
+   * @param maxTableSize the SETTINGS_HEADER_TABLE_SIZE advertised to the peer
+   * @return the decoder handle, or 0 if allocation failed
+   */
+  public static native long nativeHpackDecoderCreate(int maxTableSize);
+
+  /**
+   * Decodes one complete header block into a parsed header set that can be read with {@link
+   * #nativeGetHeader}, {@link #nativeGetHeaderValues} and {@link #nativeExportHeaders}.
+   *
+   * @param decoder the decoder handle
+   * @param block a direct buffer holding the header block
+   * @param offset the offset of the header block in the buffer
+   * @param length the length of the header block
+   * @return the headers ID (free with {@link #nativeFreeHeaders}), or a negative HPACK error code
+   */
+  public static native long nativeHpackDecode(
+      long decoder, ByteBuffer block, int offset, int length);
+
+  /**
+   * Updates the maximum dynamic table size after a SETTINGS_HEADER_TABLE_SIZE change.
+   *
+   * @param decoder the decoder handle
+   * @param maxTableSize the new maximum size in bytes
+   */
+  public static native void nativeHpackDecoderSetMaxTableSize(long decoder, int maxTableSize);
+
+  /**
+   * Releases an HPACK decoder and its dynamic table.
+   *
+   * @param decoder the decoder handle
+   */
+  public static native void nativeHpackDecoderFree(long decoder);
+
+  /**
+   * Creates a per-connection HPACK encoder for HTTP/2 response header blocks.
+   *
+   * @param maxTableSize the peer's SETTINGS_HEADER_TABLE_SIZE
+   * @return the encoder handle, or 0 if allocation failed
+   */
+  public static native long nativeHpackEncoderCreate(int maxTableSize);
+
+  /**
+   * Registers a header set that repeats across responses. Its literals are encoded once, and
+   * encoders refer back to the dynamic table entries they inserted for it.
+   *
+   * @param namesAndValues alternating header names and values
+   * @return the set ID shared by all encoders, or 0 if the set is invalid (including a
+   *     pseudo-header after a regular field) or the registry is full
+   */
+  public static native int nativeHpackRegisterHeaderSet(String[] namesAndValues);
+
+  /**
+   * Encodes one header block: the additional pseudo-header fields, then a registered header set,
+   * then the remaining additional headers.
+   *
+   * @param encoder the encoder handle
+   * @param headerSetId the registered header set, or 0 for none
+   * @param namesAndValues alternating header names and values, may be null
+   * @param out the direct buffer to write into
+   * @param offset the offset to start writing at
+   * @return the number of bytes written, the negated worst-case size if {@code out} is too small,
+   *     or 0 on invalid arguments or allocation failure
+   */
+  public static native int nativeHpackEncode(
+      long encoder, int headerSetId, String[] namesAndValues, ByteBuffer out, int offset);
+
+  /**
+   * Adopts a new SETTINGS_HEADER_TABLE_SIZE from the peer; the next header block signals it.
+   *
+   * @param encoder the encoder handle
+   * @param maxTableSize the new maximum size in bytes
+   */
+  public static native void nativeHpackEncoderSetMaxTableSize(long encoder, int maxTableSize);
+
+  /**
+   * Releases an HPACK encoder and its dynamic table.
+   *
+   * @param encoder the encoder handle
+   */
+  public static native void nativeHpackEncoderFree(long encoder);
+
+  /**
+   * Refreshes the cached HTTP Date header used by {@link #nativeWriteResponseHead}.
+   *
+   * @param epochSecond the current time in seconds since the epoch
+   */
+  public static native void nativeUpdateDateHeader(long epochSecond);
+
+  /**
+   * Registers a response header set that is stored pre-serialized and copied verbatim.
+   *
+   * @param namesAndValues alternating header names and values
+   * @return the header set ID, or 0 if the set is invalid or the registry is full
+   */
+  public static native int nativeRegisterResponseHeaders(String[] namesAndValues);
+
+  /**
+   * Serializes an HTTP/1.1 response head: status line, Date, a registered header set,
+   * Content-Length, additional headers and the terminating blank line.
+   *
+   * @param out the direct buffer to write into
+   * @param offset the offset to start writing at
+   * @param status the status code
+   * @param headerSetId the registered header set, or 0 for none
+   * @param contentLength the Content-Length to send, or -1 to omit it
+   * @param namesAndValues additional headers as alternating names and values, may be null
+   * @return the number of bytes written, the negated required size if {@code out} is too small,
+   *     or 0 on invalid arguments
+   */
+  public static native int nativeWriteResponseHead(
+      ByteBuffer out,
+      int offset,
+      int status,
+      int headerSetId,
+      long contentLength,
+      String[] namesAndValues);
+
+  /**
+   * Writes the framing of a multipart body: before each part its delimiter line, headers and
+   * blank line, and after the last part the close delimiter. Part bodies are not written; frame
+   * {@code i} precedes the body of part {@code i}.
+   *
+   * @param out the direct buffer to write into, from position 0
+   * @param boundary the boundary, 1 to 70 characters allowed by RFC 2046
+   * @param headerText the part headers as alternating names and values, for all parts in order,
+   *     encoded as UTF-8 and concatenated
+   * @param headerLengths the length in bytes of each name and value in {@code headerText}
+   * @param headerCounts the number of headers of each part
+   * @param frameEnds receives the end offset of each frame; one entry more than there are parts
+   * @return the number of bytes written, the negated required size if {@code out} is too small,
+   *     or 0 if the arguments are invalid or a header contains CR or LF
+   */
+  public static native int nativeWriteMultipartFraming(
+      ByteBuffer out,
+      String boundary,
+      byte[] headerText,
+      int[] headerLengths,
+      int[] headerCounts,
+      int[] frameEnds);
+
+  /**
+   * Encodes bytes as base64 (RFC 4648).
+   *
+   * @param src the direct buffer holding the bytes
+   * @param srcOffset the offset of the bytes
+   * @param length the number of bytes
+   * @param dst the direct buffer to write the text into
+   * @param dstOffset the offset to write at
+   * @param flags {@link Base64Codec#URL} and {@link Base64Codec#NO_PADDING}
+   * @return the number of characters written, or -1 if the arguments are invalid or {@code dst}
+   *     is too small
+   */
+  public static native int nativeBase64Encode(
+      ByteBuffer src, int srcOffset, int length, ByteBuffer dst, int dstOffset, int flags);
+
+  /**
+   * Decodes base64 text (RFC 4648); padding is optional. Decoding is strict unless {@link
+   * Base64Codec#LENIENT} is set, which skips whitespace and ignores nonzero spare bits. The
+   * buffers may be the same, with {@code dstOffset <= srcOffset}, to decode in place.
+   *
+   * @param src the direct buffer holding the text
+   * @param srcOffset the offset of the text
+   * @param length the length of the text
+   * @param dst the direct buffer to write the bytes into, with room for {@code (length * 3 + 3) /
+   *     4} bytes
+   * @param dstOffset the offset to write at
+   * @param flags {@link Base64Codec#URL} and {@link Base64Codec#LENIENT}
+   * @return the number of bytes written, {@code -1 - i} if the text is invalid at offset {@code
+   *     i}, or {@link Integer#MIN_VALUE} if the arguments are invalid or {@code dst} is too small
+   */
+  public static native int nativeBase64Decode(
+      ByteBuffer src, int srcOffset, int length, ByteBuffer dst, int dstOffset, int flags);
+
+  /**
+   * Acquires a block from the native size-class pool. Use {@link DirectBufferPool} instead; the
+   * buffer pool natives are package-private so that only it hands out and releases blocks.
+   *
+   * @param size the minimum capacity, at most 16 MB
+   * @return the block's handle, or 0 if {@code size} is too large or the pool budget is exhausted
+   */
+  static native long nativeBufferPoolAcquire(int size);
+
+  /**
+   * Wraps a block of the buffer pool in a direct buffer. The buffer is not freed by the garbage
+   * collector; its memory is handed out again once the handle is released.
+   *
+   * @param handle a handle from {@link #nativeBufferPoolAcquire}
+   * @return a buffer whose capacity is the requested size rounded up to a power of two of at
+   *     least 4 KB, or null if the handle names no block in use
+   */
+  static native ByteBuffer nativeBufferPoolBuffer(long handle);
+
+  /**
+   * Returns a block to the buffer pool. Buffers wrapping it must not be used afterwards.
+   *
+   * @param handle a handle from {@link #nativeBufferPoolAcquire}
+   * @return false if the handle names no block in use, for instance because it was released
+   */
+  static native boolean nativeBufferPoolRelease(long handle);
+
+  /**
+   * Sets the budget for memory mapped by the buffer pool, in use or cached.
+   *
+   * @param budget the budget in bytes
+   */
+  static native void nativeBufferPoolSetBudget(long budget);
+
+  /**
+   * Returns the free blocks of the buffer pool's shared lists to the OS.
+   *
+   * @return the number of bytes released
+   */
+  static native long nativeBufferPoolTrim();
+
+  /** Moves the buffer pool blocks cached by the calling thread to the shared lists. */
+  static native void nativeBufferPoolFlushThreadCache();
+
+  /**
+   * Reads the buffer pool statistics.
+   *
+   * @param out receives the budget, mapped bytes, bytes in use, peak bytes in use, acquisitions,
+   *     thread cache hits, shared list hits, blocks mapped, acquisitions refused and blocks
+   *     unmapped, in that order, then the number of blocks in use per size class from 4 KB up
+   */
+  static native void nativeBufferPoolStats(long[] out);
+
+  /**
+   * Tokenizes a Cookie header into an index of {@code [name_off, name_len, value_off, value_len]}
+   * entries, four ints per cookie. Whitespace and surrounding double quotes are trimmed; values are
+   * not decoded.
+   *
+   * @param header the header bytes
+   * @param length the number of bytes to parse
+   * @param index the array receiving the index entries
+   * @return the number of cookies, or the negated count if {@code index} is too small
+   */
+  public static native int nativeParseCookies(byte[] header, int length, int[] index);
+
+  /**
+   * Tokenizes a raw query string into an index of {@code [name_off, name_len, value_off,
+   * value_len, flags]} entries, five ints per parameter. Flag 1 marks a name and flag 2 a value
+   * that contains {@code %} or {@code +} and needs decoding.
+   *
+   * @param query the raw query bytes
+   * @param length the number of bytes to parse
+   * @param index the array receiving the index entries
+   * @return the number of parameters, or the negated count if {@code index} is too small
+   */
+  public static native int nativeParseQuery(byte[] query, int length, int[] index);
+
+  /**
+   * Tokenizes a urlencoded form body in place, into the index layout of {@link #nativeParseQuery}.
+   * The offsets point into the body buffer.
+   *
+   * @param body a direct ByteBuffer holding the body from index 0
+   * @param length the number of bytes to parse
+   * @param index the array receiving the index entries
+   * @return the number of fields, the negated count if {@code index} is too small, or 0 on error
+   */
+  public static native int nativeParseFormIndex(ByteBuffer body, int length, int[] index);
+
+  /**
+   * Compiles the server's offers for content negotiation.
+   *
+   * @param kind 0 for media types (Accept), 1 for content codings (Accept-Encoding), 2 for
+   *     language tags (Accept-Language)
+   * @param offers the available values in order of server preference
+   * @return the offer set ID, or 0 if the offers are invalid or too many sets are registered
+   */
+  public static native int nativeCompileOffers(int kind, String[] offers);
+
+  /**
+   * Selects the best offer for an Accept-style header value, honouring q-values and range
+   * specificity.
+   *
+   * @param offerSetId the ID returned by {@link #nativeCompileOffers}
+   * @param header the header value
+   * @return the index of the selected offer, or -1 if none is acceptable
+   */
+  public static native int nativeNegotiate(int offerSetId, String header);
+
+  /**
+   * Percent-decodes bytes, scanning for escapes with SIMD and bulk-copying the runs between them.
+   *
+   * @param src the encoded bytes
+   * @param offset the offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @param dest receives the decoded bytes; must hold at least {@code length} bytes
+   * @param plusAsSpace whether '+' decodes to a space
+   * @return the decoded length, -1 if there was nothing to decode and {@code dest} was not
+   *     written, or -2 on invalid arguments
+   */
+  public static native int nativePercentDecode(
+      byte[] src, int offset, int length, byte[] dest, boolean plusAsSpace);
+
+  /**
+   * Percent-decodes bytes of a direct ByteBuffer, without copying them out of the buffer first.
+   *
+   * @param src a direct ByteBuffer holding the encoded bytes
+   * @param offset the absolute offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @param dest receives the decoded bytes; must hold at least {@code length} bytes
+   * @param plusAsSpace whether '+' decodes to a space
+   * @return the decoded length, -1 if there was nothing to decode and {@code dest} was not
+   *     written, or -2 on invalid arguments
+   */
+  public static native int nativePercentDecodeDirect(
+      ByteBuffer src, int offset, int length, byte[] dest, boolean plusAsSpace);
+
+  /**
+   * Registers a set of trusted proxy ranges for {@link #nativeResolveClientAddress}.
+   *
+   * @param cidrs four values per range: masked address high/low bits and mask high/low bits, IPv4
+   *     mapped into ::ffff:0:0/96
+   * @return the set ID, or 0 if the ranges are invalid or too many sets are registered
+   */
+  public static native int nativeCompileTrustedProxies(long[] cidrs);
+
+  /**
+   * Resolves the client address behind trusted proxies. If the peer is trusted, the Forwarded
+   * values (or X-Forwarded-For values if there are none) are walked from the right to the first
+   * untrusted address.
+   *
+   * @param proxySetId the ID returned by {@link #nativeCompileTrustedProxies}
+   * @param peerHigh the upper 64 bits of the peer address
+   * @param peerLow the lower 64 bits of the peer address
+   * @param forwarded the Forwarded header values, or null
+   * @param xForwardedFor the X-Forwarded-For header values, or null
+   * @param out receives the resolved address as high and low bits
+   * @return 1 if the address came from a forwarding header, 0 if it is the peer, -1 on invalid
+   *     arguments
+   */
+  public static native int nativeResolveClientAddress(
+      int proxySetId,
+      long peerHigh,
+      long peerLow,
+      String[] forwarded,
+      String[] xForwardedFor,
+      long[] out);
+
+  /**
+   * Creates a streaming decoder for chunked transfer coding.
+   *
+   * @return the decoder handle, or 0 if allocation failed
+   */
+  public static native long nativeChunkedDecoderCreate();
+
+  /**
+   * Strips chunk framing in place. Data bytes are compacted to {@code offset}; state carries over
+   * between calls, so the body may be split at any byte.
+   *
+   * @param decoder the decoder handle
+   * @param buffer a direct buffer holding the encoded bytes
+   * @param offset the offset of the encoded bytes
+   * @param length the number of encoded bytes
+   * @return the bytes consumed in bits 0-30, the data bytes produced in bits 31-61 and bit 62 set
+   *     once the body is complete, or a negated error code
+   */
+  public static native long nativeChunkedDecode(
+      long decoder, ByteBuffer buffer, int offset, int length);
+
+  /**
+   * Publishes the trailer fields of a completely decoded body.
+   *
+   * @param decoder the decoder handle
+   * @return the headers ID; release it with {@link #nativeFreeHeaders(long)}. 0 if there are none
+   */
+  public static native long nativeChunkedDecoderTrailers(long decoder);
+
+  /**
+   * Resets a decoder for the next body.
+   *
+   * @param decoder the decoder handle
+   */
+  public static native void nativeChunkedDecoderReset(long decoder);
+
+  /**
+   * Releases a chunked decoder.
+   *
+   * @param decoder the decoder handle
+   */
+  public static native void nativeChunkedDecoderFree(long decoder);
+
+  /**
+   * Frames data already in a direct buffer as one chunk, writing the size line into the headroom
+   * before it and CRLF after it.
+   *
+   * @param buffer the direct buffer
+   * @param dataOffset the offset of the chunk data
+   * @param dataLength the length of the chunk data, greater than 0
+   * @return the offset where the framed chunk starts, or -1 if there is no room for the framing
+   */
+  public static native int nativeChunkedFrame(ByteBuffer buffer, int dataOffset, int dataLength);
+
+  /**
+   * Writes the last chunk of a chunked body with optional trailer fields.
+   *
+   * @param out the direct buffer to write to
+   * @param offset the offset to write at
+   * @param trailerText the UTF-8 trailer names and values, alternating and concatenated; may be
+   *     null if there are none
+   * @param trailerLengths the byte length of each name and value in {@code trailerText}, may be
+   *     null if there are none
+   * @return the number of bytes written, the negated required size if {@code out} is too small,
+   *     or 0 on invalid arguments
+   */
+  public static native int nativeChunkedWriteLastChunk(
+      ByteBuffer out, int offset, byte[] trailerText, int[] trailerLengths);
+
+  /**
+   * Creates a streaming multipart parser.
+   *
+   * @param boundary the boundary parameter of the Content-Type header, without leading dashes
+   * @return the parser handle, or 0 if the boundary is invalid or allocation fails
+   */
+  public static native long nativeMultipartParserCreate(String boundary);
+
+  /**
+   * Parses the next chunk of a multipart body. Events are written seven ints each: {@code [type,
+   * name_off, name_len, filename_off, filename_len, type_off, type_len]} for a part start (type
+   * 1), {@code [type, off, len, ...]} for part data (type 2), then part end (3) and close
+   * delimiter (4). Absent values have length -1; offsets are absolute buffer indexes.
+   *
+   * @param parser the parser handle
+   * @param buffer a direct buffer holding the chunk
+   * @param offset the offset of the chunk
+   * @param length the length of the chunk
+   * @param events the array receiving the events
+   * @return the bytes consumed in bits 0-30, the event count in bits 31-61 and bit 62 set once the
+   *     close delimiter has been read, or a negated error code
+   */
+  public static native long nativeMultipartParse(
+      long parser, ByteBuffer buffer, int offset, int length, int[] events);
+
+  /**
+   * Resets a multipart parser for another body with the same boundary.
+   *
+   * @param parser the parser handle
+   */
+  public static native void nativeMultipartParserReset(long parser);
+
+  /**
+   * Releases a multipart parser.
+   *
+   * @param parser the parser handle
+   */
+  public static native void nativeMultipartParserFree(long parser);
+
+  /**
+   * Creates an anonymous temporary file for spilling a large multipart part, using O_TMPFILE.
+   *
+   * @param directory the directory on whose filesystem the file is created
+   * @param sizeHint bytes to preallocate, an upper bound on the content size, or 0
+   * @return the file handle, or 0 if anonymous files are unsupported or creation fails
+   */
+  public static native long nativeSpillFileCreate(String directory, long sizeHint);
+
+  /**
+   * Appends bytes from a direct buffer to a spill file. Writes are coalesced into large blocks.
+   *
+   * @param file the file handle
+   * @param buffer the direct buffer
+   * @param offset the offset of the bytes
+   * @param length the number of bytes
+   * @return 0, or a negated errno
+   */
+  public static native int nativeSpillFileWrite(
+      long file, ByteBuffer buffer, int offset, int length);
+
+  /**
+   * Writes out pending bytes and trims preallocated space past the content.
+   *
+   * @param file the file handle
+   * @return the file size, or a negated errno
+   */
+  public static native long nativeSpillFileFinish(long file);
+
+  /**
+   * Gets the file descriptor of a spill file, to open it again through {@code /proc/self/fd}.
+   *
+   * @param file the file handle
+   * @return the file descriptor
+   */
+  public static native int nativeSpillFileDescriptor(long file);
+
+  /**
+   * Links a finished spill file at a path without copying it, replacing an existing file.
+   *
+   * @param file the file handle
+   * @param target the path to link at
+   * @return 0, or a negated errno (such as -EXDEV for a target on another filesystem)
+   */
+  public static native int nativeSpillFileLink(long file, String target);
+
+  /**
+   * Closes a spill file, discarding its content unless it was linked.
+   *
+   * @param file the file handle
+   */
+  public static native void nativeSpillFileFree(long file);
+
   /**
    * Optimized memory copy - copies from source to destination buffer.
    *
@@ -158,7 +745,7 @@ public class NativeOptimizer {
    *
    * @param bodyBuffer the body data
    * @param length the length of the data
-   * @param contentType the Content-Type header value
+   * @param contentType the Content-Type header value, classified by its parsed type and subtype
    * @return an integer code representing the body type (0=unknown, 1=JSON, 2=form, 3=multipart,
    *     4=text, 5=binary)
    */
@@ -176,6 +763,34 @@ public class NativeOptimizer {
   public static native ByteBuffer nativeFastParseBody(
       ByteBuffer bodyBuffer, int length, int bodyType);
 
+  /**
+   * Parses a multipart/form-data body using the boundary from its Content-Type, into the layout
+   * returned by {@link #nativeFastParseBody} for multipart bodies (in native byte order). Unlike
+   * that method, the boundary is not guessed from the body.
+   *
+   * @param bodyBuffer the body data buffer, which must be direct
+   * @param length the length of the data
+   * @param boundary the boundary parameter, without leading dashes
+   * @return the parsed parts, or null if the boundary is invalid or no part is found
+   */
+  public static native ByteBuffer nativeParseMultipartForm(
+      ByteBuffer bodyBuffer, int length, String boundary);
+
+  /**
+   * Indexes the parts of a multipart/form-data body without copying them. Each part takes 8
+   * ints: the offset and length in the body of its name, filename, content type and content, in
+   * that order. A length of -1 marks a header value that is absent.
+   *
+   * @param bodyBuffer the body data buffer, which must be direct
+   * @param length the length of the data
+   * @param boundary the boundary parameter, without leading dashes
+   * @param index the array to receive the part entries
+   * @return the number of parts, the negated number of parts if the array is too small, or 0 if
+   *     the boundary is invalid or no part is found
+   */
+  public static native int nativeIndexMultipartForm(
+      ByteBuffer bodyBuffer, int length, String boundary, int[] index);
+
   /**
    * Fast content type detection from the body contents.
    *
@@ -251,6 +866,18 @@ public class NativeOptimizer {
     return NATIVE_LOADED.get();
   }
 
+  /**
+   * Gets the instruction set variant of the native SIMD kernels in use, selected for this CPU when
+   * the library was loaded. The {@code BLYFAST_SIMD_VARIANT} environment variable can select a
+   * lower variant.
+   *
+   * @return {@code avx512}, {@code avx2}, {@code sse42} or {@code baseline} on x86-64, {@code neon}
+   *     on aarch64, or null if the native library is not available
+   */
+  public static String getSimdVariant() {
+    return NATIVE_LOADED.get() ? nativeSimdVariant() : null;
+  }
+
   /** Java fallback implementation for fast JSON string escaping. */
   private static String javaEscapeJson(String input) {
     if (input == null) return null;
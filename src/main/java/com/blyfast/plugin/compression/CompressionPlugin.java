@@ -1,12 +1,15 @@
 package com.blyfast.plugin.compression;
 
 import com.blyfast.core.Blyfast;
+import com.blyfast.http.ContentNegotiator;
 import com.blyfast.http.Context;
 import com.blyfast.middleware.Middleware;
 import com.blyfast.plugin.AbstractPlugin;
 import io.undertow.server.HttpServerExchange;
 import io.undertow.util.Headers;
+import java.util.ArrayList;
 import java.util.HashSet;
+import java.util.List;
 import java.util.Set;
 import java.util.regex.Pattern;
 
@@ -46,6 +49,17 @@ public class CompressionPlugin extends AbstractPlugin {
    * @return the middleware
    */
   public Middleware createMiddleware() {
+    // Codings in server preference order; identity keeps q=0 from being ignored
+    List<String> codings = new ArrayList<>();
+    if (config.isEnableGzip()) {
+      codings.add("gzip");
+    }
+    if (config.isEnableDeflate()) {
+      codings.add("deflate");
+    }
+    codings.add("identity");
+    ContentNegotiator negotiator = ContentNegotiator.encodings(codings.toArray(new String[0]));
+
     return ctx -> {
       // Check if compression should be applied
       if (!shouldCompress(ctx)) {
@@ -58,10 +72,11 @@ public class CompressionPlugin extends AbstractPlugin {
         return true; // Client doesn't support compression
       }
 
-      // Apply compression based on accepted encodings
-      if (acceptEncoding.contains("gzip") && config.isEnableGzip()) {
+      // Apply the coding the client prefers, honouring q-values
+      String coding = negotiator.selectOffer(acceptEncoding);
+      if ("gzip".equals(coding)) {
         applyGzipCompression(ctx);
-      } else if (acceptEncoding.contains("deflate") && config.isEnableDeflate()) {
+      } else if ("deflate".equals(coding)) {
         applyDeflateCompression(ctx);
       }
 
@@ -3,10 +3,16 @@ package com.blyfast.plugin.jwt;
 import com.blyfast.core.Blyfast;
 import com.blyfast.http.Context;
 import com.blyfast.middleware.Middleware;
+import com.blyfast.nativeopt.Base64Codec;
 import com.blyfast.plugin.AbstractPlugin;
 import io.jsonwebtoken.*;
+import io.jsonwebtoken.io.Decoder;
+import io.jsonwebtoken.io.DecodingException;
 import io.jsonwebtoken.security.Keys;
 import io.jsonwebtoken.security.SignatureException;
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.InputStream;
 import java.nio.charset.StandardCharsets;
 import java.util.Date;
 import java.util.HashMap;
@@ -22,6 +28,7 @@ public class JwtPlugin extends AbstractPlugin {
 
   private final SecretKey secretKey;
   private final JwtConfig config;
+  private final JwtParser parser;
 
   /**
    * Creates a new JWT plugin with the specified secret key.
@@ -42,6 +49,7 @@ public class JwtPlugin extends AbstractPlugin {
     super("jwt", "1.0.0");
     this.secretKey = Keys.hmacShaKeyFor(secretKey.getBytes(StandardCharsets.UTF_8));
     this.config = config;
+    this.parser = Jwts.parser().verifyWith(this.secretKey).b64Url(new Base64UrlDecoder()).build();
   }
 
   @Override
@@ -160,7 +168,7 @@ public class JwtPlugin extends AbstractPlugin {
    * @throws JwtException if the token is invalid
    */
   public Claims validateToken(String token) throws JwtException {
-    return Jwts.parser().verifyWith(secretKey).build().parseSignedClaims(token).getPayload();
+    return parser.parseSignedClaims(token).getPayload();
   }
 
   /**
@@ -211,8 +219,7 @@ public class JwtPlugin extends AbstractPlugin {
       case "query":
         return ctx.query(key);
       case "cookie":
-        // Cookie extraction would be implemented here
-        break;
+        return ctx.cookie(key);
     }
 
     return null;
@@ -239,6 +246,21 @@ public class JwtPlugin extends AbstractPlugin {
     return config;
   }
 
+  /**
+   * Decodes token segments with the strict base64url codec: a segment with characters outside the
+   * alphabet or nonzero spare bits is rejected, so each token has a single accepted encoding.
+   */
+  private static final class Base64UrlDecoder implements Decoder<InputStream, InputStream> {
+    @Override
+    public InputStream decode(InputStream in) throws DecodingException {
+      try {
+        return new ByteArrayInputStream(Base64Codec.decode(in.readAllBytes(), Base64Codec.URL));
+      } catch (IOException | IllegalArgumentException e) {
+        throw new DecodingException("Invalid base64url token segment: " + e.getMessage(), e);
+      }
+    }
+  }
+
   /** Configuration for the JWT plugin. */
   public static class JwtConfig {
     private String authScheme = DEFAULT_AUTH_SCHEME;
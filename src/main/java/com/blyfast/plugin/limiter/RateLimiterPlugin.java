@@ -1,6 +1,9 @@
 package com.blyfast.plugin.limiter;
 
 import com.blyfast.core.Blyfast;
+import com.blyfast.http.ClientAddress;
+import com.blyfast.http.Context;
+import com.blyfast.http.TrustedProxies;
 import com.blyfast.middleware.Middleware;
 import com.blyfast.plugin.AbstractPlugin;
 import java.time.Duration;
@@ -14,7 +17,8 @@ import java.util.function.Function;
 /** Plugin for rate limiting requests to protect against abuse. */
 public class RateLimiterPlugin extends AbstractPlugin {
   private final RateLimiterConfig config;
-  private final Map<String, TokenBucket> buckets = new ConcurrentHashMap<>();
+  // Keyed by ClientAddress by default, or by the String from a custom key extractor
+  private final Map<Object, TokenBucket> buckets = new ConcurrentHashMap<>();
   private final ScheduledExecutorService scheduler = Executors.newScheduledThreadPool(1);
 
   /** Creates a new rate limiter plugin with default configuration. */
@@ -57,7 +61,12 @@ public class RateLimiterPlugin extends AbstractPlugin {
    * @return the middleware
    */
   public Middleware createMiddleware() {
-    return createMiddleware(config.getKeyExtractor());
+    if (config.hasCustomKeyExtractor()) {
+      return createMiddleware(config.getKeyExtractor());
+    }
+    // Key on the 128-bit address itself; no per-request String is built
+    TrustedProxies proxies = config.getTrustedProxies();
+    return createKeyedMiddleware(ctx -> clientKey(ctx.clientAddress(proxies)));
   }
 
   /**
@@ -67,8 +76,12 @@ public class RateLimiterPlugin extends AbstractPlugin {
    * @return the middleware
    */
   public Middleware createMiddleware(Function<com.blyfast.http.Context, String> keyExtractor) {
+    return createKeyedMiddleware(keyExtractor);
+  }
+
+  private Middleware createKeyedMiddleware(Function<Context, ?> keyExtractor) {
     return ctx -> {
-      String key = keyExtractor.apply(ctx);
+      Object key = keyExtractor.apply(ctx);
 
       // Get or create a token bucket for this key
       TokenBucket bucket =
@@ -87,6 +100,11 @@ public class RateLimiterPlugin extends AbstractPlugin {
     };
   }
 
+  // Requests without a known peer address share one bucket
+  private static Object clientKey(ClientAddress address) {
+    return address != null ? address : "unknown";
+  }
+
   /** Cleans up expired token buckets to prevent memory leaks. */
   private void cleanupExpiredBuckets() {
     long now = System.currentTimeMillis();
@@ -174,16 +192,12 @@ public class RateLimiterPlugin extends AbstractPlugin {
         Duration.ofHours(1); // Time after which unused buckets are removed
     private Duration cleanupInterval =
         Duration.ofMinutes(5); // Interval for cleaning up expired buckets
+    // Forwarding headers are only believed from these proxies
+    private TrustedProxies trustedProxies = TrustedProxies.none();
+    // Default key extractor uses the client IP address
     private Function<com.blyfast.http.Context, String> keyExtractor =
-        ctx ->
-            ctx.request().getHeader("X-Forwarded-For") != null
-                ? ctx.request().getHeader("X-Forwarded-For")
-                : ctx.request()
-                    .getExchange()
-                    .getSourceAddress()
-                    .getHostString(); // Default key extractor uses
-
-    // IP address
+        ctx -> String.valueOf(clientKey(ctx.clientAddress(trustedProxies)));
+    private boolean customKeyExtractor;
 
     public double getMaxTokens() {
       return maxTokens;
@@ -237,7 +251,38 @@ public class RateLimiterPlugin extends AbstractPlugin {
     public RateLimiterConfig setKeyExtractor(
         Function<com.blyfast.http.Context, String> keyExtractor) {
       this.keyExtractor = keyExtractor;
+      this.customKeyExtractor = true;
       return this;
     }
+
+    public boolean hasCustomKeyExtractor() {
+      return customKeyExtractor;
+    }
+
+    public TrustedProxies getTrustedProxies() {
+      return trustedProxies;
+    }
+
+    /**
+     * Sets the reverse proxies whose Forwarded / X-Forwarded-For headers are believed by the
+     * default key extractor. Without any, requests are keyed on the connected peer address.
+     *
+     * @param trustedProxies the trusted proxies
+     * @return this configuration
+     */
+    public RateLimiterConfig setTrustedProxies(TrustedProxies trustedProxies) {
+      this.trustedProxies = trustedProxies;
+      return this;
+    }
+
+    /**
+     * Sets the trusted reverse proxies by address or CIDR range.
+     *
+     * @param cidrs addresses or ranges such as {@code "10.0.0.0/8"}
+     * @return this configuration
+     */
+    public RateLimiterConfig setTrustedProxies(String... cidrs) {
+      return setTrustedProxies(TrustedProxies.of(cidrs));
+    }
   }
 }
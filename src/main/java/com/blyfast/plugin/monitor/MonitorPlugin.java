@@ -2,6 +2,8 @@ package com.blyfast.plugin.monitor;
 
 import com.blyfast.core.Blyfast;
 import com.blyfast.middleware.Middleware;
+import com.blyfast.nativeopt.DirectBufferPool;
+import com.blyfast.nativeopt.HeaderBlockCache;
 import com.blyfast.plugin.AbstractPlugin;
 import java.io.IOException;
 import java.lang.management.ManagementFactory;
@@ -233,6 +235,18 @@ public class MonitorPlugin extends AbstractPlugin {
 
     data.put("paths", pathData);
 
+    // Native header block cache, once it has seen traffic
+    HeaderBlockCache.Stats headerCache = HeaderBlockCache.stats();
+    if (headerCache.getHits() + headerCache.getMisses() + headerCache.getBypasses() > 0) {
+      data.put("headerCache", headerCache.toMap());
+    }
+
+    // Native direct buffer pool, once it has handed out buffers
+    DirectBufferPool.Stats bufferPool = DirectBufferPool.stats();
+    if (bufferPool.getAcquired() > 0) {
+      data.put("bufferPool", bufferPool.toMap());
+    }
+
     return data;
   }
 
@@ -0,0 +1,124 @@
+package com.blyfast.nativeopt;
+
+import static java.lang.foreign.ValueLayout.ADDRESS;
+import static java.lang.foreign.ValueLayout.JAVA_INT;
+
+import java.lang.foreign.FunctionDescriptor;
+import java.lang.foreign.Linker;
+import java.lang.foreign.MemoryLayout;
+import java.lang.foreign.MemorySegment;
+import java.lang.foreign.SymbolLookup;
+import java.lang.invoke.MethodHandle;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Binding through {@code java.lang.foreign} downcalls to the plain C functions in ffm_exports.c.
+ * Compiled for Java 22 into the multi-release part of the jar and loaded by {@link NativeBindings}.
+ *
+ * <p>Every function is linked with {@link Linker.Option#critical(boolean) critical(true)}: none of
+ * them block or call back into Java, so the JVM can skip the thread state transitions and pass heap
+ * arrays in place, without the copying or pinning of JNI array access.
+ */
+final class FfmBindings extends NativeBindings {
+  // Static final, so the JIT treats the handles as constants and inlines the downcalls
+  private static final MethodHandle ANALYZE_HTTP_BODY =
+      downcall("blyfastAnalyzeHttpBody", ADDRESS, JAVA_INT, ADDRESS, JAVA_INT);
+  private static final MethodHandle DETECT_CONTENT_TYPE =
+      downcall("blyfastDetectContentType", ADDRESS, JAVA_INT);
+  private static final MethodHandle PARSE_COOKIES =
+      downcall("blyfastParseCookies", ADDRESS, JAVA_INT, ADDRESS, JAVA_INT);
+  private static final MethodHandle PARSE_QUERY =
+      downcall("blyfastParseQuery", ADDRESS, JAVA_INT, ADDRESS, JAVA_INT);
+  private static final MethodHandle PERCENT_DECODE =
+      downcall("blyfastPercentDecode", ADDRESS, JAVA_INT, ADDRESS, JAVA_INT);
+
+  @Override
+  public String getName() {
+    return "ffm";
+  }
+
+  @Override
+  public int analyzeHttpBody(ByteBuffer body, int length, String contentType) {
+    MemorySegment segment = MemorySegment.ofBuffer(body.slice(0, body.limit()));
+    if (length < 0 || length > segment.byteSize()) {
+      return 0;
+    }
+    byte[] type = contentType.getBytes(StandardCharsets.UTF_8);
+    try {
+      return (int)
+          ANALYZE_HTTP_BODY.invokeExact(segment, length, MemorySegment.ofArray(type), type.length);
+    } catch (Throwable e) {
+      throw new IllegalStateException("Native call failed", e);
+    }
+  }
+
+  @Override
+  public int detectContentType(ByteBuffer body, int length) {
+    MemorySegment segment = MemorySegment.ofBuffer(body.slice(0, body.limit()));
+    if (length < 0 || length > segment.byteSize()) {
+      return 0;
+    }
+    try {
+      return (int) DETECT_CONTENT_TYPE.invokeExact(segment, length);
+    } catch (Throwable e) {
+      throw new IllegalStateException("Native call failed", e);
+    }
+  }
+
+  @Override
+  public int parseCookies(byte[] header, int length, int[] index) {
+    if (length < 0 || length > header.length) {
+      return 0;
+    }
+    try {
+      return (int)
+          PARSE_COOKIES.invokeExact(
+              MemorySegment.ofArray(header), length, MemorySegment.ofArray(index), index.length);
+    } catch (Throwable e) {
+      throw new IllegalStateException("Native call failed", e);
+    }
+  }
+
+  @Override
+  public int parseQuery(byte[] query, int length, int[] index) {
+    if (length < 0 || length > query.length) {
+      return 0;
+    }
+    try {
+      return (int)
+          PARSE_QUERY.invokeExact(
+              MemorySegment.ofArray(query), length, MemorySegment.ofArray(index), index.length);
+    } catch (Throwable e) {
+      throw new IllegalStateException("Native call failed", e);
+    }
+  }
+
+  @Override
+  public int percentDecode(byte[] src, int offset, int length, byte[] dest, boolean plusAsSpace) {
+    if (offset < 0 || length < 0 || offset > src.length - length || dest.length < length) {
+      return -2;
+    }
+    try {
+      return (int)
+          PERCENT_DECODE.invokeExact(
+              MemorySegment.ofArray(src).asSlice(offset, length),
+              length,
+              MemorySegment.ofArray(dest),
+              plusAsSpace ? 1 : 0);
+    } catch (Throwable e) {
+      throw new IllegalStateException("Native call failed", e);
+    }
+  }
+
+  // Links an int-returning function of the library NativeOptimizer loaded into this class loader
+  private static MethodHandle downcall(String name, MemoryLayout... arguments) {
+    MemorySegment symbol =
+        SymbolLookup.loaderLookup()
+            .find(name)
+            .orElseThrow(() -> new UnsatisfiedLinkError("Native function not found: " + name));
+    return Linker.nativeLinker()
+        .downcallHandle(
+            symbol, FunctionDescriptor.of(JAVA_INT, arguments), Linker.Option.critical(true));
+  }
+}
@@ -0,0 +1,72 @@
+#include "blyfastnative.h"
+
+/**
+ * Base64 and base64url (RFC 4648 4 and 5) for direct buffers. The codec itself is a SIMD kernel,
+ * in base64_codec.c.
+ */
+
+/**
+ * Gets the encoded length of `length` bytes.
+ */
+int base64EncodedLength(int length, int flags) {
+    if (flags & BASE64_NO_PADDING) {
+        return (int)(((int64_t)length * 4 + 2) / 3);
+    }
+    return (int)(((int64_t)length + 2) / 3 * 4);
+}
+
+/**
+ * Gets an upper bound on the decoded length of `length` characters.
+ */
+int base64DecodedMaxLength(int length) {
+    return (int)(((int64_t)length * 3 + 3) / 4);
+}
+
+/**
+ * Encodes `length` bytes at `srcOffset` in a direct buffer as base64 at `dstOffset` in another.
+ * Returns the number of characters written, or -1 if the arguments are invalid or `dst` is too
+ * small.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBase64Encode
+  (JNIEnv *env, jclass cls, jobject src, jint srcOffset, jint length, jobject dst,
+   jint dstOffset, jint flags) {
+    // The encoded length must fit in a jint
+    if (src == NULL || dst == NULL || srcOffset < 0 || length < 0 || dstOffset < 0 ||
+        length > INT_MAX / 4 * 3) {
+        return -1;
+    }
+    const unsigned char* in = (const unsigned char*)(*env)->GetDirectBufferAddress(env, src);
+    char* out = (char*)(*env)->GetDirectBufferAddress(env, dst);
+    if (in == NULL || out == NULL ||
+        (jlong)srcOffset + length > (*env)->GetDirectBufferCapacity(env, src) ||
+        (jlong)dstOffset + base64EncodedLength(length, flags) >
+            (*env)->GetDirectBufferCapacity(env, dst)) {
+        return -1;
+    }
+    return base64Encode(in + srcOffset, length, out + dstOffset, flags);
+}
+
+/**
+ * Decodes `length` base64 characters at `srcOffset` in a direct buffer to `dstOffset` in another,
+ * which needs room for (length * 3 + 3) / 4 bytes. The buffers may be the same, with `dstOffset`
+ * no greater than `srcOffset`.
+ *
+ * Returns the number of bytes written, -1 - offset of the first invalid character (relative to
+ * `srcOffset`), or Integer.MIN_VALUE if the arguments are invalid or `dst` is too small.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBase64Decode
+  (JNIEnv *env, jclass cls, jobject src, jint srcOffset, jint length, jobject dst,
+   jint dstOffset, jint flags) {
+    if (src == NULL || dst == NULL || srcOffset < 0 || length < 0 || dstOffset < 0) {
+        return INT_MIN;
+    }
+    const unsigned char* in = (const unsigned char*)(*env)->GetDirectBufferAddress(env, src);
+    unsigned char* out = (unsigned char*)(*env)->GetDirectBufferAddress(env, dst);
+    if (in == NULL || out == NULL ||
+        (jlong)srcOffset + length > (*env)->GetDirectBufferCapacity(env, src) ||
+        (jlong)dstOffset + base64DecodedMaxLength(length) >
+            (*env)->GetDirectBufferCapacity(env, dst)) {
+        return INT_MIN;
+    }
+    return base64Decode(in + srcOffset, length, out + dstOffset, flags);
+}
@@ -0,0 +1,265 @@
+#include "blyfastnative.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Base64 and base64url (RFC 4648 4 and 5).
+ *
+ * With AVX2 the encoder turns 24 bytes into 32 characters per iteration: a byte shuffle spreads
+ * each 3-byte group over 4 bytes, two 16-bit multiplies move the four 6-bit fields into separate
+ * bytes, and a table lookup keyed on each field's range adds the alphabet offset. The decoder
+ * classifies 32 characters at once with range compares, adds each range's offset and packs the
+ * 6-bit values back with two multiply-adds. Blocks holding padding, whitespace or invalid
+ * characters, and the tails, go through the scalar code, which also reports errors.
+ */
+
+static const char ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char URL_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static inline int decodeChar(unsigned char c, int url) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == (url ? '-' : '+')) {
+        return 62;
+    }
+    if (c == (url ? '_' : '/')) {
+        return 63;
+    }
+    return -1;
+}
+
+static inline int isBase64Whitespace(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+#if defined(__AVX2__)
+
+// Encodes src[0, 24) into 32 characters; reads src[0, 28)
+static inline void encodeBlock(const unsigned char* src, char* dst, __m256i offsets) {
+    __m256i in = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)src)),
+        _mm_loadu_si128((const __m128i*)(src + 12)), 1);
+
+    // Each 32-bit group takes bytes b1 b0 b2 b1 of a 3-byte group, so that the four 6-bit
+    // fields can be shifted into place by 16-bit multiplies
+    in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m256i fieldsAc = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                                          _mm256_set1_epi32(0x04000040));
+    __m256i fieldsBd = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                                          _mm256_set1_epi32(0x01000010));
+    __m256i values = _mm256_or_si256(fieldsAc, fieldsBd);
+
+    // Range index: 0 for A-Z, 1 for a-z, 2-11 for digits, 12 and 13 for the last two characters
+    __m256i range = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+    range = _mm256_sub_epi8(range, _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+    __m256i chars = _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, range));
+    _mm256_storeu_si256((__m256i*)dst, chars);
+}
+
+static inline __m256i inRange(__m256i in, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8((char)(low - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(high + 1)), in));
+}
+
+// Decodes 32 alphabet characters into 24 bytes; returns 0 without writing if any is not one
+static inline int decodeBlock(const unsigned char* src, unsigned char* dst, char char62,
+                              char char63) {
+    __m256i in = _mm256_loadu_si256((const __m256i*)src);
+    __m256i upper = inRange(in, 'A', 'Z');
+    __m256i lower = inRange(in, 'a', 'z');
+    __m256i digit = inRange(in, '0', '9');
+    __m256i is62 = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(char62));
+    __m256i is63 = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(char63));
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                                    _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+    if ((uint32_t)_mm256_movemask_epi8(valid) != 0xFFFFFFFFu) {
+        return 0;
+    }
+
+    __m256i delta = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    delta = _mm256_or_si256(delta, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+    delta = _mm256_or_si256(delta, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+    delta = _mm256_or_si256(delta,
+                            _mm256_and_si256(is62, _mm256_set1_epi8((char)(62 - char62))));
+    delta = _mm256_or_si256(delta,
+                            _mm256_and_si256(is63, _mm256_set1_epi8((char)(63 - char63))));
+    __m256i values = _mm256_add_epi8(in, delta);
+
+    // a b c d per 32-bit group -> (a << 18) | (b << 12) | (c << 6) | d
+    __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    groups = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    groups = _mm256_permutevar8x32_epi32(groups, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+    _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(groups));
+    _mm_storel_epi64((__m128i*)(dst + 16), _mm256_extracti128_si256(groups, 1));
+    return 1;
+}
+
+#endif
+
+/**
+ * Encodes `length` bytes into `dst`, which must hold base64EncodedLength bytes. Returns the
+ * number of characters written.
+ */
+int SIMD_KERNEL(base64Encode)(const unsigned char* src, int length, char* dst, int flags) {
+    const char* alphabet = (flags & BASE64_URL) ? URL_ALPHABET : ALPHABET;
+    int i = 0;
+    char* out = dst;
+
+#if defined(__AVX2__)
+    const __m256i offsets = (flags & BASE64_URL)
+        ? _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -17, 32, 0, 0)
+        : _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+                           65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    for (; i + 28 <= length; i += 24) {
+        encodeBlock(src + i, out, offsets);
+        out += 32;
+    }
+#endif
+
+    for (; i + 3 <= length; i += 3) {
+        uint32_t group = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        out[0] = alphabet[group >> 18];
+        out[1] = alphabet[(group >> 12) & 0x3F];
+        out[2] = alphabet[(group >> 6) & 0x3F];
+        out[3] = alphabet[group & 0x3F];
+        out += 4;
+    }
+
+    int remaining = length - i;
+    if (remaining > 0) {
+        uint32_t group = (uint32_t)src[i] << 16;
+        if (remaining == 2) {
+            group |= (uint32_t)src[i + 1] << 8;
+        }
+        *out++ = alphabet[group >> 18];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        if (remaining == 2) {
+            *out++ = alphabet[(group >> 6) & 0x3F];
+        }
+        if (!(flags & BASE64_NO_PADDING)) {
+            *out++ = '=';
+            if (remaining == 1) {
+                *out++ = '=';
+            }
+        }
+    }
+    return (int)(out - dst);
+}
+
+/**
+ * Decodes `length` characters into `dst`, which must hold base64DecodedMaxLength bytes. Padding
+ * is optional but, when present, must complete the last group. BASE64_LENIENT skips whitespace
+ * and accepts non-zero bits after the last byte, as MIME decoders do.
+ *
+ * Returns the number of bytes written, or -1 - offset of the first invalid character; an offset
+ * of `length` means the input ended inside a group.
+ */
+int SIMD_KERNEL(base64Decode)(const unsigned char* src, int length, unsigned char* dst, int flags) {
+    int url = flags & BASE64_URL;
+    int lenient = flags & BASE64_LENIENT;
+    unsigned char* out = dst;
+    uint32_t group = 0;
+    int count = 0;           // 6-bit values in group
+    int lastData = -1;       // Offset of the last character decoded
+    int i = 0;
+
+#if defined(__AVX2__)
+    const char char62 = url ? '-' : '+';
+    const char char63 = url ? '_' : '/';
+    int vectorFrom = 0;      // Blocks starting before this offset are known to fail
+#endif
+
+    while (i < length) {
+#if defined(__AVX2__)
+        if (count == 0 && i >= vectorFrom) {
+            while (i + 32 <= length && decodeBlock(src + i, out, char62, char63)) {
+                i += 32;
+                out += 24;
+                lastData = i - 1;
+            }
+            vectorFrom = i + 32;
+            if (i >= length) {
+                break;
+            }
+        }
+#endif
+        unsigned char c = src[i];
+        int value = decodeChar(c, url);
+        if (value >= 0) {
+            group = (group << 6) | (uint32_t)value;
+            lastData = i;
+            if (++count == 4) {
+                out[0] = (unsigned char)(group >> 16);
+                out[1] = (unsigned char)(group >> 8);
+                out[2] = (unsigned char)group;
+                out += 3;
+                group = 0;
+                count = 0;
+            }
+            i++;
+        } else if (lenient && isBase64Whitespace(c)) {
+            i++;
+        } else if (c == '=') {
+            // Padding completes a group of two or three values and ends the input
+            if (count < 2) {
+                return -1 - i;
+            }
+            int missing = 4 - count;
+            while (i < length && missing > 0) {
+                if (src[i] == '=') {
+                    missing--;
+                } else if (!(lenient && isBase64Whitespace(src[i]))) {
+                    return -1 - i;
+                }
+                i++;
+            }
+            if (missing > 0) {
+                return -1 - length;
+            }
+            while (i < length) {
+                if (!(lenient && isBase64Whitespace(src[i]))) {
+                    return -1 - i;
+                }
+                i++;
+            }
+        } else {
+            return -1 - i;
+        }
+    }
+
+    // A final group of two or three values holds one or two bytes; its spare bits must be zero
+    if (count == 1) {
+        return -1 - length;
+    }
+    if (count == 2) {
+        if (!lenient && (group & 0x0F) != 0) {
+            return -1 - lastData;
+        }
+        *out++ = (unsigned char)(group >> 4);
+    } else if (count == 3) {
+        if (!lenient && (group & 0x03) != 0) {
+            return -1 - lastData;
+        }
+        *out++ = (unsigned char)(group >> 10);
+        *out++ = (unsigned char)(group >> 2);
+    }
+    return (int)(out - dst);
+}
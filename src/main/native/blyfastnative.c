@@ -248,6 +248,29 @@ JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeMemoryCo
     }
 }
 
+/**
+ * Classifies a body by its Content-Type: 0=unknown, 1=JSON, 2=form, 3=multipart, 4=text,
+ * 5=binary. A JSON body that does not start with '{' or '[' is unknown.
+ */
+int analyzeHttpBody(const char* buffer, int length, const char* contentType,
+                    int contentTypeLength) {
+    // Classify by the parsed type and subtype rather than substrings of the header
+    MediaType mediaType;
+    if (!parseMediaType(contentType, contentTypeLength, &mediaType)) {
+        return 5; // Assume binary
+    } else if (mediaTypeIs(&mediaType, "application", "json")) {
+        // Simple validation - check if it starts with { or [
+        return (length > 0 && (buffer[0] == '{' || buffer[0] == '[')) ? 1 : 0;
+    } else if (mediaTypeIs(&mediaType, "application", "x-www-form-urlencoded")) {
+        return 2; // Form data
+    } else if (mediaTypeIs(&mediaType, "multipart", "form-data")) {
+        return 3; // Multipart form
+    } else if (mediaTypeIs(&mediaType, "text", NULL)) {
+        return 4; // Text
+    }
+    return 5; // Assume binary
+}
+
 /**
  * Optimized HTTP body processing - analyzes content type and prepares for parsing
  */
@@ -269,20 +292,7 @@ JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeAnalyzeH
     if (contentType != NULL) {
         const char *ctStr = (*env)->GetStringUTFChars(env, contentType, NULL);
         if (ctStr != NULL) {
-            // Case-insensitive matching using portable function
-            if (strcasestr_portable(ctStr, "application/json") != NULL) {
-                // Simple validation - check if it starts with { or [
-                bodyType = (length > 0 && (buffer[0] == '{' || buffer[0] == '[')) ? 1 : 0;
-            } else if (strcasestr_portable(ctStr, "application/x-www-form-urlencoded") != NULL) {
-                bodyType = 2; // Form data
-            } else if (strcasestr_portable(ctStr, "multipart/form-data") != NULL) {
-                bodyType = 3; // Multipart form
-            } else if (strcasestr_portable(ctStr, "text/") != NULL) {
-                bodyType = 4; // Text
-            } else {
-                bodyType = 5; // Assume binary
-            }
-            
+            bodyType = analyzeHttpBody(buffer, length, ctStr, (int)strlen(ctStr));
             (*env)->ReleaseStringUTFChars(env, contentType, ctStr);
         }
     }
@@ -321,8 +331,8 @@ JNIEXPORT jobject JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFastP
             break;
             
         case 3: // Multipart form
-            // For multipart form, we extract boundaries and parts
-            resultBuffer = parseMultipartForm(env, buffer, length);
+            // Without the Content-Type, the boundary is taken from the first delimiter line
+            resultBuffer = parseMultipartForm(env, buffer, length, NULL, 0);
             break;
             
         case 4: // Text
@@ -337,16 +347,11 @@ JNIEXPORT jobject JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFastP
 }
 
 /**
- * Fast content type detection - improved algorithm
+ * Detects the type of a body from its first bytes, with the codes of analyzeHttpBody plus
+ * 6=XML and 7=HTML.
  */
-JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFastDetectContentType
-  (JNIEnv *env, jclass cls, jobject bodyBuffer, jint length) {
-    if (bodyBuffer == NULL) {
-        return 0; // Unknown
-    }
-    
-    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, bodyBuffer);
-    if (buffer == NULL || length <= 0) {
+int detectContentType(const char* buffer, int length) {
+    if (length <= 0) {
         return 0; // Unknown
     }
     
@@ -399,3 +404,19 @@ JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFastDete
         return 4;
     }
 }
+
+/**
+ * Fast content type detection - improved algorithm
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFastDetectContentType
+  (JNIEnv *env, jclass cls, jobject bodyBuffer, jint length) {
+    if (bodyBuffer == NULL) {
+        return 0; // Unknown
+    }
+    
+    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, bodyBuffer);
+    if (buffer == NULL) {
+        return 0; // Unknown
+    }
+    return detectContentType(buffer, length);
+}
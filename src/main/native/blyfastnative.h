@@ -15,7 +15,6 @@
 #define MAX_BOUNDARY_LEN 256
 #define MAX_HEADER_NAME_LEN 1024
 #define MAX_CONTENT_TYPE_LEN 256
-#define MAX_PARTS 100
 #define MAX_JSON_NUMBER_LEN 64
 #define MAX_FORM_DATA_EXPANSION 3
 #define INITIAL_ESCAPE_BUFFER_SIZE 64
@@ -23,6 +22,13 @@
 #define BINARY_CHAR_THRESHOLD_PERCENT 10
 #define TEXT_CHAR_THRESHOLD_PERCENT 90
 
+// Layout of the buffer written by nativeExportHeaders
+#define HEADER_EXPORT_PREAMBLE_SIZE 8
+#define HEADER_EXPORT_ENTRY_SIZE 16
+
+// Header sets with at least this many entries get a hashed name index
+#define HEADER_INDEX_THRESHOLD 16
+
 // Helper macro for JNI exception checking
 #define CHECK_JNI_EXCEPTION(env) \
     do { \
@@ -40,6 +46,170 @@
         } \
     } while(0)
 
+// Strict header framing errors, returned negated from nativeParseHttpHeadersStrict
+#define HEADER_ERROR_BARE_CR 1
+#define HEADER_ERROR_OBS_FOLD 2
+#define HEADER_ERROR_NUL 3
+#define HEADER_ERROR_INVALID_FIELD 4
+#define HEADER_ERROR_DUPLICATE_CONTENT_LENGTH 5
+#define HEADER_ERROR_INVALID_CONTENT_LENGTH 6
+#define HEADER_ERROR_CONTENT_LENGTH_WITH_TRANSFER_ENCODING 7
+
+// Header block dedup cache: repeated blocks reuse a shared parsed set
+#define MAX_VOLATILE_HEADERS 16
+#define MAX_CACHED_HEADER_LINES 64
+#define HEADER_CACHE_STATS 5            // hits, misses, bypasses, evictions, bytes reused
+
+// percentDecode result when the input contains no escapes
+#define PERCENT_DECODE_UNCHANGED -1
+
+// Cookie index entry: name_off, name_len, value_off, value_len
+#define COOKIE_INDEX_ENTRY_INTS 4
+
+// Query string index: [name_off, name_len, value_off, value_len, flags] per parameter
+#define QUERY_INDEX_ENTRY_INTS 5
+#define QUERY_NAME_ENCODED 1            // Name contains '%' or '+'
+#define QUERY_VALUE_ENCODED 2           // Value contains '%' or '+'
+
+// Content negotiation: offer kinds and registry limits
+#define NEGOTIATION_MEDIA_TYPE 0
+#define NEGOTIATION_ENCODING 1
+#define NEGOTIATION_LANGUAGE 2
+#define MAX_NEGOTIATION_OFFERS 32
+#define MAX_NEGOTIATION_OFFER_SETS 64
+#define MAX_NEGOTIATION_OFFER_LEN 127
+
+// Client address resolution from Forwarded / X-Forwarded-For
+#define MAX_TRUSTED_PROXY_SETS 64
+#define MAX_TRUSTED_PROXY_CIDRS 64
+#define TRUSTED_PROXY_CIDR_LONGS 4      // address high/low, mask high/low
+#define MAX_FORWARDED_HOPS 64
+#define MAX_FORWARDED_NODE_LEN 64
+
+// Registered header sets for the HTTP/1.1 response head writer
+#define MAX_RESPONSE_HEADER_SETS 64
+
+// HPACK (RFC 7541) limits for HTTP/2 header blocks
+#define HPACK_STATIC_TABLE_SIZE 61
+#define HPACK_HUFFMAN_SYMBOLS 257
+#define HPACK_DEFAULT_TABLE_SIZE 4096
+#define HPACK_ENTRY_OVERHEAD 32
+#define MAX_HPACK_STRING_LEN (64 * 1024)
+
+// Registered response header sets for the HPACK encoder
+#define HPACK_MAX_CACHED_SETS 64
+#define HPACK_MAX_CACHED_SET_SIZE 32
+
+// HPACK decoder errors, returned negated from nativeHpackDecode; all are COMPRESSION_ERROR
+#define HPACK_ERROR_TRUNCATED 1
+#define HPACK_ERROR_INTEGER_OVERFLOW 2
+#define HPACK_ERROR_INVALID_INDEX 3
+#define HPACK_ERROR_HUFFMAN 4
+#define HPACK_ERROR_TABLE_SIZE 5
+#define HPACK_ERROR_STRING_TOO_LONG 6
+#define HPACK_ERROR_NO_MEMORY 7
+#define HPACK_ERROR_NO_SLOT 8
+
+// Chunked transfer coding (RFC 9112 7.1) limits
+#define MAX_CHUNK_EXTENSION_LEN 4096
+#define MAX_CHUNKED_TRAILER_LINE 8192
+#define MAX_CHUNKED_TRAILERS 64
+#define CHUNK_HEADER_RESERVE 10         // Eight hex digits plus CRLF, enough for any jint size
+
+// Chunked decoder errors, returned negated from nativeChunkedDecode
+#define CHUNKED_ERROR_INVALID_SIZE 1
+#define CHUNKED_ERROR_SIZE_OVERFLOW 2
+#define CHUNKED_ERROR_MISSING_CRLF 3
+#define CHUNKED_ERROR_EXTENSION_TOO_LONG 4
+#define CHUNKED_ERROR_TRAILER_TOO_LONG 5
+#define CHUNKED_ERROR_INVALID_TRAILER 6
+#define CHUNKED_ERROR_NO_MEMORY 7
+
+// nativeChunkedDecode result: consumed bytes, produced bytes and a completion flag
+#define CHUNKED_RESULT_PRODUCED_SHIFT 31
+#define CHUNKED_RESULT_COMPLETE_SHIFT 62
+
+// Streaming multipart parser limits
+#define MAX_MULTIPART_HEADER_BLOCK 16384    // Largest part header block held back between chunks
+#define MAX_MULTIPART_PADDING 64            // Transport padding allowed after a boundary
+
+// Streaming multipart events, MULTIPART_EVENT_INTS ints each
+#define MULTIPART_EVENT_INTS 7
+#define MULTIPART_EVENT_PART_BEGIN 1
+#define MULTIPART_EVENT_DATA 2
+#define MULTIPART_EVENT_PART_END 3
+#define MULTIPART_EVENT_END 4
+
+// Streaming multipart errors, returned negated from nativeMultipartParse
+#define MULTIPART_ERROR_INVALID_ARGUMENT 1
+#define MULTIPART_ERROR_INVALID_DELIMITER 2
+#define MULTIPART_ERROR_INVALID_HEADER 3
+#define MULTIPART_ERROR_HEADERS_TOO_LONG 4
+
+// nativeMultipartParse result: consumed bytes, event count and a completion flag
+#define MULTIPART_RESULT_EVENTS_SHIFT 31
+#define MULTIPART_RESULT_COMPLETE_SHIFT 62
+
+// Ints per part written by nativeIndexMultipartForm
+#define MULTIPART_INDEX_ENTRY_INTS 8
+
+// Multipart spill files coalesce part content into writes of this size
+#define SPILL_WRITE_BUFFER_SIZE (1024 * 1024)
+
+// Multipart response framing: longest boundary allowed by RFC 2046 5.1.1
+#define MAX_MULTIPART_RESPONSE_BOUNDARY 70
+
+// Base64 codec flags (RFC 4648)
+#define BASE64_URL 1                    // base64url alphabet
+#define BASE64_LENIENT 2                // Decoding skips whitespace and ignores spare bits
+#define BASE64_NO_PADDING 4             // Encoding omits '=' padding
+
+// Direct buffer pool: power-of-two blocks from 4 KB to 16 MB under a global budget
+#define BUFFER_POOL_MIN_SHIFT 12
+#define BUFFER_POOL_MAX_SHIFT 24
+#define BUFFER_POOL_CLASSES (BUFFER_POOL_MAX_SHIFT - BUFFER_POOL_MIN_SHIFT + 1)
+#define BUFFER_POOL_THREAD_CACHE_MAX_SHIFT 16   // Larger blocks are only cached on shared lists
+#define BUFFER_POOL_THREAD_CACHE_BLOCKS 4       // Per class and thread
+#define BUFFER_POOL_DEFAULT_BUDGET (256LL * 1024 * 1024)
+#define BUFFER_POOL_STATS (10 + BUFFER_POOL_CLASSES)  // Counters, then blocks in use per class
+
+// Framing state carried across the lines of one header block during strict parsing
+typedef struct {
+    int contentLengths;
+    int transferEncodings;
+    int error;                      // HEADER_ERROR_* code, 0 while the block is valid
+} HeaderFraming;
+
+// Parsed Content-Type value; type, subtype and charset point into the parsed string
+typedef struct {
+    const char* type;
+    int typeLength;
+    const char* subtype;
+    int subtypeLength;
+    const char* charset;            // Without quotes; NULL if absent
+    int charsetLength;
+    char boundary[MAX_BOUNDARY_LEN]; // NUL-terminated, quoted-pairs resolved; empty if absent
+    int boundaryLength;
+} MediaType;
+
+// Bump allocator for short-lived per-call data: nothing is freed individually, and the heap
+// blocks are all released together by arenaRelease
+#define ARENA_ALIGNMENT 16
+#define ARENA_MIN_BLOCK_SIZE 4096
+#define ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    unsigned char data[];
+} ArenaBlock;
+
+typedef struct {
+    unsigned char* cursor;          // Next free byte of the current block
+    unsigned char* limit;           // End of the current block
+    ArenaBlock* blocks;             // Heap blocks, newest first
+    size_t nextBlockSize;
+} Arena;
+
 // Thread safety for header storage
 extern pthread_mutex_t headers_mutex;
 
@@ -47,16 +217,61 @@ extern pthread_mutex_t headers_mutex;
 typedef struct HeaderValue {
     char* name;
     char* value;
+    int nameLen;
+    int valueLen;
+    uint32_t nameHash;              // Hash of the lowercased name
+    int sharedBefore;               // Own headers of a cache-built set: shared headers before it
     struct HeaderValue* next;
+    struct HeaderValue* nextSame;   // Next header with the same name (indexed sets only)
 } HeaderValue;
 
-// Headers collection for the parsed HTTP headers
+// Open-addressing index slot: first/last header sharing a name
 typedef struct {
+    uint32_t hash;
+    HeaderValue* first;
+    HeaderValue* last;
+} HeaderIndexSlot;
+
+// Headers collection for the parsed HTTP headers (kept in wire order)
+typedef struct ParsedHeaders {
     HeaderValue* first;
+    HeaderValue* last;
     int count;
     jlong id;
+    HeaderIndexSlot* index;         // NULL until count reaches HEADER_INDEX_THRESHOLD
+    uint32_t indexMask;
+    struct ParsedHeaders* base;     // Shared cached headers, linked after this set's own ones
+                                    // but merged back into wire order on export
+    int refCount;                   // Holders of a shared set; 0 for sets with a single owner
 } ParsedHeaders;
 
+// HPACK static table entry
+typedef struct {
+    const char* name;
+    int nameLen;
+    const char* value;
+    int valueLen;
+} HpackStaticEntry;
+
+// HPACK dynamic table entry; name and value share one allocation
+typedef struct {
+    char* data;
+    int nameLen;
+    int valueLen;
+} HpackTableEntry;
+
+// Per-connection HPACK dynamic table (ring buffer, newest entry at head)
+typedef struct {
+    HpackTableEntry* entries;
+    int capacity;
+    int count;
+    int head;
+    size_t size;            // RFC 7541 4.1 size: name + value + 32 per entry
+    size_t maxSize;         // Current limit from dynamic table size updates
+    size_t settingsMaxSize; // Upper bound from SETTINGS_HEADER_TABLE_SIZE
+    uint64_t insertCount;   // Entries ever inserted; lets the encoder locate its own inserts
+} HpackDynamicTable;
+
 // Global storage for parsed headers (improved with thread safety)
 extern ParsedHeaders* headers_storage[MAX_HEADERS];
 extern volatile int next_header_id;
@@ -67,9 +282,45 @@ extern int free_header_count;
 
 // Utility function declarations
 int urlDecode(char* dest, const char* src, int len);
+int findPercentEscape(const char* src, int pos, int len, int plusAsSpace);
+int percentDecode(char* dest, const char* src, int len, int plusAsSpace);
 int hexCharToInt(char c);
+int containsLineBreak(const char* str, size_t len);
 const char* strcasestr_portable(const char* haystack, const char* needle);
 void freeHeadersList(HeaderValue* header);
+uint32_t headerNameHash(const char* name, size_t len);
+void arenaInit(Arena* arena, void* initial, size_t initialSize);
+void* arenaAlloc(Arena* arena, size_t size);
+void arenaRelease(Arena* arena);
+
+// Header set function declarations
+ParsedHeaders* newParsedHeaders(void);
+void freeParsedHeaders(ParsedHeaders* headers);
+int addParsedHeader(ParsedHeaders* headers, const char* name, size_t nameLen,
+                    const char* value, size_t valueLen);
+int addHeaderLine(ParsedHeaders* headers, const char* line, const char* lineEnd);
+const char* findHeaderLineEnd(const char* pos, const char* end, HeaderFraming* framing);
+int checkHeaderFraming(HeaderFraming* framing, const char* line, const char* lineEnd);
+void buildHeaderIndex(ParsedHeaders* headers);
+jlong registerParsedHeaders(ParsedHeaders* headers);
+HeaderValue* findHeader(ParsedHeaders* headers, const char* name, size_t nameLen);
+HeaderValue* findNextHeader(ParsedHeaders* headers, HeaderValue* current);
+
+// Header block dedup cache
+int headerBlockCacheEnabled(void);
+ParsedHeaders* parseCachedHeaderBlock(const char* buffer, int length, HeaderFraming* framing);
+
+// HPACK function declarations
+extern const HpackStaticEntry hpackStaticTable[HPACK_STATIC_TABLE_SIZE];
+extern const uint32_t hpackHuffmanCodes[HPACK_HUFFMAN_SYMBOLS];
+extern const uint8_t hpackHuffmanCodeLengths[HPACK_HUFFMAN_SYMBOLS];
+int hpackTableInit(HpackDynamicTable* table, size_t maxSize);
+void hpackTableFree(HpackDynamicTable* table);
+int hpackTableAdd(HpackDynamicTable* table, const char* name, int nameLen,
+                  const char* value, int valueLen);
+void hpackTableSetMaxSize(HpackDynamicTable* table, size_t maxSize);
+HpackTableEntry* hpackTableGet(HpackDynamicTable* table, int index);
+int hpackHuffmanDecode(const unsigned char* src, size_t len, char* dest, size_t destCap);
 
 // JSON parser function declarations
 void initJsonParserCache(JNIEnv *env);
@@ -82,7 +333,67 @@ jobject parseJsonNumber(JNIEnv *env, const char **cursor, const char *end);
 
 // Form parser function declarations
 jobject parseFormData(JNIEnv *env, char* buffer, jint length);
-jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length);
+int tokenizeQuery(const unsigned char* query, int length, jint* index, int maxParams);
+int tokenizeCookies(const unsigned char* header, int length, jint* index, int maxCookies);
+
+// Body classification
+int analyzeHttpBody(const char* buffer, int length, const char* contentType,
+                    int contentTypeLength);
+int detectContentType(const char* buffer, int length);
+
+// Multipart boundary search
+int findBoundary(const unsigned char* haystack, int pos, int length, const char* needle,
+                 int needleLength);
+int findBoundaryPrefix(const unsigned char* haystack, int pos, int length, const char* needle,
+                       int needleLength);
+jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length, const char* boundary,
+                           int boundaryLength);
+
+// Media type parsing
+int parseMediaType(const char* value, int length, MediaType* out);
+int mediaTypeIs(const MediaType* mediaType, const char* type, const char* subtype);
+
+// Base64 codec
+int base64EncodedLength(int length, int flags);
+int base64DecodedMaxLength(int length);
+int base64Encode(const unsigned char* src, int length, char* dst, int flags);
+int base64Decode(const unsigned char* src, int length, unsigned char* dst, int flags);
+
+// Direct buffer pool
+int64_t bufferPoolAcquire(int size);
+void* bufferPoolBlock(int64_t handle, int64_t* capacity);
+int bufferPoolRelease(int64_t handle);
+void bufferPoolSetBudget(int64_t budget);
+
+// SIMD kernels. KERNEL_SOURCES in the Makefile are compiled once per instruction set with
+// SIMD_VARIANT naming the variant, and SIMD_KERNEL appends it to each kernel's name; the
+// unsuffixed declarations above forward to the variant selected at load time (cpu_dispatch.c)
+#define SIMD_KERNEL_CONCAT(name, variant) name##_##variant
+#define SIMD_KERNEL_NAME(name, variant) SIMD_KERNEL_CONCAT(name, variant)
+#define SIMD_KERNEL(name) SIMD_KERNEL_NAME(name, SIMD_VARIANT)
+
+typedef struct {
+    const char* name;
+    int (*findBoundary)(const unsigned char* haystack, int pos, int length, const char* needle,
+                        int needleLength);
+    int (*findPercentEscape)(const char* src, int pos, int len, int plusAsSpace);
+    int (*base64Encode)(const unsigned char* src, int length, char* dst, int flags);
+    int (*base64Decode)(const unsigned char* src, int length, unsigned char* dst, int flags);
+} SimdKernels;
+
+#define DECLARE_SIMD_KERNELS(variant) \
+    int SIMD_KERNEL_NAME(findBoundary, variant)(const unsigned char* haystack, int pos, \
+                                                int length, const char* needle, \
+                                                int needleLength); \
+    int SIMD_KERNEL_NAME(findPercentEscape, variant)(const char* src, int pos, int len, \
+                                                     int plusAsSpace); \
+    int SIMD_KERNEL_NAME(base64Encode, variant)(const unsigned char* src, int length, char* dst, \
+                                                int flags); \
+    int SIMD_KERNEL_NAME(base64Decode, variant)(const unsigned char* src, int length, \
+                                                unsigned char* dst, int flags);
+
+const char* simdVariant(void);
+int selectSimdVariant(const char* name);
 
 #endif // BLYFASTNATIVE_H
 
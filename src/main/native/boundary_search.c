@@ -0,0 +1,131 @@
+#include "blyfastnative.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Multipart boundary search.
+ *
+ * A boundary is a short needle searched for in long, often binary, part content. Comparing it at
+ * every offset costs O(n * m). Instead, a vector of candidate start positions is filtered at once
+ * by comparing the needle's first byte at each position and its last byte m - 1 bytes further on;
+ * only positions where both match are verified with memcmp. For a CRLF-led delimiter in binary
+ * data that is about one candidate per 64 KB, so the search runs at close to memory speed.
+ *
+ * This is a SIMD kernel, built once per instruction set: 64 positions per step with AVX-512BW, 32
+ * with AVX2, then 16 with SSE2 or NEON for what remains.
+ */
+
+// Verifies the candidates in `mask` (bit i = position pos + i) and returns the first match or -1
+static inline int verifyCandidates(const unsigned char* haystack, int pos, uint64_t mask,
+                                   int bitsPerPosition, const char* needle, int needleLength) {
+    while (mask != 0) {
+        int candidate = pos + __builtin_ctzll(mask) / bitsPerPosition;
+        if (memcmp(haystack + candidate + 1, needle + 1, needleLength - 2) == 0) {
+            return candidate;
+        }
+        // Clear every bit of this position
+        mask &= ~((((uint64_t)1 << bitsPerPosition) - 1)
+                  << ((candidate - pos) * bitsPerPosition));
+    }
+    return -1;
+}
+
+/**
+ * Finds the first occurrence of `needle` (at least two bytes) that lies entirely within
+ * haystack[pos, length). Returns its offset, or -1 if there is none.
+ */
+int SIMD_KERNEL(findBoundary)(const unsigned char* haystack, int pos, int length,
+                              const char* needle, int needleLength) {
+    const unsigned char first = (unsigned char)needle[0];
+    const unsigned char last = (unsigned char)needle[needleLength - 1];
+    const int lastOffset = needleLength - 1;
+
+#if defined(__AVX512BW__)
+    const __m512i first64 = _mm512_set1_epi8((char)first);
+    const __m512i last64 = _mm512_set1_epi8((char)last);
+    for (; pos + lastOffset + 64 <= length; pos += 64) {
+        __m512i starts = _mm512_loadu_si512((const void*)(haystack + pos));
+        __m512i ends = _mm512_loadu_si512((const void*)(haystack + pos + lastOffset));
+        uint64_t mask = _mm512_cmpeq_epi8_mask(starts, first64) &
+                        _mm512_cmpeq_epi8_mask(ends, last64);
+        if (mask != 0) {
+            int found = verifyCandidates(haystack, pos, mask, 1, needle, needleLength);
+            if (found >= 0) {
+                return found;
+            }
+        }
+    }
+#endif
+#if defined(__AVX2__)
+    const __m256i first32 = _mm256_set1_epi8((char)first);
+    const __m256i last32 = _mm256_set1_epi8((char)last);
+    for (; pos + lastOffset + 32 <= length; pos += 32) {
+        __m256i starts = _mm256_loadu_si256((const __m256i*)(haystack + pos));
+        __m256i ends = _mm256_loadu_si256((const __m256i*)(haystack + pos + lastOffset));
+        __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(starts, first32),
+                                        _mm256_cmpeq_epi8(ends, last32));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+        if (mask != 0) {
+            int found = verifyCandidates(haystack, pos, mask, 1, needle, needleLength);
+            if (found >= 0) {
+                return found;
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i first16 = _mm_set1_epi8((char)first);
+    const __m128i last16 = _mm_set1_epi8((char)last);
+    for (; pos + lastOffset + 16 <= length; pos += 16) {
+        __m128i starts = _mm_loadu_si128((const __m128i*)(haystack + pos));
+        __m128i ends = _mm_loadu_si128((const __m128i*)(haystack + pos + lastOffset));
+        __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(starts, first16),
+                                     _mm_cmpeq_epi8(ends, last16));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+        if (mask != 0) {
+            int found = verifyCandidates(haystack, pos, mask, 1, needle, needleLength);
+            if (found >= 0) {
+                return found;
+            }
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t first16 = vdupq_n_u8(first);
+    const uint8x16_t last16 = vdupq_n_u8(last);
+    for (; pos + lastOffset + 16 <= length; pos += 16) {
+        uint8x16_t starts = vld1q_u8(haystack + pos);
+        uint8x16_t ends = vld1q_u8(haystack + pos + lastOffset);
+        uint8x16_t hits = vandq_u8(vceqq_u8(starts, first16), vceqq_u8(ends, last16));
+        // Narrow to four bits per byte so the match mask fits in one 64-bit lane
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if (mask != 0) {
+            int found = verifyCandidates(haystack, pos, mask, 4, needle, needleLength);
+            if (found >= 0) {
+                return found;
+            }
+        }
+    }
+#endif
+
+    // Remaining positions, and the whole search without SIMD: memchr finds the first byte
+    while (pos + needleLength <= length) {
+        const unsigned char* hit = memchr(haystack + pos, first, length - lastOffset - pos);
+        if (hit == NULL) {
+            return -1;
+        }
+        pos = (int)(hit - haystack);
+        if (haystack[pos + lastOffset] == last &&
+            memcmp(haystack + pos + 1, needle + 1, needleLength - 2) == 0) {
+            return pos;
+        }
+        pos++;
+    }
+    return -1;
+}
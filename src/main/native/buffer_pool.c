@@ -0,0 +1,417 @@
+#include "blyfastnative.h"
+#include <sys/mman.h>
+
+/**
+ * Size-class pool for direct buffers.
+ *
+ * Blocks are powers of two from 4 KB to 16 MB, mapped from the OS once and then recycled: a
+ * released block goes to a small cache of the releasing thread or to the shared free list of its
+ * class, and is handed out again with its pages already faulted in. Java wraps blocks with
+ * NewDirectByteBuffer, so the JVM neither counts them against -XX:MaxDirectMemorySize nor frees
+ * them with a Cleaner; they are released explicitly.
+ *
+ * Every mapped block has a descriptor, and blocks are acquired and released through handles that
+ * name the descriptor and its generation. A release succeeds only for the current generation of a
+ * block in use, so a second release, a release after the block was handed out again, or a
+ * made-up handle is refused without touching the free lists. The pool never writes into a block.
+ *
+ * Mapped memory, in use or cached, is bounded by a global budget. When a new block would exceed
+ * it, free blocks on the shared lists are unmapped first, and the block is refused if that is not
+ * enough. Thread caches hold only small blocks, so little of the budget can sit idle in them.
+ */
+
+// One per mapped block; descriptors stay allocated once created and are reused after an unmap
+typedef struct BlockDescriptor {
+    void* address;                  // NULL while the descriptor is unused
+    struct BlockDescriptor* next;   // Free list link
+    uint64_t state;                 // 32-bit generation << 1 | in use
+    uint32_t index;
+    int sizeClass;
+} BlockDescriptor;
+
+#define DESCRIPTOR_CHUNK_SHIFT 12
+#define DESCRIPTOR_CHUNK_SIZE (1 << DESCRIPTOR_CHUNK_SHIFT)
+#define DESCRIPTOR_CHUNKS 1024      // Up to 4M blocks mapped at once
+
+typedef struct {
+    BlockDescriptor* blocks[BUFFER_POOL_CLASSES];
+    int counts[BUFFER_POOL_CLASSES];
+} ThreadCache;
+
+enum {
+    POOL_STAT_BUDGET,
+    POOL_STAT_RESERVED,         // Mapped bytes, in use or cached
+    POOL_STAT_IN_USE,
+    POOL_STAT_PEAK_IN_USE,
+    POOL_STAT_ACQUIRED,
+    POOL_STAT_THREAD_HITS,
+    POOL_STAT_SHARED_HITS,
+    POOL_STAT_MAPPED,           // Blocks mapped from the OS
+    POOL_STAT_REJECTED,         // Acquisitions refused by the budget
+    POOL_STAT_TRIMMED,          // Free blocks unmapped
+    POOL_STAT_CLASS_IN_USE      // Blocks in use per class, BUFFER_POOL_CLASSES entries
+};
+
+_Static_assert(POOL_STAT_CLASS_IN_USE + BUFFER_POOL_CLASSES == BUFFER_POOL_STATS,
+               "BUFFER_POOL_STATS does not match the statistics");
+
+static BlockDescriptor* sharedBlocks[BUFFER_POOL_CLASSES];
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t poolStats[BUFFER_POOL_STATS] = { [POOL_STAT_BUDGET] = BUFFER_POOL_DEFAULT_BUDGET };
+
+// Descriptor registry; chunks are published before descriptorCount covers them
+static BlockDescriptor* descriptorChunks[DESCRIPTOR_CHUNKS];
+static uint32_t descriptorCount = 0;
+static BlockDescriptor* unusedDescriptors = NULL;
+
+static pthread_key_t threadCacheKey;
+static pthread_once_t threadCacheKeyOnce = PTHREAD_ONCE_INIT;
+static __thread ThreadCache* threadCache;
+
+static inline int64_t classSize(int sizeClass) {
+    return (int64_t)1 << (sizeClass + BUFFER_POOL_MIN_SHIFT);
+}
+
+// Smallest class holding `size` bytes, or -1 if it is larger than the largest block
+static inline int classFor(int size) {
+    if (size <= (1 << BUFFER_POOL_MIN_SHIFT)) {
+        return 0;
+    }
+    if (size > (1 << BUFFER_POOL_MAX_SHIFT)) {
+        return -1;
+    }
+    return 32 - __builtin_clz((unsigned)size - 1) - BUFFER_POOL_MIN_SHIFT;
+}
+
+static inline void countStat(int stat, int64_t amount) {
+    __atomic_add_fetch(&poolStats[stat], amount, __ATOMIC_RELAXED);
+}
+
+static inline void pushBlock(BlockDescriptor** list, BlockDescriptor* block) {
+    block->next = *list;
+    *list = block;
+}
+
+// Handles are generation << 32 | (index + 1), so 0 is never a valid handle
+static inline int64_t handleFor(BlockDescriptor* block, uint64_t state) {
+    return (int64_t)(((state >> 1) << 32) | ((uint64_t)block->index + 1));
+}
+
+// The descriptor a handle names, or NULL if there is none
+static BlockDescriptor* descriptorFor(int64_t handle) {
+    uint32_t slot = (uint32_t)handle;
+    if (slot == 0 || slot > __atomic_load_n(&descriptorCount, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    uint32_t index = slot - 1;
+    return &descriptorChunks[index >> DESCRIPTOR_CHUNK_SHIFT][index & (DESCRIPTOR_CHUNK_SIZE - 1)];
+}
+
+// A descriptor for a new mapping, or NULL if the registry is full; called with poolMutex held
+static BlockDescriptor* newDescriptor(void) {
+    if (unusedDescriptors != NULL) {
+        BlockDescriptor* block = unusedDescriptors;
+        unusedDescriptors = block->next;
+        return block;
+    }
+    uint32_t index = descriptorCount;
+    uint32_t chunk = index >> DESCRIPTOR_CHUNK_SHIFT;
+    if (chunk >= DESCRIPTOR_CHUNKS) {
+        return NULL;
+    }
+    if (descriptorChunks[chunk] == NULL) {
+        BlockDescriptor* blocks =
+            (BlockDescriptor*)calloc(DESCRIPTOR_CHUNK_SIZE, sizeof(BlockDescriptor));
+        if (blocks == NULL) {
+            return NULL;
+        }
+        for (uint32_t i = 0; i < DESCRIPTOR_CHUNK_SIZE; i++) {
+            blocks[i].index = (chunk << DESCRIPTOR_CHUNK_SHIFT) + i;
+        }
+        descriptorChunks[chunk] = blocks;
+    }
+    __atomic_store_n(&descriptorCount, index + 1, __ATOMIC_RELEASE);
+    return &descriptorChunks[chunk][index & (DESCRIPTOR_CHUNK_SIZE - 1)];
+}
+
+// Moves every block of a thread cache to the shared lists
+static void flushThreadCache(ThreadCache* cache) {
+    pthread_mutex_lock(&poolMutex);
+    for (int c = 0; c < BUFFER_POOL_CLASSES; c++) {
+        while (cache->blocks[c] != NULL) {
+            BlockDescriptor* block = cache->blocks[c];
+            cache->blocks[c] = block->next;
+            pushBlock(&sharedBlocks[c], block);
+        }
+        cache->counts[c] = 0;
+    }
+    pthread_mutex_unlock(&poolMutex);
+}
+
+static void destroyThreadCache(void* cache) {
+    flushThreadCache((ThreadCache*)cache);
+    free(cache);
+    threadCache = NULL;
+}
+
+static void createThreadCacheKey(void) {
+    pthread_key_create(&threadCacheKey, destroyThreadCache);
+}
+
+// The calling thread's cache, created on first use and flushed when the thread exits
+static ThreadCache* currentThreadCache(void) {
+    if (threadCache == NULL) {
+        pthread_once(&threadCacheKeyOnce, createThreadCacheKey);
+        ThreadCache* cache = (ThreadCache*)calloc(1, sizeof(ThreadCache));
+        if (cache != NULL && pthread_setspecific(threadCacheKey, cache) != 0) {
+            free(cache);
+            cache = NULL;
+        }
+        threadCache = cache;
+    }
+    return threadCache;
+}
+
+// Unmaps free blocks from the shared lists, largest first, until `bytes` are released (all of
+// them if `bytes` is negative). Returns the number of bytes released.
+static int64_t trimShared(int64_t bytes) {
+    int64_t released = 0;
+    pthread_mutex_lock(&poolMutex);
+    for (int c = BUFFER_POOL_CLASSES - 1; c >= 0 && (bytes < 0 || released < bytes); c--) {
+        while (sharedBlocks[c] != NULL && (bytes < 0 || released < bytes)) {
+            BlockDescriptor* block = sharedBlocks[c];
+            sharedBlocks[c] = block->next;
+            munmap(block->address, (size_t)classSize(c));
+            block->address = NULL;
+            pushBlock(&unusedDescriptors, block);
+            released += classSize(c);
+            countStat(POOL_STAT_TRIMMED, 1);
+        }
+    }
+    pthread_mutex_unlock(&poolMutex);
+    countStat(POOL_STAT_RESERVED, -released);
+    return released;
+}
+
+// Counts `bytes` of new mappings against the budget; returns 0 if they do not fit
+static int reserve(int64_t bytes) {
+    int64_t budget = __atomic_load_n(&poolStats[POOL_STAT_BUDGET], __ATOMIC_RELAXED);
+    if (__atomic_add_fetch(&poolStats[POOL_STAT_RESERVED], bytes, __ATOMIC_RELAXED) <= budget) {
+        return 1;
+    }
+    countStat(POOL_STAT_RESERVED, -bytes);
+    return 0;
+}
+
+static BlockDescriptor* mapBlock(int sizeClass) {
+    int64_t size = classSize(sizeClass);
+    if (!reserve(size) && !(trimShared(size) > 0 && reserve(size))) {
+        countStat(POOL_STAT_REJECTED, 1);
+        return NULL;
+    }
+    void* address = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    BlockDescriptor* block = NULL;
+    if (address != MAP_FAILED) {
+        pthread_mutex_lock(&poolMutex);
+        block = newDescriptor();
+        pthread_mutex_unlock(&poolMutex);
+        if (block == NULL) {
+            munmap(address, (size_t)size);
+        }
+    }
+    if (block == NULL) {
+        countStat(POOL_STAT_RESERVED, -size);
+        countStat(POOL_STAT_REJECTED, 1);
+        return NULL;
+    }
+    block->address = address;
+    block->sizeClass = sizeClass;
+    countStat(POOL_STAT_MAPPED, 1);
+    return block;
+}
+
+/**
+ * Acquires a block of at least `size` bytes. Returns its handle, or 0 if `size` is negative or
+ * larger than the largest block, or if the budget is exhausted.
+ */
+int64_t bufferPoolAcquire(int size) {
+    int c = size >= 0 ? classFor(size) : -1;
+    if (c < 0) {
+        return 0;
+    }
+
+    BlockDescriptor* block = NULL;
+    ThreadCache* cache = c + BUFFER_POOL_MIN_SHIFT <= BUFFER_POOL_THREAD_CACHE_MAX_SHIFT
+        ? currentThreadCache() : NULL;
+    if (cache != NULL && cache->blocks[c] != NULL) {
+        block = cache->blocks[c];
+        cache->blocks[c] = block->next;
+        cache->counts[c]--;
+        countStat(POOL_STAT_THREAD_HITS, 1);
+    } else {
+        pthread_mutex_lock(&poolMutex);
+        block = sharedBlocks[c];
+        if (block != NULL) {
+            sharedBlocks[c] = block->next;
+        }
+        pthread_mutex_unlock(&poolMutex);
+        if (block != NULL) {
+            countStat(POOL_STAT_SHARED_HITS, 1);
+        } else if ((block = mapBlock(c)) == NULL) {
+            return 0;
+        }
+    }
+
+    // The block is off every list, so nothing else changes its state until it is released
+    uint64_t state = __atomic_load_n(&block->state, __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&block->state, state, __ATOMIC_RELEASE);
+
+    int64_t size64 = classSize(c);
+    int64_t inUse = __atomic_add_fetch(&poolStats[POOL_STAT_IN_USE], size64, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&poolStats[POOL_STAT_PEAK_IN_USE], __ATOMIC_RELAXED);
+    while (inUse > peak &&
+           !__atomic_compare_exchange_n(&poolStats[POOL_STAT_PEAK_IN_USE], &peak, inUse, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    countStat(POOL_STAT_ACQUIRED, 1);
+    countStat(POOL_STAT_CLASS_IN_USE + c, 1);
+    return handleFor(block, state);
+}
+
+/**
+ * Gets the address and size of the block a handle from bufferPoolAcquire names. Returns NULL if
+ * the handle is not that of a block in use.
+ */
+void* bufferPoolBlock(int64_t handle, int64_t* capacity) {
+    BlockDescriptor* block = descriptorFor(handle);
+    if (block == NULL) {
+        return NULL;
+    }
+    uint64_t state = __atomic_load_n(&block->state, __ATOMIC_ACQUIRE);
+    if ((state & 1) == 0 || handleFor(block, state) != handle) {
+        return NULL;
+    }
+    *capacity = classSize(block->sizeClass);
+    return block->address;
+}
+
+/**
+ * Releases the block a handle from bufferPoolAcquire names. Returns 1, or 0 if the handle names
+ * no block in use: released already, possibly re-acquired since, or not from bufferPoolAcquire.
+ */
+int bufferPoolRelease(int64_t handle) {
+    BlockDescriptor* block = descriptorFor(handle);
+    if (block == NULL) {
+        return 0;
+    }
+    // Retire this generation; of concurrent or repeated releases only the first gets here
+    uint64_t generation = (uint64_t)handle >> 32;
+    uint64_t expected = generation << 1 | 1;
+    uint64_t released = ((generation + 1) & 0xFFFFFFFFu) << 1;
+    if (!__atomic_compare_exchange_n(&block->state, &expected, released, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    int c = block->sizeClass;
+    countStat(POOL_STAT_IN_USE, -classSize(c));
+    countStat(POOL_STAT_CLASS_IN_USE + c, -1);
+
+    ThreadCache* cache = c + BUFFER_POOL_MIN_SHIFT <= BUFFER_POOL_THREAD_CACHE_MAX_SHIFT
+        ? currentThreadCache() : NULL;
+    if (cache != NULL && cache->counts[c] < BUFFER_POOL_THREAD_CACHE_BLOCKS) {
+        pushBlock(&cache->blocks[c], block);
+        cache->counts[c]++;
+    } else {
+        pthread_mutex_lock(&poolMutex);
+        pushBlock(&sharedBlocks[c], block);
+        pthread_mutex_unlock(&poolMutex);
+    }
+    return 1;
+}
+
+/**
+ * Sets the budget for mapped memory, unmapping free shared blocks if more is mapped. Blocks in
+ * use are not affected, so the pool may stay over a lowered budget until they are released.
+ */
+void bufferPoolSetBudget(int64_t budget) {
+    __atomic_store_n(&poolStats[POOL_STAT_BUDGET], budget, __ATOMIC_RELAXED);
+    int64_t excess = __atomic_load_n(&poolStats[POOL_STAT_RESERVED], __ATOMIC_RELAXED) - budget;
+    if (excess > 0) {
+        trimShared(excess);
+    }
+}
+
+/**
+ * Acquires a block of at least `size` bytes from the pool. Returns its handle, or 0 if `size` is
+ * larger than the largest block or the budget is exhausted.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolAcquire
+  (JNIEnv *env, jclass cls, jint size) {
+    return (jlong)bufferPoolAcquire(size);
+}
+
+/**
+ * Wraps the block of a handle from nativeBufferPoolAcquire in a direct buffer. Returns null if
+ * the handle names no block in use.
+ */
+JNIEXPORT jobject JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolBuffer
+  (JNIEnv *env, jclass cls, jlong handle) {
+    int64_t capacity;
+    void* block = bufferPoolBlock(handle, &capacity);
+    return block != NULL ? (*env)->NewDirectByteBuffer(env, block, capacity) : NULL;
+}
+
+/**
+ * Returns the block of a handle from nativeBufferPoolAcquire to the pool. Returns false if the
+ * handle names no block in use.
+ */
+JNIEXPORT jboolean JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolRelease
+  (JNIEnv *env, jclass cls, jlong handle) {
+    return bufferPoolRelease(handle) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Sets the budget for memory mapped by the pool, in bytes.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolSetBudget
+  (JNIEnv *env, jclass cls, jlong budget) {
+    bufferPoolSetBudget(budget > 0 ? budget : 0);
+}
+
+/**
+ * Unmaps every free block on the shared lists. Returns the number of bytes released.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolTrim
+  (JNIEnv *env, jclass cls) {
+    return trimShared(-1);
+}
+
+/**
+ * Moves the blocks cached by the calling thread to the shared lists.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolFlushThreadCache
+  (JNIEnv *env, jclass cls) {
+    if (threadCache != NULL) {
+        flushThreadCache(threadCache);
+    }
+}
+
+/**
+ * Reads the pool statistics: budget, mapped bytes, bytes in use, peak bytes in use, acquisitions,
+ * thread cache hits, shared list hits, blocks mapped, acquisitions refused and blocks unmapped,
+ * followed by the number of blocks in use per class, smallest first.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeBufferPoolStats
+  (JNIEnv *env, jclass cls, jlongArray out) {
+    if (out == NULL) {
+        return;
+    }
+    jsize length = (*env)->GetArrayLength(env, out);
+    jlong values[BUFFER_POOL_STATS];
+    for (int i = 0; i < BUFFER_POOL_STATS; i++) {
+        values[i] = (jlong)__atomic_load_n(&poolStats[i], __ATOMIC_RELAXED);
+    }
+    (*env)->SetLongArrayRegion(env, out, 0,
+                               length < BUFFER_POOL_STATS ? length : BUFFER_POOL_STATS, values);
+}
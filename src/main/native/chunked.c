@@ -0,0 +1,487 @@
+#include "blyfastnative.h"
+
+/**
+ * Chunked transfer coding (RFC 9112 7.1).
+ *
+ * The decoder strips chunk framing in place: data bytes are compacted towards the start of the
+ * input region, so a body can be read into one direct buffer and handed on without a second copy.
+ * It is a byte-level state machine, so a chunk-size line, a CRLF or a trailer field may be split
+ * across any number of calls. Chunk extensions are validated for length and skipped; trailer
+ * fields are collected into a parsed header set.
+ *
+ * The encoder writes framing around data that is already in place: the size line into headroom
+ * reserved before the data and the CRLF after it, so each chunk goes out as one contiguous slice.
+ */
+
+typedef enum {
+    CHUNK_SIZE,             // Hex digits of chunk-size
+    CHUNK_EXTENSION,        // Whitespace and chunk-ext up to CR
+    CHUNK_SIZE_LF,
+    CHUNK_DATA,
+    CHUNK_DATA_CR,
+    CHUNK_DATA_LF,
+    CHUNK_TRAILER,          // A trailer field line, or the empty line ending the body
+    CHUNK_TRAILER_LF,
+    CHUNK_DONE,
+    CHUNK_ERROR
+} ChunkedState;
+
+typedef struct {
+    ChunkedState state;
+    int error;
+    uint64_t size;          // chunk-size while it is parsed, then bytes left in the chunk
+    int sizeDigits;
+    int extensionLength;    // Bytes since the first ';', or 0 before it
+    char* line;             // Trailer line being assembled; allocated for the first trailer
+    int lineLength;
+    ParsedHeaders* trailers;
+} ChunkedDecoder;
+
+static int chunkedFail(ChunkedDecoder* decoder, int error) {
+    decoder->state = CHUNK_ERROR;
+    decoder->error = error;
+    return -error;
+}
+
+// Parses the assembled trailer line as "name: value" and adds it to the trailer set
+static int addTrailer(ChunkedDecoder* decoder) {
+    const char* line = decoder->line;
+    int length = decoder->lineLength;
+
+    const char* colon = memchr(line, ':', length);
+    if (colon == NULL || colon == line) {
+        return CHUNKED_ERROR_INVALID_TRAILER;
+    }
+    int nameLen = (int)(colon - line);
+    for (int i = 0; i < nameLen; i++) {
+        // Also rejects obsolete line folding, which starts with whitespace
+        if (line[i] == ' ' || line[i] == '\t') {
+            return CHUNKED_ERROR_INVALID_TRAILER;
+        }
+    }
+
+    int valueStart = nameLen + 1;
+    int valueEnd = length;
+    while (valueStart < valueEnd && (line[valueStart] == ' ' || line[valueStart] == '\t')) {
+        valueStart++;
+    }
+    while (valueEnd > valueStart && (line[valueEnd - 1] == ' ' || line[valueEnd - 1] == '\t')) {
+        valueEnd--;
+    }
+
+    if (decoder->trailers == NULL) {
+        decoder->trailers = newParsedHeaders();
+        if (decoder->trailers == NULL) {
+            return CHUNKED_ERROR_NO_MEMORY;
+        }
+    }
+    if (decoder->trailers->count >= MAX_CHUNKED_TRAILERS) {
+        return CHUNKED_ERROR_TRAILER_TOO_LONG;
+    }
+    if (addParsedHeader(decoder->trailers, line, nameLen, line + valueStart,
+                        valueEnd - valueStart) != 0) {
+        return CHUNKED_ERROR_NO_MEMORY;
+    }
+    return 0;
+}
+
+/**
+ * Decodes `length` bytes in place. Stops after the final CRLF so that any bytes following the
+ * body (a pipelined request) are left untouched.
+ *
+ * Returns the number of bytes consumed and stores the number of data bytes written to the start of
+ * `buffer` in `produced`, or returns a negated CHUNKED_ERROR_* code.
+ */
+static int chunkedDecode(ChunkedDecoder* decoder, unsigned char* buffer, int length,
+                         int* produced) {
+    int in = 0;
+    int out = 0;
+    *produced = 0;
+
+    while (in < length && decoder->state != CHUNK_DONE) {
+        unsigned char c = buffer[in];
+
+        switch (decoder->state) {
+            case CHUNK_SIZE: {
+                int digit = hexCharToInt((char)c);
+                if (digit >= 0) {
+                    if (decoder->size > ((uint64_t)INT64_MAX >> 4)) {
+                        return chunkedFail(decoder, CHUNKED_ERROR_SIZE_OVERFLOW);
+                    }
+                    decoder->size = (decoder->size << 4) | (uint64_t)digit;
+                    decoder->sizeDigits++;
+                    in++;
+                } else if (decoder->sizeDigits == 0) {
+                    return chunkedFail(decoder, CHUNKED_ERROR_INVALID_SIZE);
+                } else {
+                    decoder->state = CHUNK_EXTENSION;
+                    decoder->extensionLength = 0;
+                }
+                break;
+            }
+
+            case CHUNK_EXTENSION:
+                if (c == '\r') {
+                    decoder->state = CHUNK_SIZE_LF;
+                } else if (c == '\n') {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                } else if (decoder->extensionLength > 0 || c == ';') {
+                    if (++decoder->extensionLength > MAX_CHUNK_EXTENSION_LEN) {
+                        return chunkedFail(decoder, CHUNKED_ERROR_EXTENSION_TOO_LONG);
+                    }
+                } else if (c != ' ' && c != '\t') {
+                    // Only whitespace (BWS) may sit between chunk-size and the first ';'
+                    return chunkedFail(decoder, CHUNKED_ERROR_INVALID_SIZE);
+                }
+                in++;
+                break;
+
+            case CHUNK_SIZE_LF:
+                if (c != '\n') {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                }
+                in++;
+                if (decoder->size == 0) {
+                    decoder->state = CHUNK_TRAILER;
+                    decoder->lineLength = 0;
+                } else {
+                    decoder->state = CHUNK_DATA;
+                }
+                break;
+
+            case CHUNK_DATA: {
+                int available = length - in;
+                int n = decoder->size < (uint64_t)available ? (int)decoder->size : available;
+                if (out != in) {
+                    memmove(buffer + out, buffer + in, n);
+                }
+                out += n;
+                in += n;
+                decoder->size -= n;
+                if (decoder->size == 0) {
+                    decoder->state = CHUNK_DATA_CR;
+                }
+                break;
+            }
+
+            case CHUNK_DATA_CR:
+                if (c != '\r') {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                }
+                in++;
+                decoder->state = CHUNK_DATA_LF;
+                break;
+
+            case CHUNK_DATA_LF:
+                if (c != '\n') {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                }
+                in++;
+                decoder->state = CHUNK_SIZE;
+                decoder->size = 0;
+                decoder->sizeDigits = 0;
+                break;
+
+            case CHUNK_TRAILER: {
+                const unsigned char* cr = memchr(buffer + in, '\r', length - in);
+                int end = cr ? (int)(cr - buffer) : length;
+                int n = end - in;
+                if (memchr(buffer + in, '\n', n) != NULL) {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                }
+                if (n > 0) {
+                    if (n > MAX_CHUNKED_TRAILER_LINE - decoder->lineLength) {
+                        return chunkedFail(decoder, CHUNKED_ERROR_TRAILER_TOO_LONG);
+                    }
+                    if (decoder->line == NULL) {
+                        decoder->line = (char*)malloc(MAX_CHUNKED_TRAILER_LINE);
+                        if (decoder->line == NULL) {
+                            return chunkedFail(decoder, CHUNKED_ERROR_NO_MEMORY);
+                        }
+                    }
+                    memcpy(decoder->line + decoder->lineLength, buffer + in, n);
+                    decoder->lineLength += n;
+                }
+                in = end;
+                if (cr != NULL) {
+                    in++;
+                    decoder->state = CHUNK_TRAILER_LF;
+                }
+                break;
+            }
+
+            case CHUNK_TRAILER_LF:
+                if (c != '\n') {
+                    return chunkedFail(decoder, CHUNKED_ERROR_MISSING_CRLF);
+                }
+                in++;
+                if (decoder->lineLength == 0) {
+                    decoder->state = CHUNK_DONE;
+                } else {
+                    int rc = addTrailer(decoder);
+                    if (rc != 0) {
+                        return chunkedFail(decoder, rc);
+                    }
+                    decoder->lineLength = 0;
+                    decoder->state = CHUNK_TRAILER;
+                }
+                break;
+
+            default:
+                return chunkedFail(decoder, decoder->error);
+        }
+    }
+
+    *produced = out;
+    return in;
+}
+
+static void chunkedDecoderReset(ChunkedDecoder* decoder) {
+    if (decoder->trailers != NULL) {
+        freeParsedHeaders(decoder->trailers);
+    }
+    char* line = decoder->line;
+    memset(decoder, 0, sizeof(ChunkedDecoder));
+    decoder->line = line;
+    decoder->state = CHUNK_SIZE;
+}
+
+/**
+ * Creates a chunked body decoder. Returns a handle, or 0 if allocation fails.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedDecoderCreate
+  (JNIEnv *env, jclass cls) {
+    ChunkedDecoder* decoder = (ChunkedDecoder*)calloc(1, sizeof(ChunkedDecoder));
+    if (!decoder) {
+        return 0;
+    }
+    decoder->state = CHUNK_SIZE;
+    return (jlong)(intptr_t)decoder;
+}
+
+/**
+ * Decodes the next `length` bytes of a chunked body in place; data is compacted to `offset`.
+ *
+ * Returns consumed | produced << CHUNKED_RESULT_PRODUCED_SHIFT, with bit
+ * CHUNKED_RESULT_COMPLETE_SHIFT set once the last chunk and trailers have been read, or a negated
+ * CHUNKED_ERROR_* code. After an error the decoder keeps failing until it is reset.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedDecode
+  (JNIEnv *env, jclass cls, jlong decoderHandle, jobject buffer, jint offset, jint length) {
+    ChunkedDecoder* decoder = (ChunkedDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL || buffer == NULL || offset < 0 || length < 0) {
+        return -CHUNKED_ERROR_INVALID_SIZE;
+    }
+    if (decoder->state == CHUNK_ERROR) {
+        return -decoder->error;
+    }
+
+    unsigned char* data = (unsigned char*)(*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (data == NULL || (jlong)offset + length > capacity) {
+        return -CHUNKED_ERROR_INVALID_SIZE;
+    }
+
+    int produced;
+    int consumed = chunkedDecode(decoder, data + offset, length, &produced);
+    if (consumed < 0) {
+        return consumed;
+    }
+
+    jlong result = (jlong)consumed | ((jlong)produced << CHUNKED_RESULT_PRODUCED_SHIFT);
+    if (decoder->state == CHUNK_DONE) {
+        result |= (jlong)1 << CHUNKED_RESULT_COMPLETE_SHIFT;
+    }
+    return result;
+}
+
+/**
+ * Publishes the trailer fields of a completely decoded body as a parsed header set.
+ *
+ * Returns the headers ID (free with nativeFreeHeaders), or 0 if there were no trailers, the body
+ * is not complete yet or no header slot is free.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedDecoderTrailers
+  (JNIEnv *env, jclass cls, jlong decoderHandle) {
+    ChunkedDecoder* decoder = (ChunkedDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL || decoder->state != CHUNK_DONE || decoder->trailers == NULL) {
+        return 0;
+    }
+
+    ParsedHeaders* trailers = decoder->trailers;
+    decoder->trailers = NULL;
+    buildHeaderIndex(trailers);
+    jlong id = registerParsedHeaders(trailers);
+    if (id == 0) {
+        freeParsedHeaders(trailers);
+    }
+    return id;
+}
+
+/**
+ * Resets a decoder for the next body on the same connection, discarding unread trailers.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedDecoderReset
+  (JNIEnv *env, jclass cls, jlong decoderHandle) {
+    ChunkedDecoder* decoder = (ChunkedDecoder*)(intptr_t)decoderHandle;
+    if (decoder != NULL) {
+        chunkedDecoderReset(decoder);
+    }
+}
+
+/**
+ * Frees a decoder created by nativeChunkedDecoderCreate.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedDecoderFree
+  (JNIEnv *env, jclass cls, jlong decoderHandle) {
+    ChunkedDecoder* decoder = (ChunkedDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL) {
+        return;
+    }
+    if (decoder->trailers != NULL) {
+        freeParsedHeaders(decoder->trailers);
+    }
+    free(decoder->line);
+    free(decoder);
+}
+
+/**
+ * Frames `dataLength` bytes at `dataOffset` as one chunk: the hex size line is written into the
+ * bytes just before the data (at most CHUNK_HEADER_RESERVE) and CRLF just after it.
+ *
+ * Returns the offset where the framed chunk starts (it ends at dataOffset + dataLength + 2), or
+ * -1 if there is not enough room around the data. Empty chunks are rejected, since a zero size
+ * would end the body; use nativeChunkedWriteLastChunk for that.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedFrame
+  (JNIEnv *env, jclass cls, jobject buffer, jint dataOffset, jint dataLength) {
+    if (buffer == NULL || dataOffset < 0 || dataLength <= 0) {
+        return -1;
+    }
+
+    char* data = (char*)(*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (data == NULL || (jlong)dataOffset + dataLength + 2 > capacity) {
+        return -1;
+    }
+
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    char digits[8];
+    int digitCount = 0;
+    for (uint32_t size = (uint32_t)dataLength; size != 0; size >>= 4) {
+        digits[digitCount++] = HEX_DIGITS[size & 0xF];
+    }
+
+    int start = dataOffset - digitCount - 2;
+    if (start < 0) {
+        return -1;
+    }
+
+    char* cursor = data + start;
+    for (int i = digitCount - 1; i >= 0; i--) {
+        *cursor++ = digits[i];
+    }
+    cursor[0] = '\r';
+    cursor[1] = '\n';
+
+    char* end = data + dataOffset + dataLength;
+    end[0] = '\r';
+    end[1] = '\n';
+    return start;
+}
+
+/**
+ * Writes the last chunk, the trailer fields and the final CRLF. The fields are taken from
+ * `trailerText` (may be null when there are none): the UTF-8 names and values, alternating and
+ * concatenated, with `trailerLengths` giving the length of each.
+ *
+ * Returns the number of bytes written, the negated required size if `out` is too small, or 0 on
+ * invalid arguments (including trailer text containing CR or LF).
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeChunkedWriteLastChunk
+  (JNIEnv *env, jclass cls, jobject out, jint offset, jbyteArray trailerText,
+   jintArray trailerLengths) {
+    if (out == NULL || offset < 0) {
+        return 0;
+    }
+
+    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, out);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, out);
+    if (buffer == NULL || offset > capacity) {
+        return 0;
+    }
+
+    jsize fieldCount = trailerLengths != NULL ? (*env)->GetArrayLength(env, trailerLengths) : 0;
+    jsize textLength = trailerText != NULL ? (*env)->GetArrayLength(env, trailerText) : 0;
+    if (fieldCount % 2 != 0 || (trailerText == NULL && fieldCount > 0)) {
+        return 0;
+    }
+
+    jint* lengths = NULL;
+    if (fieldCount > 0) {
+        lengths = (jint*)malloc(sizeof(jint) * (size_t)fieldCount);
+        if (lengths == NULL) {
+            return 0;
+        }
+        (*env)->GetIntArrayRegion(env, trailerLengths, 0, fieldCount, lengths);
+    }
+    jlong totalText = 0;
+    for (jsize i = 0; i < fieldCount; i++) {
+        if (lengths[i] < 0) {
+            free(lengths);
+            return 0;
+        }
+        totalText += lengths[i];
+    }
+    if (totalText != textLength) {
+        free(lengths);
+        return 0;
+    }
+
+    // "0\r\n", each "name: value\r\n", final CRLF
+    size_t required = 3 + (size_t)textLength + (size_t)fieldCount * 2 + 2;
+    if (required > (size_t)(capacity - offset)) {
+        free(lengths);
+        return required > INT_MAX ? -INT_MAX : -(jint)required;
+    }
+
+    const char* text = NULL;
+    if (trailerText != NULL) {
+        text = (const char*)(*env)->GetPrimitiveArrayCritical(env, trailerText, NULL);
+        if (text == NULL) {
+            free(lengths);
+            return 0;
+        }
+    }
+
+    char* cursor = buffer + offset;
+    memcpy(cursor, "0\r\n", 3);
+    cursor += 3;
+
+    size_t textOffset = 0;
+    int valid = 1;
+    for (jsize i = 0; i < fieldCount; i++) {
+        const char* chars = text + textOffset;
+        size_t len = (size_t)lengths[i];
+        textOffset += len;
+        if ((len == 0 && i % 2 == 0) || containsLineBreak(chars, len)) {
+            valid = 0;
+            break;
+        }
+        memcpy(cursor, chars, len);
+        cursor += len;
+        memcpy(cursor, i % 2 == 0 ? ": " : "\r\n", 2);
+        cursor += 2;
+    }
+    if (text != NULL) {
+        (*env)->ReleasePrimitiveArrayCritical(env, trailerText, (void*)text, JNI_ABORT);
+    }
+    free(lengths);
+    if (!valid) {
+        return 0;
+    }
+
+    *cursor++ = '\r';
+    *cursor++ = '\n';
+    return (jint)(cursor - (buffer + offset));
+}
@@ -0,0 +1,388 @@
+#include "blyfastnative.h"
+
+/**
+ * Client address resolution behind reverse proxies.
+ *
+ * Addresses are handled as 128-bit values, IPv4 mapped into ::ffff:0:0/96, so one comparison
+ * against a masked CIDR covers both families. The forwarding chain is walked from the right: each
+ * hop is only believed if the address that reported it is a trusted proxy, so the result is the
+ * rightmost untrusted address and clients cannot spoof it by sending their own header.
+ */
+
+typedef struct {
+    uint64_t high;
+    uint64_t low;
+} Address128;
+
+typedef struct {
+    Address128 address;
+    Address128 mask;
+} TrustedCidr;
+
+typedef struct {
+    TrustedCidr cidrs[MAX_TRUSTED_PROXY_CIDRS];
+    int count;
+} TrustedProxySet;
+
+typedef struct {
+    const char* start;
+    int length;
+} ForwardedHop;
+
+static TrustedProxySet* proxySets[MAX_TRUSTED_PROXY_SETS];
+static int proxySetCount = 0;
+static pthread_mutex_t proxySetsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline int isTrusted(const TrustedProxySet* set, Address128 address) {
+    for (int i = 0; i < set->count; i++) {
+        const TrustedCidr* cidr = &set->cidrs[i];
+        if ((address.high & cidr->mask.high) == cidr->address.high &&
+            (address.low & cidr->mask.low) == cidr->address.low) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses dotted-quad IPv4 without leading zeros; returns 1 on success
+static int parseIpv4(const char* s, int len, uint32_t* out) {
+    uint32_t address = 0;
+    int pos = 0;
+    for (int part = 0; part < 4; part++) {
+        if (part > 0) {
+            if (pos >= len || s[pos] != '.') {
+                return 0;
+            }
+            pos++;
+        }
+        int start = pos;
+        uint32_t octet = 0;
+        while (pos < len && s[pos] >= '0' && s[pos] <= '9' && pos - start < 3) {
+            octet = octet * 10 + (s[pos] - '0');
+            pos++;
+        }
+        if (pos == start || octet > 255 || (pos - start > 1 && s[start] == '0')) {
+            return 0;
+        }
+        address = (address << 8) | octet;
+    }
+    if (pos != len) {
+        return 0;
+    }
+    *out = address;
+    return 1;
+}
+
+// Parses an IPv6 literal, with "::" compression and an optional embedded IPv4 tail
+static int parseIpv6(const char* s, int len, Address128* out) {
+    uint16_t groups[8];
+    int count = 0;
+    int gap = -1;
+    int pos = 0;
+
+    if (len >= 2 && s[0] == ':' && s[1] == ':') {
+        gap = 0;
+        pos = 2;
+    } else if (len > 0 && s[0] == ':') {
+        return 0;
+    }
+
+    while (pos < len) {
+        if (count == 8) {
+            return 0;
+        }
+        int start = pos;
+        uint32_t group = 0;
+        while (pos < len && pos - start < 4 && hexValue(s[pos]) >= 0) {
+            group = (group << 4) | (uint32_t)hexValue(s[pos]);
+            pos++;
+        }
+        if (pos < len && s[pos] == '.') {
+            // Embedded IPv4 takes the last two groups
+            uint32_t v4;
+            if (count > 6 || !parseIpv4(s + start, len - start, &v4)) {
+                return 0;
+            }
+            groups[count++] = (uint16_t)(v4 >> 16);
+            groups[count++] = (uint16_t)v4;
+            pos = len;
+            break;
+        }
+        if (pos == start) {
+            return 0;
+        }
+        groups[count++] = (uint16_t)group;
+        if (pos == len) {
+            break;
+        }
+        if (s[pos] != ':') {
+            return 0;
+        }
+        pos++;
+        if (pos < len && s[pos] == ':') {
+            if (gap >= 0) {
+                return 0;
+            }
+            gap = count;
+            pos++;
+        } else if (pos == len) {
+            return 0; // Trailing single colon
+        }
+    }
+
+    if ((gap < 0 && count != 8) || (gap >= 0 && count > 7)) {
+        return 0;
+    }
+
+    uint16_t full[8] = {0};
+    if (gap < 0) {
+        memcpy(full, groups, sizeof(full));
+    } else {
+        memcpy(full, groups, gap * sizeof(uint16_t));
+        int tail = count - gap;
+        memcpy(full + 8 - tail, groups + gap, tail * sizeof(uint16_t));
+    }
+
+    out->high = ((uint64_t)full[0] << 48) | ((uint64_t)full[1] << 32) |
+                ((uint64_t)full[2] << 16) | full[3];
+    out->low = ((uint64_t)full[4] << 48) | ((uint64_t)full[5] << 32) |
+               ((uint64_t)full[6] << 16) | full[7];
+    return 1;
+}
+
+/**
+ * Parses a forwarded node: an IPv4 or IPv6 address with an optional port, IPv6 in brackets when a
+ * port follows. Returns 0 for anything else, including "unknown" and obfuscated identifiers.
+ */
+static int parseNode(const char* s, int len, Address128* out) {
+    if (len <= 0 || len > MAX_FORWARDED_NODE_LEN) {
+        return 0;
+    }
+    if (s[0] == '[') {
+        const char* close = memchr(s, ']', len);
+        if (close == NULL) {
+            return 0;
+        }
+        int rest = len - (int)(close + 1 - s);
+        if (rest > 0 && close[1] != ':') {
+            return 0;
+        }
+        return parseIpv6(s + 1, (int)(close - s) - 1, out);
+    }
+
+    const char* colon = memchr(s, ':', len);
+    if (colon != NULL && memchr(colon + 1, ':', len - (int)(colon + 1 - s)) != NULL) {
+        return parseIpv6(s, len, out);
+    }
+
+    // IPv4, possibly followed by ":port"
+    uint32_t v4;
+    if (!parseIpv4(s, colon != NULL ? (int)(colon - s) : len, &v4)) {
+        return 0;
+    }
+    out->high = 0;
+    out->low = 0x0000FFFF00000000ULL | v4;
+    return 1;
+}
+
+// Finds the for= parameter of a Forwarded element and parses its (possibly quoted) node
+static int parseForwardedElement(const char* s, int len, Address128* out) {
+    int pos = 0;
+    while (pos < len) {
+        while (pos < len && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == ';')) {
+            pos++;
+        }
+        int nameStart = pos;
+        while (pos < len && s[pos] != '=' && s[pos] != ';') {
+            pos++;
+        }
+        if (pos >= len || s[pos] != '=') {
+            continue;
+        }
+        int isFor = pos - nameStart == 3 && strncasecmp(s + nameStart, "for", 3) == 0;
+        pos++;
+
+        int valueStart = pos;
+        int valueEnd;
+        if (pos < len && s[pos] == '"') {
+            valueStart = ++pos;
+            while (pos < len && s[pos] != '"') {
+                pos++;
+            }
+            valueEnd = pos;
+            if (pos < len) {
+                pos++;
+            }
+        } else {
+            while (pos < len && s[pos] != ';') {
+                pos++;
+            }
+            valueEnd = pos;
+            while (valueEnd > valueStart && (s[valueEnd - 1] == ' ' || s[valueEnd - 1] == '\t')) {
+                valueEnd--;
+            }
+        }
+        if (isFor) {
+            return parseNode(s + valueStart, valueEnd - valueStart, out);
+        }
+    }
+    return 0;
+}
+
+// Splits a header value into comma-separated hops (quoted commas are not separators)
+static int splitHops(const char* s, int len, ForwardedHop* hops, int maxHops) {
+    int count = 0;
+    int start = 0;
+    int quoted = 0;
+    for (int pos = 0; pos <= len; pos++) {
+        if (pos < len && s[pos] == '"') {
+            quoted = !quoted;
+        }
+        if (pos == len || (s[pos] == ',' && !quoted)) {
+            int a = start;
+            int b = pos;
+            while (a < b && (s[a] == ' ' || s[a] == '\t')) a++;
+            while (b > a && (s[b - 1] == ' ' || s[b - 1] == '\t')) b--;
+            if (b > a) {
+                if (count == maxHops) {
+                    // Keep the rightmost hops, which are the ones checked first
+                    memmove(hops, hops + 1, (maxHops - 1) * sizeof(ForwardedHop));
+                    count--;
+                }
+                hops[count].start = s + a;
+                hops[count].length = b - a;
+                count++;
+            }
+            start = pos + 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * Walks one header value from the right, counting the hops taken in `taken`. Returns 1 once the
+ * client is known (stored in `current`), 0 if every hop was a trusted proxy and earlier values
+ * should be consulted.
+ */
+static int walkHops(const TrustedProxySet* set, const char* value, int len, int forwarded,
+                    Address128* current, int* taken) {
+    ForwardedHop hops[MAX_FORWARDED_HOPS];
+    int count = splitHops(value, len, hops, MAX_FORWARDED_HOPS);
+    for (int i = count - 1; i >= 0; i--) {
+        Address128 hop;
+        int valid = forwarded ? parseForwardedElement(hops[i].start, hops[i].length, &hop)
+                              : parseNode(hops[i].start, hops[i].length, &hop);
+        if (!valid) {
+            // The proxy vouched for something that is not an address; it is the best we know
+            return 1;
+        }
+        *current = hop;
+        (*taken)++;
+        if (!isTrusted(set, hop)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Registers a trusted proxy set. `cidrs` holds TRUSTED_PROXY_CIDR_LONGS values per range: the
+ * masked address (high, low) and the mask (high, low), IPv4 ranges mapped into ::ffff:0:0/96.
+ *
+ * Returns the set ID (1-based), or 0 if the set is invalid or the registry is full.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeCompileTrustedProxies
+  (JNIEnv *env, jclass cls, jlongArray cidrs) {
+    if (cidrs == NULL) {
+        return 0;
+    }
+    jsize length = (*env)->GetArrayLength(env, cidrs);
+    if (length % TRUSTED_PROXY_CIDR_LONGS != 0 ||
+        length / TRUSTED_PROXY_CIDR_LONGS > MAX_TRUSTED_PROXY_CIDRS) {
+        return 0;
+    }
+
+    TrustedProxySet* set = (TrustedProxySet*)calloc(1, sizeof(TrustedProxySet));
+    if (!set) {
+        return 0;
+    }
+    jlong values[MAX_TRUSTED_PROXY_CIDRS * TRUSTED_PROXY_CIDR_LONGS];
+    (*env)->GetLongArrayRegion(env, cidrs, 0, length, values);
+    set->count = length / TRUSTED_PROXY_CIDR_LONGS;
+    for (int i = 0; i < set->count; i++) {
+        TrustedCidr* cidr = &set->cidrs[i];
+        const jlong* v = values + i * TRUSTED_PROXY_CIDR_LONGS;
+        cidr->mask.high = (uint64_t)v[2];
+        cidr->mask.low = (uint64_t)v[3];
+        cidr->address.high = (uint64_t)v[0] & cidr->mask.high;
+        cidr->address.low = (uint64_t)v[1] & cidr->mask.low;
+    }
+
+    jint id = 0;
+    pthread_mutex_lock(&proxySetsMutex);
+    if (proxySetCount < MAX_TRUSTED_PROXY_SETS) {
+        proxySets[proxySetCount] = set;
+        __atomic_store_n(&proxySetCount, proxySetCount + 1, __ATOMIC_RELEASE);
+        id = proxySetCount;
+    }
+    pthread_mutex_unlock(&proxySetsMutex);
+
+    if (id == 0) {
+        free(set);
+    }
+    return id;
+}
+
+/**
+ * Resolves the client address of a request that arrived from `peer`. If the peer is a trusted
+ * proxy, the Forwarded values (or X-Forwarded-For when there is no Forwarded header) are walked
+ * from the right until an untrusted address is found.
+ *
+ * Writes the address (high, low) to `out` and returns 1 if it came from a forwarding header, 0 if
+ * it is the peer, or -1 if the arguments are invalid.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeResolveClientAddress
+  (JNIEnv *env, jclass cls, jint proxySetId, jlong peerHigh, jlong peerLow,
+   jobjectArray forwarded, jobjectArray xForwardedFor, jlongArray out) {
+    if (out == NULL || (*env)->GetArrayLength(env, out) < 2 || proxySetId <= 0 ||
+        proxySetId > __atomic_load_n(&proxySetCount, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    const TrustedProxySet* set = proxySets[proxySetId - 1];
+
+    Address128 current = { (uint64_t)peerHigh, (uint64_t)peerLow };
+    int taken = 0;
+    jobjectArray values = forwarded != NULL && (*env)->GetArrayLength(env, forwarded) > 0
+        ? forwarded : xForwardedFor;
+
+    if (values != NULL && isTrusted(set, current)) {
+        // Repeated header fields form one list; the last field holds the nearest hops
+        for (jsize i = (*env)->GetArrayLength(env, values) - 1; i >= 0; i--) {
+            jstring str = (jstring)(*env)->GetObjectArrayElement(env, values, i);
+            const char* chars = str != NULL ? (*env)->GetStringUTFChars(env, str, NULL) : NULL;
+            int done = 1;
+            if (chars != NULL) {
+                done = walkHops(set, chars, (int)strlen(chars), values == forwarded, &current,
+                                &taken);
+                (*env)->ReleaseStringUTFChars(env, str, chars);
+            }
+            if (str != NULL) {
+                (*env)->DeleteLocalRef(env, str);
+            }
+            if (done) {
+                break;
+            }
+        }
+    }
+
+    jlong result[2] = { (jlong)current.high, (jlong)current.low };
+    (*env)->SetLongArrayRegion(env, out, 0, 2, result);
+    return taken > 0;
+}
@@ -0,0 +1,273 @@
+#include "blyfastnative.h"
+
+/**
+ * Proactive content negotiation (RFC 9110 12.5) for Accept, Accept-Encoding and Accept-Language.
+ *
+ * The server's offers are compiled once into a registry. A header value is then parsed and matched
+ * against them in a single pass: every offer gets the q-value of the most specific range that
+ * matches it, and the offer with the highest non-zero q-value wins, earlier offers winning ties.
+ * Media range parameters other than q are ignored.
+ */
+
+typedef struct {
+    char value[MAX_NEGOTIATION_OFFER_LEN + 1];  // Lowercased
+    int length;
+    int slash;                                  // Media types: position of '/'
+} NegotiationOffer;
+
+typedef struct {
+    int kind;
+    int count;
+    NegotiationOffer offers[MAX_NEGOTIATION_OFFERS];
+} NegotiationOfferSet;
+
+static NegotiationOfferSet* offerSets[MAX_NEGOTIATION_OFFER_SETS];
+static int offerSetCount = 0;
+static pthread_mutex_t offerSetsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline int isNegotiationSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// Parses a qvalue (RFC 9110 12.4.2) as thousandths; returns -1 if malformed
+static int parseQValue(const char* s, int len) {
+    if (len < 1 || (s[0] != '0' && s[0] != '1')) {
+        return -1;
+    }
+    int value = (s[0] - '0') * 1000;
+    if (len == 1) {
+        return value;
+    }
+    if (s[1] != '.' || len > 5) {
+        return -1;
+    }
+
+    int scale = 100;
+    for (int i = 2; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return -1;
+        }
+        value += (s[i] - '0') * scale;
+        scale /= 10;
+    }
+    return value <= 1000 ? value : -1;
+}
+
+// Specificity with which `range` matches `offer`, or -1 if it does not match
+static int rangeSpecificity(int kind, const char* range, int rangeLen, const NegotiationOffer* offer) {
+    switch (kind) {
+        case NEGOTIATION_MEDIA_TYPE: {
+            if (rangeLen == 3 && memcmp(range, "*/*", 3) == 0) {
+                return 1;
+            }
+            const char* slash = memchr(range, '/', rangeLen);
+            if (slash == NULL) {
+                return -1;
+            }
+            int typeLen = (int)(slash - range);
+            if (typeLen != offer->slash || strncasecmp(range, offer->value, typeLen) != 0) {
+                return -1;
+            }
+            int subtypeLen = rangeLen - typeLen - 1;
+            if (subtypeLen == 1 && slash[1] == '*') {
+                return 2;
+            }
+            if (subtypeLen == offer->length - offer->slash - 1 &&
+                strncasecmp(slash + 1, offer->value + offer->slash + 1, subtypeLen) == 0) {
+                return 3;
+            }
+            return -1;
+        }
+
+        case NEGOTIATION_ENCODING:
+            if (rangeLen == 1 && range[0] == '*') {
+                return 1;
+            }
+            return rangeLen == offer->length && strncasecmp(range, offer->value, rangeLen) == 0
+                ? 2 : -1;
+
+        case NEGOTIATION_LANGUAGE:
+            // Basic filtering (RFC 4647 3.3.1): "en" matches "en" and "en-us"
+            if (rangeLen == 1 && range[0] == '*') {
+                return 0;
+            }
+            if (rangeLen > offer->length || strncasecmp(range, offer->value, rangeLen) != 0) {
+                return -1;
+            }
+            return rangeLen == offer->length || offer->value[rangeLen] == '-' ? rangeLen : -1;
+
+        default:
+            return -1;
+    }
+}
+
+/**
+ * Returns the index of the best offer for `header`, or -1 if none is acceptable
+ */
+static int negotiate(const NegotiationOfferSet* set, const char* header, int headerLen) {
+    int quality[MAX_NEGOTIATION_OFFERS];
+    int specificity[MAX_NEGOTIATION_OFFERS];
+    for (int i = 0; i < set->count; i++) {
+        quality[i] = -1;
+        specificity[i] = -1;
+    }
+
+    int pos = 0;
+    while (pos < headerLen) {
+        const char* comma = memchr(header + pos, ',', headerLen - pos);
+        int elementEnd = comma ? (int)(comma - header) : headerLen;
+
+        // Range, up to the first parameter
+        int start = pos;
+        while (start < elementEnd && isNegotiationSpace(header[start])) {
+            start++;
+        }
+        if (start == elementEnd) {
+            pos = elementEnd + 1;
+            continue;
+        }
+        const char* semicolon = memchr(header + start, ';', elementEnd - start);
+        int rangeEnd = semicolon ? (int)(semicolon - header) : elementEnd;
+        while (rangeEnd > start && isNegotiationSpace(header[rangeEnd - 1])) {
+            rangeEnd--;
+        }
+
+        // Parameters: only q matters
+        int q = 1000;
+        int paramPos = semicolon ? (int)(semicolon - header) + 1 : elementEnd;
+        while (paramPos < elementEnd) {
+            const char* next = memchr(header + paramPos, ';', elementEnd - paramPos);
+            int paramEnd = next ? (int)(next - header) : elementEnd;
+            int p = paramPos;
+            int e = paramEnd;
+            while (p < e && isNegotiationSpace(header[p])) {
+                p++;
+            }
+            while (e > p && isNegotiationSpace(header[e - 1])) {
+                e--;
+            }
+            if (e - p >= 2 && (header[p] == 'q' || header[p] == 'Q') && header[p + 1] == '=') {
+                q = parseQValue(header + p + 2, e - p - 2);
+            }
+            paramPos = paramEnd + 1;
+        }
+
+        if (rangeEnd > start && q >= 0) {
+            for (int i = 0; i < set->count; i++) {
+                int s = rangeSpecificity(set->kind, header + start, rangeEnd - start, &set->offers[i]);
+                if (s > specificity[i]) {
+                    specificity[i] = s;
+                    quality[i] = q;
+                }
+            }
+        }
+
+        pos = elementEnd + 1;
+    }
+
+    int best = -1;
+    int bestQuality = 0;
+    for (int i = 0; i < set->count; i++) {
+        int q = quality[i];
+        // identity is acceptable unless excluded explicitly or by "*;q=0" (RFC 9110 12.5.3)
+        if (q < 0 && set->kind == NEGOTIATION_ENCODING && set->offers[i].length == 8 &&
+            memcmp(set->offers[i].value, "identity", 8) == 0) {
+            q = 1;
+        }
+        if (q > bestQuality) {
+            best = i;
+            bestQuality = q;
+        }
+    }
+    return best;
+}
+
+/**
+ * Compiles the server's offers for one kind of negotiation (NEGOTIATION_*).
+ *
+ * Returns the offer set ID, or 0 if the offers are invalid or the registry is full.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeCompileOffers
+  (JNIEnv *env, jclass cls, jint kind, jobjectArray offers) {
+    if (offers == NULL || kind < NEGOTIATION_MEDIA_TYPE || kind > NEGOTIATION_LANGUAGE) {
+        return 0;
+    }
+
+    jsize count = (*env)->GetArrayLength(env, offers);
+    if (count == 0 || count > MAX_NEGOTIATION_OFFERS) {
+        return 0;
+    }
+
+    NegotiationOfferSet* set = (NegotiationOfferSet*)calloc(1, sizeof(NegotiationOfferSet));
+    if (!set) {
+        return 0;
+    }
+    set->kind = kind;
+    set->count = count;
+
+    int valid = 1;
+    for (jsize i = 0; i < count && valid; i++) {
+        jstring str = (jstring)(*env)->GetObjectArrayElement(env, offers, i);
+        const char* chars = str != NULL ? (*env)->GetStringUTFChars(env, str, NULL) : NULL;
+        if (chars == NULL) {
+            valid = 0;
+        } else {
+            NegotiationOffer* offer = &set->offers[i];
+            size_t len = strlen(chars);
+            const char* slash = memchr(chars, '/', len);
+            if (len == 0 || len > MAX_NEGOTIATION_OFFER_LEN ||
+                (kind == NEGOTIATION_MEDIA_TYPE && slash == NULL)) {
+                valid = 0;
+            } else {
+                for (size_t j = 0; j < len; j++) {
+                    offer->value[j] = (char)tolower((unsigned char)chars[j]);
+                }
+                offer->length = (int)len;
+                offer->slash = slash ? (int)(slash - chars) : -1;
+            }
+            (*env)->ReleaseStringUTFChars(env, str, chars);
+        }
+        if (str != NULL) {
+            (*env)->DeleteLocalRef(env, str);
+        }
+    }
+
+    jint id = 0;
+    if (valid) {
+        pthread_mutex_lock(&offerSetsMutex);
+        if (offerSetCount < MAX_NEGOTIATION_OFFER_SETS) {
+            offerSets[offerSetCount] = set;
+            __atomic_store_n(&offerSetCount, offerSetCount + 1, __ATOMIC_RELEASE);
+            id = offerSetCount;
+        }
+        pthread_mutex_unlock(&offerSetsMutex);
+    }
+
+    if (id == 0) {
+        free(set);
+    }
+    return id;
+}
+
+/**
+ * Selects the best offer from a compiled set for an Accept-style header value.
+ *
+ * Returns the offer index, or -1 if no offer is acceptable or the set ID is unknown.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeNegotiate
+  (JNIEnv *env, jclass cls, jint offerSetId, jstring header) {
+    if (header == NULL || offerSetId <= 0 ||
+        offerSetId > __atomic_load_n(&offerSetCount, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+
+    const char* chars = (*env)->GetStringUTFChars(env, header, NULL);
+    if (chars == NULL) {
+        return -1;
+    }
+
+    int best = negotiate(offerSets[offerSetId - 1], chars, (int)strlen(chars));
+
+    (*env)->ReleaseStringUTFChars(env, header, chars);
+    return best;
+}
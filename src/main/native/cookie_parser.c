@@ -0,0 +1,104 @@
+#include "blyfastnative.h"
+
+/**
+ * Cookie header tokenizer (RFC 6265 5.4 / 4.2.1, parsed leniently as browsers send it).
+ *
+ * Produces an offset index instead of strings: for each cookie, the offsets and lengths of its
+ * name and value inside the header bytes. Surrounding whitespace is trimmed, a value wrapped in
+ * double quotes is reported without them, and segments without a name are skipped. Values are
+ * left encoded; callers decode only the values they actually read.
+ */
+
+static inline int isCookieSpace(unsigned char c) {
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * Tokenizes `length` bytes of a Cookie header into `index`.
+ *
+ * Returns the number of cookies found, or the negated count if `index` has room for fewer.
+ */
+int tokenizeCookies(const unsigned char* header, int length, jint* index, int maxCookies) {
+    int count = 0;
+    int pos = 0;
+
+    while (pos < length) {
+        const unsigned char* semicolon = memchr(header + pos, ';', length - pos);
+        int segmentEnd = semicolon ? (int)(semicolon - header) : length;
+
+        // Trim the segment
+        int start = pos;
+        int end = segmentEnd;
+        while (start < end && isCookieSpace(header[start])) {
+            start++;
+        }
+        while (end > start && isCookieSpace(header[end - 1])) {
+            end--;
+        }
+
+        const unsigned char* equals = memchr(header + start, '=', end - start);
+        if (equals != NULL) {
+            int nameEnd = (int)(equals - header);
+            int valueStart = nameEnd + 1;
+            while (nameEnd > start && isCookieSpace(header[nameEnd - 1])) {
+                nameEnd--;
+            }
+            while (valueStart < end && isCookieSpace(header[valueStart])) {
+                valueStart++;
+            }
+
+            int valueEnd = end;
+            if (valueEnd - valueStart >= 2 && header[valueStart] == '"' &&
+                header[valueEnd - 1] == '"') {
+                valueStart++;
+                valueEnd--;
+            }
+
+            if (nameEnd > start) {
+                if (count < maxCookies) {
+                    jint* entry = index + count * COOKIE_INDEX_ENTRY_INTS;
+                    entry[0] = start;
+                    entry[1] = nameEnd - start;
+                    entry[2] = valueStart;
+                    entry[3] = valueEnd - valueStart;
+                }
+                count++;
+            }
+        }
+
+        pos = segmentEnd + 1;
+    }
+
+    return count <= maxCookies ? count : -count;
+}
+
+/**
+ * Tokenizes a Cookie header held in a byte array into an int array index of
+ * [name_off, name_len, value_off, value_len] entries
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseCookies
+  (JNIEnv *env, jclass cls, jbyteArray header, jint length, jintArray index) {
+    if (header == NULL || index == NULL || length < 0 ||
+        length > (*env)->GetArrayLength(env, header)) {
+        return 0;
+    }
+
+    int maxCookies = (*env)->GetArrayLength(env, index) / COOKIE_INDEX_ENTRY_INTS;
+
+    // Both arrays are small and the scan does not call back into the JVM
+    unsigned char* bytes = (unsigned char*)(*env)->GetPrimitiveArrayCritical(env, header, NULL);
+    if (bytes == NULL) {
+        return 0;
+    }
+    jint* entries = (jint*)(*env)->GetPrimitiveArrayCritical(env, index, NULL);
+    if (entries == NULL) {
+        (*env)->ReleasePrimitiveArrayCritical(env, header, bytes, JNI_ABORT);
+        return 0;
+    }
+
+    int count = tokenizeCookies(bytes, length, entries, maxCookies);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, index, entries, 0);
+    (*env)->ReleasePrimitiveArrayCritical(env, header, bytes, JNI_ABORT);
+    return count;
+}
@@ -0,0 +1,130 @@
+#include "blyfastnative.h"
+
+/**
+ * Runtime selection of SIMD kernels.
+ *
+ * The library is compiled for the baseline of its architecture, so the one binary shipped in the
+ * jar loads on any host. Only the kernels (KERNEL_SOURCES in the Makefile) are compiled once per
+ * instruction set: baseline x86-64 (SSE2), SSE4.2, AVX2 and AVX-512 on x86-64, NEON on aarch64.
+ * When the library is loaded, the best variant the CPU and OS support is selected with cpuid, and
+ * the unsuffixed kernel functions forward to it.
+ *
+ * The BLYFAST_SIMD_VARIANT environment variable selects a variant by name instead, to compare
+ * variants or to rule one out on a host where it misbehaves; a variant the CPU does not support
+ * is ignored.
+ */
+
+#if defined(__x86_64__)
+DECLARE_SIMD_KERNELS(avx512)
+DECLARE_SIMD_KERNELS(avx2)
+DECLARE_SIMD_KERNELS(sse42)
+DECLARE_SIMD_KERNELS(baseline)
+#elif defined(__aarch64__)
+DECLARE_SIMD_KERNELS(neon)
+#else
+DECLARE_SIMD_KERNELS(baseline)
+#endif
+
+#define SIMD_KERNELS(variant) { #variant, SIMD_KERNEL_NAME(findBoundary, variant), \
+                                SIMD_KERNEL_NAME(findPercentEscape, variant), \
+                                SIMD_KERNEL_NAME(base64Encode, variant), \
+                                SIMD_KERNEL_NAME(base64Decode, variant) }
+
+// Best first; the last variant runs on every host of the architecture
+static const SimdKernels variants[] = {
+#if defined(__x86_64__)
+    SIMD_KERNELS(avx512),
+    SIMD_KERNELS(avx2),
+    SIMD_KERNELS(sse42),
+    SIMD_KERNELS(baseline),
+#elif defined(__aarch64__)
+    SIMD_KERNELS(neon),
+#else
+    SIMD_KERNELS(baseline),
+#endif
+};
+
+#define SIMD_VARIANT_COUNT ((int)(sizeof(variants) / sizeof(variants[0])))
+
+static const SimdKernels* active = &variants[SIMD_VARIANT_COUNT - 1];
+
+// Whether the CPU (and, for AVX state, the OS) supports everything a variant was compiled with;
+// see SIMD_FLAGS_* in the Makefile
+static int cpuSupports(const char* variant) {
+#if defined(__x86_64__)
+    if (strcmp(variant, "avx512") == 0) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2") &&
+               __builtin_cpu_supports("fma");
+    }
+    if (strcmp(variant, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+               __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("fma");
+    }
+    if (strcmp(variant, "sse42") == 0) {
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    }
+#endif
+    return 1;
+}
+
+/**
+ * Selects the kernels of the named variant, or of the best supported variant if `name` is NULL.
+ * Returns 1, or 0 if the variant is unknown or not supported by this CPU.
+ */
+int selectSimdVariant(const char* name) {
+    for (int i = 0; i < SIMD_VARIANT_COUNT; i++) {
+        if ((name == NULL || strcmp(variants[i].name, name) == 0) &&
+            cpuSupports(variants[i].name)) {
+            active = &variants[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Gets the name of the active variant.
+ */
+const char* simdVariant(void) {
+    return active->name;
+}
+
+__attribute__((constructor))
+static void initSimdKernels(void) {
+#if defined(__x86_64__)
+    // Constructors may run before the one that initializes __builtin_cpu_supports
+    __builtin_cpu_init();
+#endif
+    const char* requested = getenv("BLYFAST_SIMD_VARIANT");
+    if (requested == NULL || !selectSimdVariant(requested)) {
+        selectSimdVariant(NULL);
+    }
+}
+
+int findBoundary(const unsigned char* haystack, int pos, int length, const char* needle,
+                 int needleLength) {
+    return active->findBoundary(haystack, pos, length, needle, needleLength);
+}
+
+int findPercentEscape(const char* src, int pos, int len, int plusAsSpace) {
+    return active->findPercentEscape(src, pos, len, plusAsSpace);
+}
+
+int base64Encode(const unsigned char* src, int length, char* dst, int flags) {
+    return active->base64Encode(src, length, dst, flags);
+}
+
+int base64Decode(const unsigned char* src, int length, unsigned char* dst, int flags) {
+    return active->base64Decode(src, length, dst, flags);
+}
+
+/**
+ * Gets the name of the active SIMD kernel variant: avx512, avx2, sse42 or baseline on x86-64,
+ * neon on aarch64, and baseline elsewhere.
+ */
+JNIEXPORT jstring JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSimdVariant
+  (JNIEnv *env, jclass cls) {
+    return (*env)->NewStringUTF(env, active->name);
+}
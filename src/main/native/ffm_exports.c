@@ -0,0 +1,67 @@
+#include "blyfastnative.h"
+
+/**
+ * Plain C entry points for the java.lang.foreign bindings (FfmBindings, Java 22+).
+ *
+ * Each one returns what the NativeOptimizer JNI function of the same purpose returns, but takes
+ * raw pointers instead of JNI references: the JVM passes the address of a direct buffer, or of a
+ * heap array through the critical linker option, so a call needs no JNIEnv, array pinning or
+ * string conversion. None of them block or call back into the JVM, which the critical option
+ * requires. Offsets and lengths are checked by the Java side, which knows the array bounds.
+ */
+
+/**
+ * Classifies a body by its Content-Type, given as `contentTypeLength` bytes of UTF-8. Same
+ * result as nativeAnalyzeHttpBody.
+ */
+int blyfastAnalyzeHttpBody(const char* body, int length, const char* contentType,
+                           int contentTypeLength) {
+    if (body == NULL || length < 0 || contentType == NULL || contentTypeLength < 0) {
+        return 0;
+    }
+    return analyzeHttpBody(body, length, contentType, contentTypeLength);
+}
+
+/**
+ * Detects the type of a body from its first bytes. Same result as nativeFastDetectContentType.
+ */
+int blyfastDetectContentType(const char* body, int length) {
+    if (body == NULL) {
+        return 0;
+    }
+    return detectContentType(body, length);
+}
+
+/**
+ * Tokenizes a Cookie header into `index`, which holds `indexLength` ints. Same result as
+ * nativeParseCookies.
+ */
+int blyfastParseCookies(const unsigned char* header, int length, jint* index, int indexLength) {
+    if (header == NULL || index == NULL || length < 0 || indexLength < 0) {
+        return 0;
+    }
+    return tokenizeCookies(header, length, index, indexLength / COOKIE_INDEX_ENTRY_INTS);
+}
+
+/**
+ * Tokenizes a raw query string into `index`, which holds `indexLength` ints. Same result as
+ * nativeParseQuery.
+ */
+int blyfastParseQuery(const unsigned char* query, int length, jint* index, int indexLength) {
+    if (query == NULL || index == NULL || length < 0 || indexLength < 0) {
+        return 0;
+    }
+    return tokenizeQuery(query, length, index, indexLength / QUERY_INDEX_ENTRY_INTS);
+}
+
+/**
+ * Percent-decodes `length` bytes of `src` into `dest`, which holds at least `length` bytes. Same
+ * result as nativePercentDecode: the decoded length, PERCENT_DECODE_UNCHANGED, or -2 if the
+ * arguments are invalid.
+ */
+int blyfastPercentDecode(const char* src, int length, char* dest, int plusAsSpace) {
+    if (src == NULL || dest == NULL || length < 0) {
+        return -2;
+    }
+    return percentDecode(dest, src, length, plusAsSpace);
+}
@@ -22,16 +22,6 @@ jobject parseFormData(JNIEnv *env, char* buffer, jint length) {
         return NULL;
     }
     
-    // Temporary buffers for URL decoding
-    char* keyBuffer = (char*)malloc(length + 1);
-    char* valueBuffer = (char*)malloc(length + 1);
-    if (keyBuffer == NULL || valueBuffer == NULL) {
-        free(result);
-        if (keyBuffer) free(keyBuffer);
-        if (valueBuffer) free(valueBuffer);
-        return NULL;
-    }
-    
     int resultPos = 0;
     int keyStart = 0;
     int valueStart = -1;
@@ -44,24 +34,23 @@ jobject parseFormData(JNIEnv *env, char* buffer, jint length) {
             // Found the separator between key and value
             int keyLength = i - keyStart;
             
-            // URL decode the key
-            int decodedKeyLen = urlDecode(keyBuffer, buffer + keyStart, keyLength);
-            
-            // Bounds check before writing
-            if (resultPos + 4 + decodedKeyLen > maxResultPos) {
+            // Bounds check before writing; decoding never makes the key longer
+            if (resultPos + 4 + keyLength > maxResultPos) {
                 free(result);
-                free(keyBuffer);
-                free(valueBuffer);
                 return NULL; // Buffer overflow protection
             }
             
-            // Write key length (4 bytes)
-            *((int*)(result + resultPos)) = decodedKeyLen;
-            resultPos += 4;
+            // URL decode the key straight into the result, copying keys without escapes as is
+            int decodedKeyLen = percentDecode(result + resultPos + 4, buffer + keyStart,
+                                              keyLength, 1);
+            if (decodedKeyLen == PERCENT_DECODE_UNCHANGED) {
+                memcpy(result + resultPos + 4, buffer + keyStart, keyLength);
+                decodedKeyLen = keyLength;
+            }
             
-            // Copy decoded key
-            memcpy(result + resultPos, keyBuffer, decodedKeyLen);
-            resultPos += decodedKeyLen;
+            // Write key length (4 bytes)
+            memcpy(result + resultPos, &decodedKeyLen, 4);
+            resultPos += 4 + decodedKeyLen;
             
             valueStart = i + 1;
         } else if (c == '&') {
@@ -73,24 +62,23 @@ jobject parseFormData(JNIEnv *env, char* buffer, jint length) {
             
             int valueLength = i - valueStart;
             
-            // URL decode the value
-            int decodedValueLen = urlDecode(valueBuffer, buffer + valueStart, valueLength);
-            
-            // Bounds check before writing
-            if (resultPos + 4 + decodedValueLen > maxResultPos) {
+            // Bounds check before writing; decoding never makes the value longer
+            if (resultPos + 4 + valueLength > maxResultPos) {
                 free(result);
-                free(keyBuffer);
-                free(valueBuffer);
                 return NULL; // Buffer overflow protection
             }
             
-            // Write value length (4 bytes)
-            *((int*)(result + resultPos)) = decodedValueLen;
-            resultPos += 4;
+            // URL decode the value straight into the result
+            int decodedValueLen = percentDecode(result + resultPos + 4, buffer + valueStart,
+                                                valueLength, 1);
+            if (decodedValueLen == PERCENT_DECODE_UNCHANGED) {
+                memcpy(result + resultPos + 4, buffer + valueStart, valueLength);
+                decodedValueLen = valueLength;
+            }
             
-            // Copy decoded value
-            memcpy(result + resultPos, valueBuffer, decodedValueLen);
-            resultPos += decodedValueLen;
+            // Write value length (4 bytes)
+            memcpy(result + resultPos, &decodedValueLen, 4);
+            resultPos += 4 + decodedValueLen;
             
             // Reset for next pair
             keyStart = i + 1;
@@ -98,10 +86,6 @@ jobject parseFormData(JNIEnv *env, char* buffer, jint length) {
         }
     }
     
-    // Clean up temporary buffers
-    free(keyBuffer);
-    free(valueBuffer);
-    
     // Create a Java byte array (Java-managed memory) to avoid memory leaks
     // NewDirectByteBuffer does NOT free malloc'd memory automatically
     jbyteArray byteArray = (*env)->NewByteArray(env, resultPos);
@@ -145,43 +129,86 @@ jobject parseFormData(JNIEnv *env, char* buffer, jint length) {
 }
 
 /**
- * Parse multipart form data - robust implementation with improved error handling
- * 
- * This parser can handle:
- * - Proper Content-Disposition header parsing (name, filename)
- * - Content-Type headers for parts
- * - Efficient boundary scanning
- * - Proper handling of CRLF at boundaries
- * - Memory-efficient processing
- * - Malformed input detection and error handling
+ * Tokenizes a urlencoded form body held in a direct ByteBuffer into an int array index of
+ * [name_off, name_len, value_off, value_len, flags] entries, the layout of nativeParseQuery.
+ * Offsets point into the body itself, so nothing is copied or decoded here.
+ *
+ * Returns the number of fields, the negated count if `index` is too small, or 0 on error.
  */
-jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
-    if (buffer == NULL || length <= 0) {
-        return NULL; // Invalid input
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseFormIndex
+  (JNIEnv *env, jclass cls, jobject body, jint length, jintArray index) {
+    if (body == NULL || index == NULL || length < 0) {
+        return 0;
     }
 
-    // Define structure for multipart/form-data parts
-    typedef struct {
-        char* name;          // Field name
-        char* filename;      // Optional filename for file uploads
-        char* contentType;   // Content type of the part
-        char* data;          // Pointer to data in original buffer
-        int dataLength;      // Length of data
-        char isFile;         // Whether this part is a file upload
-    } MultipartPart;
-    
-    // Max number of parts we'll process
-    // Using constant from header
-    
-    // Allocate array for tracking parts
-    MultipartPart parts[MAX_PARTS];
-    int partCount = 0;
-    
-    // Initialize all parts to null values
-    memset(parts, 0, sizeof(parts));
-    
-    // Find the boundary
-    char boundary[MAX_BOUNDARY_LEN] = {0};
+    unsigned char* bytes = (unsigned char*)(*env)->GetDirectBufferAddress(env, body);
+    if (bytes == NULL || length > (*env)->GetDirectBufferCapacity(env, body)) {
+        return 0;
+    }
+
+    int maxParams = (*env)->GetArrayLength(env, index) / QUERY_INDEX_ENTRY_INTS;
+    jint* entries = (jint*)(*env)->GetPrimitiveArrayCritical(env, index, NULL);
+    if (entries == NULL) {
+        return 0;
+    }
+
+    int count = tokenizeQuery(bytes, length, entries, maxParams);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, index, entries, 0);
+    return count;
+}
+
+// A multipart part; all strings point into the request body
+typedef struct MultipartPart {
+    const char* name;               // Field name
+    const char* filename;           // Optional filename for file uploads
+    const char* contentType;        // Content type of the part
+    const char* data;               // Content
+    int nameLength;
+    int filenameLength;
+    int contentTypeLength;
+    int dataLength;
+    char isFile;                    // Whether this part is a file upload
+    struct MultipartPart* next;
+} MultipartPart;
+
+// Part descriptors for typical forms fit on the stack; larger forms grow the arena on the heap
+#define MULTIPART_ARENA_STACK_SIZE 4096
+
+// Finds `token` in [start, end), or returns NULL
+static const char* findInLine(const char* start, const char* end, const char* token,
+                              int tokenLength) {
+    for (const char* p = start; end - p >= tokenLength; p++) {
+        p = memchr(p, token[0], end - p - tokenLength + 1);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (memcmp(p, token, tokenLength) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Finds the quoted parameter value after `token` (such as `name="`) in a header line
+static int findQuotedParam(const char* start, const char* end, const char* token,
+                           int tokenLength, const char** value) {
+    const char* valueStart = findInLine(start, end, token, tokenLength);
+    if (valueStart == NULL) {
+        return 0;
+    }
+    valueStart += tokenLength;
+    const char* valueEnd = memchr(valueStart, '"', end - valueStart);
+    if (valueEnd == NULL) {
+        return 0;
+    }
+    *value = valueStart;
+    return (int)(valueEnd - valueStart);
+}
+
+// Takes the boundary from the first line that looks like a delimiter, for callers that do not
+// have the Content-Type. Returns its length, or 0 if none is found.
+static int guessBoundary(const char* buffer, int length, char* boundary) {
     int boundaryLen = 0;
     
     // Extract boundary from the data
@@ -199,17 +226,16 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
                     break;
                 }
                 // Safeguard against too long boundary
-                if (k - j > MAX_BOUNDARY_LEN - 1 || k - j >= sizeof(boundary) - 1) {
+                if (k - j >= MAX_BOUNDARY_LEN - 1) {
                     break;
                 }
             }
             
             if (isLikelyBoundary) {
                 // Extract boundary string safely
-                boundaryLen = 0;
                 while (j < length && buffer[j] != '\r' && buffer[j] != '\n' && 
                        !(j + 1 < length && buffer[j] == '-' && buffer[j+1] == '-') && 
-                       boundaryLen < sizeof(boundary) - 1) {
+                       boundaryLen < MAX_BOUNDARY_LEN - 1) {
                     boundary[boundaryLen++] = buffer[j++];
                 }
                 boundary[boundaryLen] = 0;
@@ -217,64 +243,44 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
             }
         }
     }
-    
-    if (boundaryLen == 0) {
-        // Failed to find boundary
-        return NULL;
-    }
-    
-    // Prepare boundary markers
-    char* boundaryStart = NULL;
-    char* boundaryEnd = NULL;
-    
-    // Safely allocate boundary markers with length checks
-    boundaryStart = malloc(boundaryLen + 5); // "--boundary"
-    if (!boundaryStart) {
-        return NULL; // Memory allocation failure
-    }
-    
-    boundaryEnd = malloc(boundaryLen + 7);   // "--boundary--"
-    if (!boundaryEnd) {
-        free(boundaryStart);
-        return NULL; // Memory allocation failure
-    }
-    
-    // Format boundary strings
-    snprintf(boundaryStart, boundaryLen + 5, "--%s", boundary);
-    snprintf(boundaryEnd, boundaryLen + 7, "--%s--", boundary);
+    return boundaryLen;
+}
+
+// Finds the parts of a multipart body, allocating their descriptors from `arena`. Returns the
+// part count with the list in *firstPart, or -1 if allocation fails.
+static int collectMultipartParts(const char* buffer, int length, const char* boundary,
+                                 int boundaryLen, Arena* arena, MultipartPart** firstPart) {
+    // Prepare boundary markers: "--boundary" and "--boundary--"
+    char boundaryStart[MAX_BOUNDARY_LEN + 4];
+    char boundaryEnd[MAX_BOUNDARY_LEN + 4];
+    memcpy(boundaryStart, "--", 2);
+    memcpy(boundaryStart + 2, boundary, boundaryLen);
+    memcpy(boundaryEnd, boundaryStart, boundaryLen + 2);
+    memcpy(boundaryEnd + boundaryLen + 2, "--", 2);
     
     int boundaryStartLen = boundaryLen + 2;
     int boundaryEndLen = boundaryLen + 4;
     
+    // Parts are kept as a list in body order
+    MultipartPart* lastPart = NULL;
+    int partCount = 0;
+    *firstPart = NULL;
+    
     // Parse all parts
     int pos = 0;
-    int foundEndBoundary = 0;
     
-    while (pos < length && partCount < MAX_PARTS && !foundEndBoundary) {
+    while (pos < length) {
         // Find next boundary
-        int boundaryPos = -1;
-        
-        for (int i = pos; i <= length - boundaryStartLen; i++) {
-            // Check for boundary start (with bounds checking)
-            if (i + boundaryStartLen <= length && memcmp(buffer + i, boundaryStart, boundaryStartLen) == 0) {
-                boundaryPos = i;
-                
-                // Check if this is end boundary (with bounds checking)
-                if (i + boundaryEndLen <= length && 
-                    memcmp(buffer + i, boundaryEnd, boundaryEndLen) == 0) {
-                    foundEndBoundary = 1;
-                }
-                break;
-            }
-        }
-        
+        int boundaryPos = findBoundary((const unsigned char*)buffer, pos, length, boundaryStart,
+                                       boundaryStartLen);
         if (boundaryPos == -1) {
             break; // No more boundaries
         }
         
-        if (foundEndBoundary) {
-            // End of multipart data
-            break;
+        // Check if this is end boundary (with bounds checking)
+        if (boundaryPos + boundaryEndLen <= length &&
+            memcmp(buffer + boundaryPos, boundaryEnd, boundaryEndLen) == 0) {
+            break; // End of multipart data
         }
         
         // Move to the line after boundary
@@ -290,8 +296,8 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
         }
         
         // Parse headers
-        MultipartPart* part = &parts[partCount];
-        // Initialization already done by the memset above
+        MultipartPart part;
+        memset(&part, 0, sizeof(part));
         
         int headerEnd = headerStart;
         while (headerEnd < length) {
@@ -306,7 +312,9 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
                 break;
             }
             
-            // Extract header line
+            // Header line, parsed in place
+            const char* line = buffer + headerEnd;
+            const char* end = buffer + lineEnd;
             int lineLength = lineEnd - headerEnd;
             if (lineLength == 0) {
                 // Empty line marks end of headers
@@ -314,73 +322,40 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
                 break;
             }
             
-            // Allocate and copy header line for easier processing
-            char* headerLine = malloc(lineLength + 1);
-            if (!headerLine) {
-                // Memory allocation failure
-                goto cleanup;
-            }
-            
-            memcpy(headerLine, buffer + headerEnd, lineLength);
-            headerLine[lineLength] = 0;
-            
             // Parse Content-Disposition header
-            if (strncasecmp(headerLine, "Content-Disposition:", 20) == 0) {
-                char* valueStart = headerLine + 20;
-                while (*valueStart == ' ' || *valueStart == '\t') valueStart++;
+            if (lineLength >= 20 && strncasecmp(line, "Content-Disposition:", 20) == 0) {
+                const char* valueStart = line + 20;
+                const char* value = NULL;
                 
                 // Extract name parameter
-                char* nameStart = strstr(valueStart, "name=\"");
-                if (nameStart) {
-                    nameStart += 6; // Skip 'name="'
-                    char* nameEnd = strchr(nameStart, '"');
-                    if (nameEnd) {
-                        int nameLen = nameEnd - nameStart;
-                        if (nameLen > 0 && nameLen < MAX_HEADER_NAME_LEN) {
-                            part->name = malloc(nameLen + 1);
-                            if (part->name) {
-                                memcpy(part->name, nameStart, nameLen);
-                                part->name[nameLen] = 0;
-                            }
-                        }
-                    }
+                int nameLen = findQuotedParam(valueStart, end, "name=\"", 6, &value);
+                if (nameLen > 0 && nameLen < MAX_HEADER_NAME_LEN) {
+                    part.name = value;
+                    part.nameLength = nameLen;
                 }
                 
                 // Extract filename parameter
-                char* filenameStart = strstr(valueStart, "filename=\"");
-                if (filenameStart) {
-                    filenameStart += 10; // Skip 'filename="'
-                    char* filenameEnd = strchr(filenameStart, '"');
-                    if (filenameEnd) {
-                        int filenameLen = filenameEnd - filenameStart;
-                        if (filenameLen > 0 && filenameLen < MAX_HEADER_NAME_LEN) {
-                            part->filename = malloc(filenameLen + 1);
-                            if (part->filename) {
-                                memcpy(part->filename, filenameStart, filenameLen);
-                                part->filename[filenameLen] = 0;
-                                part->isFile = 1;
-                            }
-                        }
-                    }
+                int filenameLen = findQuotedParam(valueStart, end, "filename=\"", 10, &value);
+                if (filenameLen > 0 && filenameLen < MAX_HEADER_NAME_LEN) {
+                    part.filename = value;
+                    part.filenameLength = filenameLen;
+                    part.isFile = 1;
                 }
             }
             // Parse Content-Type header
-            else if (strncasecmp(headerLine, "Content-Type:", 13) == 0) {
-                char* valueStart = headerLine + 13;
-                while (*valueStart == ' ' || *valueStart == '\t') valueStart++;
+            else if (lineLength >= 13 && strncasecmp(line, "Content-Type:", 13) == 0) {
+                const char* valueStart = line + 13;
+                while (valueStart < end && (*valueStart == ' ' || *valueStart == '\t')) {
+                    valueStart++;
+                }
                 
-                int valueLen = strlen(valueStart);
+                int valueLen = (int)(end - valueStart);
                 if (valueLen > 0 && valueLen < MAX_CONTENT_TYPE_LEN) {
-                    part->contentType = malloc(valueLen + 1);
-                    if (part->contentType) {
-                        memcpy(part->contentType, valueStart, valueLen);
-                        part->contentType[valueLen] = 0;
-                    }
+                    part.contentType = valueStart;
+                    part.contentTypeLength = valueLen;
                 }
             }
             
-            free(headerLine);
-            
             // Move to next header
             headerEnd = lineEnd + 2; // Skip CRLF
         }
@@ -389,40 +364,91 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
         int contentStart = headerEnd;
         int nextBoundaryPos = length;
         
-        for (int i = contentStart; i <= length - boundaryStartLen; i++) {
-            if (memcmp(buffer + i, boundaryStart, boundaryStartLen) == 0) {
-                // Check if there's a preceding CRLF that should be excluded from content
-                if (i >= 2 && buffer[i-2] == '\r' && buffer[i-1] == '\n') {
-                    nextBoundaryPos = i - 2;
-                } else {
-                    nextBoundaryPos = i;
-                }
-                break;
+        int i = findBoundary((const unsigned char*)buffer, contentStart, length, boundaryStart,
+                             boundaryStartLen);
+        if (i >= 0) {
+            // Check if there's a preceding CRLF that should be excluded from content
+            if (i >= 2 && buffer[i-2] == '\r' && buffer[i-1] == '\n') {
+                nextBoundaryPos = i - 2;
+            } else {
+                nextBoundaryPos = i;
             }
         }
         
-        // Set content data pointer and length with bounds checking
+        // Keep parts with content; invalid data boundaries skip the part
         if (contentStart < nextBoundaryPos && nextBoundaryPos <= length) {
-            part->data = buffer + contentStart;
-            part->dataLength = nextBoundaryPos - contentStart;
+            part.data = buffer + contentStart;
+            part.dataLength = nextBoundaryPos - contentStart;
             
-            // Move to next part
+            MultipartPart* kept = (MultipartPart*)arenaAlloc(arena, sizeof(MultipartPart));
+            if (kept == NULL) {
+                return -1; // Memory allocation failure
+            }
+            *kept = part;
+            if (lastPart != NULL) {
+                lastPart->next = kept;
+            } else {
+                *firstPart = kept;
+            }
+            lastPart = kept;
             partCount++;
-            pos = nextBoundaryPos;
-        } else {
-            // Invalid data boundaries, skip this part
-            pos = nextBoundaryPos;
         }
+        
+        // Move to next part
+        pos = nextBoundaryPos;
     }
     
-    // If no parts were found, return null
-    if (partCount == 0) {
-        free(boundaryStart);
-        free(boundaryEnd);
+    return partCount;
+}
+
+/**
+ * Parse multipart form data - robust implementation with improved error handling
+ *
+ * `boundary` is the Content-Type boundary parameter, of `boundaryLength` bytes; with a length of 0
+ * it is guessed from the first delimiter line of the body.
+ * 
+ * This parser can handle:
+ * - Proper Content-Disposition header parsing (name, filename)
+ * - Content-Type headers for parts
+ * - Efficient boundary scanning
+ * - Proper handling of CRLF at boundaries
+ * - Any number of parts: descriptors come from an arena released in one shot, and names,
+ *   filenames and content types point into the body instead of being copied
+ * - Malformed input detection and error handling
+ */
+jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length, const char* boundary,
+                           int boundaryLength) {
+    if (buffer == NULL || length <= 0) {
+        return NULL; // Invalid input
+    }
+
+    // Use the Content-Type boundary when given, so matching starts at once
+    char guessed[MAX_BOUNDARY_LEN];
+    int boundaryLen = boundaryLength;
+    if (boundaryLen <= 0) {
+        boundary = guessed;
+        boundaryLen = guessBoundary(buffer, length, guessed);
+    }
+    if (boundaryLen == 0 || boundaryLen >= MAX_BOUNDARY_LEN) {
+        // Failed to find boundary
         return NULL;
     }
     
-    // Allocate memory for serialized parts in a format we can return to Java
+    // Parts are kept as a list in body order
+    unsigned char stackBlock[MULTIPART_ARENA_STACK_SIZE];
+    Arena arena;
+    arenaInit(&arena, stackBlock, sizeof(stackBlock));
+    MultipartPart* firstPart = NULL;
+    int partCount = collectMultipartParts(buffer, length, boundary, boundaryLen, &arena,
+                                          &firstPart);
+    
+    // If no parts were found or allocation failed, return null
+    if (partCount <= 0) {
+        arenaRelease(&arena);
+        return NULL;
+    }
+    
+    // Serialize the parts in a format we can return to Java, in native byte order
     // Format: [part_count:4][serialized_parts...]
     // Each serialized part format:
     // [name_len:4][filename_len:4][content_type_len:4][data_len:4][is_file:1]
@@ -430,30 +456,37 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
     
     // Calculate required size with overflow protection
     size_t totalSize = 4; // part count
-    for (int i = 0; i < partCount; i++) {
-        MultipartPart* part = &parts[i];
+    for (MultipartPart* part = firstPart; part != NULL; part = part->next) {
         size_t partSize = 4 + 4 + 4 + 4 + 1; // lengths and is_file flag
         
-        partSize += part->name ? strlen(part->name) : 0;
-        partSize += part->filename ? strlen(part->filename) : 0;
-        partSize += part->contentType ? strlen(part->contentType) : 0;
+        partSize += part->nameLength;
+        partSize += part->filenameLength;
+        partSize += part->contentTypeLength;
         partSize += part->dataLength;
         
         // Add padding for alignment if needed
         partSize = (partSize + 3) & ~3; // Align to 4 bytes
         
-        // Check for overflow
-        if (totalSize > SIZE_MAX - partSize) {
-            goto cleanup; // Integer overflow
-        }
         totalSize += partSize;
+        if (totalSize > INT_MAX) {
+            arenaRelease(&arena);
+            return NULL; // Larger than a Java array
+        }
+    }
+    
+    // Serialize straight into Java-managed memory, without an intermediate native copy
+    jbyteArray byteArray = (*env)->NewByteArray(env, (jsize)totalSize);
+    if (byteArray == NULL) {
+        arenaRelease(&arena);
+        CHECK_JNI_EXCEPTION(env);
+        return NULL;
     }
     
-    // Allocate result buffer
-    char* result = (char*)malloc(totalSize);
-    if (!result) {
-        // Clean up parts before returning
-        goto cleanup;
+    char* result = (char*)(*env)->GetPrimitiveArrayCritical(env, byteArray, NULL);
+    if (result == NULL) {
+        arenaRelease(&arena);
+        (*env)->DeleteLocalRef(env, byteArray);
+        return NULL;
     }
     
     // Write part count
@@ -461,68 +494,33 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
     size_t resultPos = 4;
     
     // Write each part
-    for (int i = 0; i < partCount; i++) {
-        MultipartPart* part = &parts[i];
-        
-        // Get string lengths, handle NULL pointers
-        int nameLen = part->name ? strlen(part->name) : 0;
-        int filenameLen = part->filename ? strlen(part->filename) : 0;
-        int contentTypeLen = part->contentType ? strlen(part->contentType) : 0;
-        
-        // Bounds checking before each write
-        if (resultPos + 17 > totalSize) { // 4+4+4+4+1 = 17 minimum
-            free(result);
-            goto cleanup;
-        }
-        
+    for (MultipartPart* part = firstPart; part != NULL; part = part->next) {
         // Write header lengths and is_file flag
-        *((int*)(result + resultPos)) = nameLen;
+        *((int*)(result + resultPos)) = part->nameLength;
         resultPos += 4;
-        *((int*)(result + resultPos)) = filenameLen;
+        *((int*)(result + resultPos)) = part->filenameLength;
         resultPos += 4;
-        *((int*)(result + resultPos)) = contentTypeLen;
+        *((int*)(result + resultPos)) = part->contentTypeLength;
         resultPos += 4;
         *((int*)(result + resultPos)) = part->dataLength;
         resultPos += 4;
         result[resultPos++] = part->isFile;
         
-        // Write strings with bounds checking
-        if (nameLen > 0 && part->name) {
-            if (resultPos + nameLen > totalSize) {
-                free(result);
-                goto cleanup;
-            }
-            memcpy(result + resultPos, part->name, nameLen);
-            resultPos += nameLen;
+        // Write strings and data; absent strings have length 0
+        if (part->nameLength > 0) {
+            memcpy(result + resultPos, part->name, part->nameLength);
+            resultPos += part->nameLength;
         }
-        
-        if (filenameLen > 0 && part->filename) {
-            if (resultPos + filenameLen > totalSize) {
-                free(result);
-                goto cleanup;
-            }
-            memcpy(result + resultPos, part->filename, filenameLen);
-            resultPos += filenameLen;
-        }
-        
-        if (contentTypeLen > 0 && part->contentType) {
-            if (resultPos + contentTypeLen > totalSize) {
-                free(result);
-                goto cleanup;
-            }
-            memcpy(result + resultPos, part->contentType, contentTypeLen);
-            resultPos += contentTypeLen;
+        if (part->filenameLength > 0) {
+            memcpy(result + resultPos, part->filename, part->filenameLength);
+            resultPos += part->filenameLength;
         }
-        
-        // Write data with bounds checking
-        if (part->dataLength > 0 && part->data) {
-            if (resultPos + part->dataLength > totalSize) {
-                free(result);
-                goto cleanup;
-            }
-            memcpy(result + resultPos, part->data, part->dataLength);
-            resultPos += part->dataLength;
+        if (part->contentTypeLength > 0) {
+            memcpy(result + resultPos, part->contentType, part->contentTypeLength);
+            resultPos += part->contentTypeLength;
         }
+        memcpy(result + resultPos, part->data, part->dataLength);
+        resultPos += part->dataLength;
         
         // Align to 4 bytes if needed
         while (resultPos % 4 != 0 && resultPos < totalSize) {
@@ -530,33 +528,8 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
         }
     }
     
-    // Clean up part resources
-    for (int i = 0; i < partCount; i++) {
-        free(parts[i].name);
-        free(parts[i].filename);
-        free(parts[i].contentType);
-        // Note: We don't free part->data as it points into the original buffer
-    }
-    
-    // Clean up temporary allocations
-    free(boundaryStart);
-    free(boundaryEnd);
-    
-    // Create a Java byte array (Java-managed memory) to avoid memory leaks
-    // NewDirectByteBuffer does NOT free malloc'd memory automatically
-    jbyteArray byteArray = (*env)->NewByteArray(env, totalSize);
-    if (byteArray == NULL) {
-        free(result);
-        CHECK_JNI_EXCEPTION(env);
-        return NULL;
-    }
-    
-    // Copy data to Java-managed memory
-    (*env)->SetByteArrayRegion(env, byteArray, 0, totalSize, (jbyte*)result);
-    CHECK_JNI_EXCEPTION(env);
-    
-    // Free the malloc'd buffer
-    free(result);
+    (*env)->ReleasePrimitiveArrayCritical(env, byteArray, result, 0);
+    arenaRelease(&arena);
     
     // Wrap the byte array in a ByteBuffer
     jclass byteBufferClass = (*env)->FindClass(env, "java/nio/ByteBuffer");
@@ -588,18 +561,100 @@ jobject parseMultipartForm(JNIEnv *env, char* buffer, jint length) {
     (*env)->DeleteLocalRef(env, byteArray);
     
     return resultBuffer;
+}
 
-cleanup:
-    // Error handling - clean up all allocated resources
-    for (int i = 0; i < MAX_PARTS; i++) {
-        free(parts[i].name);
-        free(parts[i].filename);
-        free(parts[i].contentType);
-        // Note: We don't free part->data as it points into the original buffer
+// Copies a boundary parameter from Java; returns its length, or 0 if it is empty or too long
+static int getBoundaryBytes(JNIEnv *env, jstring boundary, char* out) {
+    jsize boundaryLength = (*env)->GetStringUTFLength(env, boundary);
+    if (boundaryLength <= 0 || boundaryLength >= MAX_BOUNDARY_LEN) {
+        return 0;
     }
-    
-    free(boundaryStart);
-    free(boundaryEnd);
-    return NULL;
+    (*env)->GetStringUTFRegion(env, boundary, 0, (*env)->GetStringLength(env, boundary), out);
+    return boundaryLength;
+}
+
+/**
+ * Parses a multipart/form-data body held in a direct ByteBuffer using the boundary parameter of
+ * its Content-Type, into the layout returned by nativeFastParseBody. Returns NULL if the boundary
+ * is invalid or the body has no parts.
+ */
+JNIEXPORT jobject JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseMultipartForm
+  (JNIEnv *env, jclass cls, jobject body, jint length, jstring boundary) {
+    if (body == NULL || boundary == NULL || length <= 0) {
+        return NULL;
+    }
+    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, body);
+    if (buffer == NULL || length > (*env)->GetDirectBufferCapacity(env, body)) {
+        return NULL;
+    }
+
+    char boundaryBytes[MAX_BOUNDARY_LEN];
+    int boundaryLength = getBoundaryBytes(env, boundary, boundaryBytes);
+    if (boundaryLength == 0) {
+        return NULL;
+    }
+    return parseMultipartForm(env, buffer, length, boundaryBytes, boundaryLength);
 }
 
+/**
+ * Indexes the parts of a multipart/form-data body held in a direct ByteBuffer without copying
+ * anything, writing MULTIPART_INDEX_ENTRY_INTS ints per part into `index`: [name_off, name_len,
+ * filename_off, filename_len, type_off, type_len, data_off, data_len]. Offsets are body indexes
+ * and absent values have length -1.
+ *
+ * Returns the part count, its negation if `index` is too small (nothing is written; call again
+ * with room for that many parts), or 0 if the boundary is invalid, no part is found or
+ * allocation fails.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeIndexMultipartForm
+  (JNIEnv *env, jclass cls, jobject body, jint length, jstring boundary, jintArray index) {
+    if (body == NULL || boundary == NULL || index == NULL || length <= 0) {
+        return 0;
+    }
+    const char* buffer = (const char*)(*env)->GetDirectBufferAddress(env, body);
+    if (buffer == NULL || length > (*env)->GetDirectBufferCapacity(env, body)) {
+        return 0;
+    }
+    char boundaryBytes[MAX_BOUNDARY_LEN];
+    int boundaryLength = getBoundaryBytes(env, boundary, boundaryBytes);
+    if (boundaryLength == 0) {
+        return 0;
+    }
+
+    unsigned char stackBlock[MULTIPART_ARENA_STACK_SIZE];
+    Arena arena;
+    arenaInit(&arena, stackBlock, sizeof(stackBlock));
+    MultipartPart* firstPart = NULL;
+    int partCount = collectMultipartParts(buffer, length, boundaryBytes, boundaryLength, &arena,
+                                          &firstPart);
+    if (partCount <= 0) {
+        arenaRelease(&arena);
+        return 0;
+    }
+    if (partCount > (*env)->GetArrayLength(env, index) / MULTIPART_INDEX_ENTRY_INTS) {
+        arenaRelease(&arena);
+        return -partCount;
+    }
+
+    jint* entries = (jint*)(*env)->GetPrimitiveArrayCritical(env, index, NULL);
+    if (entries == NULL) {
+        arenaRelease(&arena);
+        return 0;
+    }
+    jint* entry = entries;
+    for (MultipartPart* part = firstPart; part != NULL; part = part->next) {
+        entry[0] = part->name != NULL ? (jint)(part->name - buffer) : 0;
+        entry[1] = part->name != NULL ? part->nameLength : -1;
+        entry[2] = part->filename != NULL ? (jint)(part->filename - buffer) : 0;
+        entry[3] = part->filename != NULL ? part->filenameLength : -1;
+        entry[4] = part->contentType != NULL ? (jint)(part->contentType - buffer) : 0;
+        entry[5] = part->contentType != NULL ? part->contentTypeLength : -1;
+        entry[6] = (jint)(part->data - buffer);
+        entry[7] = part->dataLength;
+        entry += MULTIPART_INDEX_ENTRY_INTS;
+    }
+    (*env)->ReleasePrimitiveArrayCritical(env, index, entries, 0);
+
+    arenaRelease(&arena);
+    return partCount;
+}
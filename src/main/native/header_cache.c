@@ -0,0 +1,346 @@
+#include "blyfastnative.h"
+
+/**
+ * Header block dedup cache.
+ *
+ * Keep-alive clients such as internal services tend to send the same header block on every
+ * request, apart from a few fields like a request ID. When the cache is enabled, the parser hashes
+ * each block with the configured volatile header lines left out and looks the hash up in a
+ * direct-mapped table. On a hit only the volatile lines are parsed; every other header comes from
+ * the cached, already indexed set, which is shared by reference. Stable lines are compared byte for
+ * byte before a hit is taken, so a hash collision only costs a miss.
+ *
+ * A set built through the cache links its volatile headers first, then the shared ones. Each
+ * volatile header records how many shared headers preceded it on the wire, so that exports can
+ * restore wire order; lookups by name are unaffected, since a name is either volatile or not.
+ */
+
+typedef struct {
+    char* name;
+    int length;
+} VolatileHeader;
+
+// Immutable once published; replaced configurations are kept since parsers may still read them
+typedef struct {
+    VolatileHeader headers[MAX_VOLATILE_HEADERS];
+    int count;
+} HeaderCacheConfig;
+
+typedef struct {
+    uint64_t hash;
+    char* stable;               // Stable lines joined with '\n', for exact comparison
+    int stableLength;
+    ParsedHeaders* headers;     // Shared parsed stable headers; the cache holds one reference
+} HeaderBlockCacheEntry;
+
+typedef struct {
+    const char* start;
+    int length;
+    int isVolatile;
+} HeaderLine;
+
+enum { STAT_HITS, STAT_MISSES, STAT_BYPASSES, STAT_EVICTIONS, STAT_BYTES_REUSED };
+
+static HeaderCacheConfig* activeConfig = NULL;
+static HeaderBlockCacheEntry* cacheEntries = NULL;
+static uint32_t cacheMask = 0;
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t cacheStats[HEADER_CACHE_STATS];
+
+static inline void countStat(int stat, int64_t amount) {
+    __atomic_add_fetch(&cacheStats[stat], amount, __ATOMIC_RELAXED);
+}
+
+// Mixes one line into the block hash, eight bytes at a time
+static uint64_t hashLine(uint64_t hash, const unsigned char* p, int length) {
+    const uint64_t k = 0x9E3779B97F4A7C15ULL;
+    uint64_t lineLength = (uint64_t)length;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = (hash ^ word) * k;
+        hash ^= hash >> 29;
+        p += 8;
+        length -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, length);
+    hash = (hash ^ tail ^ (lineLength << 40)) * k;
+    return hash ^ (hash >> 32);
+}
+
+static int isVolatileLine(const HeaderCacheConfig* config, const char* line, int length) {
+    const char* colon = memchr(line, ':', length);
+    if (colon == NULL) {
+        return 0;
+    }
+    int nameLen = (int)(colon - line);
+    while (nameLen > 0 && (line[nameLen - 1] == ' ' || line[nameLen - 1] == '\t')) {
+        nameLen--;
+    }
+    for (int i = 0; i < config->count; i++) {
+        if (config->headers[i].length == nameLen &&
+            strncasecmp(config->headers[i].name, line, nameLen) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int stableLinesMatch(const HeaderBlockCacheEntry* entry, const HeaderLine* lines,
+                            int lineCount) {
+    int pos = 0;
+    for (int i = 0; i < lineCount; i++) {
+        if (lines[i].isVolatile) {
+            continue;
+        }
+        if (memcmp(entry->stable + pos, lines[i].start, lines[i].length) != 0) {
+            return 0;
+        }
+        pos += lines[i].length + 1;
+    }
+    return 1;
+}
+
+static void releaseCacheEntries(HeaderBlockCacheEntry* entries, uint32_t mask) {
+    if (entries == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i <= mask; i++) {
+        freeParsedHeaders(entries[i].headers);
+        free(entries[i].stable);
+    }
+    free(entries);
+}
+
+int headerBlockCacheEnabled(void) {
+    return __atomic_load_n(&activeConfig, __ATOMIC_ACQUIRE) != NULL;
+}
+
+/**
+ * Parses a header block through the cache. Returns an unregistered set, or NULL if the block
+ * should be parsed normally (cache disabled, too many lines, nothing stable or out of memory).
+ * With `framing` set every line is validated while splitting, hits included; on a violation NULL
+ * is returned with the code in framing->error.
+ */
+ParsedHeaders* parseCachedHeaderBlock(const char* buffer, int length, HeaderFraming* framing) {
+    const HeaderCacheConfig* config = __atomic_load_n(&activeConfig, __ATOMIC_ACQUIRE);
+    if (config == NULL) {
+        return NULL;
+    }
+
+    // Split into lines like the parser does, hashing the stable ones
+    HeaderLine lines[MAX_CACHED_HEADER_LINES];
+    int lineCount = 0;
+    int stableLength = 0;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const char* pos = buffer;
+    const char* end = buffer + length;
+
+    while (pos < end) {
+        const char* lineEnd = findHeaderLineEnd(pos, end, framing);
+        if (framing != NULL && (framing->error != 0 ||
+                                (lineEnd > pos && checkHeaderFraming(framing, pos, lineEnd) != 0))) {
+            return NULL;
+        }
+        if (lineEnd > pos) {
+            if (lineCount == MAX_CACHED_HEADER_LINES) {
+                countStat(STAT_BYPASSES, 1);
+                return NULL;
+            }
+            HeaderLine* line = &lines[lineCount++];
+            line->start = pos;
+            line->length = (int)(lineEnd - pos);
+            line->isVolatile = isVolatileLine(config, pos, line->length);
+            if (!line->isVolatile) {
+                hash = hashLine(hash, (const unsigned char*)pos, line->length);
+                stableLength += line->length + 1;
+            }
+        }
+        if (lineEnd < end && *lineEnd == '\r') lineEnd++;
+        if (lineEnd < end && *lineEnd == '\n') lineEnd++;
+        pos = lineEnd;
+    }
+
+    if (stableLength == 0) {
+        countStat(STAT_BYPASSES, 1);
+        return NULL;
+    }
+
+    ParsedHeaders* headers = newParsedHeaders();
+    if (!headers) {
+        return NULL;
+    }
+    // Stable lines without a colon add no header, so only count those with one
+    int sharedBefore = 0;
+    for (int i = 0; i < lineCount; i++) {
+        if (!lines[i].isVolatile) {
+            sharedBefore += memchr(lines[i].start, ':', lines[i].length) != NULL;
+        } else if (addHeaderLine(headers, lines[i].start, lines[i].start + lines[i].length) != 0) {
+            freeParsedHeaders(headers);
+            return NULL;
+        } else {
+            headers->last->sharedBefore = sharedBefore;
+        }
+    }
+
+    ParsedHeaders* shared = NULL;
+    pthread_mutex_lock(&cacheMutex);
+    if (cacheEntries != NULL) {
+        HeaderBlockCacheEntry* entry = &cacheEntries[hash & cacheMask];
+        if (entry->headers != NULL && entry->hash == hash && entry->stableLength == stableLength &&
+            stableLinesMatch(entry, lines, lineCount)) {
+            shared = entry->headers;
+            __atomic_add_fetch(&shared->refCount, 1, __ATOMIC_ACQ_REL);
+        }
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    if (shared != NULL) {
+        countStat(STAT_HITS, 1);
+        countStat(STAT_BYTES_REUSED, stableLength);
+    } else {
+        countStat(STAT_MISSES, 1);
+
+        shared = newParsedHeaders();
+        char* stable = (char*)malloc(stableLength);
+        if (!shared || !stable) {
+            free(shared);
+            free(stable);
+            freeParsedHeaders(headers);
+            return NULL;
+        }
+        shared->refCount = 1;
+
+        int stablePos = 0;
+        for (int i = 0; i < lineCount; i++) {
+            if (lines[i].isVolatile) {
+                continue;
+            }
+            if (addHeaderLine(shared, lines[i].start, lines[i].start + lines[i].length) != 0) {
+                free(stable);
+                freeParsedHeaders(shared);
+                freeParsedHeaders(headers);
+                return NULL;
+            }
+            memcpy(stable + stablePos, lines[i].start, lines[i].length);
+            stable[stablePos + lines[i].length] = '\n';
+            stablePos += lines[i].length + 1;
+        }
+        buildHeaderIndex(shared);
+
+        // Replace whatever occupied the slot; its holders keep their own references
+        ParsedHeaders* evicted = NULL;
+        char* evictedStable = stable;
+        pthread_mutex_lock(&cacheMutex);
+        if (cacheEntries != NULL) {
+            HeaderBlockCacheEntry* entry = &cacheEntries[hash & cacheMask];
+            evicted = entry->headers;
+            evictedStable = entry->stable;
+            entry->hash = hash;
+            entry->stable = stable;
+            entry->stableLength = stableLength;
+            entry->headers = shared;
+            __atomic_add_fetch(&shared->refCount, 1, __ATOMIC_ACQ_REL);
+        }
+        pthread_mutex_unlock(&cacheMutex);
+
+        if (evicted != NULL) {
+            countStat(STAT_EVICTIONS, 1);
+            freeParsedHeaders(evicted);
+        }
+        free(evictedStable);
+    }
+
+    // Link the shared headers after the volatile ones; see nativeExportHeaders for wire order
+    if (headers->last != NULL) {
+        headers->last->next = shared->first;
+    } else {
+        headers->first = shared->first;
+    }
+    headers->base = shared;
+    headers->count += shared->count;
+    return headers;
+}
+
+/**
+ * Enables the header block cache with `entries` slots (rounded up to a power of two), treating the
+ * named headers as volatile, or disables it when `entries` is 0. Clears the statistics.
+ *
+ * Returns the number of slots, or 0 if the cache is disabled.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeConfigureHeaderCache
+  (JNIEnv *env, jclass cls, jint entries, jobjectArray volatileHeaders) {
+    HeaderCacheConfig* config = NULL;
+    HeaderBlockCacheEntry* newEntries = NULL;
+    uint32_t capacity = 0;
+
+    if (entries > 0) {
+        jsize volatileCount = volatileHeaders != NULL
+            ? (*env)->GetArrayLength(env, volatileHeaders) : 0;
+        if (volatileCount > MAX_VOLATILE_HEADERS) {
+            return 0;
+        }
+
+        capacity = 1;
+        while (capacity < (uint32_t)entries && capacity < (1u << 16)) {
+            capacity <<= 1;
+        }
+        config = (HeaderCacheConfig*)calloc(1, sizeof(HeaderCacheConfig));
+        newEntries = (HeaderBlockCacheEntry*)calloc(capacity, sizeof(HeaderBlockCacheEntry));
+        if (!config || !newEntries) {
+            free(config);
+            free(newEntries);
+            return 0;
+        }
+
+        for (jsize i = 0; i < volatileCount; i++) {
+            jstring str = (jstring)(*env)->GetObjectArrayElement(env, volatileHeaders, i);
+            const char* chars = str != NULL ? (*env)->GetStringUTFChars(env, str, NULL) : NULL;
+            if (chars != NULL) {
+                size_t len = strlen(chars);
+                char* name = len > 0 && len <= MAX_HEADER_NAME_LEN ? strdup(chars) : NULL;
+                if (name != NULL) {
+                    config->headers[config->count].name = name;
+                    config->headers[config->count].length = (int)len;
+                    config->count++;
+                }
+                (*env)->ReleaseStringUTFChars(env, str, chars);
+            }
+            if (str != NULL) {
+                (*env)->DeleteLocalRef(env, str);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&cacheMutex);
+    HeaderBlockCacheEntry* oldEntries = cacheEntries;
+    uint32_t oldMask = cacheMask;
+    cacheEntries = newEntries;
+    cacheMask = capacity > 0 ? capacity - 1 : 0;
+    __atomic_store_n(&activeConfig, config, __ATOMIC_RELEASE);
+    for (int i = 0; i < HEADER_CACHE_STATS; i++) {
+        __atomic_store_n(&cacheStats[i], 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    releaseCacheEntries(oldEntries, oldMask);
+    return (jint)capacity;
+}
+
+/**
+ * Copies the cache statistics (hits, misses, bypasses, evictions, bytes reused) into `out`
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHeaderCacheStats
+  (JNIEnv *env, jclass cls, jlongArray out) {
+    if (out == NULL) {
+        return;
+    }
+    jsize length = (*env)->GetArrayLength(env, out);
+    jlong values[HEADER_CACHE_STATS];
+    for (int i = 0; i < HEADER_CACHE_STATS; i++) {
+        values[i] = (jlong)__atomic_load_n(&cacheStats[i], __ATOMIC_RELAXED);
+    }
+    (*env)->SetLongArrayRegion(env, out, 0, length < HEADER_CACHE_STATS ? length : HEADER_CACHE_STATS,
+                               values);
+}
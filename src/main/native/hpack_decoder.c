@@ -0,0 +1,420 @@
+#include "blyfastnative.h"
+
+/**
+ * HPACK (RFC 7541) decoder for HTTP/2 header blocks.
+ *
+ * Each connection owns one decoder, since the dynamic table is connection state. Header blocks
+ * must be decoded in the order they arrive, from one thread at a time. A decoded block is
+ * published as a regular parsed header set, so nativeGetHeader, nativeGetHeaderValues and
+ * nativeExportHeaders work on it exactly as on HTTP/1.1 headers. Pseudo-headers keep their
+ * names (":method", ":path", ...).
+ */
+
+// Huffman decoding runs a 4-bit-at-a-time state machine over the code tree. States are the
+// tree's 256 internal nodes; since the shortest code is 5 bits, a nibble emits at most one symbol.
+#define HUFFMAN_DECODE_STATES 256
+#define HUFFMAN_FLAG_EMIT 0x01
+#define HUFFMAN_FLAG_ACCEPT 0x02
+#define HUFFMAN_FLAG_FAIL 0x04
+
+typedef struct {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t symbol;
+} HuffmanDecodeEntry;
+
+static HuffmanDecodeEntry huffmanDecodeTable[HUFFMAN_DECODE_STATES][16];
+static pthread_once_t huffmanTableOnce = PTHREAD_ONCE_INIT;
+
+// Per-connection decoder state
+typedef struct {
+    HpackDynamicTable table;
+    char* scratch;          // Huffman output: decoded name followed by decoded value
+    size_t scratchSize;
+} HpackDecoder;
+
+static void buildHuffmanDecodeTable(void) {
+    // Code tree: children >= 0 are internal nodes, < 0 are leaves holding ~symbol
+    int children[HUFFMAN_DECODE_STATES][2];
+    uint8_t depth[HUFFMAN_DECODE_STATES];
+    uint8_t allOnes[HUFFMAN_DECODE_STATES];
+    int nodeCount = 1;
+
+    memset(children, 0, sizeof(children));
+    depth[0] = 0;
+    allOnes[0] = 1;
+
+    for (int sym = 0; sym < HPACK_HUFFMAN_SYMBOLS; sym++) {
+        uint32_t code = hpackHuffmanCodes[sym];
+        int len = hpackHuffmanCodeLengths[sym];
+        int node = 0;
+        for (int bit = len - 1; bit >= 0; bit--) {
+            int b = (code >> bit) & 1;
+            if (bit == 0) {
+                children[node][b] = ~sym;
+            } else {
+                if (children[node][b] == 0) {
+                    int child = nodeCount++;
+                    children[node][b] = child;
+                    depth[child] = depth[node] + 1;
+                    allOnes[child] = allOnes[node] && b == 1;
+                }
+                node = children[node][b];
+            }
+        }
+    }
+
+    for (int state = 0; state < nodeCount; state++) {
+        for (int nibble = 0; nibble < 16; nibble++) {
+            HuffmanDecodeEntry* entry = &huffmanDecodeTable[state][nibble];
+            int node = state;
+            entry->flags = 0;
+
+            for (int bit = 3; bit >= 0; bit--) {
+                int next = children[node][(nibble >> bit) & 1];
+                if (next < 0) {
+                    int sym = ~next;
+                    if (sym == 256) {
+                        // EOS inside a string is a decoding error (5.2)
+                        entry->flags = HUFFMAN_FLAG_FAIL;
+                        break;
+                    }
+                    entry->flags |= HUFFMAN_FLAG_EMIT;
+                    entry->symbol = (uint8_t)sym;
+                    node = 0;
+                } else {
+                    node = next;
+                }
+            }
+
+            if (!(entry->flags & HUFFMAN_FLAG_FAIL)) {
+                entry->state = (uint8_t)node;
+                // A string may only end on a symbol boundary or inside at most 7 bits of EOS prefix
+                if (node == 0 || (allOnes[node] && depth[node] <= 7)) {
+                    entry->flags |= HUFFMAN_FLAG_ACCEPT;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Decodes a Huffman-coded string. Returns the decoded length, or -1 on malformed input or if
+ * the output does not fit in destCap bytes.
+ */
+int hpackHuffmanDecode(const unsigned char* src, size_t len, char* dest, size_t destCap) {
+    pthread_once(&huffmanTableOnce, buildHuffmanDecodeTable);
+
+    uint8_t state = 0;
+    uint8_t flags = HUFFMAN_FLAG_ACCEPT;
+    size_t out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        for (int shift = 4; shift >= 0; shift -= 4) {
+            const HuffmanDecodeEntry* entry = &huffmanDecodeTable[state][(src[i] >> shift) & 0x0F];
+            if (entry->flags & HUFFMAN_FLAG_FAIL) {
+                return -1;
+            }
+            if (entry->flags & HUFFMAN_FLAG_EMIT) {
+                if (out >= destCap) {
+                    return -1;
+                }
+                dest[out++] = (char)entry->symbol;
+            }
+            state = entry->state;
+            flags = entry->flags;
+        }
+    }
+
+    return (flags & HUFFMAN_FLAG_ACCEPT) ? (int)out : -1;
+}
+
+// Decodes an HPACK integer with an N-bit prefix (5.1). Returns 0 or an HPACK_ERROR_* code.
+static int hpackReadInteger(const unsigned char** cursor, const unsigned char* end,
+                            int prefixBits, uint32_t* result) {
+    if (*cursor >= end) {
+        return HPACK_ERROR_TRUNCATED;
+    }
+
+    uint32_t prefixMask = (1u << prefixBits) - 1;
+    uint32_t value = **cursor & prefixMask;
+    (*cursor)++;
+    if (value < prefixMask) {
+        *result = value;
+        return 0;
+    }
+
+    int shift = 0;
+    while (*cursor < end) {
+        unsigned char b = **cursor;
+        (*cursor)++;
+        // Anything past 2^28 is far beyond every limit we enforce
+        if (shift > 21) {
+            return HPACK_ERROR_INTEGER_OVERFLOW;
+        }
+        value += (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *result = value;
+            return 0;
+        }
+        shift += 7;
+    }
+    return HPACK_ERROR_TRUNCATED;
+}
+
+// Reads a string literal (5.2). Huffman strings are decoded into the scratch area starting at
+// scratchOffset; raw strings are returned in place.
+static int hpackReadString(HpackDecoder* decoder, const unsigned char** cursor,
+                           const unsigned char* end, size_t scratchOffset,
+                           const char** str, int* strLen) {
+    if (*cursor >= end) {
+        return HPACK_ERROR_TRUNCATED;
+    }
+
+    int huffman = (**cursor & 0x80) != 0;
+    uint32_t len;
+    int rc = hpackReadInteger(cursor, end, 7, &len);
+    if (rc != 0) {
+        return rc;
+    }
+    if (len > (size_t)(end - *cursor)) {
+        return HPACK_ERROR_TRUNCATED;
+    }
+    if (len > MAX_HPACK_STRING_LEN) {
+        return HPACK_ERROR_STRING_TOO_LONG;
+    }
+
+    if (!huffman) {
+        *str = (const char*)*cursor;
+        *strLen = (int)len;
+        *cursor += len;
+        return 0;
+    }
+
+    // Shortest code is 5 bits, so output is at most len * 8 / 5 bytes
+    size_t maxDecoded = ((size_t)len * 8) / 5 + 1;
+    if (scratchOffset + maxDecoded > decoder->scratchSize) {
+        size_t newSize = decoder->scratchSize * 2;
+        while (newSize < scratchOffset + maxDecoded) {
+            newSize *= 2;
+        }
+        char* grown = (char*)realloc(decoder->scratch, newSize);
+        if (!grown) {
+            return HPACK_ERROR_NO_MEMORY;
+        }
+        decoder->scratch = grown;
+        decoder->scratchSize = newSize;
+    }
+
+    int decoded = hpackHuffmanDecode(*cursor, len, decoder->scratch + scratchOffset, maxDecoded);
+    if (decoded < 0) {
+        return HPACK_ERROR_HUFFMAN;
+    }
+    *str = decoder->scratch + scratchOffset;
+    *strLen = decoded;
+    *cursor += len;
+    return 0;
+}
+
+// Resolves an HPACK index (1-based, static table first) to a name/value pair
+static int hpackLookup(HpackDecoder* decoder, uint32_t index,
+                       const char** name, int* nameLen, const char** value, int* valueLen) {
+    if (index == 0) {
+        return HPACK_ERROR_INVALID_INDEX;
+    }
+    if (index <= HPACK_STATIC_TABLE_SIZE) {
+        const HpackStaticEntry* entry = &hpackStaticTable[index - 1];
+        *name = entry->name;
+        *nameLen = entry->nameLen;
+        *value = entry->value;
+        *valueLen = entry->valueLen;
+        return 0;
+    }
+
+    HpackTableEntry* entry = hpackTableGet(&decoder->table, (int)(index - HPACK_STATIC_TABLE_SIZE - 1));
+    if (entry == NULL) {
+        return HPACK_ERROR_INVALID_INDEX;
+    }
+    *name = entry->data;
+    *nameLen = entry->nameLen;
+    *value = entry->data + entry->nameLen;
+    *valueLen = entry->valueLen;
+    return 0;
+}
+
+/**
+ * Decodes a complete header block into `headers`. Returns 0 or an HPACK_ERROR_* code; on error
+ * the dynamic table is out of sync with the peer and the connection must be closed.
+ */
+static int hpackDecodeBlock(HpackDecoder* decoder, const unsigned char* cursor,
+                            const unsigned char* end, ParsedHeaders* headers) {
+    while (cursor < end) {
+        unsigned char b = *cursor;
+        const char* name;
+        const char* value;
+        int nameLen;
+        int valueLen;
+        uint32_t index;
+        int rc;
+
+        if (b & 0x80) {
+            // Indexed header field (6.1)
+            if ((rc = hpackReadInteger(&cursor, end, 7, &index)) != 0 ||
+                (rc = hpackLookup(decoder, index, &name, &nameLen, &value, &valueLen)) != 0) {
+                return rc;
+            }
+            if (addParsedHeader(headers, name, nameLen, value, valueLen) != 0) {
+                return HPACK_ERROR_NO_MEMORY;
+            }
+            continue;
+        }
+
+        if ((b & 0xE0) == 0x20) {
+            // Dynamic table size update (6.3) - only allowed before the first field
+            if ((rc = hpackReadInteger(&cursor, end, 5, &index)) != 0) {
+                return rc;
+            }
+            if (headers->count > 0 || index > decoder->table.settingsMaxSize) {
+                return HPACK_ERROR_TABLE_SIZE;
+            }
+            hpackTableSetMaxSize(&decoder->table, index);
+            continue;
+        }
+
+        // Literal header field: with incremental indexing (6.2.1), without indexing (6.2.2)
+        // or never indexed (6.2.3)
+        int incremental = (b & 0xC0) == 0x40;
+        if ((rc = hpackReadInteger(&cursor, end, incremental ? 6 : 4, &index)) != 0) {
+            return rc;
+        }
+
+        int nameInScratch = 0;
+        if (index > 0) {
+            const char* unusedValue;
+            int unusedLen;
+            if ((rc = hpackLookup(decoder, index, &name, &nameLen, &unusedValue, &unusedLen)) != 0) {
+                return rc;
+            }
+        } else {
+            if ((rc = hpackReadString(decoder, &cursor, end, 0, &name, &nameLen)) != 0) {
+                return rc;
+            }
+            nameInScratch = name == decoder->scratch;
+        }
+
+        // A Huffman name occupies the front of the scratch area; decode the value after it
+        size_t valueOffset = nameInScratch ? (size_t)nameLen : 0;
+        if ((rc = hpackReadString(decoder, &cursor, end, valueOffset, &value, &valueLen)) != 0) {
+            return rc;
+        }
+        if (nameInScratch) {
+            // The scratch area may have moved while decoding the value
+            name = decoder->scratch;
+        }
+
+        if (addParsedHeader(headers, name, nameLen, value, valueLen) != 0) {
+            return HPACK_ERROR_NO_MEMORY;
+        }
+        if (incremental && hpackTableAdd(&decoder->table, name, nameLen, value, valueLen) != 0) {
+            return HPACK_ERROR_NO_MEMORY;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Creates a per-connection HPACK decoder
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackDecoderCreate
+  (JNIEnv *env, jclass cls, jint maxTableSize) {
+    if (maxTableSize < 0) {
+        return 0;
+    }
+
+    HpackDecoder* decoder = (HpackDecoder*)calloc(1, sizeof(HpackDecoder));
+    if (!decoder) {
+        return 0;
+    }
+
+    decoder->scratchSize = 1024;
+    decoder->scratch = (char*)malloc(decoder->scratchSize);
+    if (!decoder->scratch || hpackTableInit(&decoder->table, (size_t)maxTableSize) != 0) {
+        free(decoder->scratch);
+        free(decoder);
+        return 0;
+    }
+
+    return (jlong)(intptr_t)decoder;
+}
+
+/**
+ * Decodes one complete header block (HEADERS plus any CONTINUATION payloads, concatenated) and
+ * publishes it as a parsed header set.
+ *
+ * Returns the headers ID (free with nativeFreeHeaders), or a negated HPACK_ERROR_* code.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackDecode
+  (JNIEnv *env, jclass cls, jlong decoderHandle, jobject block, jint offset, jint length) {
+    HpackDecoder* decoder = (HpackDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL || block == NULL || offset < 0 || length < 0) {
+        return -HPACK_ERROR_TRUNCATED;
+    }
+
+    unsigned char* buffer = (unsigned char*)(*env)->GetDirectBufferAddress(env, block);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, block);
+    if (buffer == NULL || (jlong)offset + length > capacity) {
+        return -HPACK_ERROR_TRUNCATED;
+    }
+
+    ParsedHeaders* headers = newParsedHeaders();
+    if (!headers) {
+        return -HPACK_ERROR_NO_MEMORY;
+    }
+
+    int rc = hpackDecodeBlock(decoder, buffer + offset, buffer + offset + length, headers);
+    if (rc != 0) {
+        freeParsedHeaders(headers);
+        return -rc;
+    }
+
+    buildHeaderIndex(headers);
+    jlong id = registerParsedHeaders(headers);
+    if (id == 0) {
+        freeParsedHeaders(headers);
+        return -HPACK_ERROR_NO_SLOT;
+    }
+    return id;
+}
+
+/**
+ * Applies a new SETTINGS_HEADER_TABLE_SIZE bound. The peer must follow up with a dynamic table
+ * size update; entries beyond the new bound are evicted right away.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackDecoderSetMaxTableSize
+  (JNIEnv *env, jclass cls, jlong decoderHandle, jint maxTableSize) {
+    HpackDecoder* decoder = (HpackDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL || maxTableSize < 0) {
+        return;
+    }
+
+    decoder->table.settingsMaxSize = (size_t)maxTableSize;
+    if (decoder->table.maxSize > decoder->table.settingsMaxSize) {
+        hpackTableSetMaxSize(&decoder->table, decoder->table.settingsMaxSize);
+    }
+}
+
+/**
+ * Releases a decoder and its dynamic table
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackDecoderFree
+  (JNIEnv *env, jclass cls, jlong decoderHandle) {
+    HpackDecoder* decoder = (HpackDecoder*)(intptr_t)decoderHandle;
+    if (decoder == NULL) {
+        return;
+    }
+
+    hpackTableFree(&decoder->table);
+    free(decoder->scratch);
+    free(decoder);
+}
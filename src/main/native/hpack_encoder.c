@@ -0,0 +1,540 @@
+#include "blyfastnative.h"
+
+/**
+ * HPACK (RFC 7541) encoder for HTTP/2 response header blocks.
+ *
+ * Each connection owns one encoder mirroring the peer decoder's dynamic table. Fields are sent as
+ * indexed references whenever the static or dynamic table already holds them, and as literals
+ * with incremental indexing otherwise, Huffman-coded when that is shorter. Credentials and
+ * cookies are sent never-indexed (7.1.3).
+ *
+ * Header sets that repeat on most responses (content type plus the security headers) can be
+ * registered once. Their literals are encoded at registration time, and each encoder remembers
+ * where it inserted them, so after the first response they cost one byte per field.
+ */
+
+// A field of a registered header set, with its literal representation encoded up front
+typedef struct {
+    char* name;             // Lowercased
+    int nameLen;
+    char* value;
+    int valueLen;
+    int staticIndex;        // Full static table match, 0 if none
+    unsigned char* literal; // Literal with incremental indexing
+    int literalLen;
+} HpackCachedField;
+
+typedef struct {
+    HpackCachedField* fields;
+    int count;
+    int literalLen;         // Sum of the fields' literal lengths (worst case output)
+} HpackCachedSet;
+
+static HpackCachedSet cachedSets[HPACK_MAX_CACHED_SETS];
+static int cachedSetCount = 0;
+static pthread_mutex_t cachedSetsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Per-connection encoder state
+typedef struct {
+    HpackDynamicTable table;
+    // Table insertCount right after each cached field was inserted, 0 if never inserted
+    uint64_t* cachedInsertions[HPACK_MAX_CACHED_SETS];
+    int sizeUpdatePending;
+    size_t minPendingSize;  // Smallest size since the last block, signalled first (4.2)
+} HpackEncoder;
+
+// Writes an HPACK integer with an N-bit prefix (5.1); at most 6 bytes for 32-bit values
+static unsigned char* hpackWriteInteger(unsigned char* out, unsigned char flags,
+                                        int prefixBits, uint32_t value) {
+    uint32_t prefixMax = (1u << prefixBits) - 1;
+    if (value < prefixMax) {
+        *out++ = flags | (unsigned char)value;
+        return out;
+    }
+
+    *out++ = flags | (unsigned char)prefixMax;
+    value -= prefixMax;
+    while (value >= 0x80) {
+        *out++ = (unsigned char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static size_t hpackHuffmanEncodedLength(const unsigned char* src, size_t len) {
+    size_t bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        bits += hpackHuffmanCodeLengths[src[i]];
+    }
+    return (bits + 7) / 8;
+}
+
+static unsigned char* hpackHuffmanEncode(unsigned char* out, const unsigned char* src, size_t len) {
+    uint64_t bits = 0;
+    int pending = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        int codeLen = hpackHuffmanCodeLengths[src[i]];
+        bits = (bits << codeLen) | hpackHuffmanCodes[src[i]];
+        pending += codeLen;
+        while (pending >= 8) {
+            pending -= 8;
+            *out++ = (unsigned char)(bits >> pending);
+        }
+    }
+
+    if (pending > 0) {
+        // Pad with the most significant bits of EOS (all ones)
+        *out++ = (unsigned char)((bits << (8 - pending)) | (0xFF >> pending));
+    }
+    return out;
+}
+
+// Writes a string literal (5.2), Huffman-coded only if that is strictly shorter
+static unsigned char* hpackWriteString(unsigned char* out, const char* str, int len) {
+    size_t huffmanLen = hpackHuffmanEncodedLength((const unsigned char*)str, len);
+    if (huffmanLen < (size_t)len) {
+        out = hpackWriteInteger(out, 0x80, 7, (uint32_t)huffmanLen);
+        return hpackHuffmanEncode(out, (const unsigned char*)str, len);
+    }
+
+    out = hpackWriteInteger(out, 0x00, 7, (uint32_t)len);
+    memcpy(out, str, len);
+    return out + len;
+}
+
+// Worst case size of one literal field: representation byte, name and value with 6-byte lengths
+static size_t hpackMaxFieldSize(int nameLen, int valueLen) {
+    return 6 + 6 + (size_t)nameLen + 6 + (size_t)valueLen;
+}
+
+static int hpackIsSensitive(const char* name, int nameLen) {
+    return (nameLen == 13 && memcmp(name, "authorization", 13) == 0) ||
+           (nameLen == 19 && memcmp(name, "proxy-authorization", 19) == 0) ||
+           (nameLen == 6 && memcmp(name, "cookie", 6) == 0) ||
+           (nameLen == 10 && memcmp(name, "set-cookie", 10) == 0);
+}
+
+// Returns the static index of a full match, or 0; *nameIndex receives the first name match
+static int hpackStaticLookup(const char* name, int nameLen, const char* value, int valueLen,
+                             int* nameIndex) {
+    *nameIndex = 0;
+    for (int i = 0; i < HPACK_STATIC_TABLE_SIZE; i++) {
+        const HpackStaticEntry* entry = &hpackStaticTable[i];
+        if (entry->nameLen != nameLen || memcmp(entry->name, name, nameLen) != 0) {
+            continue;
+        }
+        if (*nameIndex == 0) {
+            *nameIndex = i + 1;
+        }
+        if (entry->valueLen == valueLen && memcmp(entry->value, value, valueLen) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Same as hpackStaticLookup for the dynamic table, returning HPACK indices (62 and up)
+static int hpackDynamicLookup(HpackDynamicTable* table, const char* name, int nameLen,
+                              const char* value, int valueLen, int* nameIndex) {
+    for (int i = 0; i < table->count; i++) {
+        HpackTableEntry* entry = hpackTableGet(table, i);
+        if (entry->nameLen != nameLen || memcmp(entry->data, name, nameLen) != 0) {
+            continue;
+        }
+        if (*nameIndex == 0) {
+            *nameIndex = HPACK_STATIC_TABLE_SIZE + 1 + i;
+        }
+        if (entry->valueLen == valueLen && memcmp(entry->data + nameLen, value, valueLen) == 0) {
+            return HPACK_STATIC_TABLE_SIZE + 1 + i;
+        }
+    }
+    return 0;
+}
+
+// Encodes one field with a lowercased name. Returns NULL if the dynamic table could not grow.
+static unsigned char* hpackEncodeField(HpackEncoder* encoder, unsigned char* out,
+                                       const char* name, int nameLen,
+                                       const char* value, int valueLen) {
+    int nameIndex;
+    int index = hpackStaticLookup(name, nameLen, value, valueLen, &nameIndex);
+    if (index == 0) {
+        index = hpackDynamicLookup(&encoder->table, name, nameLen, value, valueLen, &nameIndex);
+    }
+    if (index > 0) {
+        return hpackWriteInteger(out, 0x80, 7, (uint32_t)index);
+    }
+
+    size_t entrySize = (size_t)nameLen + valueLen + HPACK_ENTRY_OVERHEAD;
+    int incremental = 0;
+    if (hpackIsSensitive(name, nameLen)) {
+        out = hpackWriteInteger(out, 0x10, 4, (uint32_t)nameIndex);
+    } else if (entrySize > encoder->table.maxSize) {
+        // Would only flush the table
+        out = hpackWriteInteger(out, 0x00, 4, (uint32_t)nameIndex);
+    } else {
+        out = hpackWriteInteger(out, 0x40, 6, (uint32_t)nameIndex);
+        incremental = 1;
+    }
+
+    if (nameIndex == 0) {
+        out = hpackWriteString(out, name, nameLen);
+    }
+    out = hpackWriteString(out, value, valueLen);
+
+    if (incremental && hpackTableAdd(&encoder->table, name, nameLen, value, valueLen) != 0) {
+        return NULL;
+    }
+    return out;
+}
+
+// Encodes a registered header set, reusing the dynamic table entries it inserted earlier
+static unsigned char* hpackEncodeCachedSet(HpackEncoder* encoder, unsigned char* out, int setId) {
+    HpackCachedSet* set = &cachedSets[setId - 1];
+    uint64_t* insertions = encoder->cachedInsertions[setId - 1];
+    if (insertions == NULL) {
+        insertions = (uint64_t*)calloc(set->count, sizeof(uint64_t));
+        if (!insertions) {
+            return NULL;
+        }
+        encoder->cachedInsertions[setId - 1] = insertions;
+    }
+
+    HpackDynamicTable* table = &encoder->table;
+    for (int i = 0; i < set->count; i++) {
+        HpackCachedField* field = &set->fields[i];
+        if (field->staticIndex > 0) {
+            out = hpackWriteInteger(out, 0x80, 7, (uint32_t)field->staticIndex);
+            continue;
+        }
+
+        // Still in the table as long as fewer than `count` entries were inserted after it
+        uint64_t age = table->insertCount - insertions[i];
+        if (insertions[i] != 0 && age < (uint64_t)table->count) {
+            out = hpackWriteInteger(out, 0x80, 7, (uint32_t)(HPACK_STATIC_TABLE_SIZE + 1 + age));
+            continue;
+        }
+
+        memcpy(out, field->literal, field->literalLen);
+        out += field->literalLen;
+
+        uint64_t before = table->insertCount;
+        if (hpackTableAdd(table, field->name, field->nameLen, field->value, field->valueLen) != 0) {
+            return NULL;
+        }
+        insertions[i] = table->insertCount != before ? table->insertCount : 0;
+    }
+    return out;
+}
+
+// Encodes either the pseudo-header or the regular fields among alternating names and values
+static unsigned char* hpackEncodeExtras(HpackEncoder* encoder, unsigned char* out,
+                                        const char** chars, int count, int pseudo) {
+    char nameBuffer[MAX_HEADER_NAME_LEN];
+    for (int i = 0; i < count && out != NULL; i++) {
+        const char* name = chars[i * 2];
+        if ((name[0] == ':') != pseudo) {
+            continue;
+        }
+        size_t nameLen = strlen(name);
+        if (nameLen > MAX_HEADER_NAME_LEN) {
+            nameLen = MAX_HEADER_NAME_LEN;
+        }
+        // HTTP/2 requires lowercase field names (RFC 7540 8.1.2)
+        for (size_t j = 0; j < nameLen; j++) {
+            nameBuffer[j] = (char)tolower((unsigned char)name[j]);
+        }
+        const char* value = chars[i * 2 + 1];
+        out = hpackEncodeField(encoder, out, nameBuffer, (int)nameLen, value, (int)strlen(value));
+    }
+    return out;
+}
+
+static void freeCachedField(HpackCachedField* field) {
+    free(field->name);
+    free(field->value);
+    free(field->literal);
+}
+
+// Fills a cached field from a name/value pair; returns 0 or -1 on OOM
+static int initCachedField(HpackCachedField* field, const char* name, int nameLen,
+                           const char* value, int valueLen) {
+    memset(field, 0, sizeof(HpackCachedField));
+    field->name = (char*)malloc(nameLen + 1);
+    field->value = (char*)malloc(valueLen + 1);
+    field->literal = (unsigned char*)malloc(hpackMaxFieldSize(nameLen, valueLen));
+    if (!field->name || !field->value || !field->literal) {
+        freeCachedField(field);
+        return -1;
+    }
+
+    for (int i = 0; i < nameLen; i++) {
+        field->name[i] = (char)tolower((unsigned char)name[i]);
+    }
+    field->name[nameLen] = '\0';
+    field->nameLen = nameLen;
+    memcpy(field->value, value, valueLen);
+    field->value[valueLen] = '\0';
+    field->valueLen = valueLen;
+
+    int nameIndex;
+    field->staticIndex = hpackStaticLookup(field->name, nameLen, value, valueLen, &nameIndex);
+
+    unsigned char* out = hpackWriteInteger(field->literal, 0x40, 6, (uint32_t)nameIndex);
+    if (nameIndex == 0) {
+        out = hpackWriteString(out, field->name, nameLen);
+    }
+    out = hpackWriteString(out, value, valueLen);
+    field->literalLen = (int)(out - field->literal);
+    return 0;
+}
+
+/**
+ * Creates a per-connection HPACK encoder
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackEncoderCreate
+  (JNIEnv *env, jclass cls, jint maxTableSize) {
+    if (maxTableSize < 0) {
+        return 0;
+    }
+
+    HpackEncoder* encoder = (HpackEncoder*)calloc(1, sizeof(HpackEncoder));
+    if (!encoder) {
+        return 0;
+    }
+    if (hpackTableInit(&encoder->table, (size_t)maxTableSize) != 0) {
+        free(encoder);
+        return 0;
+    }
+
+    // The peer's decoder starts at the protocol default; announce anything else up front
+    if (maxTableSize != HPACK_DEFAULT_TABLE_SIZE) {
+        encoder->sizeUpdatePending = 1;
+        encoder->minPendingSize = (size_t)maxTableSize;
+    }
+
+    return (jlong)(intptr_t)encoder;
+}
+
+/**
+ * Registers a header set (alternating names and values) for cached encoding.
+ *
+ * Returns a set ID shared by all encoders, or 0 if the registry is full or the set is invalid.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackRegisterHeaderSet
+  (JNIEnv *env, jclass cls, jobjectArray namesAndValues) {
+    if (namesAndValues == NULL) {
+        return 0;
+    }
+
+    jsize length = (*env)->GetArrayLength(env, namesAndValues);
+    int count = length / 2;
+    if (length % 2 != 0 || count == 0 || count > HPACK_MAX_CACHED_SET_SIZE) {
+        return 0;
+    }
+
+    HpackCachedField* fields = (HpackCachedField*)calloc(count, sizeof(HpackCachedField));
+    if (!fields) {
+        return 0;
+    }
+
+    int literalLen = 0;
+    int built = 0;
+    int sawRegular = 0;
+    for (; built < count; built++) {
+        jstring name = (jstring)(*env)->GetObjectArrayElement(env, namesAndValues, built * 2);
+        jstring value = (jstring)(*env)->GetObjectArrayElement(env, namesAndValues, built * 2 + 1);
+        if (name == NULL || value == NULL) {
+            break;
+        }
+
+        const char* nameStr = (*env)->GetStringUTFChars(env, name, NULL);
+        const char* valueStr = (*env)->GetStringUTFChars(env, value, NULL);
+        int rc = -1;
+        // A pseudo-header after a regular field could never be emitted in a valid block
+        if (nameStr && valueStr && !(nameStr[0] == ':' && sawRegular)) {
+            sawRegular |= nameStr[0] != ':';
+            rc = initCachedField(&fields[built], nameStr, (int)strlen(nameStr),
+                                 valueStr, (int)strlen(valueStr));
+        }
+        if (nameStr) {
+            (*env)->ReleaseStringUTFChars(env, name, nameStr);
+        }
+        if (valueStr) {
+            (*env)->ReleaseStringUTFChars(env, value, valueStr);
+        }
+        (*env)->DeleteLocalRef(env, name);
+        (*env)->DeleteLocalRef(env, value);
+        if (rc != 0) {
+            break;
+        }
+        literalLen += fields[built].literalLen;
+    }
+
+    jint id = 0;
+    if (built == count) {
+        pthread_mutex_lock(&cachedSetsMutex);
+        if (cachedSetCount < HPACK_MAX_CACHED_SETS) {
+            HpackCachedSet* set = &cachedSets[cachedSetCount];
+            set->fields = fields;
+            set->count = count;
+            set->literalLen = literalLen;
+            // Publish only after the set is fully written
+            __atomic_store_n(&cachedSetCount, cachedSetCount + 1, __ATOMIC_RELEASE);
+            id = cachedSetCount;
+        }
+        pthread_mutex_unlock(&cachedSetsMutex);
+    }
+
+    if (id == 0) {
+        for (int i = 0; i < built; i++) {
+            freeCachedField(&fields[i]);
+        }
+        free(fields);
+    }
+    return id;
+}
+
+/**
+ * Encodes one header block: the pseudo-header fields of `headers` (alternating names and values,
+ * may be null), then the registered set `setId` (0 for none), then the rest of `headers`, written
+ * to `out` at `offset`.
+ *
+ * Returns the number of bytes written, the negated worst-case size if `out` is too small, or 0
+ * on invalid arguments or allocation failure (the encoder must then be discarded).
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackEncode
+  (JNIEnv *env, jclass cls, jlong encoderHandle, jint setId, jobjectArray headers,
+   jobject out, jint offset) {
+    HpackEncoder* encoder = (HpackEncoder*)(intptr_t)encoderHandle;
+    if (encoder == NULL || out == NULL || offset < 0 || setId < 0 ||
+        setId > __atomic_load_n(&cachedSetCount, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    unsigned char* buffer = (unsigned char*)(*env)->GetDirectBufferAddress(env, out);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, out);
+    if (buffer == NULL || offset > capacity) {
+        return 0;
+    }
+
+    jsize length = headers != NULL ? (*env)->GetArrayLength(env, headers) : 0;
+    int count = length / 2;
+    if (length % 2 != 0) {
+        return 0;
+    }
+
+    jstring* strings = NULL;
+    const char** chars = NULL;
+    if (count > 0) {
+        strings = (jstring*)calloc(length, sizeof(jstring));
+        chars = (const char**)calloc(length, sizeof(char*));
+        if (!strings || !chars) {
+            free(strings);
+            free(chars);
+            return 0;
+        }
+    }
+
+    // Two size updates, then every field at its worst case
+    size_t required = 12 + (size_t)count * 6;
+    if (setId > 0) {
+        required += cachedSets[setId - 1].literalLen;
+    }
+
+    jint result = 0;
+    int pinned = 0;
+    for (; pinned < length; pinned++) {
+        strings[pinned] = (jstring)(*env)->GetObjectArrayElement(env, headers, pinned);
+        if (strings[pinned] == NULL) {
+            break;
+        }
+        chars[pinned] = (*env)->GetStringUTFChars(env, strings[pinned], NULL);
+        if (chars[pinned] == NULL) {
+            break;
+        }
+        required += 6 + strlen(chars[pinned]);
+    }
+
+    if (pinned < length) {
+        goto cleanup;
+    }
+    if (required > (size_t)(capacity - offset)) {
+        result = required > INT_MAX ? -INT_MAX : -(jint)required;
+        goto cleanup;
+    }
+
+    unsigned char* start = buffer + offset;
+    unsigned char* cursor = start;
+
+    if (encoder->sizeUpdatePending) {
+        if (encoder->minPendingSize < encoder->table.maxSize) {
+            cursor = hpackWriteInteger(cursor, 0x20, 5, (uint32_t)encoder->minPendingSize);
+        }
+        cursor = hpackWriteInteger(cursor, 0x20, 5, (uint32_t)encoder->table.maxSize);
+        encoder->sizeUpdatePending = 0;
+    }
+
+    // Pseudo-header fields must precede all regular fields (RFC 7540 8.1.2.1), so extras like
+    // :status go out ahead of the registered set
+    cursor = hpackEncodeExtras(encoder, cursor, chars, count, 1);
+    if (setId > 0 && cursor != NULL) {
+        cursor = hpackEncodeCachedSet(encoder, cursor, setId);
+    }
+    if (cursor != NULL) {
+        cursor = hpackEncodeExtras(encoder, cursor, chars, count, 0);
+    }
+
+    if (cursor != NULL) {
+        result = (jint)(cursor - start);
+    }
+
+cleanup:
+    for (int i = 0; i < pinned; i++) {
+        (*env)->ReleaseStringUTFChars(env, strings[i], chars[i]);
+        (*env)->DeleteLocalRef(env, strings[i]);
+    }
+    if (pinned < length && strings != NULL && strings[pinned] != NULL) {
+        (*env)->DeleteLocalRef(env, strings[pinned]);
+    }
+    free(strings);
+    free((void*)chars);
+    return result;
+}
+
+/**
+ * Adopts a new SETTINGS_HEADER_TABLE_SIZE from the peer; the change is signalled at the start
+ * of the next header block
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackEncoderSetMaxTableSize
+  (JNIEnv *env, jclass cls, jlong encoderHandle, jint maxTableSize) {
+    HpackEncoder* encoder = (HpackEncoder*)(intptr_t)encoderHandle;
+    if (encoder == NULL || maxTableSize < 0) {
+        return;
+    }
+
+    if (!encoder->sizeUpdatePending || (size_t)maxTableSize < encoder->minPendingSize) {
+        encoder->minPendingSize = (size_t)maxTableSize;
+    }
+    encoder->sizeUpdatePending = 1;
+    encoder->table.settingsMaxSize = (size_t)maxTableSize;
+    hpackTableSetMaxSize(&encoder->table, (size_t)maxTableSize);
+}
+
+/**
+ * Releases an encoder and its dynamic table
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeHpackEncoderFree
+  (JNIEnv *env, jclass cls, jlong encoderHandle) {
+    HpackEncoder* encoder = (HpackEncoder*)(intptr_t)encoderHandle;
+    if (encoder == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < HPACK_MAX_CACHED_SETS; i++) {
+        free(encoder->cachedInsertions[i]);
+    }
+    hpackTableFree(&encoder->table);
+    free(encoder);
+}
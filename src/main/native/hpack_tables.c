@@ -0,0 +1,227 @@
+#include "blyfastnative.h"
+
+// HPACK constant tables from RFC 7541 Appendix A (static table) and Appendix B (Huffman code)
+
+// Static table, 1-based on the wire; entry 0 here is HPACK index 1
+const HpackStaticEntry hpackStaticTable[HPACK_STATIC_TABLE_SIZE] = {
+    { ":authority", 10, "", 0 },
+    { ":method", 7, "GET", 3 },
+    { ":method", 7, "POST", 4 },
+    { ":path", 5, "/", 1 },
+    { ":path", 5, "/index.html", 11 },
+    { ":scheme", 7, "http", 4 },
+    { ":scheme", 7, "https", 5 },
+    { ":status", 7, "200", 3 },
+    { ":status", 7, "204", 3 },
+    { ":status", 7, "206", 3 },
+    { ":status", 7, "304", 3 },
+    { ":status", 7, "400", 3 },
+    { ":status", 7, "404", 3 },
+    { ":status", 7, "500", 3 },
+    { "accept-charset", 14, "", 0 },
+    { "accept-encoding", 15, "gzip, deflate", 13 },
+    { "accept-language", 15, "", 0 },
+    { "accept-ranges", 13, "", 0 },
+    { "accept", 6, "", 0 },
+    { "access-control-allow-origin", 27, "", 0 },
+    { "age", 3, "", 0 },
+    { "allow", 5, "", 0 },
+    { "authorization", 13, "", 0 },
+    { "cache-control", 13, "", 0 },
+    { "content-disposition", 19, "", 0 },
+    { "content-encoding", 16, "", 0 },
+    { "content-language", 16, "", 0 },
+    { "content-length", 14, "", 0 },
+    { "content-location", 16, "", 0 },
+    { "content-range", 13, "", 0 },
+    { "content-type", 12, "", 0 },
+    { "cookie", 6, "", 0 },
+    { "date", 4, "", 0 },
+    { "etag", 4, "", 0 },
+    { "expect", 6, "", 0 },
+    { "expires", 7, "", 0 },
+    { "from", 4, "", 0 },
+    { "host", 4, "", 0 },
+    { "if-match", 8, "", 0 },
+    { "if-modified-since", 17, "", 0 },
+    { "if-none-match", 13, "", 0 },
+    { "if-range", 8, "", 0 },
+    { "if-unmodified-since", 19, "", 0 },
+    { "last-modified", 13, "", 0 },
+    { "link", 4, "", 0 },
+    { "location", 8, "", 0 },
+    { "max-forwards", 12, "", 0 },
+    { "proxy-authenticate", 18, "", 0 },
+    { "proxy-authorization", 19, "", 0 },
+    { "range", 5, "", 0 },
+    { "referer", 7, "", 0 },
+    { "refresh", 7, "", 0 },
+    { "retry-after", 11, "", 0 },
+    { "server", 6, "", 0 },
+    { "set-cookie", 10, "", 0 },
+    { "strict-transport-security", 25, "", 0 },
+    { "transfer-encoding", 17, "", 0 },
+    { "user-agent", 10, "", 0 },
+    { "vary", 4, "", 0 },
+    { "via", 3, "", 0 },
+    { "www-authenticate", 16, "", 0 },
+};
+
+// Huffman code for each symbol, right-aligned; symbol 256 is EOS
+const uint32_t hpackHuffmanCodes[HPACK_HUFFMAN_SYMBOLS] = {
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+    0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+    0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+    0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+    0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+    0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+    0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+    0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+    0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+    0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+    0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+    0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+    0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+    0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+    0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+    0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+    0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+    0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+    0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+    0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+    0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+    0x3fffffff,
+};
+
+// Bit length of each Huffman code
+const uint8_t hpackHuffmanCodeLengths[HPACK_HUFFMAN_SYMBOLS] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+// Dynamic table management (RFC 7541 section 4), shared by the decoder and encoder
+
+int hpackTableInit(HpackDynamicTable* table, size_t maxSize) {
+    memset(table, 0, sizeof(HpackDynamicTable));
+    table->capacity = 16;
+    table->entries = (HpackTableEntry*)calloc(table->capacity, sizeof(HpackTableEntry));
+    if (!table->entries) {
+        return -1;
+    }
+    table->head = table->capacity - 1;
+    table->maxSize = maxSize;
+    table->settingsMaxSize = maxSize;
+    return 0;
+}
+
+void hpackTableFree(HpackDynamicTable* table) {
+    if (table->entries) {
+        for (int i = 0; i < table->count; i++) {
+            free(hpackTableGet(table, i)->data);
+        }
+        free(table->entries);
+    }
+    memset(table, 0, sizeof(HpackDynamicTable));
+}
+
+// Index 0 is the newest entry (HPACK index 62)
+HpackTableEntry* hpackTableGet(HpackDynamicTable* table, int index) {
+    if (index < 0 || index >= table->count) {
+        return NULL;
+    }
+    int slot = table->head - index;
+    if (slot < 0) {
+        slot += table->capacity;
+    }
+    return &table->entries[slot];
+}
+
+static void hpackTableEvictOldest(HpackDynamicTable* table) {
+    HpackTableEntry* oldest = hpackTableGet(table, table->count - 1);
+    table->size -= (size_t)oldest->nameLen + oldest->valueLen + HPACK_ENTRY_OVERHEAD;
+    free(oldest->data);
+    oldest->data = NULL;
+    table->count--;
+}
+
+void hpackTableSetMaxSize(HpackDynamicTable* table, size_t maxSize) {
+    table->maxSize = maxSize;
+    while (table->count > 0 && table->size > table->maxSize) {
+        hpackTableEvictOldest(table);
+    }
+}
+
+// Returns 0 on success (including an oversized entry that just empties the table), -1 on OOM
+int hpackTableAdd(HpackDynamicTable* table, const char* name, int nameLen,
+                  const char* value, int valueLen) {
+    size_t entrySize = (size_t)nameLen + valueLen + HPACK_ENTRY_OVERHEAD;
+
+    // Copy first: the name may point into an entry that is about to be evicted
+    char* data = (char*)malloc((size_t)nameLen + valueLen + 1);
+    if (!data) {
+        return -1;
+    }
+    memcpy(data, name, nameLen);
+    memcpy(data + nameLen, value, valueLen);
+
+    // Evict until the new entry fits; an entry larger than the table empties it (4.4)
+    while (table->count > 0 && table->size + entrySize > table->maxSize) {
+        hpackTableEvictOldest(table);
+    }
+    if (entrySize > table->maxSize) {
+        free(data);
+        return 0;
+    }
+
+    if (table->count == table->capacity) {
+        // Grow the ring and lay entries out again oldest-first
+        int newCapacity = table->capacity * 2;
+        HpackTableEntry* grown = (HpackTableEntry*)calloc(newCapacity, sizeof(HpackTableEntry));
+        if (!grown) {
+            free(data);
+            return -1;
+        }
+        for (int i = 0; i < table->count; i++) {
+            grown[table->count - 1 - i] = *hpackTableGet(table, i);
+        }
+        free(table->entries);
+        table->entries = grown;
+        table->capacity = newCapacity;
+        table->head = table->count - 1;
+    }
+
+    table->head = (table->head + 1) % table->capacity;
+    table->entries[table->head].data = data;
+    table->entries[table->head].nameLen = nameLen;
+    table->entries[table->head].valueLen = valueLen;
+    table->count++;
+    table->size += entrySize;
+    table->insertCount++;
+    return 0;
+}
@@ -1,31 +1,314 @@
 #include "blyfastnative.h"
 
 /**
- * Fast native HTTP header parsing - improved with proper cleanup
+ * Allocates an empty, unregistered header set
  */
-JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseHttpHeaders
-  (JNIEnv *env, jclass cls, jobject headerBytes, jint length) {
-    if (headerBytes == NULL || length <= 0) {
+ParsedHeaders* newParsedHeaders(void) {
+    return (ParsedHeaders*)calloc(1, sizeof(ParsedHeaders));
+}
+
+/**
+ * Frees a header set together with its values and lookup index
+ */
+void freeParsedHeaders(ParsedHeaders* headers) {
+    if (headers == NULL) {
+        return;
+    }
+    // Shared sets go away with their last holder
+    if (headers->refCount > 0 && __atomic_sub_fetch(&headers->refCount, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    
+    if (headers->base != NULL) {
+        // Only the headers before the shared ones belong to this set
+        HeaderValue* h = headers->first;
+        while (h != headers->base->first) {
+            HeaderValue* next = h->next;
+            free(h->name);
+            free(h->value);
+            free(h);
+            h = next;
+        }
+        freeParsedHeaders(headers->base);
+    } else {
+        freeHeadersList(headers->first);
+    }
+    free(headers->index);
+    free(headers);
+}
+
+// Whether `header` is one of the set's own headers rather than one shared through `base`
+static int isOwnHeader(ParsedHeaders* headers, HeaderValue* header) {
+    for (HeaderValue* h = headers->first; h != headers->base->first; h = h->next) {
+        if (h == header) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Appends a header to the set, keeping wire order. Returns 0 on success, -1 on allocation failure.
+ */
+int addParsedHeader(ParsedHeaders* headers, const char* name, size_t nameLen,
+                    const char* value, size_t valueLen) {
+    if (nameLen > MAX_HEADER_NAME_LEN) {
+        nameLen = MAX_HEADER_NAME_LEN;
+    }
+    if (valueLen > INT_MAX) {
+        return -1;
+    }
+    
+    HeaderValue* header = (HeaderValue*)malloc(sizeof(HeaderValue));
+    if (!header) {
+        return -1;
+    }
+    
+    header->name = (char*)malloc(nameLen + 1);
+    header->value = (char*)malloc(valueLen + 1);
+    if (!header->name || !header->value) {
+        free(header->name);
+        free(header->value);
+        free(header);
+        return -1;
+    }
+    
+    memcpy(header->name, name, nameLen);
+    header->name[nameLen] = '\0';
+    header->nameLen = (int)nameLen;
+    header->nameHash = headerNameHash(name, nameLen);
+    memcpy(header->value, value, valueLen);
+    header->value[valueLen] = '\0';
+    header->valueLen = (int)valueLen;
+    header->sharedBefore = 0;
+    header->next = NULL;
+    header->nextSame = NULL;
+    
+    if (headers->last) {
+        headers->last->next = header;
+    } else {
+        headers->first = header;
+    }
+    headers->last = header;
+    headers->count++;
+    return 0;
+}
+
+/**
+ * Parses one "Name: value" line (without its line ending) into the set; lines without a colon are
+ * ignored. Returns 0 on success, -1 on allocation failure.
+ */
+int addHeaderLine(ParsedHeaders* headers, const char* line, const char* lineEnd) {
+    const char* colon = memchr(line, ':', lineEnd - line);
+    if (colon == NULL) {
         return 0;
     }
     
-    // Get the buffer from the ByteBuffer
-    char *buffer = (*env)->GetDirectBufferAddress(env, headerBytes);
-    if (buffer == NULL) {
-        return 0; // Error
+    // Extract name (trim trailing whitespace)
+    size_t nameLen = colon - line;
+    while (nameLen > 0 && (line[nameLen - 1] == ' ' || line[nameLen - 1] == '\t')) {
+        nameLen--;
     }
     
-    // Allocate a new headers structure
-    ParsedHeaders* headers = (ParsedHeaders*)malloc(sizeof(ParsedHeaders));
-    if (!headers) {
-        return 0; // Memory allocation failed
+    // Extract value (skip leading whitespace)
+    const char* valueStart = colon + 1;
+    while (valueStart < lineEnd && (*valueStart == ' ' || *valueStart == '\t')) {
+        valueStart++;
+    }
+    
+    return addParsedHeader(headers, line, nameLen, valueStart, lineEnd - valueStart);
+}
+
+// Bytes that stop a header line scan: the line ending, and NUL for strict parsing
+static const unsigned char lineStopBytes[256] = { ['\0'] = 1, ['\n'] = 1, ['\r'] = 1 };
+
+/**
+ * Finds the end of the header line starting at `pos`: the next CR or LF, or `end`. With `framing`
+ * set, NUL bytes and a CR not followed by LF are recorded as errors in the same scan.
+ */
+const char* findHeaderLineEnd(const char* pos, const char* end, HeaderFraming* framing) {
+    for (;;) {
+        while (pos < end && !lineStopBytes[(unsigned char)*pos]) {
+            pos++;
+        }
+        if (pos == end || *pos != '\0') {
+            break;
+        }
+        if (framing != NULL) {
+            framing->error = HEADER_ERROR_NUL;
+            return pos;
+        }
+        pos++;
+    }
+    if (framing != NULL && pos < end && *pos == '\r' && (pos + 1 == end || pos[1] != '\n')) {
+        framing->error = HEADER_ERROR_BARE_CR;
+    }
+    return pos;
+}
+
+/**
+ * Applies the per-line framing rules to a non-empty header line: no obs-fold, a non-empty name
+ * directly followed by the colon, and a single all-digit Content-Length that never appears
+ * together with Transfer-Encoding. Returns the HEADER_ERROR_* code, also kept in `framing`.
+ */
+int checkHeaderFraming(HeaderFraming* framing, const char* line, const char* lineEnd) {
+    if (*line == ' ' || *line == '\t') {
+        return framing->error = HEADER_ERROR_OBS_FOLD;
+    }
+    const char* colon = memchr(line, ':', lineEnd - line);
+    if (colon == NULL || colon == line || colon[-1] == ' ' || colon[-1] == '\t') {
+        return framing->error = HEADER_ERROR_INVALID_FIELD;
+    }
+    
+    // Only two names matter, so the length check rules out almost every line
+    size_t nameLen = colon - line;
+    if (nameLen == 14 && strncasecmp(line, "content-length", 14) == 0) {
+        if (++framing->contentLengths > 1) {
+            return framing->error = HEADER_ERROR_DUPLICATE_CONTENT_LENGTH;
+        }
+        const char* value = colon + 1;
+        const char* valueEnd = lineEnd;
+        while (value < valueEnd && (*value == ' ' || *value == '\t')) value++;
+        while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) valueEnd--;
+        if (value == valueEnd) {
+            return framing->error = HEADER_ERROR_INVALID_CONTENT_LENGTH;
+        }
+        for (const char* p = value; p < valueEnd; p++) {
+            if (*p < '0' || *p > '9') {
+                return framing->error = HEADER_ERROR_INVALID_CONTENT_LENGTH;
+            }
+        }
+    } else if (nameLen == 17 && strncasecmp(line, "transfer-encoding", 17) == 0) {
+        framing->transferEncodings++;
+    }
+    if (framing->contentLengths > 0 && framing->transferEncodings > 0) {
+        return framing->error = HEADER_ERROR_CONTENT_LENGTH_WITH_TRANSFER_ENCODING;
+    }
+    return 0;
+}
+
+/**
+ * Builds the open-addressing name index for large header sets. Each slot points at the first
+ * header with a given (case-insensitive) name; repeated headers are chained through nextSame in
+ * wire order. Small sets are left unindexed since a hash-filtered linear scan is cheaper there.
+ * Allocation failure is not an error - lookups simply fall back to the linear scan.
+ */
+void buildHeaderIndex(ParsedHeaders* headers) {
+    // Sets borrowing shared headers rely on the shared set's index instead
+    if (headers->count < HEADER_INDEX_THRESHOLD || headers->index != NULL || headers->base != NULL) {
+        return;
+    }
+    
+    // Keep the load factor at or below 50% so probe sequences stay short
+    uint32_t capacity = 1;
+    while (capacity < (uint32_t)headers->count * 2) {
+        capacity <<= 1;
     }
     
-    // Initialize the headers structure
-    headers->first = NULL;
-    headers->count = 0;
+    HeaderIndexSlot* index = (HeaderIndexSlot*)calloc(capacity, sizeof(HeaderIndexSlot));
+    if (!index) {
+        return;
+    }
+    
+    uint32_t mask = capacity - 1;
+    for (HeaderValue* h = headers->first; h != NULL; h = h->next) {
+        uint32_t slot = h->nameHash & mask;
+        while (index[slot].first != NULL) {
+            HeaderValue* head = index[slot].first;
+            if (index[slot].hash == h->nameHash && head->nameLen == h->nameLen &&
+                strncasecmp(head->name, h->name, h->nameLen) == 0) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        
+        if (index[slot].first == NULL) {
+            index[slot].hash = h->nameHash;
+            index[slot].first = h;
+            index[slot].last = h;
+        } else {
+            index[slot].last->nextSame = h;
+            index[slot].last = h;
+        }
+    }
+    
+    headers->index = index;
+    headers->indexMask = mask;
+}
+
+/**
+ * Finds the first header with the given name (case-insensitive), or NULL if absent
+ */
+HeaderValue* findHeader(ParsedHeaders* headers, const char* name, size_t nameLen) {
+    uint32_t hash = headerNameHash(name, nameLen);
+    
+    if (headers->base != NULL) {
+        // Own headers are the few volatile ones; names never occur in both parts
+        for (HeaderValue* h = headers->first; h != headers->base->first; h = h->next) {
+            if (h->nameHash == hash && h->nameLen == (int)nameLen &&
+                strncasecmp(h->name, name, nameLen) == 0) {
+                return h;
+            }
+        }
+        return findHeader(headers->base, name, nameLen);
+    }
+    
+    if (headers->index != NULL) {
+        uint32_t slot = hash & headers->indexMask;
+        while (headers->index[slot].first != NULL) {
+            HeaderValue* head = headers->index[slot].first;
+            if (headers->index[slot].hash == hash && head->nameLen == (int)nameLen &&
+                strncasecmp(head->name, name, nameLen) == 0) {
+                return head;
+            }
+            slot = (slot + 1) & headers->indexMask;
+        }
+        return NULL;
+    }
     
-    // Thread-safe ID assignment with free list optimization
+    // Unindexed: the precomputed hash filters out almost every non-matching name
+    for (HeaderValue* h = headers->first; h != NULL; h = h->next) {
+        if (h->nameHash == hash && h->nameLen == (int)nameLen &&
+            strncasecmp(h->name, name, nameLen) == 0) {
+            return h;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Finds the next header after `current` that has the same name, preserving wire order
+ */
+HeaderValue* findNextHeader(ParsedHeaders* headers, HeaderValue* current) {
+    if (headers->base != NULL) {
+        if (!isOwnHeader(headers, current)) {
+            return findNextHeader(headers->base, current);
+        }
+        for (HeaderValue* h = current->next; h != headers->base->first; h = h->next) {
+            if (h->nameHash == current->nameHash && h->nameLen == current->nameLen &&
+                strncasecmp(h->name, current->name, current->nameLen) == 0) {
+                return h;
+            }
+        }
+        return NULL;
+    }
+    if (headers->index != NULL) {
+        return current->nextSame;
+    }
+    for (HeaderValue* h = current->next; h != NULL; h = h->next) {
+        if (h->nameHash == current->nameHash && h->nameLen == current->nameLen &&
+            strncasecmp(h->name, current->name, current->nameLen) == 0) {
+            return h;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Publishes a header set in the global storage - thread-safe.
+ * Returns the assigned ID, or 0 if every slot is in use.
+ */
+jlong registerParsedHeaders(ParsedHeaders* headers) {
     pthread_mutex_lock(&headers_mutex);
     jlong newId = 0;
     
@@ -43,110 +326,164 @@ JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseHt
             }
             if (newId >= MAX_HEADERS) {
                 pthread_mutex_unlock(&headers_mutex);
-                free(headers);
                 return 0; // No available slots
             }
         }
     }
     
     headers->id = newId;
-    headers_storage[newId] = headers; // Store immediately while holding lock
+    headers_storage[newId] = headers;
     pthread_mutex_unlock(&headers_mutex);
+    return newId;
+}
+
+// Parses a header block into an indexed, unregistered set. With `framing` set the block is
+// validated in the same pass; on a violation NULL is returned with the code in framing->error.
+static ParsedHeaders* parseHeaderBlock(const char* buffer, int length, HeaderFraming* framing) {
+    // Repeated blocks from keep-alive clients reuse a shared parsed set
+    if (headerBlockCacheEnabled()) {
+        ParsedHeaders* cached = parseCachedHeaderBlock(buffer, length, framing);
+        if (cached != NULL || (framing != NULL && framing->error != 0)) {
+            return cached;
+        }
+        if (framing != NULL) {
+            // Bypassed blocks are validated again by the full parse below
+            memset(framing, 0, sizeof(HeaderFraming));
+        }
+    }
+    
+    // Allocate a new headers structure
+    ParsedHeaders* headers = newParsedHeaders();
+    if (!headers) {
+        return NULL; // Memory allocation failed
+    }
     
     // Parse headers
-    char* pos = buffer;
-    char* end = buffer + length;
-    char* line_start = pos;
-    char* line_end;
-    char* colon;
+    const char* pos = buffer;
+    const char* end = buffer + length;
     
     while (pos < end) {
-        // Find end of line - optimized
-        line_end = pos;
-        while (line_end < end && *line_end != '\r' && *line_end != '\n') {
-            line_end++;
-        }
+        const char* line_end = findHeaderLineEnd(pos, end, framing);
         
-        // Skip empty lines
-        if (line_start == line_end) {
-            // Skip CRLF
-            if (line_end < end && *line_end == '\r') line_end++;
-            if (line_end < end && *line_end == '\n') line_end++;
-            line_start = line_end;
-            pos = line_end;
-            continue;
+        if (framing != NULL && (framing->error != 0 ||
+                                (line_end > pos && checkHeaderFraming(framing, pos, line_end) != 0))) {
+            freeParsedHeaders(headers);
+            return NULL;
         }
         
-        // Find colon separator
-        colon = line_start;
-        while (colon < line_end && *colon != ':') {
-            colon++;
-        }
-        
-        if (colon < line_end) {
-            // We found a header
-            
-            // Allocate new header value
-            HeaderValue* header = (HeaderValue*)malloc(sizeof(HeaderValue));
-            if (!header) {
-                // Memory allocation failed, cleanup and return
-                freeHeadersList(headers->first);
-                free(headers);
-                return 0;
-            }
-            
-            // Extract name (trim trailing whitespace)
-            size_t name_len = colon - line_start;
-            // Trim trailing whitespace from header name
-            while (name_len > 0 && (line_start[name_len - 1] == ' ' || line_start[name_len - 1] == '\t')) {
-                name_len--;
-            }
-            if (name_len > MAX_HEADER_NAME_LEN) {
-                name_len = MAX_HEADER_NAME_LEN;
-            }
-            header->name = (char*)malloc(name_len + 1);
-            if (!header->name) {
-                free(header);
-                freeHeadersList(headers->first);
-                free(headers);
-                return 0;
-            }
-            memcpy(header->name, line_start, name_len);
-            header->name[name_len] = '\0';
-            
-            // Extract value (skip leading whitespace)
-            char* value_start = colon + 1;
-            while (value_start < line_end && (*value_start == ' ' || *value_start == '\t')) {
-                value_start++;
-            }
-            
-            size_t value_len = line_end - value_start;
-            header->value = (char*)malloc(value_len + 1);
-            if (!header->value) {
-                free(header->name);
-                free(header);
-                freeHeadersList(headers->first);
-                free(headers);
-                return 0;
-            }
-            memcpy(header->value, value_start, value_len);
-            header->value[value_len] = '\0';
-            
-            // Add to list
-            header->next = headers->first;
-            headers->first = header;
-            headers->count++;
+        // Empty lines are skipped; anything else is a header line
+        if (line_end > pos && addHeaderLine(headers, pos, line_end) != 0) {
+            // Memory allocation failed, cleanup and return
+            freeParsedHeaders(headers);
+            return NULL;
         }
         
         // Skip CRLF
         if (line_end < end && *line_end == '\r') line_end++;
         if (line_end < end && *line_end == '\n') line_end++;
-        line_start = line_end;
         pos = line_end;
     }
     
-    // Headers already stored during ID assignment
-    return headers->id;
+    // Index large header sets before they become visible to other threads
+    buildHeaderIndex(headers);
+    return headers;
+}
+
+/**
+ * Fast native HTTP header parsing - improved with proper cleanup
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseHttpHeaders
+  (JNIEnv *env, jclass cls, jobject headerBytes, jint length) {
+    if (headerBytes == NULL || length <= 0) {
+        return 0;
+    }
+    
+    // Get the buffer from the ByteBuffer
+    char *buffer = (*env)->GetDirectBufferAddress(env, headerBytes);
+    if (buffer == NULL) {
+        return 0; // Error
+    }
+    
+    ParsedHeaders* headers = parseHeaderBlock(buffer, length, NULL);
+    if (!headers) {
+        return 0;
+    }
+    
+    jlong id = registerParsedHeaders(headers);
+    if (id == 0) {
+        freeParsedHeaders(headers);
+    }
+    return id;
+}
+
+/**
+ * Parses a header block like nativeParseHttpHeaders while rejecting ambiguous framing: bare CR,
+ * NUL, obs-fold, malformed field lines, duplicate or non-numeric Content-Length, and
+ * Content-Length combined with Transfer-Encoding. The checks run inside the line scan, so valid
+ * blocks cost the same as with the lenient parser.
+ *
+ * Returns the headers ID, the negated HEADER_ERROR_* code for a framing violation, or 0 if the
+ * block could not be stored.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseHttpHeadersStrict
+  (JNIEnv *env, jclass cls, jobject headerBytes, jint length) {
+    if (headerBytes == NULL || length <= 0) {
+        return 0;
+    }
+    
+    char *buffer = (*env)->GetDirectBufferAddress(env, headerBytes);
+    if (buffer == NULL) {
+        return 0;
+    }
+    
+    HeaderFraming framing = {0};
+    ParsedHeaders* headers = parseHeaderBlock(buffer, length, &framing);
+    if (framing.error != 0) {
+        return -(jlong)framing.error;
+    }
+    if (!headers) {
+        return 0;
+    }
+    
+    jlong id = registerParsedHeaders(headers);
+    if (id == 0) {
+        freeParsedHeaders(headers);
+    }
+    return id;
+}
+
+/**
+ * Checks a header block for ambiguous framing with the rules of nativeParseHttpHeadersStrict,
+ * without parsing it into a header set.
+ *
+ * Returns the HEADER_ERROR_* code, 0 if the framing is unambiguous, or -1 on invalid arguments.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeCheckHeaderFraming
+  (JNIEnv *env, jclass cls, jobject headerBytes, jint length) {
+    if (headerBytes == NULL || length < 0) {
+        return -1;
+    }
+    
+    const char* buffer = (const char*)(*env)->GetDirectBufferAddress(env, headerBytes);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, headerBytes);
+    if (buffer == NULL || length > capacity) {
+        return -1;
+    }
+    
+    HeaderFraming framing = {0};
+    const char* pos = buffer;
+    const char* end = buffer + length;
+    while (pos < end) {
+        const char* lineEnd = findHeaderLineEnd(pos, end, &framing);
+        if (framing.error != 0 ||
+            (lineEnd > pos && checkHeaderFraming(&framing, pos, lineEnd) != 0)) {
+            break;
+        }
+        if (lineEnd < end && *lineEnd == '\r') lineEnd++;
+        if (lineEnd < end && *lineEnd == '\n') lineEnd++;
+        pos = lineEnd;
+    }
+    return framing.error;
 }
 
 /**
@@ -163,41 +500,186 @@ JNIEXPORT jstring JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeGetHe
         return NULL;
     }
     
+    // Get the header name before taking the lock
+    const char *nameStr = (*env)->GetStringUTFChars(env, headerName, NULL);
+    if (nameStr == NULL) {
+        return NULL; // OutOfMemoryError
+    }
+    size_t nameLen = (*env)->GetStringUTFLength(env, headerName);
+    
     // Thread-safe access - keep lock during access to prevent free
     pthread_mutex_lock(&headers_mutex);
     ParsedHeaders* headers = headers_storage[headersId];
-    if (headers == NULL) {
-        pthread_mutex_unlock(&headers_mutex);
+    jstring result = NULL;
+    if (headers != NULL) {
+        HeaderValue* header = findHeader(headers, nameStr, nameLen);
+        if (header != NULL) {
+            result = (*env)->NewStringUTF(env, header->value);
+        }
+    }
+    pthread_mutex_unlock(&headers_mutex);
+    
+    (*env)->ReleaseStringUTFChars(env, headerName, nameStr);
+    CHECK_JNI_EXCEPTION(env);
+    
+    return result;
+}
+
+/**
+ * Retrieves every value of a repeated header (e.g. Set-Cookie, X-Forwarded-For) in wire order -
+ * thread-safe. Returns NULL if the header is absent.
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeGetHeaderValues
+  (JNIEnv *env, jclass cls, jlong headersId, jstring headerName) {
+    if (headerName == NULL || headersId <= 0 || headersId >= MAX_HEADERS) {
         return NULL;
     }
     
-    // Get the header name while holding lock
+    jclass stringClass = (*env)->FindClass(env, "java/lang/String");
+    CHECK_JNI_EXCEPTION(env);
+    
     const char *nameStr = (*env)->GetStringUTFChars(env, headerName, NULL);
     if (nameStr == NULL) {
-        pthread_mutex_unlock(&headers_mutex);
+        (*env)->DeleteLocalRef(env, stringClass);
         return NULL; // OutOfMemoryError
     }
+    size_t nameLen = (*env)->GetStringUTFLength(env, headerName);
     
-    // Find the header
-    HeaderValue* current = headers->first;
-    jstring result = NULL;
-    
-    while (current != NULL) {
-        if (strcasecmp(current->name, nameStr) == 0) {
-            // Found the header, return its value
-            result = (*env)->NewStringUTF(env, current->value);
-            CHECK_JNI_EXCEPTION(env);
-            break;
+    pthread_mutex_lock(&headers_mutex);
+    jobjectArray result = NULL;
+    ParsedHeaders* headers = headers_storage[headersId];
+    HeaderValue* first = headers != NULL ? findHeader(headers, nameStr, nameLen) : NULL;
+    if (first != NULL) {
+        jsize count = 0;
+        for (HeaderValue* h = first; h != NULL; h = findNextHeader(headers, h)) {
+            count++;
+        }
+        
+        result = (*env)->NewObjectArray(env, count, stringClass, NULL);
+        jsize i = 0;
+        for (HeaderValue* h = first; result != NULL && h != NULL; h = findNextHeader(headers, h)) {
+            jstring value = (*env)->NewStringUTF(env, h->value);
+            if (value == NULL) {
+                result = NULL; // OutOfMemoryError is pending
+                break;
+            }
+            (*env)->SetObjectArrayElement(env, result, i++, value);
+            (*env)->DeleteLocalRef(env, value);
         }
-        current = current->next;
     }
-    
     pthread_mutex_unlock(&headers_mutex);
+    
     (*env)->ReleaseStringUTFChars(env, headerName, nameStr);
+    (*env)->DeleteLocalRef(env, stringClass);
+    CHECK_JNI_EXCEPTION(env);
     
     return result;
 }
 
+// Walks a header set in wire order. A set built through the header cache links its own headers
+// before the shared ones, so the two lists are merged by each own header's sharedBefore
+typedef struct {
+    HeaderValue* own;
+    HeaderValue* ownEnd;
+    HeaderValue* shared;
+    int sharedSeen;
+} WireOrderCursor;
+
+static void startWireOrder(WireOrderCursor* cursor, ParsedHeaders* headers) {
+    cursor->own = headers->first;
+    cursor->ownEnd = headers->base != NULL ? headers->base->first : NULL;
+    cursor->shared = cursor->ownEnd;
+    cursor->sharedSeen = 0;
+}
+
+static HeaderValue* nextInWireOrder(WireOrderCursor* cursor) {
+    if (cursor->own != cursor->ownEnd &&
+        (cursor->shared == NULL || cursor->own->sharedBefore <= cursor->sharedSeen)) {
+        HeaderValue* h = cursor->own;
+        cursor->own = h->next;
+        return h;
+    }
+    HeaderValue* h = cursor->shared;
+    if (h != NULL) {
+        cursor->shared = h->next;
+        cursor->sharedSeen++;
+    }
+    return h;
+}
+
+/**
+ * Serializes all previously parsed headers into a direct buffer in a single call - thread-safe
+ *
+ * Layout (native byte order, offsets relative to the start of the buffer):
+ *   [count:4][pool_len:4]
+ *   count x [name_off:4][name_len:4][value_off:4][value_len:4]
+ *   [string pool: names and values, not NUL-terminated]
+ * Headers appear in wire order.
+ *
+ * Returns the number of bytes written, the negated required size if the buffer is
+ * too small, or 0 if the headers ID is unknown.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeExportHeaders
+  (JNIEnv *env, jclass cls, jlong headersId, jobject outBuffer) {
+    if (outBuffer == NULL || headersId <= 0 || headersId >= MAX_HEADERS) {
+        return 0;
+    }
+    
+    char* out = (char*)(*env)->GetDirectBufferAddress(env, outBuffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, outBuffer);
+    if (out == NULL || capacity < 0) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&headers_mutex);
+    ParsedHeaders* headers = headers_storage[headersId];
+    if (headers == NULL) {
+        pthread_mutex_unlock(&headers_mutex);
+        return 0;
+    }
+    
+    // Size the output first so a short buffer is reported without partial writes
+    size_t poolLen = 0;
+    for (HeaderValue* h = headers->first; h != NULL; h = h->next) {
+        poolLen += (size_t)h->nameLen + (size_t)h->valueLen;
+    }
+    size_t indexLen = HEADER_EXPORT_PREAMBLE_SIZE + (size_t)headers->count * HEADER_EXPORT_ENTRY_SIZE;
+    size_t required = indexLen + poolLen;
+    if (required > INT_MAX) {
+        pthread_mutex_unlock(&headers_mutex);
+        return 0;
+    }
+    if ((jlong)required > capacity) {
+        pthread_mutex_unlock(&headers_mutex);
+        return -(jint)required;
+    }
+    
+    int32_t* index = (int32_t*)out;
+    index[0] = headers->count;
+    index[1] = (int32_t)poolLen;
+    int32_t* entry = index + HEADER_EXPORT_PREAMBLE_SIZE / 4;
+    
+    size_t pos = indexLen;
+    WireOrderCursor cursor;
+    startWireOrder(&cursor, headers);
+    for (HeaderValue* h = nextInWireOrder(&cursor); h != NULL; h = nextInWireOrder(&cursor)) {
+        entry[0] = (int32_t)pos;
+        entry[1] = h->nameLen;
+        memcpy(out + pos, h->name, h->nameLen);
+        pos += h->nameLen;
+        
+        entry[2] = (int32_t)pos;
+        entry[3] = h->valueLen;
+        memcpy(out + pos, h->value, h->valueLen);
+        pos += h->valueLen;
+        
+        entry += HEADER_EXPORT_ENTRY_SIZE / 4;
+    }
+    
+    pthread_mutex_unlock(&headers_mutex);
+    return (jint)pos;
+}
+
 /**
  * Releases resources associated with previously parsed headers - thread-safe
  */
@@ -224,10 +706,7 @@ JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeFreeHead
     
     pthread_mutex_unlock(&headers_mutex);
     
-    // Free header values (safe to do outside lock)
-    freeHeadersList(headers->first);
-    
-    // Free headers structure
-    free(headers);
+    // Free header values and index (safe to do outside lock)
+    freeParsedHeaders(headers);
 }
 
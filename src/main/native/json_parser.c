@@ -14,8 +14,26 @@ static jfieldID cachedBooleanTrueField = NULL;
 static jfieldID cachedBooleanFalseField = NULL;
 static jmethodID cachedLongConstructor = NULL;
 static jmethodID cachedDoubleConstructor = NULL;
+static jclass cachedByteBufferClass = NULL;
+static jmethodID cachedAllocateDirect = NULL;
+static jmethodID cachedBufferLimit = NULL;
 static int jniCacheInitialized = 0;
 
+// Object members whose string values are decoded as base64, matched by key as written
+typedef struct {
+    const char** names;
+    const int* lengths;
+    int count;
+    int flags;              // BASE64_* flags
+} JsonBase64Fields;
+
+static jobject parseValue(JNIEnv *env, const char **cursor, const char *end,
+                          const JsonBase64Fields* base64);
+static jobject parseObject(JNIEnv *env, const char **cursor, const char *end,
+                           const JsonBase64Fields* base64);
+static jobject parseArray(JNIEnv *env, const char **cursor, const char *end,
+                          const JsonBase64Fields* base64);
+
 // Initialize JNI cache - automatically called on first use or from JNI_OnLoad
 void initJsonParserCache(JNIEnv *env) {
     if (jniCacheInitialized || env == NULL) return;
@@ -53,6 +71,15 @@ void initJsonParserCache(JNIEnv *env) {
         cachedDoubleClass = (jclass)(*env)->NewGlobalRef(env, cachedDoubleClass);
         cachedDoubleConstructor = (*env)->GetMethodID(env, cachedDoubleClass, "<init>", "(D)V");
     }
+
+    cachedByteBufferClass = (*env)->FindClass(env, "java/nio/ByteBuffer");
+    if (cachedByteBufferClass) {
+        cachedByteBufferClass = (jclass)(*env)->NewGlobalRef(env, cachedByteBufferClass);
+        cachedAllocateDirect = (*env)->GetStaticMethodID(env, cachedByteBufferClass, "allocateDirect",
+                                                         "(I)Ljava/nio/ByteBuffer;");
+        cachedBufferLimit = (*env)->GetMethodID(env, cachedByteBufferClass, "limit",
+                                                "(I)Ljava/nio/Buffer;");
+    }
     
     jniCacheInitialized = 1;
 }
@@ -74,6 +101,11 @@ void skipWhitespace(const char **cursor, const char *end) {
 
 // Parse a JSON value (object, array, string, number, true, false, null)
 jobject parseJsonValue(JNIEnv *env, const char **cursor, const char *end) {
+    return parseValue(env, cursor, end, NULL);
+}
+
+static jobject parseValue(JNIEnv *env, const char **cursor, const char *end,
+                          const JsonBase64Fields* base64) {
     skipWhitespace(cursor, end);
     
     if (*cursor >= end) {
@@ -85,9 +117,9 @@ jobject parseJsonValue(JNIEnv *env, const char **cursor, const char *end) {
     // Optimized dispatch based on first character
     switch (c) {
         case '{':
-            return parseJsonObject(env, cursor, end);
+            return parseObject(env, cursor, end, base64);
         case '[':
-            return parseJsonArray(env, cursor, end);
+            return parseArray(env, cursor, end, base64);
         case '"':
             return parseJsonString(env, cursor, end);
         case 't':
@@ -144,6 +176,126 @@ jobject parseJsonValue(JNIEnv *env, const char **cursor, const char *end) {
 
 // Parse a JSON object - improved error handling
 jobject parseJsonObject(JNIEnv *env, const char **cursor, const char *end) {
+    return parseObject(env, cursor, end, NULL);
+}
+
+static int isBase64Field(const JsonBase64Fields* base64, const char* key, int keyLength) {
+    for (int i = 0; i < base64->count; i++) {
+        if (base64->lengths[i] == keyLength && memcmp(base64->names[i], key, keyLength) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Maps an offset in the unescaped copy of a JSON string back to the string's JSON text
+static int jsonStringOffset(const char *start, const char *end, int unescapedOffset) {
+    const char *p = start;
+    for (int n = 0; n < unescapedOffset && p < end; n++) {
+        p += *p == '\\' ? 2 : 1;
+    }
+    return (int)(p - start);
+}
+
+/**
+ * Decodes a JSON string of base64 text into a new direct ByteBuffer. The only escapes base64
+ * text can hold are "\/" and, for lenient decoding, whitespace; any other escape makes the value
+ * invalid. Throws IllegalArgumentException if the value is not valid base64, with the offset of
+ * the offending character in the string as written in the JSON.
+ */
+static jobject parseBase64String(JNIEnv *env, const char **cursor, const char *end, int flags) {
+    const char *start = *cursor + 1;
+    const char *scan = start;
+    int hasEscapes = 0;
+    while (scan < end && *scan != '"') {
+        if (*scan == '\\') {
+            hasEscapes = 1;
+            if (++scan >= end) {
+                return NULL; // Unexpected end of input
+            }
+        }
+        scan++;
+    }
+    if (scan >= end || scan - start > INT_MAX) {
+        return NULL; // Unterminated string
+    }
+
+    const unsigned char *text = (const unsigned char*)start;
+    int length = (int)(scan - start);
+    unsigned char *unescaped = NULL;
+    if (hasEscapes) {
+        unescaped = (unsigned char*)malloc(length);
+        if (unescaped == NULL) {
+            return NULL;
+        }
+        int n = 0;
+        for (const char *p = start; p < scan; p++) {
+            if (*p != '\\') {
+                unescaped[n++] = (unsigned char)*p;
+                continue;
+            }
+            switch (*++p) {
+                case '/': unescaped[n++] = '/'; break;
+                case 'n': unescaped[n++] = '\n'; break;
+                case 'r': unescaped[n++] = '\r'; break;
+                case 't': unescaped[n++] = '\t'; break;
+                default: unescaped[n++] = '\\'; break; // Rejected by the decoder
+            }
+        }
+        text = unescaped;
+        length = n;
+    }
+
+    if (!cachedByteBufferClass) {
+        initJsonParserCache(env);
+    }
+    if (!cachedByteBufferClass || !cachedAllocateDirect || !cachedBufferLimit) {
+        free(unescaped);
+        return NULL;
+    }
+    jobject buffer = (*env)->CallStaticObjectMethod(env, cachedByteBufferClass,
+                                                    cachedAllocateDirect,
+                                                    (jint)base64DecodedMaxLength(length));
+    CHECK_JNI_EXCEPTION_CLEANUP(env, free(unescaped));
+    unsigned char *out = buffer != NULL
+        ? (unsigned char*)(*env)->GetDirectBufferAddress(env, buffer) : NULL;
+    int decoded = 0;
+    if (length > 0) {
+        decoded = out != NULL ? base64Decode(text, length, out, flags) : INT_MIN;
+    }
+    free(unescaped);
+
+    if (decoded < 0) {
+        if (buffer != NULL) {
+            (*env)->DeleteLocalRef(env, buffer);
+        }
+        jclass exceptionClass = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
+        if (exceptionClass != NULL) {
+            char message[80];
+            if (decoded == INT_MIN) {
+                snprintf(message, sizeof(message), "Cannot decode base64 JSON string");
+            } else {
+                int index = hasEscapes ? jsonStringOffset(start, scan, -1 - decoded)
+                                       : -1 - decoded;
+                snprintf(message, sizeof(message),
+                         "Illegal base64 character in JSON string at index %d", index);
+            }
+            (*env)->ThrowNew(env, exceptionClass, message);
+        }
+        return NULL;
+    }
+
+    jobject limited = (*env)->CallObjectMethod(env, buffer, cachedBufferLimit, (jint)decoded);
+    CHECK_JNI_EXCEPTION_CLEANUP(env, (*env)->DeleteLocalRef(env, buffer));
+    if (limited != NULL) {
+        (*env)->DeleteLocalRef(env, limited);
+    }
+    *cursor = scan + 1; // Skip the closing quote
+    return buffer;
+}
+
+static jobject parseObject(JNIEnv *env, const char **cursor, const char *end,
+                           const JsonBase64Fields* base64) {
     // Skip opening brace
     (*cursor)++;
     
@@ -180,11 +332,13 @@ jobject parseJsonObject(JNIEnv *env, const char **cursor, const char *end) {
         }
         
         // Parse the key
+        const char *keyStart = *cursor + 1;
         jobject key = parseJsonString(env, cursor, end);
         if (key == NULL) {
             (*env)->DeleteLocalRef(env, map);
             return NULL;
         }
+        int keyLength = (int)(*cursor - 1 - keyStart);
         
         skipWhitespace(cursor, end);
         
@@ -197,11 +351,22 @@ jobject parseJsonObject(JNIEnv *env, const char **cursor, const char *end) {
         (*cursor)++; // Skip the colon
         
         // Parse the value
-        jobject value = parseJsonValue(env, cursor, end);
+        jobject value;
+        skipWhitespace(cursor, end);
+        if (base64 != NULL && *cursor < end && **cursor == '"' &&
+            isBase64Field(base64, keyStart, keyLength)) {
+            value = parseBase64String(env, cursor, end, base64->flags);
+        } else {
+            value = parseValue(env, cursor, end, base64);
+        }
         if (value == NULL && (*cursor - 1 >= end || *(*cursor - 1) != 'n')) {
             // NULL is valid for JSON null, but check if it was actually null
             // This is a simplified check
         }
+        CHECK_JNI_EXCEPTION_CLEANUP(env, {
+            (*env)->DeleteLocalRef(env, key);
+            (*env)->DeleteLocalRef(env, map);
+        });
         
         // Add key-value pair to the map
         // Note: value can be NULL for JSON null
@@ -241,6 +406,11 @@ jobject parseJsonObject(JNIEnv *env, const char **cursor, const char *end) {
 
 // Parse a JSON array - improved error handling
 jobject parseJsonArray(JNIEnv *env, const char **cursor, const char *end) {
+    return parseArray(env, cursor, end, NULL);
+}
+
+static jobject parseArray(JNIEnv *env, const char **cursor, const char *end,
+                          const JsonBase64Fields* base64) {
     // Skip opening bracket
     (*cursor)++;
     
@@ -269,7 +439,8 @@ jobject parseJsonArray(JNIEnv *env, const char **cursor, const char *end) {
     // Parse array elements
     while (*cursor < end) {
         // Parse the value
-        jobject value = parseJsonValue(env, cursor, end);
+        jobject value = parseValue(env, cursor, end, base64);
+        CHECK_JNI_EXCEPTION_CLEANUP(env, (*env)->DeleteLocalRef(env, list));
         
         // Add value to the list
         // Note: For null values, we still need to add them to maintain array indices
@@ -587,3 +758,73 @@ jobject parseJsonNumber(JNIEnv *env, const char **cursor, const char *end) {
     return result;
 }
 
+
+/**
+ * Parses JSON like nativeParseJson, but decodes the string values of object members named in
+ * `base64Fields` as base64 (with the BASE64_* `flags`) into direct ByteBuffers, without building
+ * an intermediate String. The values are decoded from the GetStringUTFChars copy of `input`.
+ * Returns NULL for invalid JSON and throws IllegalArgumentException if a named member holds
+ * invalid base64.
+ */
+JNIEXPORT jobject JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseJsonBase64
+  (JNIEnv *env, jclass cls, jstring input, jobjectArray base64Fields, jint flags) {
+    if (input == NULL || base64Fields == NULL) {
+        return NULL;
+    }
+
+    jsize fieldCount = (*env)->GetArrayLength(env, base64Fields);
+    jstring* fieldStrings = (jstring*)calloc(fieldCount + 1, sizeof(jstring));
+    const char** names = (const char**)calloc(fieldCount + 1, sizeof(const char*));
+    int* lengths = (int*)calloc(fieldCount + 1, sizeof(int));
+    jobject result = NULL;
+    if (fieldStrings == NULL || names == NULL || lengths == NULL) {
+        goto cleanup;
+    }
+    for (jsize i = 0; i < fieldCount; i++) {
+        fieldStrings[i] = (jstring)(*env)->GetObjectArrayElement(env, base64Fields, i);
+        if (fieldStrings[i] == NULL) {
+            goto cleanup;
+        }
+        names[i] = (*env)->GetStringUTFChars(env, fieldStrings[i], NULL);
+        if (names[i] == NULL) {
+            goto cleanup;
+        }
+        lengths[i] = (int)(*env)->GetStringUTFLength(env, fieldStrings[i]);
+    }
+
+    const char *utf8Str = (*env)->GetStringUTFChars(env, input, NULL);
+    if (utf8Str == NULL) {
+        goto cleanup; // OutOfMemoryError
+    }
+    size_t length = (*env)->GetStringUTFLength(env, input);
+    if (length > 0) {
+        JsonBase64Fields base64 = { names, lengths, (int)fieldCount, (int)flags };
+        const char *cursor = utf8Str;
+        const char *end = utf8Str + length;
+        result = parseValue(env, &cursor, end, &base64);
+
+        // Verify we consumed all input (after whitespace)
+        if (result != NULL && !(*env)->ExceptionCheck(env)) {
+            skipWhitespace(&cursor, end);
+            if (cursor < end) {
+                (*env)->DeleteLocalRef(env, result);
+                result = NULL;
+            }
+        }
+    }
+    (*env)->ReleaseStringUTFChars(env, input, utf8Str);
+
+cleanup:
+    if (fieldStrings != NULL && names != NULL) {
+        for (jsize i = 0; i < fieldCount && fieldStrings[i] != NULL; i++) {
+            if (names[i] != NULL) {
+                (*env)->ReleaseStringUTFChars(env, fieldStrings[i], names[i]);
+            }
+            (*env)->DeleteLocalRef(env, fieldStrings[i]);
+        }
+    }
+    free(fieldStrings);
+    free(names);
+    free(lengths);
+    return result;
+}
@@ -0,0 +1,154 @@
+#include "blyfastnative.h"
+
+/**
+ * Media type parsing (RFC 9110 8.3.1): type "/" subtype *( OWS ";" OWS parameter ), where a
+ * parameter value is a token or a quoted-string. Only the parameters the body parsers need are
+ * kept: charset, and boundary for multipart bodies.
+ */
+
+static inline int isTokenChar(unsigned char c) {
+    if (isalnum(c)) {
+        return 1;
+    }
+    switch (c) {
+        case '!': case '#': case '$': case '%': case '&': case '\'': case '*': case '+':
+        case '-': case '.': case '^': case '_': case '`': case '|': case '~':
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static inline int skipOptionalWhitespace(const char* value, int pos, int length) {
+    while (pos < length && (value[pos] == ' ' || value[pos] == '\t')) {
+        pos++;
+    }
+    return pos;
+}
+
+static inline int scanToken(const char* value, int pos, int length) {
+    while (pos < length && isTokenChar((unsigned char)value[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Parses a Content-Type value into `out`. Type, subtype and charset point into `value`; the
+ * boundary is copied with quoted-pairs resolved. Returns 1 on success, or 0 if the value is not a
+ * media type or its boundary exceeds MAX_BOUNDARY_LEN - 1 bytes.
+ */
+int parseMediaType(const char* value, int length, MediaType* out) {
+    memset(out, 0, sizeof(MediaType));
+
+    int pos = skipOptionalWhitespace(value, 0, length);
+    int typeEnd = scanToken(value, pos, length);
+    if (typeEnd == pos || typeEnd >= length || value[typeEnd] != '/') {
+        return 0;
+    }
+    out->type = value + pos;
+    out->typeLength = typeEnd - pos;
+
+    pos = typeEnd + 1;
+    int subtypeEnd = scanToken(value, pos, length);
+    if (subtypeEnd == pos) {
+        return 0;
+    }
+    out->subtype = value + pos;
+    out->subtypeLength = subtypeEnd - pos;
+    pos = subtypeEnd;
+
+    int haveBoundary = 0;
+    int haveCharset = 0;
+    for (;;) {
+        pos = skipOptionalWhitespace(value, pos, length);
+        if (pos == length) {
+            return 1;
+        }
+        if (value[pos] != ';') {
+            return 0;
+        }
+        pos = skipOptionalWhitespace(value, pos + 1, length);
+        if (pos == length || value[pos] == ';') {
+            continue; // Empty parameter
+        }
+
+        int nameStart = pos;
+        int nameEnd = scanToken(value, pos, length);
+        if (nameEnd == nameStart || nameEnd >= length || value[nameEnd] != '=') {
+            return 0;
+        }
+        int nameLength = nameEnd - nameStart;
+        int isBoundary = !haveBoundary && nameLength == 8 &&
+                         strncasecmp(value + nameStart, "boundary", 8) == 0;
+        int isCharset = !haveCharset && nameLength == 7 &&
+                        strncasecmp(value + nameStart, "charset", 7) == 0;
+
+        pos = nameEnd + 1;
+        if (pos < length && value[pos] == '"') {
+            // Quoted-string; a quoted-pair stands for its second character
+            int copied = 0;
+            int contentStart = ++pos;
+            while (pos < length && value[pos] != '"') {
+                if (value[pos] == '\\') {
+                    if (++pos == length) {
+                        return 0;
+                    }
+                }
+                if (isBoundary) {
+                    if (copied == MAX_BOUNDARY_LEN - 1) {
+                        return 0;
+                    }
+                    out->boundary[copied++] = value[pos];
+                }
+                pos++;
+            }
+            if (pos == length) {
+                return 0; // Unterminated quoted-string
+            }
+            if (isBoundary) {
+                out->boundaryLength = copied;
+            } else if (isCharset) {
+                out->charset = value + contentStart;
+                out->charsetLength = pos - contentStart;
+            }
+            pos++;
+        } else {
+            int valueEnd = scanToken(value, pos, length);
+            if (valueEnd == pos) {
+                return 0;
+            }
+            if (isBoundary) {
+                if (valueEnd - pos > MAX_BOUNDARY_LEN - 1) {
+                    return 0;
+                }
+                memcpy(out->boundary, value + pos, valueEnd - pos);
+                out->boundaryLength = valueEnd - pos;
+            } else if (isCharset) {
+                out->charset = value + pos;
+                out->charsetLength = valueEnd - pos;
+            }
+            pos = valueEnd;
+        }
+        haveBoundary |= isBoundary;
+        haveCharset |= isCharset;
+    }
+}
+
+/**
+ * Checks whether a parsed media type is `type`/`subtype`, ignoring case. A NULL subtype matches
+ * any subtype.
+ */
+int mediaTypeIs(const MediaType* mediaType, const char* type, const char* subtype) {
+    int typeLength = (int)strlen(type);
+    if (mediaType->typeLength != typeLength ||
+        strncasecmp(mediaType->type, type, typeLength) != 0) {
+        return 0;
+    }
+    if (subtype == NULL) {
+        return 1;
+    }
+    int subtypeLength = (int)strlen(subtype);
+    return mediaType->subtypeLength == subtypeLength &&
+           strncasecmp(mediaType->subtype, subtype, subtypeLength) == 0;
+}
@@ -0,0 +1,457 @@
+#include "blyfastnative.h"
+
+/**
+ * Streaming multipart/form-data parser (RFC 7578, RFC 2046 5.1).
+ *
+ * The body is fed in chunks as it arrives, and the parser reports what it found as fixed-size
+ * events in an int array: the start of a part with the offsets of its name, filename and content
+ * type, slices of part data, the end of a part, and the close delimiter. All offsets point into
+ * the chunk that was passed in, so nothing is copied; the events are only valid until the caller
+ * reuses that buffer.
+ *
+ * The parser never buffers input itself. When a chunk ends in the middle of something it needs
+ * whole (a part's header block, the bytes after a boundary, or a possible delimiter), it stops
+ * before those bytes and reports fewer bytes consumed; the caller keeps them and passes them again
+ * in front of the next chunk. At most MAX_MULTIPART_HEADER_BLOCK bytes are ever held back this way.
+ */
+
+typedef enum {
+    MULTIPART_PREAMBLE,         // Before the first delimiter
+    MULTIPART_BOUNDARY_TAIL,    // After a boundary: "--", or padding and CRLF
+    MULTIPART_HEADERS,          // A part's header block
+    MULTIPART_DATA,             // Part content up to the next delimiter
+    MULTIPART_EPILOGUE,         // After the close delimiter; ignored
+    MULTIPART_ERROR
+} MultipartState;
+
+typedef struct {
+    MultipartState state;
+    int error;
+    int atBodyStart;            // The first delimiter may appear without its leading CRLF
+    int partOpen;
+    char delimiter[MAX_BOUNDARY_LEN + 4];   // CRLF "--" boundary
+    int delimiterLength;
+} MultipartStream;
+
+typedef struct {
+    jint* events;
+    int count;
+    int max;
+    int base;                   // Added to offsets so events point into the caller's buffer
+} MultipartEvents;
+
+static int multipartFail(MultipartStream* stream, int error) {
+    stream->state = MULTIPART_ERROR;
+    stream->error = error;
+    return -error;
+}
+
+static void addEvent(MultipartEvents* out, int type, int aOffset, int aLength, int bOffset,
+                     int bLength, int cOffset, int cLength) {
+    jint* event = out->events + out->count * MULTIPART_EVENT_INTS;
+    event[0] = type;
+    event[1] = aLength >= 0 ? out->base + aOffset : 0;
+    event[2] = aLength;
+    event[3] = bLength >= 0 ? out->base + bOffset : 0;
+    event[4] = bLength;
+    event[5] = cLength >= 0 ? out->base + cOffset : 0;
+    event[6] = cLength;
+    out->count++;
+}
+
+/**
+ * Finds where a possible partial `needle` at the end of haystack[pos, length) starts: the first
+ * position whose remaining bytes are a proper prefix of the needle. Returns `length` if there is
+ * none, so that everything before the returned offset is known not to begin a match.
+ */
+int findBoundaryPrefix(const unsigned char* haystack, int pos, int length, const char* needle,
+                       int needleLength) {
+    int start = length - needleLength + 1;
+    if (start < pos) {
+        start = pos;
+    }
+    for (int i = start; i < length; i++) {
+        if (haystack[i] == (unsigned char)needle[0] &&
+            memcmp(haystack + i, needle, length - i) == 0) {
+            return i;
+        }
+    }
+    return length;
+}
+
+/**
+ * Finds the delimiter in buffer[pos, length). If it is not there, stores in `safeEnd` where a
+ * possible partial delimiter at the end of the buffer starts (or `length`), so the bytes before it
+ * can be released as data.
+ */
+static int findDelimiter(const unsigned char* buffer, int pos, int length,
+                         const char* delimiter, int delimiterLength, int* safeEnd) {
+    int found = findBoundary(buffer, pos, length, delimiter, delimiterLength);
+    if (found < 0) {
+        *safeEnd = findBoundaryPrefix(buffer, pos, length, delimiter, delimiterLength);
+    }
+    return found;
+}
+
+// Length of the value slice of a Content-Disposition parameter, with quotes removed
+static int parameterValue(const char* s, int pos, int end, int* valueStart) {
+    if (pos < end && s[pos] == '"') {
+        int start = ++pos;
+        while (pos < end && s[pos] != '"') {
+            pos += (s[pos] == '\\' && pos + 1 < end) ? 2 : 1;
+        }
+        *valueStart = start;
+        return pos - start;
+    }
+    int start = pos;
+    while (pos < end && s[pos] != ';' && s[pos] != ' ' && s[pos] != '\t') {
+        pos++;
+    }
+    *valueStart = start;
+    return pos - start;
+}
+
+/**
+ * Reads the name and filename parameters of a Content-Disposition value. Lengths stay -1 for
+ * parameters that are absent.
+ */
+static void parseDisposition(const char* s, int pos, int end, int* nameOffset, int* nameLength,
+                             int* filenameOffset, int* filenameLength) {
+    // Skip the disposition type ("form-data")
+    while (pos < end && s[pos] != ';') {
+        pos++;
+    }
+    while (pos < end) {
+        pos++; // ';'
+        while (pos < end && (s[pos] == ' ' || s[pos] == '\t')) {
+            pos++;
+        }
+        int paramStart = pos;
+        while (pos < end && s[pos] != '=' && s[pos] != ';') {
+            pos++;
+        }
+        int paramEnd = pos;
+        while (paramEnd > paramStart && (s[paramEnd - 1] == ' ' || s[paramEnd - 1] == '\t')) {
+            paramEnd--;
+        }
+        if (pos >= end || s[pos] != '=') {
+            continue;
+        }
+        pos++;
+        while (pos < end && (s[pos] == ' ' || s[pos] == '\t')) {
+            pos++;
+        }
+
+        int valueStart;
+        int valueLength = parameterValue(s, pos, end, &valueStart);
+        int paramLength = paramEnd - paramStart;
+        if (paramLength == 4 && strncasecmp(s + paramStart, "name", 4) == 0) {
+            *nameOffset = valueStart;
+            *nameLength = valueLength;
+        } else if (paramLength == 8 && strncasecmp(s + paramStart, "filename", 8) == 0) {
+            *filenameOffset = valueStart;
+            *filenameLength = valueLength;
+        }
+
+        pos = valueStart + valueLength;
+        while (pos < end && s[pos] != ';') {
+            pos++;
+        }
+    }
+}
+
+// Finds the CRLF CRLF ending a header block in buffer[pos, end); returns where it starts or -1
+static int findBlankLine(const unsigned char* buffer, int pos, int end) {
+    while (end - pos >= 4) {
+        const unsigned char* cr = memchr(buffer + pos, '\r', end - 3 - pos);
+        if (cr == NULL) {
+            return -1;
+        }
+        pos = (int)(cr - buffer);
+        if (memcmp(buffer + pos, "\r\n\r\n", 4) == 0) {
+            return pos;
+        }
+        pos++;
+    }
+    return -1;
+}
+
+/**
+ * Parses the header lines in buffer[start, end), which ends just before the blank line, and emits
+ * the part start event.
+ */
+static int parsePartHeaders(MultipartStream* stream, const unsigned char* buffer, int start,
+                            int end, MultipartEvents* out) {
+    const char* s = (const char*)buffer;
+    int nameOffset = 0, nameLength = -1;
+    int filenameOffset = 0, filenameLength = -1;
+    int typeOffset = 0, typeLength = -1;
+
+    int pos = start;
+    while (pos < end) {
+        const unsigned char* cr = memchr(buffer + pos, '\r', end - pos);
+        int lineEnd = cr ? (int)(cr - buffer) : end;
+        if (cr != NULL && buffer[lineEnd + 1] != '\n') {
+            return multipartFail(stream, MULTIPART_ERROR_INVALID_HEADER);
+        }
+        const char* colon = memchr(s + pos, ':', lineEnd - pos);
+        if (colon == NULL || colon == s + pos) {
+            return multipartFail(stream, MULTIPART_ERROR_INVALID_HEADER);
+        }
+
+        int fieldNameLength = (int)(colon - (s + pos));
+        int valueStart = (int)(colon - s) + 1;
+        int valueEnd = lineEnd;
+        while (valueStart < valueEnd && (s[valueStart] == ' ' || s[valueStart] == '\t')) {
+            valueStart++;
+        }
+        while (valueEnd > valueStart && (s[valueEnd - 1] == ' ' || s[valueEnd - 1] == '\t')) {
+            valueEnd--;
+        }
+
+        if (fieldNameLength == 19 && strncasecmp(s + pos, "Content-Disposition", 19) == 0) {
+            parseDisposition(s, valueStart, valueEnd, &nameOffset, &nameLength,
+                             &filenameOffset, &filenameLength);
+        } else if (fieldNameLength == 12 && strncasecmp(s + pos, "Content-Type", 12) == 0) {
+            typeOffset = valueStart;
+            typeLength = valueEnd - valueStart;
+        }
+
+        pos = lineEnd + 2; // CRLF
+    }
+
+    addEvent(out, MULTIPART_EVENT_PART_BEGIN, nameOffset, nameLength, filenameOffset,
+             filenameLength, typeOffset, typeLength);
+    stream->partOpen = 1;
+    return 0;
+}
+
+/**
+ * Parses as much of buffer[0, length) as possible, appending events to `out`. Stops when the
+ * event array is full or when the rest of the buffer has to be seen again with more data.
+ *
+ * Returns the number of bytes consumed, or a negated MULTIPART_ERROR_* code.
+ */
+static int multipartParse(MultipartStream* stream, const unsigned char* buffer, int length,
+                          MultipartEvents* out) {
+    int pos = 0;
+
+    // Every step below emits at most two events
+    while (pos < length && out->count + 2 <= out->max) {
+        int available = length - pos;
+
+        switch (stream->state) {
+            case MULTIPART_PREAMBLE: {
+                if (stream->atBodyStart) {
+                    // "--boundary" without the CRLF that belongs to it
+                    const char* dashBoundary = stream->delimiter + 2;
+                    int dashBoundaryLength = stream->delimiterLength - 2;
+                    if (available < dashBoundaryLength) {
+                        if (memcmp(buffer + pos, dashBoundary, available) == 0) {
+                            return pos;
+                        }
+                    } else if (memcmp(buffer + pos, dashBoundary, dashBoundaryLength) == 0) {
+                        stream->atBodyStart = 0;
+                        pos += dashBoundaryLength;
+                        stream->state = MULTIPART_BOUNDARY_TAIL;
+                        break;
+                    }
+                    stream->atBodyStart = 0;
+                }
+
+                int safeEnd;
+                int found = findDelimiter(buffer, pos, length, stream->delimiter,
+                                          stream->delimiterLength, &safeEnd);
+                if (found < 0) {
+                    return safeEnd;
+                }
+                pos = found + stream->delimiterLength;
+                stream->state = MULTIPART_BOUNDARY_TAIL;
+                break;
+            }
+
+            case MULTIPART_BOUNDARY_TAIL: {
+                if (available < 2) {
+                    return pos;
+                }
+                if (buffer[pos] == '-' && buffer[pos + 1] == '-') {
+                    addEvent(out, MULTIPART_EVENT_END, 0, -1, 0, -1, 0, -1);
+                    pos += 2;
+                    stream->state = MULTIPART_EPILOGUE;
+                    break;
+                }
+
+                // Transport padding, then CRLF
+                int i = pos;
+                while (i < length && (buffer[i] == ' ' || buffer[i] == '\t')) {
+                    if (i - pos >= MAX_MULTIPART_PADDING) {
+                        return multipartFail(stream, MULTIPART_ERROR_INVALID_DELIMITER);
+                    }
+                    i++;
+                }
+                if (length - i < 2) {
+                    return pos;
+                }
+                if (buffer[i] != '\r' || buffer[i + 1] != '\n') {
+                    return multipartFail(stream, MULTIPART_ERROR_INVALID_DELIMITER);
+                }
+                pos = i + 2;
+                stream->state = MULTIPART_HEADERS;
+                break;
+            }
+
+            case MULTIPART_HEADERS: {
+                // The header block ends with an empty line; a part may have no headers at all
+                int searchEnd = available < MAX_MULTIPART_HEADER_BLOCK
+                                    ? length : pos + MAX_MULTIPART_HEADER_BLOCK;
+                int headersEnd = -1;
+                if (available >= 2 && buffer[pos] == '\r' && buffer[pos + 1] == '\n') {
+                    headersEnd = pos - 2;
+                } else {
+                    headersEnd = findBlankLine(buffer, pos, searchEnd);
+                }
+                if (headersEnd == -1) {
+                    if (available >= MAX_MULTIPART_HEADER_BLOCK) {
+                        return multipartFail(stream, MULTIPART_ERROR_HEADERS_TOO_LONG);
+                    }
+                    return pos;
+                }
+
+                int rc = parsePartHeaders(stream, buffer, pos, headersEnd > pos ? headersEnd : pos,
+                                          out);
+                if (rc < 0) {
+                    return rc;
+                }
+                pos = headersEnd + 4;
+                stream->state = MULTIPART_DATA;
+                break;
+            }
+
+            case MULTIPART_DATA: {
+                int safeEnd;
+                int found = findDelimiter(buffer, pos, length, stream->delimiter,
+                                          stream->delimiterLength, &safeEnd);
+                int dataEnd = found >= 0 ? found : safeEnd;
+                if (dataEnd > pos) {
+                    addEvent(out, MULTIPART_EVENT_DATA, pos, dataEnd - pos, 0, -1, 0, -1);
+                }
+                if (found < 0) {
+                    return safeEnd;
+                }
+                addEvent(out, MULTIPART_EVENT_PART_END, 0, -1, 0, -1, 0, -1);
+                stream->partOpen = 0;
+                pos = found + stream->delimiterLength;
+                stream->state = MULTIPART_BOUNDARY_TAIL;
+                break;
+            }
+
+            case MULTIPART_EPILOGUE:
+                return length;
+
+            default:
+                return multipartFail(stream, stream->error);
+        }
+    }
+
+    return pos;
+}
+
+/**
+ * Creates a streaming multipart parser for the given boundary (the Content-Type parameter, without
+ * the leading dashes). Returns a handle, or 0 if the boundary is empty, too long or allocation
+ * fails.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeMultipartParserCreate
+  (JNIEnv *env, jclass cls, jstring boundary) {
+    if (boundary == NULL) {
+        return 0;
+    }
+    jsize boundaryLength = (*env)->GetStringUTFLength(env, boundary);
+    if (boundaryLength <= 0 || boundaryLength >= MAX_BOUNDARY_LEN) {
+        return 0;
+    }
+
+    MultipartStream* stream = (MultipartStream*)calloc(1, sizeof(MultipartStream));
+    if (stream == NULL) {
+        return 0;
+    }
+    memcpy(stream->delimiter, "\r\n--", 4);
+    (*env)->GetStringUTFRegion(env, boundary, 0, (*env)->GetStringLength(env, boundary),
+                               stream->delimiter + 4);
+    stream->delimiterLength = 4 + boundaryLength;
+    stream->state = MULTIPART_PREAMBLE;
+    stream->atBodyStart = 1;
+    return (jlong)(intptr_t)stream;
+}
+
+/**
+ * Parses the next `length` bytes of a multipart body in a direct buffer, writing events of
+ * MULTIPART_EVENT_INTS ints into `events`: [type, name_off, name_len, filename_off,
+ * filename_len, type_off, type_len] for a part start and [type, off, len, ...] for data. Absent
+ * values have length -1 and offsets are absolute buffer indexes.
+ *
+ * Returns consumed | events << MULTIPART_RESULT_EVENTS_SHIFT, with bit
+ * MULTIPART_RESULT_COMPLETE_SHIFT set once the close delimiter has been read, or a negated
+ * MULTIPART_ERROR_* code. Bytes that were not consumed must be passed again with the next chunk.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeMultipartParse
+  (JNIEnv *env, jclass cls, jlong parserHandle, jobject buffer, jint offset, jint length,
+   jintArray events) {
+    MultipartStream* stream = (MultipartStream*)(intptr_t)parserHandle;
+    if (stream == NULL || buffer == NULL || events == NULL || offset < 0 || length < 0) {
+        return -MULTIPART_ERROR_INVALID_ARGUMENT;
+    }
+    if (stream->state == MULTIPART_ERROR) {
+        return -stream->error;
+    }
+
+    unsigned char* data = (unsigned char*)(*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (data == NULL || (jlong)offset + length > capacity) {
+        return -MULTIPART_ERROR_INVALID_ARGUMENT;
+    }
+
+    MultipartEvents out;
+    out.max = (*env)->GetArrayLength(env, events) / MULTIPART_EVENT_INTS;
+    out.count = 0;
+    out.base = offset;
+    out.events = (jint*)(*env)->GetPrimitiveArrayCritical(env, events, NULL);
+    if (out.events == NULL) {
+        return -MULTIPART_ERROR_INVALID_ARGUMENT;
+    }
+
+    int consumed = multipartParse(stream, data + offset, length, &out);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, events, out.events, 0);
+    if (consumed < 0) {
+        return consumed;
+    }
+
+    jlong result = (jlong)consumed | ((jlong)out.count << MULTIPART_RESULT_EVENTS_SHIFT);
+    if (stream->state == MULTIPART_EPILOGUE) {
+        result |= (jlong)1 << MULTIPART_RESULT_COMPLETE_SHIFT;
+    }
+    return result;
+}
+
+/**
+ * Resets a parser for another body with the same boundary.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeMultipartParserReset
+  (JNIEnv *env, jclass cls, jlong parserHandle) {
+    MultipartStream* stream = (MultipartStream*)(intptr_t)parserHandle;
+    if (stream != NULL) {
+        stream->state = MULTIPART_PREAMBLE;
+        stream->error = 0;
+        stream->atBodyStart = 1;
+        stream->partOpen = 0;
+    }
+}
+
+/**
+ * Frees a parser created by nativeMultipartParserCreate.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeMultipartParserFree
+  (JNIEnv *env, jclass cls, jlong parserHandle) {
+    free((MultipartStream*)(intptr_t)parserHandle);
+}
@@ -0,0 +1,177 @@
+#include "blyfastnative.h"
+
+/**
+ * Multipart response framing (RFC 2046 5.1.1), for multipart/mixed batch responses and
+ * multipart/byteranges (RFC 9110 14.6).
+ *
+ * Only the framing is written: each part's delimiter line and headers, and the close delimiter.
+ * Part bodies are never copied; the caller interleaves the frames with the body buffers and sends
+ * them with one gathering write, so the output is an iovec list of the framing buffer and the
+ * buffers the bodies already live in.
+ */
+
+// bchars (RFC 2046 5.1.1): a boundary must not end with a space
+static int isValidBoundary(const char* boundary, size_t length) {
+    if (length == 0 || length > MAX_MULTIPART_RESPONSE_BOUNDARY || boundary[length - 1] == ' ') {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)boundary[i];
+        if (!isalnum(c) && strchr("'()+_,-./:=? ", c) == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Writes the framing of a multipart body whose parts have `headerCounts[i]` headers each, taken
+ * in order from `headerText`: the UTF-8 names and values, alternating and concatenated, with
+ * `headerLengths` giving the length of each. Frame i, which precedes the body of part i, ends at
+ * `frameEnds[i]`; the last frame is the close delimiter, so `frameEnds` needs one entry more than
+ * there are parts.
+ *
+ * Returns the number of bytes written, the negated required size if `out` is too small, or 0 on
+ * invalid arguments (including an invalid boundary or header text containing CR or LF).
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeWriteMultipartFraming
+  (JNIEnv *env, jclass cls, jobject out, jstring boundary, jbyteArray headerText,
+   jintArray headerLengths, jintArray headerCounts, jintArray frameEnds) {
+    if (out == NULL || boundary == NULL || headerLengths == NULL || headerCounts == NULL ||
+        frameEnds == NULL) {
+        return 0;
+    }
+    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, out);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, out);
+    if (buffer == NULL || capacity < 0) {
+        return 0;
+    }
+
+    jsize partCount = (*env)->GetArrayLength(env, headerCounts);
+    jsize headerLength = (*env)->GetArrayLength(env, headerLengths);
+    jsize textLength = headerText != NULL ? (*env)->GetArrayLength(env, headerText) : 0;
+    if (partCount == 0 || (*env)->GetArrayLength(env, frameEnds) <= partCount ||
+        (headerText == NULL && headerLength > 0)) {
+        return 0;
+    }
+
+    // The boundary is restricted to ASCII bchars, where modified UTF-8 and UTF-8 agree
+    char delimiter[MAX_MULTIPART_RESPONSE_BOUNDARY + 1];
+    size_t boundaryLength = (size_t)(*env)->GetStringUTFLength(env, boundary);
+    if (boundaryLength == 0 || boundaryLength > MAX_MULTIPART_RESPONSE_BOUNDARY) {
+        return 0;
+    }
+    const char* boundaryChars = (*env)->GetStringUTFChars(env, boundary, NULL);
+    if (boundaryChars == NULL) {
+        return 0;
+    }
+    memcpy(delimiter, boundaryChars, boundaryLength);
+    (*env)->ReleaseStringUTFChars(env, boundary, boundaryChars);
+    if (!isValidBoundary(delimiter, boundaryLength)) {
+        return 0;
+    }
+
+    jint* counts = (jint*)malloc(sizeof(jint) * ((size_t)partCount * 2 + 1 + (size_t)headerLength));
+    if (counts == NULL) {
+        return 0;
+    }
+    jint* ends = counts + partCount;
+    jint* lengths = ends + partCount + 1;
+    (*env)->GetIntArrayRegion(env, headerCounts, 0, partCount, counts);
+    (*env)->GetIntArrayRegion(env, headerLengths, 0, headerLength, lengths);
+
+    // "--" boundary CRLF and the blank line per part, CRLF before every delimiter but the first,
+    // and CRLF "--" boundary "--" CRLF to close
+    size_t required = (size_t)partCount * (2 + boundaryLength + 2 + 2) + (size_t)(partCount - 1) * 2
+                      + 2 + 2 + boundaryLength + 2 + 2;
+    jlong totalHeaders = 0;
+    for (jsize i = 0; i < partCount; i++) {
+        if (counts[i] < 0) {
+            free(counts);
+            return 0;
+        }
+        totalHeaders += counts[i];
+    }
+    jlong totalText = 0;
+    for (jsize i = 0; i < headerLength; i++) {
+        if (lengths[i] < 0) {
+            free(counts);
+            return 0;
+        }
+        totalText += lengths[i];
+    }
+    if (totalHeaders * 2 != headerLength || totalText != textLength) {
+        free(counts);
+        return 0;
+    }
+
+    // ": " or CRLF after every name and value
+    required += (size_t)textLength + (size_t)headerLength * 2;
+    if (required > (size_t)capacity) {
+        free(counts);
+        return required > INT_MAX ? -INT_MAX : -(jint)required;
+    }
+
+    const char* text = NULL;
+    if (headerText != NULL) {
+        text = (const char*)(*env)->GetPrimitiveArrayCritical(env, headerText, NULL);
+        if (text == NULL) {
+            free(counts);
+            return 0;
+        }
+    }
+
+    char* cursor = buffer;
+    jsize header = 0;
+    size_t textOffset = 0;
+    int valid = 1;
+    for (jsize part = 0; part < partCount && valid; part++) {
+        if (part > 0) {
+            *cursor++ = '\r';
+            *cursor++ = '\n';
+        }
+        *cursor++ = '-';
+        *cursor++ = '-';
+        memcpy(cursor, delimiter, boundaryLength);
+        cursor += boundaryLength;
+        *cursor++ = '\r';
+        *cursor++ = '\n';
+
+        for (jint h = 0; h < counts[part] * 2; h++, header++) {
+            const char* chars = text + textOffset;
+            size_t len = (size_t)lengths[header];
+            textOffset += len;
+            if ((len == 0 && h % 2 == 0) || containsLineBreak(chars, len)) {
+                valid = 0;
+                break;
+            }
+            memcpy(cursor, chars, len);
+            cursor += len;
+            memcpy(cursor, h % 2 == 0 ? ": " : "\r\n", 2);
+            cursor += 2;
+        }
+
+        *cursor++ = '\r';
+        *cursor++ = '\n';
+        ends[part] = (jint)(cursor - buffer);
+    }
+    if (text != NULL) {
+        (*env)->ReleasePrimitiveArrayCritical(env, headerText, (void*)text, JNI_ABORT);
+    }
+    if (!valid) {
+        free(counts);
+        return 0;
+    }
+
+    memcpy(cursor, "\r\n--", 4);
+    cursor += 4;
+    memcpy(cursor, delimiter, boundaryLength);
+    cursor += boundaryLength;
+    memcpy(cursor, "--\r\n", 4);
+    cursor += 4;
+    ends[partCount] = (jint)(cursor - buffer);
+
+    (*env)->SetIntArrayRegion(env, frameEnds, 0, partCount + 1, ends);
+    free(counts);
+    return (jint)(cursor - buffer);
+}
@@ -0,0 +1,131 @@
+#include "blyfastnative.h"
+
+/**
+ * Percent-decoding (RFC 3986 2.1) for paths, query strings and form bodies.
+ *
+ * Most components contain no escapes at all, and the rest are mostly long clean runs. The scanner
+ * (percent_scan.c) looks for '%' (and '+' when it means a space) a vector at a time, the runs
+ * between escapes are copied with memcpy, and an input without escapes is reported as unchanged
+ * so the caller can use the source bytes as they are.
+ */
+
+// Hex digit values, -1 for anything that is not a hex digit
+static const signed char hexValues[256] = {
+    ['0'] = 0 + 1, ['1'] = 1 + 1, ['2'] = 2 + 1, ['3'] = 3 + 1, ['4'] = 4 + 1,
+    ['5'] = 5 + 1, ['6'] = 6 + 1, ['7'] = 7 + 1, ['8'] = 8 + 1, ['9'] = 9 + 1,
+    ['A'] = 10 + 1, ['B'] = 11 + 1, ['C'] = 12 + 1, ['D'] = 13 + 1, ['E'] = 14 + 1, ['F'] = 15 + 1,
+    ['a'] = 10 + 1, ['b'] = 11 + 1, ['c'] = 12 + 1, ['d'] = 13 + 1, ['e'] = 14 + 1, ['f'] = 15 + 1,
+};
+
+// Stored off by one so the zero-initialized entries mean "not a hex digit"
+static inline int hexValue(unsigned char c) {
+    return hexValues[c] - 1;
+}
+
+/**
+ * Decodes `len` bytes of `src` into `dest`, which must have room for `len` bytes: %XX becomes
+ * the byte it encodes and, with `plusAsSpace`, '+' becomes a space. Malformed escapes are kept
+ * as they are.
+ *
+ * Returns the decoded length, or PERCENT_DECODE_UNCHANGED without touching `dest` if `src`
+ * contains nothing to decode.
+ */
+int percentDecode(char* dest, const char* src, int len, int plusAsSpace) {
+    int pos = findPercentEscape(src, 0, len, plusAsSpace);
+    if (pos == len) {
+        return PERCENT_DECODE_UNCHANGED;
+    }
+
+    memcpy(dest, src, pos);
+    int out = pos;
+    while (pos < len) {
+        // src[pos] is an escape character here
+        if (src[pos] == '+') {
+            dest[out++] = ' ';
+            pos++;
+        } else {
+            int high = pos + 2 < len ? hexValue((unsigned char)src[pos + 1]) : -1;
+            int low = high >= 0 ? hexValue((unsigned char)src[pos + 2]) : -1;
+            if (low >= 0) {
+                dest[out++] = (char)((high << 4) | low);
+                pos += 3;
+            } else {
+                dest[out++] = '%';
+                pos++;
+            }
+        }
+
+        // Bulk-copy the clean run up to the next escape
+        int next = findPercentEscape(src, pos, len, plusAsSpace);
+        memcpy(dest + out, src + pos, next - pos);
+        out += next - pos;
+        pos = next;
+    }
+    return out;
+}
+
+/**
+ * Percent-decodes `length` bytes of `src` starting at `offset` into `dest`, which must hold at
+ * least `length` bytes.
+ *
+ * Returns the decoded length, PERCENT_DECODE_UNCHANGED (-1) if the input has nothing to decode
+ * and `dest` was not written, or -2 if the arguments are invalid.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativePercentDecode
+  (JNIEnv *env, jclass cls, jbyteArray src, jint offset, jint length, jbyteArray dest,
+   jboolean plusAsSpace) {
+    if (src == NULL || dest == NULL || offset < 0 || length < 0 ||
+        offset > (*env)->GetArrayLength(env, src) - length ||
+        length > (*env)->GetArrayLength(env, dest)) {
+        return -2;
+    }
+
+    // Both arrays are short-lived scratch data and decoding does not call back into the JVM
+    char* in = (char*)(*env)->GetPrimitiveArrayCritical(env, src, NULL);
+    if (in == NULL) {
+        return -2;
+    }
+    char* out = (char*)(*env)->GetPrimitiveArrayCritical(env, dest, NULL);
+    if (out == NULL) {
+        (*env)->ReleasePrimitiveArrayCritical(env, src, in, JNI_ABORT);
+        return -2;
+    }
+
+    int decoded = percentDecode(out, in + offset, length, plusAsSpace == JNI_TRUE);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, dest, out,
+                                          decoded == PERCENT_DECODE_UNCHANGED ? JNI_ABORT : 0);
+    (*env)->ReleasePrimitiveArrayCritical(env, src, in, JNI_ABORT);
+    return decoded;
+}
+
+/**
+ * Percent-decodes `length` bytes of a direct ByteBuffer starting at `offset` into `dest`, so
+ * fields of a request body are decoded without first copying them out of the buffer.
+ *
+ * Returns the decoded length, PERCENT_DECODE_UNCHANGED (-1) if the input has nothing to decode
+ * and `dest` was not written, or -2 if the arguments are invalid.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativePercentDecodeDirect
+  (JNIEnv *env, jclass cls, jobject src, jint offset, jint length, jbyteArray dest,
+   jboolean plusAsSpace) {
+    if (src == NULL || dest == NULL || offset < 0 || length < 0 ||
+        length > (*env)->GetArrayLength(env, dest)) {
+        return -2;
+    }
+    char* in = (char*)(*env)->GetDirectBufferAddress(env, src);
+    if (in == NULL || offset > (*env)->GetDirectBufferCapacity(env, src) - length) {
+        return -2;
+    }
+
+    char* out = (char*)(*env)->GetPrimitiveArrayCritical(env, dest, NULL);
+    if (out == NULL) {
+        return -2;
+    }
+
+    int decoded = percentDecode(out, in + offset, length, plusAsSpace == JNI_TRUE);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, dest, out,
+                                          decoded == PERCENT_DECODE_UNCHANGED ? JNI_ABORT : 0);
+    return decoded;
+}
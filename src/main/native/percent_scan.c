@@ -0,0 +1,82 @@
+#include "blyfastnative.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Vector scan for percent-decoding (percent_decode.c): most of the input is clean runs between
+ * escapes, so finding the next escape is where decoding spends its time.
+ */
+
+/**
+ * Finds the first '%' at or after `pos`, or the first '+' as well when `plusAsSpace` is set.
+ * Returns `len` if there is none.
+ */
+int SIMD_KERNEL(findPercentEscape)(const char* src, int pos, int len, int plusAsSpace) {
+    const unsigned char* s = (const unsigned char*)src;
+    const unsigned char plus = plusAsSpace ? '+' : '%';
+
+#if defined(__AVX512BW__)
+    const __m512i percent64 = _mm512_set1_epi8('%');
+    const __m512i plus64 = _mm512_set1_epi8((char)plus);
+    for (; pos + 64 <= len; pos += 64) {
+        __m512i chunk = _mm512_loadu_si512((const void*)(s + pos));
+        uint64_t mask = _mm512_cmpeq_epi8_mask(chunk, percent64) |
+                        _mm512_cmpeq_epi8_mask(chunk, plus64);
+        if (mask != 0) {
+            return pos + __builtin_ctzll(mask);
+        }
+    }
+#endif
+#if defined(__AVX2__)
+    const __m256i percent32 = _mm256_set1_epi8('%');
+    const __m256i plus32 = _mm256_set1_epi8((char)plus);
+    for (; pos + 32 <= len; pos += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(s + pos));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percent32),
+                                       _mm256_cmpeq_epi8(chunk, plus32));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i percent16 = _mm_set1_epi8('%');
+    const __m128i plus16 = _mm_set1_epi8((char)plus);
+    for (; pos + 16 <= len; pos += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(s + pos));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent16),
+                                    _mm_cmpeq_epi8(chunk, plus16));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t percent16 = vdupq_n_u8('%');
+    const uint8x16_t plus16 = vdupq_n_u8(plus);
+    for (; pos + 16 <= len; pos += 16) {
+        uint8x16_t chunk = vld1q_u8(s + pos);
+        uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, percent16), vceqq_u8(chunk, plus16));
+        // Narrow to four bits per byte so the match mask fits in one 64-bit lane
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if (mask != 0) {
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+#endif
+
+    for (; pos < len; pos++) {
+        if (s[pos] == '%' || s[pos] == plus) {
+            return pos;
+        }
+    }
+    return len;
+}
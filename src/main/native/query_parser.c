@@ -0,0 +1,86 @@
+#include "blyfastnative.h"
+
+/**
+ * Query string tokenizer (application/x-www-form-urlencoded, as used in request URIs and form
+ * bodies).
+ *
+ * Produces an offset index instead of strings: for each parameter, the offsets and lengths of its
+ * name and value inside the raw query bytes, plus flags telling whether either needs decoding.
+ * Parameters are separated by '&'; a parameter without '=' has an empty value and empty segments
+ * or names are skipped. Nothing is decoded here, so unread parameters cost no allocation.
+ */
+
+// Returns QUERY_*_ENCODED `flag` if the range holds a percent escape or '+'
+static inline int encodedFlag(const unsigned char* s, int len, int flag) {
+    return memchr(s, '%', len) != NULL || memchr(s, '+', len) != NULL ? flag : 0;
+}
+
+/**
+ * Tokenizes `length` bytes of a raw query string into `index`.
+ *
+ * Returns the number of parameters found, or the negated count if `index` has room for fewer.
+ */
+int tokenizeQuery(const unsigned char* query, int length, jint* index, int maxParams) {
+    int count = 0;
+    int pos = 0;
+
+    while (pos < length) {
+        const unsigned char* ampersand = memchr(query + pos, '&', length - pos);
+        int segmentEnd = ampersand ? (int)(ampersand - query) : length;
+
+        if (segmentEnd > pos) {
+            const unsigned char* equals = memchr(query + pos, '=', segmentEnd - pos);
+            int nameEnd = equals ? (int)(equals - query) : segmentEnd;
+            int valueStart = equals ? nameEnd + 1 : segmentEnd;
+
+            if (nameEnd > pos) {
+                if (count < maxParams) {
+                    jint* entry = index + count * QUERY_INDEX_ENTRY_INTS;
+                    entry[0] = pos;
+                    entry[1] = nameEnd - pos;
+                    entry[2] = valueStart;
+                    entry[3] = segmentEnd - valueStart;
+                    entry[4] = encodedFlag(query + pos, nameEnd - pos, QUERY_NAME_ENCODED) |
+                               encodedFlag(query + valueStart, segmentEnd - valueStart,
+                                           QUERY_VALUE_ENCODED);
+                }
+                count++;
+            }
+        }
+
+        pos = segmentEnd + 1;
+    }
+
+    return count <= maxParams ? count : -count;
+}
+
+/**
+ * Tokenizes a raw query string held in a byte array into an int array index of
+ * [name_off, name_len, value_off, value_len, flags] entries
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeParseQuery
+  (JNIEnv *env, jclass cls, jbyteArray query, jint length, jintArray index) {
+    if (query == NULL || index == NULL || length < 0 ||
+        length > (*env)->GetArrayLength(env, query)) {
+        return 0;
+    }
+
+    int maxParams = (*env)->GetArrayLength(env, index) / QUERY_INDEX_ENTRY_INTS;
+
+    // Both arrays are small and the scan does not call back into the JVM
+    unsigned char* bytes = (unsigned char*)(*env)->GetPrimitiveArrayCritical(env, query, NULL);
+    if (bytes == NULL) {
+        return 0;
+    }
+    jint* entries = (jint*)(*env)->GetPrimitiveArrayCritical(env, index, NULL);
+    if (entries == NULL) {
+        (*env)->ReleasePrimitiveArrayCritical(env, query, bytes, JNI_ABORT);
+        return 0;
+    }
+
+    int count = tokenizeQuery(bytes, length, entries, maxParams);
+
+    (*env)->ReleasePrimitiveArrayCritical(env, index, entries, 0);
+    (*env)->ReleasePrimitiveArrayCritical(env, query, bytes, JNI_ABORT);
+    return count;
+}
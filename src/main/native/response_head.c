@@ -0,0 +1,322 @@
+#include "blyfastnative.h"
+#include <time.h>
+
+/**
+ * HTTP/1.1 response head serializer.
+ *
+ * Writes the status line and headers into a direct buffer in one call. Header sets that are
+ * identical on every response are registered once and stored pre-serialized, so writing them is a
+ * single memcpy. The Date header is formatted by a once-per-second tick rather than per response.
+ */
+
+// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+#define DATE_HEADER_LEN 37
+
+typedef struct {
+    char* data;         // "Name: value\r\n" lines
+    int length;
+} ResponseHeaderSet;
+
+static ResponseHeaderSet headerSets[MAX_RESPONSE_HEADER_SETS];
+static int headerSetCount = 0;
+static pthread_mutex_t headerSetsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Double-buffered so writers never see a line that is being reformatted
+static char dateHeaders[2][DATE_HEADER_LEN];
+static int currentDateHeader = 0;
+static int64_t dateHeaderSecond = -1;
+static pthread_mutex_t dateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const DAY_NAMES[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char* const MONTH_NAMES[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+static const char* reasonPhrase(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 409: return "Conflict";
+        case 410: return "Gone";
+        case 413: return "Content Too Large";
+        case 415: return "Unsupported Media Type";
+        case 422: return "Unprocessable Content";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "";
+    }
+}
+
+static void writeTwoDigits(char* dest, int value) {
+    dest[0] = (char)('0' + value / 10);
+    dest[1] = (char)('0' + value % 10);
+}
+
+// Formats the Date line for `second` into the spare buffer and publishes it
+static void updateDateHeader(int64_t second) {
+    pthread_mutex_lock(&dateMutex);
+    if (second != dateHeaderSecond) {
+        time_t t = (time_t)second;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+
+        // IMF-fixdate (RFC 9110 5.6.7), always exactly DATE_HEADER_LEN bytes
+        int spare = 1 - __atomic_load_n(&currentDateHeader, __ATOMIC_RELAXED);
+        char* line = dateHeaders[spare];
+        int year = (tm.tm_year + 1900) % 10000;
+        memcpy(line, "Date: ", 6);
+        memcpy(line + 6, DAY_NAMES[tm.tm_wday], 3);
+        memcpy(line + 9, ", ", 2);
+        writeTwoDigits(line + 11, tm.tm_mday);
+        line[13] = ' ';
+        memcpy(line + 14, MONTH_NAMES[tm.tm_mon], 3);
+        line[17] = ' ';
+        writeTwoDigits(line + 18, year / 100);
+        writeTwoDigits(line + 20, year % 100);
+        line[22] = ' ';
+        writeTwoDigits(line + 23, tm.tm_hour);
+        line[25] = ':';
+        writeTwoDigits(line + 26, tm.tm_min);
+        line[28] = ':';
+        writeTwoDigits(line + 29, tm.tm_sec);
+        memcpy(line + 31, " GMT\r\n", 6);
+        __atomic_store_n(&currentDateHeader, spare, __ATOMIC_RELEASE);
+        __atomic_store_n(&dateHeaderSecond, second, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&dateMutex);
+}
+
+static const char* currentDateLine(void) {
+    // Until the first tick, format on demand
+    if (__atomic_load_n(&dateHeaderSecond, __ATOMIC_ACQUIRE) < 0) {
+        updateDateHeader((int64_t)time(NULL));
+    }
+    return dateHeaders[__atomic_load_n(&currentDateHeader, __ATOMIC_ACQUIRE)];
+}
+
+/**
+ * Refreshes the cached Date header; called once per second by the Java tick
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeUpdateDateHeader
+  (JNIEnv *env, jclass cls, jlong epochSecond) {
+    updateDateHeader((int64_t)epochSecond);
+}
+
+/**
+ * Registers a header set (alternating names and values) that is written verbatim after the
+ * status line. Returns its ID, or 0 if the set is invalid or the registry is full.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeRegisterResponseHeaders
+  (JNIEnv *env, jclass cls, jobjectArray namesAndValues) {
+    if (namesAndValues == NULL) {
+        return 0;
+    }
+
+    jsize length = (*env)->GetArrayLength(env, namesAndValues);
+    if (length == 0 || length % 2 != 0) {
+        return 0;
+    }
+
+    size_t capacity = 256;
+    size_t used = 0;
+    char* data = (char*)malloc(capacity);
+    if (!data) {
+        return 0;
+    }
+
+    int valid = 1;
+    for (jsize i = 0; i < length && valid; i++) {
+        jstring str = (jstring)(*env)->GetObjectArrayElement(env, namesAndValues, i);
+        if (str == NULL) {
+            valid = 0;
+            break;
+        }
+        const char* chars = (*env)->GetStringUTFChars(env, str, NULL);
+        if (chars == NULL) {
+            (*env)->DeleteLocalRef(env, str);
+            valid = 0;
+            break;
+        }
+
+        size_t len = strlen(chars);
+        // Room for the text plus ": " or "\r\n"
+        if (used + len + 2 > capacity) {
+            while (used + len + 2 > capacity) {
+                capacity *= 2;
+            }
+            char* grown = (char*)realloc(data, capacity);
+            if (!grown) {
+                valid = 0;
+            } else {
+                data = grown;
+            }
+        }
+        // Field values and names must not be able to inject extra lines
+        if (valid && ((len == 0 && i % 2 == 0) || containsLineBreak(chars, len))) {
+            valid = 0;
+        }
+        if (valid) {
+            memcpy(data + used, chars, len);
+            used += len;
+            memcpy(data + used, i % 2 == 0 ? ": " : "\r\n", 2);
+            used += 2;
+        }
+
+        (*env)->ReleaseStringUTFChars(env, str, chars);
+        (*env)->DeleteLocalRef(env, str);
+    }
+
+    jint id = 0;
+    if (valid) {
+        pthread_mutex_lock(&headerSetsMutex);
+        if (headerSetCount < MAX_RESPONSE_HEADER_SETS) {
+            headerSets[headerSetCount].data = data;
+            headerSets[headerSetCount].length = (int)used;
+            __atomic_store_n(&headerSetCount, headerSetCount + 1, __ATOMIC_RELEASE);
+            id = headerSetCount;
+        }
+        pthread_mutex_unlock(&headerSetsMutex);
+    }
+
+    if (id == 0) {
+        free(data);
+    }
+    return id;
+}
+
+/**
+ * Writes a complete response head: status line, Date, the registered header set `headerSetId`
+ * (0 for none), Content-Length when `contentLength` >= 0, the `extra` headers (alternating names
+ * and values, may be null) and the terminating blank line.
+ *
+ * Returns the number of bytes written, the negated required size if `out` is too small, or 0 on
+ * invalid arguments (including header text containing CR or LF).
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeWriteResponseHead
+  (JNIEnv *env, jclass cls, jobject out, jint offset, jint status, jint headerSetId,
+   jlong contentLength, jobjectArray extra) {
+    if (out == NULL || offset < 0 || status < 100 || status > 999 || headerSetId < 0 ||
+        headerSetId > __atomic_load_n(&headerSetCount, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    char* buffer = (char*)(*env)->GetDirectBufferAddress(env, out);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, out);
+    if (buffer == NULL || offset > capacity) {
+        return 0;
+    }
+
+    jsize extraLength = extra != NULL ? (*env)->GetArrayLength(env, extra) : 0;
+    if (extraLength % 2 != 0) {
+        return 0;
+    }
+
+    const char* reason = reasonPhrase(status);
+    size_t reasonLen = strlen(reason);
+    char lengthDigits[24];
+    int lengthDigitsLen = contentLength >= 0
+        ? snprintf(lengthDigits, sizeof(lengthDigits), "%lld", (long long)contentLength) : 0;
+
+    // "HTTP/1.1 200 " + reason + CRLF, Date, registered set, Content-Length, final CRLF
+    size_t required = 13 + reasonLen + 2 + DATE_HEADER_LEN + 2;
+    if (headerSetId > 0) {
+        required += headerSets[headerSetId - 1].length;
+    }
+    if (contentLength >= 0) {
+        required += 16 + lengthDigitsLen + 2;
+    }
+
+    // Extra headers are measured first so a too-small buffer is reported before writing
+    for (jsize i = 0; i < extraLength; i++) {
+        jstring str = (jstring)(*env)->GetObjectArrayElement(env, extra, i);
+        if (str == NULL) {
+            return 0;
+        }
+        required += (*env)->GetStringUTFLength(env, str) + 2;
+        (*env)->DeleteLocalRef(env, str);
+    }
+    if (required > (size_t)(capacity - offset)) {
+        return required > INT_MAX ? -INT_MAX : -(jint)required;
+    }
+
+    char* cursor = buffer + offset;
+    memcpy(cursor, "HTTP/1.1 ", 9);
+    cursor[9] = (char)('0' + status / 100);
+    cursor[10] = (char)('0' + status / 10 % 10);
+    cursor[11] = (char)('0' + status % 10);
+    cursor[12] = ' ';
+    cursor += 13;
+    memcpy(cursor, reason, reasonLen);
+    cursor += reasonLen;
+    *cursor++ = '\r';
+    *cursor++ = '\n';
+
+    memcpy(cursor, currentDateLine(), DATE_HEADER_LEN);
+    cursor += DATE_HEADER_LEN;
+
+    if (headerSetId > 0) {
+        ResponseHeaderSet* set = &headerSets[headerSetId - 1];
+        memcpy(cursor, set->data, set->length);
+        cursor += set->length;
+    }
+
+    if (contentLength >= 0) {
+        memcpy(cursor, "Content-Length: ", 16);
+        cursor += 16;
+        memcpy(cursor, lengthDigits, lengthDigitsLen);
+        cursor += lengthDigitsLen;
+        *cursor++ = '\r';
+        *cursor++ = '\n';
+    }
+
+    for (jsize i = 0; i < extraLength; i++) {
+        jstring str = (jstring)(*env)->GetObjectArrayElement(env, extra, i);
+        const char* chars = str != NULL ? (*env)->GetStringUTFChars(env, str, NULL) : NULL;
+        if (chars == NULL) {
+            if (str != NULL) {
+                (*env)->DeleteLocalRef(env, str);
+            }
+            return 0;
+        }
+
+        size_t len = strlen(chars);
+        // Same check as at registration: no CR/LF, no empty names
+        int invalid = containsLineBreak(chars, len) || (len == 0 && i % 2 == 0);
+        if (!invalid) {
+            memcpy(cursor, chars, len);
+            cursor += len;
+            memcpy(cursor, i % 2 == 0 ? ": " : "\r\n", 2);
+            cursor += 2;
+        }
+
+        (*env)->ReleaseStringUTFChars(env, str, chars);
+        (*env)->DeleteLocalRef(env, str);
+        if (invalid) {
+            return 0;
+        }
+    }
+
+    *cursor++ = '\r';
+    *cursor++ = '\n';
+    return (jint)(cursor - (buffer + offset));
+}
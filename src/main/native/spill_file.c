@@ -0,0 +1,252 @@
+#define _GNU_SOURCE // O_TMPFILE and fallocate
+#include "blyfastnative.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Spill files for large multipart uploads.
+ *
+ * Part content above the configured threshold is written to an anonymous O_TMPFILE file instead
+ * of the heap. The file is preallocated with fallocate from the request's Content-Length, which
+ * is an upper bound that is trimmed once the part ends, and content is coalesced into
+ * SPILL_WRITE_BUFFER_SIZE writes. Saving links the file into the filesystem instead of copying
+ * it; a file that is never saved disappears when it is closed, even if the process dies.
+ */
+
+#if defined(__linux__) && defined(O_TMPFILE)
+
+typedef struct {
+    int fd;
+    int used;                       // Bytes pending in buffer
+    jlong written;                  // Bytes written to the file
+    unsigned char buffer[SPILL_WRITE_BUFFER_SIZE];
+} SpillFile;
+
+// Writes all of data, retrying short and interrupted writes. Returns 0 or a negated errno.
+static int writeFully(SpillFile* file, const unsigned char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(file->fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        data += n;
+        length -= (size_t)n;
+        file->written += n;
+    }
+    return 0;
+}
+
+static int flushSpillFile(SpillFile* file) {
+    int result = writeFully(file, file->buffer, (size_t)file->used);
+    file->used = 0;
+    return result;
+}
+
+/**
+ * Creates an anonymous spill file in `directory`, preallocating `sizeHint` bytes when positive.
+ * Returns a handle, or 0 if the filesystem does not support O_TMPFILE or the file cannot be
+ * created; callers then fall back to a named temporary file.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileCreate
+  (JNIEnv *env, jclass cls, jstring directory, jlong sizeHint) {
+    if (directory == NULL) {
+        return 0;
+    }
+    const char* path = (*env)->GetStringUTFChars(env, directory, NULL);
+    if (path == NULL) {
+        return 0;
+    }
+    int fd = open(path, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    (*env)->ReleaseStringUTFChars(env, directory, path);
+    if (fd < 0) {
+        return 0;
+    }
+
+    // Best effort: reserves contiguous extents up front. Unlike posix_fallocate this never falls
+    // back to writing zeros on filesystems without support.
+    if (sizeHint > 0) {
+        (void)fallocate(fd, 0, 0, (off_t)sizeHint);
+    }
+
+    SpillFile* file = (SpillFile*)malloc(sizeof(SpillFile));
+    if (file == NULL) {
+        close(fd);
+        return 0;
+    }
+    file->fd = fd;
+    file->used = 0;
+    file->written = 0;
+    return (jlong)(intptr_t)file;
+}
+
+/**
+ * Appends `length` bytes at `offset` in a direct buffer to a spill file. Small writes are
+ * coalesced; writes of at least a whole buffer go straight to the file. Returns 0 or a negated
+ * errno.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileWrite
+  (JNIEnv *env, jclass cls, jlong fileHandle, jobject buffer, jint offset, jint length) {
+    SpillFile* file = (SpillFile*)(intptr_t)fileHandle;
+    if (file == NULL || buffer == NULL || offset < 0 || length < 0) {
+        return -EINVAL;
+    }
+    unsigned char* data = (unsigned char*)(*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (data == NULL || (jlong)offset + length > capacity) {
+        return -EINVAL;
+    }
+    data += offset;
+
+    if ((jlong)file->used + length <= SPILL_WRITE_BUFFER_SIZE) {
+        memcpy(file->buffer + file->used, data, (size_t)length);
+        file->used += length;
+        if (file->used < SPILL_WRITE_BUFFER_SIZE) {
+            return 0;
+        }
+        return flushSpillFile(file);
+    }
+
+    int result = flushSpillFile(file);
+    if (result < 0) {
+        return result;
+    }
+    if (length >= SPILL_WRITE_BUFFER_SIZE) {
+        return writeFully(file, data, (size_t)length);
+    }
+    memcpy(file->buffer, data, (size_t)length);
+    file->used = length;
+    return 0;
+}
+
+/**
+ * Writes out pending content and trims the preallocated space past it. Returns the file size or
+ * a negated errno.
+ */
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileFinish
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+    SpillFile* file = (SpillFile*)(intptr_t)fileHandle;
+    if (file == NULL) {
+        return -EINVAL;
+    }
+    int result = flushSpillFile(file);
+    if (result < 0) {
+        return result;
+    }
+    if (ftruncate(file->fd, (off_t)file->written) != 0) {
+        return -errno;
+    }
+    return file->written;
+}
+
+/**
+ * Gets the descriptor of a spill file, which can be opened again through /proc/self/fd.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileDescriptor
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+    SpillFile* file = (SpillFile*)(intptr_t)fileHandle;
+    return file != NULL ? file->fd : -1;
+}
+
+/**
+ * Links a finished spill file at `target`, atomically replacing an existing file, without
+ * copying its content. The spill file stays open and can be linked again. Returns 0 or a negated
+ * errno; -EXDEV means the target is on another filesystem and the content must be copied.
+ */
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileLink
+  (JNIEnv *env, jclass cls, jlong fileHandle, jstring target) {
+    SpillFile* file = (SpillFile*)(intptr_t)fileHandle;
+    if (file == NULL || target == NULL) {
+        return -EINVAL;
+    }
+    char source[32];
+    snprintf(source, sizeof(source), "/proc/self/fd/%d", file->fd);
+
+    const char* path = (*env)->GetStringUTFChars(env, target, NULL);
+    if (path == NULL) {
+        return -ENOMEM;
+    }
+    int result = 0;
+    if (linkat(AT_FDCWD, source, AT_FDCWD, path, AT_SYMLINK_FOLLOW) != 0) {
+        result = -errno;
+    }
+
+    // linkat never replaces; link under a temporary name next to the target and rename over it
+    if (result == -EEXIST) {
+        size_t pathLength = strlen(path);
+        char* temporary = (char*)malloc(pathLength + 32);
+        if (temporary == NULL) {
+            result = -ENOMEM;
+        } else {
+            for (int attempt = 0; result == -EEXIST && attempt < 100; attempt++) {
+                snprintf(temporary, pathLength + 32, "%s.%d-%d.tmp", path, (int)getpid(),
+                         attempt);
+                result = linkat(AT_FDCWD, source, AT_FDCWD, temporary, AT_SYMLINK_FOLLOW) == 0
+                             ? 0
+                             : -errno;
+            }
+            if (result == 0 && rename(temporary, path) != 0) {
+                result = -errno;
+                unlink(temporary);
+            }
+            free(temporary);
+        }
+    }
+
+    (*env)->ReleaseStringUTFChars(env, target, path);
+    return result;
+}
+
+/**
+ * Closes a spill file created by nativeSpillFileCreate. Its content is discarded unless it was
+ * linked.
+ */
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileFree
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+    SpillFile* file = (SpillFile*)(intptr_t)fileHandle;
+    if (file != NULL) {
+        close(file->fd);
+        free(file);
+    }
+}
+
+#else
+
+// Without O_TMPFILE no spill file can be created and the Java side uses named temporary files
+
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileCreate
+  (JNIEnv *env, jclass cls, jstring directory, jlong sizeHint) {
+    return 0;
+}
+
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileWrite
+  (JNIEnv *env, jclass cls, jlong fileHandle, jobject buffer, jint offset, jint length) {
+    return -1;
+}
+
+JNIEXPORT jlong JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileFinish
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+    return -1;
+}
+
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileDescriptor
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+    return -1;
+}
+
+JNIEXPORT jint JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileLink
+  (JNIEnv *env, jclass cls, jlong fileHandle, jstring target) {
+    return -1;
+}
+
+JNIEXPORT void JNICALL Java_com_blyfast_nativeopt_NativeOptimizer_nativeSpillFileFree
+  (JNIEnv *env, jclass cls, jlong fileHandle) {
+}
+
+#endif
@@ -22,6 +22,25 @@ void freeHeadersList(HeaderValue* header) {
     }
 }
 
+// FNV-1a hash over the ASCII-lowercased header name
+uint32_t headerNameHash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Checks whether header text contains CR or LF, which would allow response splitting
+int containsLineBreak(const char* str, size_t len) {
+    return memchr(str, '\r', len) != NULL || memchr(str, '\n', len) != NULL;
+}
+
 // Helper function to convert hex character to integer
 int hexCharToInt(char c) {
     if (c >= '0' && c <= '9') return c - '0';
@@ -59,49 +78,77 @@ const char* strcasestr_portable(const char* haystack, const char* needle) {
     return NULL;
 }
 
-// URL decode function - decodes %XX sequences with bounds checking
+// URL decode function - decodes %XX sequences and '+' into a NUL-terminated copy
 int urlDecode(char* dest, const char* src, int len) {
     if (dest == NULL || src == NULL || len < 0) {
         return 0;
     }
     
-    int i, j = 0;
-    // Maximum expansion is 1:1 (no expansion), but we need space for null terminator
-    int maxDestLen = len + 1;
-    
-    for (i = 0; i < len && j < maxDestLen - 1; i++) {
-        if (src[i] == '%' && i + 2 < len) {
-            int high = hexCharToInt(src[i + 1]);
-            int low = hexCharToInt(src[i + 2]);
-            if (high >= 0 && low >= 0) {
-                if (j < maxDestLen - 1) {
-                    dest[j++] = (char)((high << 4) | low);
-                    i += 2;
-                } else {
-                    break; // Buffer full
-                }
-            } else {
-                if (j < maxDestLen - 1) {
-                    dest[j++] = src[i];
-                } else {
-                    break;
-                }
-            }
-        } else if (src[i] == '+') {
-            if (j < maxDestLen - 1) {
-                dest[j++] = ' ';
-            } else {
-                break;
-            }
-        } else {
-            if (j < maxDestLen - 1) {
-                dest[j++] = src[i];
-            } else {
-                break;
-            }
+    int decoded = percentDecode(dest, src, len, 1);
+    if (decoded == PERCENT_DECODE_UNCHANGED) {
+        memcpy(dest, src, len);
+        decoded = len;
+    }
+    dest[decoded] = '\0';
+    return decoded;
+}
+
+
+/**
+ * Starts an arena that allocates from `initial` (typically a stack buffer, may be NULL) before
+ * falling back to heap blocks of doubling size.
+ */
+void arenaInit(Arena* arena, void* initial, size_t initialSize) {
+    arena->cursor = (unsigned char*)initial;
+    arena->limit = initial != NULL ? (unsigned char*)initial + initialSize : NULL;
+    arena->blocks = NULL;
+    arena->nextBlockSize = ARENA_MIN_BLOCK_SIZE;
+}
+
+/**
+ * Allocates `size` bytes aligned to ARENA_ALIGNMENT. The memory lives until arenaRelease.
+ * Returns NULL if allocation fails.
+ */
+void* arenaAlloc(Arena* arena, size_t size) {
+    if (arena->cursor != NULL) {
+        uintptr_t start = ((uintptr_t)arena->cursor + ARENA_ALIGNMENT - 1)
+                          & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+        if (start <= (uintptr_t)arena->limit && size <= (uintptr_t)arena->limit - start) {
+            arena->cursor = (unsigned char*)(start + size);
+            return (void*)start;
         }
     }
-    dest[j] = '\0';
-    return j;
+
+    if (size > SIZE_MAX / 2 - ARENA_ALIGNMENT - sizeof(ArenaBlock)) {
+        return NULL;
+    }
+    size_t blockSize = arena->nextBlockSize;
+    while (blockSize < size + ARENA_ALIGNMENT) {
+        blockSize *= 2;
+    }
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockSize);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->nextBlockSize = blockSize < ARENA_MAX_BLOCK_SIZE ? blockSize * 2 : blockSize;
+    arena->cursor = block->data;
+    arena->limit = block->data + blockSize;
+    return arenaAlloc(arena, size);
 }
 
+/**
+ * Frees every heap block of an arena at once. The initial buffer is left to its owner.
+ */
+void arenaRelease(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->cursor = NULL;
+    arena->limit = NULL;
+}
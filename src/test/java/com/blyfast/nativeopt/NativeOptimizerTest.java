@@ -2,12 +2,35 @@ package com.blyfast.nativeopt;
 
 import static org.junit.jupiter.api.Assertions.*;
 
+import com.blyfast.http.ClientAddress;
+import com.blyfast.http.ContentNegotiator;
+import com.blyfast.http.Cookies;
+import com.blyfast.http.FormData;
+import com.blyfast.http.MediaType;
+import com.blyfast.http.MultipartResponse;
+import com.blyfast.http.PercentDecoder;
+import com.blyfast.http.QueryParams;
+import com.blyfast.http.Request;
+import com.blyfast.http.ResponseHeadWriter;
+import com.blyfast.http.TrustedProxies;
+import java.io.IOException;
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Map;
+import java.util.Random;
+import java.util.stream.Stream;
 import org.junit.jupiter.api.BeforeAll;
 import org.junit.jupiter.api.DisplayName;
 import org.junit.jupiter.api.Nested;
 import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
 
 /**
  * Comprehensive unit tests for the NativeOptimizer class.
@@ -438,6 +461,38 @@ public class NativeOptimizerTest {
       NativeOptimizer.nativeFreeHeaders(headersId);
     }
 
+    @Test
+    @DisplayName("Should return repeated headers in order for large header sets")
+    void testGetHeaderValuesIndexed() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      // Enough headers to cross the native index threshold
+      StringBuilder headers = new StringBuilder("X-Forwarded-For: 10.0.0.1\r\n");
+      for (int i = 0; i < 48; i++) {
+        headers.append("X-Trace-").append(i).append(": span-").append(i).append("\r\n");
+      }
+      headers.append("x-forwarded-for: 10.0.0.2\r\n");
+      byte[] bytes = headers.toString().getBytes(StandardCharsets.UTF_8);
+
+      ByteBuffer buffer = ByteBuffer.allocateDirect(bytes.length);
+      buffer.put(bytes);
+      buffer.flip();
+
+      long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, bytes.length);
+      assertTrue(headersId > 0);
+
+      assertEquals("span-31", NativeOptimizer.nativeGetHeader(headersId, "x-trace-31"));
+      assertEquals("10.0.0.1", NativeOptimizer.nativeGetHeader(headersId, "X-Forwarded-For"));
+      assertArrayEquals(
+          new String[] {"10.0.0.1", "10.0.0.2"},
+          NativeOptimizer.nativeGetHeaderValues(headersId, "X-FORWARDED-FOR"));
+      assertNull(NativeOptimizer.nativeGetHeaderValues(headersId, "Missing"));
+
+      NativeOptimizer.nativeFreeHeaders(headersId);
+    }
+
     @Test
     @DisplayName("Should free headers correctly")
     void testFreeHeaders() {
@@ -462,6 +517,1480 @@ public class NativeOptimizerTest {
     }
   }
 
+  @Nested
+  @DisplayName("Header Export Tests")
+  class HeaderExportTests {
+
+    @Test
+    @DisplayName("Should export all headers in wire order")
+    void testExportHeaders() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      String headers =
+          "Host: example.com\r\n"
+              + "Set-Cookie: a=1\r\n"
+              + "Accept: */*\r\n"
+              + "Set-Cookie: b=2\r\n";
+
+      ByteBuffer buffer = ByteBuffer.allocateDirect(headers.length());
+      buffer.put(headers.getBytes(StandardCharsets.UTF_8));
+      buffer.flip();
+
+      long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, headers.length());
+      assertTrue(headersId > 0);
+
+      NativeHeaderMap map = NativeHeaderMap.export(headersId);
+      assertNotNull(map);
+      assertEquals(4, map.size());
+      assertEquals("Host", map.name(0));
+      assertEquals("example.com", map.value(0));
+      assertEquals("example.com", map.get("host"));
+      assertEquals(java.util.List.of("a=1", "b=2"), map.getAll("SET-COOKIE"));
+      assertFalse(map.contains("Content-Type"));
+      assertNull(map.get("Content-Type"));
+
+      NativeOptimizer.nativeFreeHeaders(headersId);
+    }
+
+    @Test
+    @DisplayName("Should report required size when buffer is too small")
+    void testExportHeadersBufferTooSmall() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      String headers = "Content-Type: application/json\r\n";
+
+      ByteBuffer buffer = ByteBuffer.allocateDirect(headers.length());
+      buffer.put(headers.getBytes(StandardCharsets.UTF_8));
+      buffer.flip();
+
+      long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, headers.length());
+      assertTrue(headersId > 0);
+
+      int required = NativeOptimizer.nativeExportHeaders(headersId, ByteBuffer.allocateDirect(4));
+      // 8 byte preamble + one 16 byte entry + "Content-Type" + "application/json"
+      assertEquals(-(8 + 16 + 12 + 16), required);
+
+      NativeOptimizer.nativeFreeHeaders(headersId);
+      assertEquals(
+          0, NativeOptimizer.nativeExportHeaders(headersId, ByteBuffer.allocateDirect(64)));
+    }
+    @Test
+    @DisplayName("Should serve request header lookups from the exported set")
+    void testRequestReadsExportedHeaders() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      String headers = "Host: example.com\r\nCookie: a=1\r\nX-Tag: x\r\nCookie: b=2\r\n";
+      ByteBuffer buffer = ByteBuffer.allocateDirect(headers.length());
+      buffer.put(headers.getBytes(StandardCharsets.UTF_8));
+      long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, headers.length());
+      NativeHeaderMap map = NativeHeaderMap.export(headersId);
+      NativeOptimizer.nativeFreeHeaders(headersId);
+
+      // Without an exchange, any lookup that reached Undertow's header map would fail
+      Request request = new Request(null);
+      request.setNativeHeaders(map);
+      assertEquals("example.com", request.getHeader("host"));
+      assertNull(request.getHeader("Accept"));
+      assertEquals(List.of("a=1", "b=2"), request.getHeaders("Cookie"));
+      assertEquals(List.of(), request.getHeaders("Accept"));
+      assertEquals("2", request.getCookie("b"));
+    }
+  }
+
+  @Nested
+  @DisplayName("HPACK Decoding Tests")
+  class HpackDecodingTests {
+
+    private ByteBuffer hex(String hex) {
+      ByteBuffer buffer = ByteBuffer.allocateDirect(hex.length() / 2);
+      for (int i = 0; i < hex.length(); i += 2) {
+        buffer.put((byte) Integer.parseInt(hex.substring(i, i + 2), 16));
+      }
+      buffer.flip();
+      return buffer;
+    }
+
+    @Test
+    @DisplayName("Should decode RFC 7541 C.4 requests with Huffman coding")
+    void testDecodeHuffmanRequests() throws Exception {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      try (HpackDecoder decoder = new HpackDecoder()) {
+        ByteBuffer first = hex("828684418cf1e3c2e5f23a6ba0ab90f4ff");
+        NativeHeaderMap map = decoder.decodeToMap(first, 0, first.remaining());
+        assertEquals(4, map.size());
+        assertEquals(":method", map.name(0));
+        assertEquals("GET", map.value(0));
+        assertEquals("www.example.com", map.get(":authority"));
+
+        // Second request references ":authority" through the dynamic table
+        ByteBuffer second = hex("828684be5886a8eb10649cbf");
+        map = decoder.decodeToMap(second, 0, second.remaining());
+        assertEquals("www.example.com", map.get(":authority"));
+        assertEquals("no-cache", map.get("cache-control"));
+      }
+    }
+
+    @Test
+    @DisplayName("Should reject malformed header blocks")
+    void testDecodeMalformed() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      try (HpackDecoder decoder = new HpackDecoder()) {
+        ByteBuffer invalidIndex = hex("80");
+        assertThrows(IOException.class, () -> decoder.decode(invalidIndex, 0, 1));
+
+        ByteBuffer truncated = hex("410f7777");
+        assertThrows(IOException.class, () -> decoder.decode(truncated, 0, 4));
+      }
+    }
+
+    @Test
+    @DisplayName("Should round-trip encoded responses and index cached header sets")
+    void testEncodeRoundTrip() throws Exception {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      int jsonHeaders = HpackEncoder.jsonResponseHeaders();
+      try (HpackEncoder encoder = new HpackEncoder();
+          HpackDecoder decoder = new HpackDecoder()) {
+        ByteBuffer first = encoder.encode(jsonHeaders, ":status", "200", "Content-Length", "2");
+        int firstLength = first.remaining();
+        NativeHeaderMap map = decoder.decodeToMap(first, 0, firstLength);
+        // Pseudo-headers precede the cached set's regular fields
+        assertEquals(":status", map.name(0));
+        assertEquals("200", map.value(0));
+        assertEquals("content-type", map.name(1));
+        assertEquals("application/json", map.get("content-type"));
+        assertEquals("DENY", map.get("x-frame-options"));
+        assertEquals("2", map.get("content-length"));
+
+        // Second response only references the dynamic table for the cached set
+        ByteBuffer second = encoder.encode(jsonHeaders, ":status", "200", "Content-Length", "2");
+        assertTrue(second.remaining() < firstLength / 4);
+        map = decoder.decodeToMap(second, 0, second.remaining());
+        assertEquals(":status", map.name(0));
+        assertEquals("nosniff", map.get("x-content-type-options"));
+        assertEquals("no-referrer-when-downgrade", map.get("referrer-policy"));
+      }
+
+      assertThrows(
+          IllegalStateException.class,
+          () -> HpackEncoder.registerHeaderSet("content-type", "text/plain", ":status", "200"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Response Head Tests")
+  class ResponseHeadTests {
+
+    @Test
+    @DisplayName("Should serialize status line, Date, registered and extra headers")
+    void testWriteResponseHead() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      int jsonHeaders = ResponseHeadWriter.register("Content-Type", "application/json");
+      ByteBuffer head = ResponseHeadWriter.write(404, jsonHeaders, 12, "X-Request-Id", "abc");
+      byte[] bytes = new byte[head.remaining()];
+      head.get(bytes);
+      String text = new String(bytes, StandardCharsets.US_ASCII);
+
+      assertTrue(text.startsWith("HTTP/1.1 404 Not Found\r\nDate: "));
+      assertTrue(text.matches("(?s).*Date: \\w{3}, \\d{2} \\w{3} \\d{4} [0-9:]{8} GMT\r\n.*"));
+      assertTrue(
+          text.endsWith(
+              "Content-Type: application/json\r\n"
+                  + "Content-Length: 12\r\n"
+                  + "X-Request-Id: abc\r\n\r\n"));
+    }
+
+    @Test
+    @DisplayName("Should reject header injection")
+    void testRejectLineBreaks() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      assertThrows(
+          IllegalArgumentException.class,
+          () -> ResponseHeadWriter.write(200, 0, -1, "X-Test", "a\r\nSet-Cookie: b"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Cookie Parsing Tests")
+  class CookieParsingTests {
+
+    @Test
+    @DisplayName("Should index cookies and decode only the value read")
+    void testParseCookies() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      Cookies cookies =
+          Cookies.parse(
+              " sid=abc123 ; theme = \"dark\";novalue; =x; empty=;  name=J%C3%BCrgen%20K ");
+
+      assertEquals(4, cookies.size());
+      assertEquals("sid", cookies.name(0));
+      assertEquals("abc123", cookies.get("sid"));
+      assertEquals("dark", cookies.get("theme"));
+      assertEquals("", cookies.get("empty"));
+      assertEquals("J\u00fcrgen K", cookies.get("name"));
+      assertEquals("J%C3%BCrgen%20K", cookies.getRaw("name"));
+      assertNull(cookies.get("SID"));
+      assertFalse(cookies.contains("novalue"));
+
+      // Raw UTF-8 bytes (as Undertow passes them, one char per byte) mean the same with or
+      // without an escape elsewhere in the value
+      Cookies raw = Cookies.parse("a=J\u00c3\u00bcrgen; b=J\u00c3\u00bcrgen%20K");
+      assertEquals("J\u00fcrgen", raw.get("a"));
+      assertEquals("J\u00fcrgen K", raw.get("b"));
+    }
+
+    @Test
+    @DisplayName("Should grow the index for large Cookie headers")
+    void testParseManyCookies() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      StringBuilder header = new StringBuilder();
+      for (int i = 0; i < 100; i++) {
+        header.append("c").append(i).append("=v").append(i).append("; ");
+      }
+
+      Cookies cookies = Cookies.parse(header.toString());
+      assertEquals(100, cookies.size());
+      assertEquals("v99", cookies.get("c99"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Content Negotiation Tests")
+  class ContentNegotiationTests {
+
+    @Test
+    @DisplayName("Should pick the offer matched with the highest q-value")
+    void testNegotiateMediaTypes() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      ContentNegotiator negotiator =
+          ContentNegotiator.mediaTypes("application/json", "text/html", "text/plain");
+
+      assertEquals("text/html", negotiator.selectOffer("text/*;q=0.5, text/html, */*;q=0.1"));
+      assertEquals("text/plain", negotiator.selectOffer("text/*;q=0.5, text/html;q=0.2"));
+      assertEquals("application/json", negotiator.selectOffer("*/*"));
+      assertEquals("application/json", negotiator.selectOffer(null));
+      assertEquals(-1, negotiator.select("image/png"));
+      assertEquals(-1, negotiator.select("text/*;q=0, application/*;q=0"));
+    }
+
+    @Test
+    @DisplayName("Should honour q=0 and keep identity acceptable for encodings")
+    void testNegotiateEncodings() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      ContentNegotiator negotiator = ContentNegotiator.encodings("gzip", "deflate", "identity");
+
+      assertEquals("gzip", negotiator.selectOffer("deflate, gzip"));
+      assertEquals("deflate", negotiator.selectOffer("gzip;q=0, deflate"));
+      assertEquals("deflate", negotiator.selectOffer("GZIP;q=0.1, Deflate;q=0.8"));
+      assertEquals("identity", negotiator.selectOffer("br"));
+      assertEquals("identity", negotiator.selectOffer(""));
+      assertNull(negotiator.selectOffer("identity;q=0, br"));
+      // A repeated value is answered from the cache with the same result
+      assertEquals("deflate", negotiator.selectOffer("gzip;q=0, deflate"));
+    }
+
+    @Test
+    @DisplayName("Should match language ranges by prefix")
+    void testNegotiateLanguages() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      ContentNegotiator negotiator = ContentNegotiator.languages("en-US", "fr", "de");
+
+      assertEquals("fr", negotiator.selectOffer("fr-CH, fr;q=0.9, en;q=0.8"));
+      assertEquals("en-US", negotiator.selectOffer("en"));
+      assertEquals("de", negotiator.selectOffer("en;q=0, *;q=0.5, fr;q=0.1"));
+      assertEquals(-1, negotiator.select("e, es"));
+    }
+
+    @Test
+    @DisplayName("Should keep negotiating past the offer set registry and cache limits")
+    void testNegotiatorLimits() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      // More negotiators than the native registry holds share one offer set
+      ContentNegotiator negotiator = null;
+      for (int i = 0; i < 100; i++) {
+        negotiator = ContentNegotiator.encodings("br", "gzip", "identity");
+      }
+      // Distinct header values beyond the cache size evict older ones
+      for (int i = 1; i < 1000; i++) {
+        assertEquals("gzip", negotiator.selectOffer("gzip;q=0." + i + ", br;q=0"));
+      }
+      assertEquals("br", negotiator.selectOffer("gzip, br"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Chunked Transfer Coding Tests")
+  class ChunkedTransferCodingTests {
+
+    @Test
+    @DisplayName("Should strip chunk framing in place across split reads")
+    void testDecodeChunkedBody() throws IOException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      byte[] encoded =
+          ("5;ext=1\r\nhello\r\n7\r\n, world\r\n0\r\nX-Checksum: abc\r\n\r\nNEXT")
+              .getBytes(StandardCharsets.US_ASCII);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(encoded.length);
+      buffer.put(encoded);
+
+      try (ChunkedDecoder decoder = new ChunkedDecoder()) {
+        StringBuilder body = new StringBuilder();
+        int pos = 0;
+        while (!decoder.isComplete()) {
+          int length = Math.min(4, encoded.length - pos);
+          int produced = decoder.decode(buffer, pos, length);
+          for (int i = 0; i < produced; i++) {
+            body.append((char) buffer.get(pos + i));
+          }
+          pos += decoder.consumed();
+        }
+
+        assertEquals("hello, world", body.toString());
+        assertEquals(encoded.length - 4, pos);
+        assertEquals("abc", decoder.trailers().get("x-checksum"));
+      }
+    }
+
+    @Test
+    @DisplayName("Should reject malformed chunk framing")
+    void testDecodeMalformedChunkedBody() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      ByteBuffer buffer = ByteBuffer.allocateDirect(16);
+      buffer.put("5\r\nhelloX".getBytes(StandardCharsets.US_ASCII));
+      try (ChunkedDecoder decoder = new ChunkedDecoder()) {
+        assertThrows(IOException.class, () -> decoder.decode(buffer, 0, 9));
+      }
+    }
+
+    @Test
+    @DisplayName("Should frame data in place and write the last chunk")
+    void testEncodeChunks() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      byte[] data = "abcdefghijklmnopqrstuvwxyz".getBytes(StandardCharsets.US_ASCII);
+      int capacity = ChunkedEncoder.HEADROOM + data.length + ChunkedEncoder.TAILROOM;
+      ByteBuffer buffer = ByteBuffer.allocateDirect(capacity);
+      buffer.position(ChunkedEncoder.HEADROOM);
+      buffer.put(data);
+
+      ByteBuffer chunk = ChunkedEncoder.frame(buffer, ChunkedEncoder.HEADROOM, data.length);
+      assertEquals(
+          "1a\r\nabcdefghijklmnopqrstuvwxyz\r\n",
+          StandardCharsets.US_ASCII.decode(chunk).toString());
+
+      ByteBuffer last = ChunkedEncoder.lastChunk("X-Checksum", "abc");
+      assertEquals(
+          "0\r\nX-Checksum: abc\r\n\r\n", StandardCharsets.US_ASCII.decode(last).toString());
+      assertEquals(
+          "0\r\n\r\n", StandardCharsets.US_ASCII.decode(ChunkedEncoder.lastChunk()).toString());
+
+      // UTF-8 on the wire, not modified UTF-8: no surrogate pairs, and U+0000 as a single byte
+      ByteBuffer utf8 = ChunkedEncoder.lastChunk("X-Note", "caf\u00e9 \ud83d\ude00 \u0000");
+      byte[] written = new byte[utf8.remaining()];
+      utf8.get(written);
+      assertArrayEquals(
+          "0\r\nX-Note: caf\u00e9 \ud83d\ude00 \u0000\r\n\r\n".getBytes(StandardCharsets.UTF_8),
+          written);
+      assertThrows(IllegalArgumentException.class, () -> ChunkedEncoder.lastChunk("X", "a\r\nb"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Query String Tests")
+  class QueryStringTests {
+
+    @Test
+    @DisplayName("Should index parameters and decode only values that are read")
+    void testParseQuery() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      QueryParams query = QueryParams.parse("q=caf%C3%A9+au+lait&&flag&tag=a&tag=b&=x&a%20b=1");
+
+      assertEquals(5, query.size());
+      assertEquals("caf\u00e9 au lait", query.get("q"));
+      assertEquals("", query.get("flag"));
+      assertEquals(List.of("a", "b"), query.getAll("tag"));
+      assertEquals("1", query.get("a b"));
+      assertTrue(query.getAll("missing").isEmpty());
+      assertFalse(query.contains(""));
+
+      // Raw UTF-8 bytes decode the same with or without an escape in the same value
+      QueryParams raw = QueryParams.parse("a=caf\u00c3\u00a9&b=caf\u00c3\u00a9+au+lait");
+      assertEquals("caf\u00e9", raw.get("a"));
+      assertEquals("caf\u00e9 au lait", raw.get("b"));
+    }
+
+    @Test
+    @DisplayName("Should parse typed values straight from the query bytes")
+    void testTypedQueryValues() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      QueryParams query =
+          QueryParams.parse(
+              "page=42&min=-9223372036854775808&big=9223372036854775808&ratio=-12.5"
+                  + "&exp=1e3&on=YES&off=0&bad=4x2&plus=%2B7");
+
+      assertEquals(42, query.getInt("page"));
+      assertEquals(Long.MIN_VALUE, query.getLong("min"));
+      assertNull(query.getLong("big"));
+      assertNull(query.getInt("min"));
+      assertEquals(-12.5, query.getDouble("ratio"));
+      assertEquals(1000.0, query.getDouble("exp"));
+      assertEquals(Boolean.TRUE, query.getBoolean("on"));
+      assertEquals(Boolean.FALSE, query.getBoolean("off"));
+      assertNull(query.getInt("bad"));
+      assertNull(query.getBoolean("bad"));
+      assertEquals(7, query.getInt("plus"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Header Block Cache Tests")
+  class HeaderBlockCacheTests {
+
+    private List<String> exportedLines(String block) {
+      ByteBuffer buffer = ByteBuffer.allocateDirect(block.length());
+      buffer.put(block.getBytes(StandardCharsets.US_ASCII));
+      long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, block.length());
+      try {
+        NativeHeaderMap map = NativeHeaderMap.export(headersId);
+        List<String> lines = new ArrayList<>();
+        for (int i = 0; i < map.size(); i++) {
+          lines.add(map.name(i) + ": " + map.value(i));
+        }
+        return lines;
+      } finally {
+        NativeOptimizer.nativeFreeHeaders(headersId);
+      }
+    }
+
+    @Test
+    @DisplayName("Should export headers in wire order whether or not the cache is enabled")
+    void testWireOrderWithCache() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      String block =
+          "Host: internal\r\nX-Request-Id: r1\r\nAccept: a\r\nDate: d1\r\n"
+              + "Accept: b\r\nX-Trace: t\r\n\r\n";
+      String edges = "X-Request-Id: r2\r\nHost: internal\r\nAccept: a\r\nDate: d2\r\n\r\n";
+      List<String> uncached = exportedLines(block);
+      List<String> edgesUncached = exportedLines(edges);
+      assertEquals(6, uncached.size());
+      assertEquals("Host: internal", uncached.get(0));
+      assertEquals("X-Request-Id: r1", uncached.get(1));
+
+      assertTrue(HeaderBlockCache.enable(64, "X-Request-Id", "Date"));
+      try {
+        // A miss, then a hit on the same stable lines
+        assertEquals(uncached, exportedLines(block));
+        assertEquals(uncached, exportedLines(block));
+        // Volatile headers at both ends of the block
+        assertEquals(edgesUncached, exportedLines(edges));
+        assertEquals(edgesUncached, exportedLines(edges));
+        assertEquals(2, HeaderBlockCache.stats().getHits());
+      } finally {
+        HeaderBlockCache.disable();
+      }
+    }
+
+    @Test
+    @DisplayName("Should reuse repeated header blocks and re-read volatile headers")
+    void testHeaderBlockCache() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      assertTrue(HeaderBlockCache.enable(64, "X-Request-Id"));
+      try {
+        for (int i = 0; i < 3; i++) {
+          String block =
+              "Host: internal\r\nX-Request-Id: req-"
+                  + i
+                  + "\r\nAccept: a\r\nAccept: b\r\n\r\n";
+          ByteBuffer buffer = ByteBuffer.allocateDirect(block.length());
+          buffer.put(block.getBytes(StandardCharsets.US_ASCII));
+
+          long headersId = NativeOptimizer.nativeParseHttpHeaders(buffer, block.length());
+          try {
+            assertEquals("req-" + i, NativeOptimizer.nativeGetHeader(headersId, "x-request-id"));
+            assertEquals("internal", NativeOptimizer.nativeGetHeader(headersId, "Host"));
+            String[] accept = NativeOptimizer.nativeGetHeaderValues(headersId, "Accept");
+            assertArrayEquals(new String[] {"a", "b"}, accept);
+          } finally {
+            NativeOptimizer.nativeFreeHeaders(headersId);
+          }
+        }
+
+        HeaderBlockCache.Stats stats = HeaderBlockCache.stats();
+        assertEquals(2, stats.getHits());
+        assertEquals(1, stats.getMisses());
+        assertTrue(stats.getBytesReused() > 0);
+      } finally {
+        HeaderBlockCache.disable();
+      }
+    }
+  }
+
+  @Nested
+  @DisplayName("Strict Header Framing Tests")
+  class StrictHeaderFramingTests {
+
+    private long parseStrict(String block) throws HeaderFramingException {
+      byte[] bytes = block.getBytes(StandardCharsets.ISO_8859_1);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(bytes.length);
+      buffer.put(bytes);
+      return HeaderFramingException.parseStrict(buffer, bytes.length);
+    }
+
+    private int framingError(String block) {
+      HeaderFramingException e =
+          assertThrows(HeaderFramingException.class, () -> parseStrict(block));
+      assertEquals(400, e.getStatusCode());
+      return e.getCode();
+    }
+
+    @Test
+    @DisplayName("Should accept well-framed header blocks")
+    void testValidFraming() throws HeaderFramingException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      long headersId = parseStrict("Host: example.com\r\nContent-Length: 42\r\n\r\n");
+      assertTrue(headersId > 0);
+      try {
+        assertEquals("42", NativeOptimizer.nativeGetHeader(headersId, "content-length"));
+      } finally {
+        NativeOptimizer.nativeFreeHeaders(headersId);
+      }
+    }
+
+    @Test
+    @DisplayName("Should reject ambiguous framing with a specific code")
+    void testRejectedFraming() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      assertEquals(HeaderFramingException.BARE_CR, framingError("Host: a\rX: b\r\n\r\n"));
+      assertEquals(HeaderFramingException.OBS_FOLD, framingError("X: a\r\n b\r\n\r\n"));
+      assertEquals(HeaderFramingException.NUL, framingError("X: a\0b\r\n\r\n"));
+      assertEquals(HeaderFramingException.INVALID_FIELD, framingError("Host : a\r\n\r\n"));
+      assertEquals(
+          HeaderFramingException.DUPLICATE_CONTENT_LENGTH,
+          framingError("Content-Length: 1\r\nContent-Length: 1\r\n\r\n"));
+      assertEquals(
+          HeaderFramingException.INVALID_CONTENT_LENGTH,
+          framingError("Content-Length: 1, 1\r\n\r\n"));
+      assertEquals(
+          HeaderFramingException.CONTENT_LENGTH_WITH_TRANSFER_ENCODING,
+          framingError("Transfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n"));
+    }
+
+    @Test
+    @DisplayName("Should apply the same rules in the native scanner and the Java fallback")
+    void testCheckMatchesScanner() {
+      Object[][] vectors = {
+        {"Host: example.com\r\nContent-Length: 42\r\n\r\n", 0},
+        {"Content-Length:  7 \r\nTransfer-Encoding-X: a\r\n", 0},
+        {"Content-Length: 1\r\nTransfer-Encoding: chunked\r\n", 7},
+        {"Transfer-Encoding: chunked\r\ncontent-length: 5\r\n", 7},
+        {"Content-Length: 1\r\nContent-Length: 1\r\n", 5},
+        {"Content-Length: 1\r\nCONTENT-LENGTH: 2\r\n", 5},
+        {"Content-Length: 1, 1\r\n", 6},
+        {"Content-Length: -1\r\n", 6},
+        {"Content-Length: \r\n", 6},
+        {"Host: a\r\n folded\r\n", 2},
+        {"Content-Length: 1\r\n\tTransfer-Encoding: chunked\r\n", 2},
+        {"Host: a\rContent-Length: 1\r\n", 1},
+        {"Host: a\0\r\n", 3},
+        {"Content-Length : 1\r\n", 4},
+        {": a\r\n", 4},
+      };
+
+      for (Object[] vector : vectors) {
+        String block = (String) vector[0];
+        int expected = (Integer) vector[1];
+        byte[] bytes = block.getBytes(StandardCharsets.ISO_8859_1);
+        ByteBuffer direct = ByteBuffer.allocateDirect(bytes.length);
+        direct.put(bytes);
+
+        assertEquals(expected, HeaderFramingException.javaCheck(direct, bytes.length), block);
+        assertEquals(
+            expected, HeaderFramingException.check(ByteBuffer.wrap(bytes), bytes.length), block);
+        if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+          continue;
+        }
+        assertEquals(expected, HeaderFramingException.check(direct, bytes.length), block);
+        if (expected != 0) {
+          assertEquals(expected, framingError(block), block);
+        }
+      }
+    }
+  }
+
+  @Nested
+  @DisplayName("Client Address Tests")
+  class ClientAddressTests {
+
+    private ClientAddress resolve(int setId, String peer, String[] forwarded, String[] xff) {
+      ClientAddress address = ClientAddress.parse(peer);
+      long[] out = new long[2];
+      int resolved =
+          NativeOptimizer.nativeResolveClientAddress(
+              setId, address.getHigh(), address.getLow(), forwarded, xff, out);
+      assertTrue(resolved >= 0);
+      return new ClientAddress(out[0], out[1]);
+    }
+
+    @Test
+    @DisplayName("Should parse and format IPv4 and IPv6 literals")
+    void testParseAndFormat() {
+      assertEquals("192.0.2.1", ClientAddress.parse("192.0.2.1:8080").toString());
+      assertTrue(ClientAddress.parse("192.0.2.1").isIpv4());
+      assertEquals("2001:db8::1", ClientAddress.parse("[2001:DB8:0:0:0:0:0:1]:443").toString());
+      assertEquals("::1", ClientAddress.parse("::1").toString());
+      assertEquals(ClientAddress.parse("10.0.0.1"), ClientAddress.parse("::ffff:10.0.0.1"));
+      assertNull(ClientAddress.parse("unknown"));
+      assertNull(ClientAddress.parse("010.0.0.1"));
+      assertNull(ClientAddress.parse("1::2::3"));
+    }
+
+    @Test
+    @DisplayName("Should match trusted proxy ranges")
+    void testTrustedProxyRanges() {
+      TrustedProxies proxies = TrustedProxies.of("10.0.0.0/8", "2001:db8::/32", "127.0.0.1");
+      assertTrue(proxies.contains(ClientAddress.parse("10.20.30.40")));
+      assertTrue(proxies.contains(ClientAddress.parse("2001:db8:1::5")));
+      assertTrue(proxies.contains(ClientAddress.parse("127.0.0.1")));
+      assertFalse(proxies.contains(ClientAddress.parse("127.0.0.2")));
+      assertFalse(proxies.contains(ClientAddress.parse("11.0.0.1")));
+      assertThrows(IllegalArgumentException.class, () -> TrustedProxies.of("10.0.0.0/33"));
+      assertThrows(IllegalArgumentException.class, () -> TrustedProxies.of("not-an-address"));
+    }
+
+    @Test
+    @DisplayName("Should resolve the rightmost untrusted forwarded address")
+    void testNativeResolve() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      long[] cidrs = new long[4];
+      ClientAddress network = ClientAddress.parse("10.0.0.0");
+      cidrs[0] = network.getHigh();
+      cidrs[1] = network.getLow();
+      cidrs[2] = -1L;
+      cidrs[3] = 0xFFFFFFFFFF000000L;
+      int setId = NativeOptimizer.nativeCompileTrustedProxies(cidrs);
+      assertTrue(setId > 0);
+
+      String[] xff = {"203.0.113.7, 198.51.100.2, 10.0.0.5"};
+      assertEquals(ClientAddress.parse("198.51.100.2"), resolve(setId, "10.1.1.1", null, xff));
+      assertEquals(ClientAddress.parse("8.8.8.8"), resolve(setId, "8.8.8.8", null, xff));
+
+      String[] forwarded = {"for=\"[2001:db8::17]:4711\";proto=https, for=10.0.0.9"};
+      assertEquals(
+          ClientAddress.parse("2001:db8::17"), resolve(setId, "10.1.1.1", forwarded, xff));
+      assertEquals(
+          ClientAddress.parse("10.0.0.2"),
+          resolve(setId, "10.0.0.2", new String[] {"for=unknown"}, null));
+    }
+  }
+
+  @Nested
+  @DisplayName("Percent Decoding Tests")
+  class PercentDecodingTests {
+
+    @Test
+    @DisplayName("Should decode escapes and plus signs")
+    void testDecode() {
+      assertEquals("a b c", PercentDecoder.decode("a%20b+c", true));
+      assertEquals("a b+c", PercentDecoder.decodePath("a%20b+c"));
+      assertEquals("\u20ac", PercentDecoder.decodeQuery("%E2%82%AC"));
+      assertEquals("100%", PercentDecoder.decodeQuery("100%"));
+      assertEquals("%zz", PercentDecoder.decodeQuery("%zz"));
+    }
+
+    @Test
+    @DisplayName("Should return clean input unchanged")
+    void testUnchanged() {
+      String clean = "plain-value";
+      assertSame(clean, PercentDecoder.decodeQuery(clean));
+      byte[] bytes = "a+b".getBytes(StandardCharsets.US_ASCII);
+      assertEquals(
+          PercentDecoder.UNCHANGED, PercentDecoder.decode(bytes, 0, 3, false, new byte[3]));
+    }
+
+    @Test
+    @DisplayName("Should decode long input natively like the Java decoder")
+    void testNativeDecode() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      String encoded = "x".repeat(70) + "%41+%2" + "y".repeat(40) + "%7e";
+      byte[] src = encoded.getBytes(StandardCharsets.US_ASCII);
+      byte[] dest = new byte[src.length];
+      int length = NativeOptimizer.nativePercentDecode(src, 0, src.length, dest, true);
+      assertEquals(
+          "x".repeat(70) + "A %2" + "y".repeat(40) + "~",
+          new String(dest, 0, length, StandardCharsets.US_ASCII));
+
+      byte[] clean = "z".repeat(100).getBytes(StandardCharsets.US_ASCII);
+      assertEquals(-1, NativeOptimizer.nativePercentDecode(clean, 0, 100, dest, true));
+      assertEquals(-2, NativeOptimizer.nativePercentDecode(clean, 50, 100, dest, true));
+    }
+  }
+
+  @Nested
+  @DisplayName("Form Data Tests")
+  class FormDataTests {
+
+    private ByteBuffer direct(String body) {
+      byte[] bytes = body.getBytes(StandardCharsets.UTF_8);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(bytes.length);
+      buffer.put(bytes).flip();
+      return buffer;
+    }
+
+    private void assertFields(FormData form) {
+      assertEquals(4, form.size());
+      assertEquals(List.of("a", "b c"), form.getAll("tag"));
+      assertEquals("a", form.get("tag"));
+      assertEquals("", form.get("flag"));
+      assertEquals("\u20ac", form.get("price unit"));
+      assertSame(form.get("tag"), form.value(0));
+      assertFalse(form.contains("missing"));
+      assertTrue(form.getAll("missing").isEmpty());
+    }
+
+    @Test
+    @DisplayName("Should keep repeated fields and decode lazily")
+    void testMultiValue() {
+      String body = "tag=a&tag=b+c&flag&&price+unit=%E2%82%AC";
+      assertFields(FormData.parse(direct(body), body.length()));
+      assertFields(FormData.parse(ByteBuffer.wrap(body.getBytes(StandardCharsets.UTF_8)), 40));
+    }
+
+    @Test
+    @DisplayName("Should tokenize a direct body natively in place")
+    void testNativeIndex() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      ByteBuffer body = direct("a=1&b=%41&c");
+      int[] index = new int[15];
+      assertEquals(3, NativeOptimizer.nativeParseFormIndex(body, 11, index));
+      assertArrayEquals(new int[] {4, 1, 6, 3, 2}, Arrays.copyOfRange(index, 5, 10));
+      assertEquals(-3, NativeOptimizer.nativeParseFormIndex(body, 11, new int[5]));
+
+      byte[] dest = new byte[3];
+      assertEquals(1, NativeOptimizer.nativePercentDecodeDirect(body, 6, 3, dest, true));
+      assertEquals('A', dest[0]);
+      assertEquals(-1, NativeOptimizer.nativePercentDecodeDirect(body, 0, 3, dest, true));
+    }
+  }
+
+  @Nested
+  @DisplayName("Streaming Multipart Tests")
+  class StreamingMultipartTests {
+    private static final String BODY =
+        "--XyZ\r\nContent-Disposition: form-data; name=\"field\"\r\n\r\nvalue\r\n"
+            + "--XyZ\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+            + "Content-Type: text/plain\r\n\r\nline1\r\n--XyNot\r\n--XyZ--\r\n";
+
+    // Records events as text, the way an application would copy parts to their destination
+    private class Recorder implements MultipartParser.Listener {
+      final StringBuilder log = new StringBuilder();
+
+      @Override
+      public void partBegin(String name, String filename, String contentType) {
+        log.append('[').append(name).append('|').append(filename).append('|');
+        log.append(contentType).append(']');
+      }
+
+      @Override
+      public void partData(ByteBuffer buffer, int offset, int length) {
+        byte[] bytes = new byte[length];
+        buffer.get(offset, bytes, 0, length);
+        log.append(new String(bytes, StandardCharsets.UTF_8));
+      }
+
+      @Override
+      public void partEnd() {
+        log.append("<end>");
+      }
+    }
+
+    @Test
+    @DisplayName("Should report parts identically for any chunk size")
+    void testChunkedFeeding() throws IOException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      byte[] body = BODY.getBytes(StandardCharsets.US_ASCII);
+      String expected =
+          "[field|null|null]value<end>[file|a.txt|text/plain]line1\r\n--XyNot<end>";
+      for (int chunk = 1; chunk <= body.length; chunk++) {
+        Recorder recorder = new Recorder();
+        ByteBuffer buffer = ByteBuffer.allocateDirect(body.length);
+        try (MultipartParser parser = new MultipartParser("XyZ")) {
+          for (int fed = 0; fed < body.length; ) {
+            int n = Math.min(chunk, body.length - fed);
+            buffer.put(body, fed, n);
+            fed += n;
+            int consumed = parser.parse(buffer, 0, buffer.position(), recorder);
+            buffer.flip().position(consumed);
+            buffer.compact();
+          }
+          assertTrue(parser.isComplete());
+        }
+        assertEquals(expected, recorder.log.toString(), "chunk size " + chunk);
+      }
+    }
+
+    @Test
+    @DisplayName("Should reject malformed bodies")
+    void testMalformed() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      byte[] body = "--XyZ\r\nbogus\r\n\r\ndata\r\n--XyZ--".getBytes(StandardCharsets.US_ASCII);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(body.length);
+      buffer.put(body);
+      try (MultipartParser parser = new MultipartParser("XyZ")) {
+        assertThrows(IOException.class, () -> parser.parse(buffer, 0, body.length, new Recorder()));
+      }
+      assertThrows(IllegalArgumentException.class, () -> new MultipartParser(""));
+    }
+  }
+
+  @Nested
+  @DisplayName("Spill File Tests")
+  class SpillFileTests {
+    @TempDir Path directory;
+
+    @Test
+    @DisplayName("Should write, read back and link an anonymous spill file")
+    void testSpillAndLink() throws IOException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+      long file = NativeOptimizer.nativeSpillFileCreate(directory.toString(), 8 << 20);
+      if (file == 0) {
+        return; // No O_TMPFILE on this platform or filesystem
+      }
+      try {
+        byte[] content = new byte[3 << 20];
+        new Random(7).nextBytes(content);
+        ByteBuffer buffer = ByteBuffer.allocateDirect(content.length);
+        buffer.put(content).flip();
+        for (int offset = 0; offset < content.length; offset += 100_000) {
+          int length = Math.min(100_000, content.length - offset);
+          assertEquals(0, NativeOptimizer.nativeSpillFileWrite(file, buffer, offset, length));
+        }
+        assertEquals(content.length, NativeOptimizer.nativeSpillFileFinish(file));
+
+        // Anonymous until linked
+        try (Stream<Path> entries = Files.list(directory)) {
+          assertEquals(0, entries.count());
+        }
+        Path proc = Paths.get("/proc/self/fd/" + NativeOptimizer.nativeSpillFileDescriptor(file));
+        assertArrayEquals(content, Files.readAllBytes(proc));
+
+        Path target = directory.resolve("upload.bin");
+        Files.write(target, "old".getBytes(StandardCharsets.US_ASCII));
+        assertEquals(0, NativeOptimizer.nativeSpillFileLink(file, target.toString()));
+        assertArrayEquals(content, Files.readAllBytes(target));
+        try (Stream<Path> entries = Files.list(directory)) {
+          assertEquals(1, entries.count());
+        }
+      } finally {
+        NativeOptimizer.nativeSpillFileFree(file);
+      }
+      assertTrue(Files.exists(directory.resolve("upload.bin")));
+    }
+
+    @Test
+    @DisplayName("Should reject writes outside the buffer")
+    void testInvalidWrite() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+      long file = NativeOptimizer.nativeSpillFileCreate(directory.toString(), 0);
+      if (file == 0) {
+        return;
+      }
+      try {
+        ByteBuffer buffer = ByteBuffer.allocateDirect(16);
+        assertTrue(NativeOptimizer.nativeSpillFileWrite(file, buffer, 10, 10) < 0);
+        assertEquals(0, NativeOptimizer.nativeSpillFileFinish(file));
+      } finally {
+        NativeOptimizer.nativeSpillFileFree(file);
+      }
+    }
+  }
+
+  @Nested
+  @DisplayName("Media Type Tests")
+  class MediaTypeTests {
+    @Test
+    @DisplayName("Should parse type, subtype and parameters")
+    void testParse() {
+      MediaType type =
+          MediaType.parse("Multipart/Form-Data; BOUNDARY=\"a \\\"b\"; charset=UTF-8");
+      assertNotNull(type);
+      assertEquals("multipart", type.getType());
+      assertEquals("form-data", type.getSubtype());
+      assertTrue(type.is("multipart", "FORM-DATA"));
+      assertTrue(type.is("multipart", "*"));
+      assertEquals("a \"b", type.getBoundary());
+      assertEquals("UTF-8", type.getCharset());
+      assertNull(type.getParameter("name"));
+
+      MediaType text = MediaType.parse(" text/plain ;; foo=\"boundary=x\"");
+      assertNotNull(text);
+      assertNull(text.getBoundary());
+      assertEquals("boundary=x", text.getParameter("FOO"));
+    }
+
+    @Test
+    @DisplayName("Should reject malformed media types")
+    void testMalformed() {
+      assertNull(MediaType.parse(null));
+      assertNull(MediaType.parse(""));
+      assertNull(MediaType.parse("text"));
+      assertNull(MediaType.parse("text/"));
+      assertNull(MediaType.parse("text/plain garbage"));
+      assertNull(MediaType.parse("text/plain; charset"));
+      assertNull(MediaType.parse("text/plain; charset=\"utf-8"));
+    }
+
+    @Test
+    @DisplayName("Should parse multipart bodies with the Content-Type boundary")
+    void testMultipartWithBoundary() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+      // The preamble has a delimiter-like line that guessing would take as the boundary
+      byte[] body =
+          ("--not-it\r\npreamble\r\n"
+                  + "--real\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\nv1\r\n"
+                  + "--real\r\nContent-Disposition: form-data; name=\"b\"\r\n\r\nv2\r\n"
+                  + "--real--\r\n")
+              .getBytes(StandardCharsets.US_ASCII);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(body.length);
+      buffer.put(body).flip();
+
+      ByteBuffer parsed = NativeOptimizer.nativeParseMultipartForm(buffer, body.length, "real");
+      assertNotNull(parsed);
+      assertEquals(2, parsed.order(ByteOrder.nativeOrder()).getInt(0));
+      assertNull(NativeOptimizer.nativeParseMultipartForm(buffer, body.length, "absent"));
+    }
+  }
+
+  @Nested
+  @DisplayName("Multipart Index Tests")
+  class MultipartIndexTests {
+    @Test
+    @DisplayName("Should index parts as offsets into the body")
+    void testIndex() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+      String body =
+          "--b\r\nContent-Disposition: form-data; name=\"title\"\r\n\r\nhello\r\n"
+              + "--b\r\nContent-Disposition: form-data; name=\"doc\"; filename=\"a.txt\"\r\n"
+              + "Content-Type: text/plain\r\n\r\nfile content\r\n"
+              + "--b--\r\n";
+      byte[] bytes = body.getBytes(StandardCharsets.US_ASCII);
+      ByteBuffer buffer = ByteBuffer.allocateDirect(bytes.length);
+      buffer.put(bytes).flip();
+
+      // Too small for both parts: the negated count asks for a larger array
+      int[] small = new int[8];
+      assertEquals(-2, NativeOptimizer.nativeIndexMultipartForm(buffer, bytes.length, "b", small));
+
+      int[] index = new int[16];
+      assertEquals(2, NativeOptimizer.nativeIndexMultipartForm(buffer, bytes.length, "b", index));
+      assertEquals(body.indexOf("title"), index[0]);
+      assertEquals(5, index[1]);
+      assertEquals(-1, index[3]); // No filename
+      assertEquals(-1, index[5]); // No content type
+      assertEquals(body.indexOf("hello"), index[6]);
+      assertEquals(5, index[7]);
+
+      assertEquals(body.indexOf("a.txt"), index[10]);
+      assertEquals(5, index[11]);
+      assertEquals(body.indexOf("text/plain"), index[12]);
+      assertEquals(10, index[13]);
+      ByteBuffer content = buffer.slice(index[14], index[15]);
+      byte[] data = new byte[content.remaining()];
+      content.get(data);
+      assertEquals("file content", new String(data, StandardCharsets.US_ASCII));
+
+      assertEquals(0, NativeOptimizer.nativeIndexMultipartForm(buffer, bytes.length, "x", index));
+    }
+  }
+
+  @Nested
+  @DisplayName("Multipart Response Tests")
+  class MultipartResponseTests {
+    private String concat(ByteBuffer[] buffers) {
+      StringBuilder text = new StringBuilder();
+      for (ByteBuffer buffer : buffers) {
+        byte[] bytes = new byte[buffer.remaining()];
+        buffer.get(bytes);
+        text.append(new String(bytes, StandardCharsets.UTF_8));
+      }
+      return text.toString();
+    }
+
+    @Test
+    @DisplayName("Should frame parts around their bodies")
+    void testMixed() {
+      ByteBuffer json = ByteBuffer.allocateDirect(8);
+      json.put("{\"a\":1}".getBytes(StandardCharsets.US_ASCII)).flip();
+      MultipartResponse body =
+          MultipartResponse.of("mixed", "batch_1")
+              .part("first".getBytes(StandardCharsets.US_ASCII), "Content-Type", "text/plain")
+              .part(json, "Content-Type", "application/json", "Content-ID", "<2>");
+
+      String expected =
+          "--batch_1\r\nContent-Type: text/plain\r\n\r\nfirst"
+              + "\r\n--batch_1\r\nContent-Type: application/json\r\nContent-ID: <2>\r\n\r\n"
+              + "{\"a\":1}"
+              + "\r\n--batch_1--\r\n";
+      ByteBuffer[] buffers = body.toBuffers();
+      assertEquals(5, buffers.length);
+      assertEquals(expected, concat(buffers));
+      assertEquals(expected.length(), body.getContentLength());
+      assertEquals("multipart/mixed; boundary=batch_1", body.getContentType());
+
+      // Bodies are sent from the buffers they were given
+      assertTrue(buffers[3].isDirect());
+      assertEquals(expected, concat(body.toBuffers()));
+    }
+
+    @Test
+    @DisplayName("Should add Content-Range headers to byte ranges")
+    void testByteRanges() {
+      ByteBuffer content = ByteBuffer.wrap("0123456789".getBytes(StandardCharsets.US_ASCII));
+      MultipartResponse body =
+          MultipartResponse.of("byteranges", "r")
+              .range("text/plain", content, 0, 2)
+              .range("text/plain", content, 7, 9);
+      assertEquals(
+          "--r\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-2/10\r\n\r\n012"
+              + "\r\n--r\r\nContent-Type: text/plain\r\nContent-Range: bytes 7-9/10\r\n\r\n789"
+              + "\r\n--r--\r\n",
+          concat(body.toBuffers()));
+      assertThrows(
+          IllegalArgumentException.class, () -> body.range("text/plain", content, 5, 10));
+      String contentType = MultipartResponse.byteRanges().getContentType();
+      assertTrue(contentType.startsWith("multipart/byteranges; boundary="));
+    }
+
+    @Test
+    @DisplayName("Should write header text as standard UTF-8")
+    void testUtf8Headers() {
+      // Outside the BMP, and U+0000, modified UTF-8 differs from UTF-8
+      String value = "\uD83D\uDE00 a\u0000b";
+      MultipartResponse body =
+          MultipartResponse.of("mixed", "u").part(new byte[0], "Content-Description", value);
+      ByteBuffer[] buffers = body.toBuffers();
+      byte[] expected =
+          ("--u\r\nContent-Description: " + value + "\r\n\r\n").getBytes(StandardCharsets.UTF_8);
+      byte[] frame = new byte[buffers[0].remaining()];
+      buffers[0].get(frame);
+      assertArrayEquals(expected, frame);
+    }
+
+    @Test
+    @DisplayName("Should reject invalid boundaries and headers")
+    void testInvalid() {
+      assertThrows(IllegalArgumentException.class, () -> MultipartResponse.of("mixed", ""));
+      assertThrows(IllegalArgumentException.class, () -> MultipartResponse.of("mixed", "a "));
+      assertThrows(IllegalArgumentException.class, () -> MultipartResponse.of("mixed", "a\"b"));
+      assertThrows(IllegalStateException.class, () -> MultipartResponse.mixed().toBuffers());
+      MultipartResponse injected =
+          MultipartResponse.mixed().part(new byte[0], "X-Test", "a\r\nInjected: 1");
+      assertThrows(IllegalArgumentException.class, injected::toBuffers);
+      String quoted = MultipartResponse.of("mixed", "a b").getContentType();
+      assertEquals("multipart/mixed; boundary=\"a b\"", quoted);
+    }
+  }
+
+  @Nested
+  @DisplayName("Base64 Tests")
+  class Base64Tests {
+    @Test
+    @DisplayName("Should match java.util.Base64 for every length and alphabet")
+    void testRoundTrip() {
+      Random random = new Random(47);
+      for (int length = 0; length < 300; length++) {
+        byte[] data = new byte[length];
+        random.nextBytes(data);
+        String standard = java.util.Base64.getEncoder().encodeToString(data);
+        String url = java.util.Base64.getUrlEncoder().withoutPadding().encodeToString(data);
+
+        assertEquals(standard, Base64Codec.encodeToString(data, 0));
+        assertEquals(
+            url, Base64Codec.encodeToString(data, Base64Codec.URL | Base64Codec.NO_PADDING));
+        assertArrayEquals(data, Base64Codec.decode(standard, 0));
+        assertArrayEquals(data, Base64Codec.decode(url, Base64Codec.URL));
+      }
+    }
+
+    @Test
+    @DisplayName("Should encode and decode direct buffers in place")
+    void testDirectBuffers() {
+      byte[] data = new byte[1000];
+      new Random(7).nextBytes(data);
+      String text = java.util.Base64.getEncoder().encodeToString(data);
+
+      ByteBuffer src = ByteBuffer.allocateDirect(data.length).put(data).flip();
+      ByteBuffer dst = ByteBuffer.allocateDirect(Base64Codec.encodedLength(data.length, 0));
+      assertEquals(text.length(), Base64Codec.encode(src, dst, 0));
+      assertFalse(src.hasRemaining());
+
+      // Decoding over the text leaves the bytes at the start of the same buffer
+      dst.flip();
+      ByteBuffer out = dst.duplicate();
+      assertEquals(data.length, Base64Codec.decode(dst, out, 0));
+      byte[] decoded = new byte[data.length];
+      out.flip().get(decoded);
+      assertArrayEquals(data, decoded);
+    }
+
+    @Test
+    @DisplayName("Should reject non-canonical input unless lenient")
+    void testStrictAndLenient() {
+      // "QR==" has nonzero spare bits; "QQ==" is the canonical encoding of "A"
+      assertArrayEquals(new byte[] {'A'}, Base64Codec.decode("QQ==", 0));
+      assertArrayEquals(new byte[] {'A'}, Base64Codec.decode("QQ", 0));
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode("QR==", 0));
+      assertArrayEquals(new byte[] {'A'}, Base64Codec.decode("QR==", Base64Codec.LENIENT));
+
+      String wrapped = "SGVsbG8s\r\nIHdvcmxk\r\n";
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode(wrapped, 0));
+      assertEquals(
+          "Hello, world",
+          new String(Base64Codec.decode(wrapped, Base64Codec.LENIENT), StandardCharsets.US_ASCII));
+
+      // Each alphabet rejects the other's characters
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode("-_8", 0));
+      assertThrows(
+          IllegalArgumentException.class, () -> Base64Codec.decode("+/8", Base64Codec.URL));
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode("Q", 0));
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode("QQ==QQ==", 0));
+    }
+
+    @Test
+    @DisplayName("Should report the offset of the first invalid character")
+    void testErrorOffset() {
+      byte[] text = new byte[200];
+      Arrays.fill(text, (byte) 'A');
+      text[150] = '*';
+      IllegalArgumentException e =
+          assertThrows(IllegalArgumentException.class, () -> Base64Codec.decode(text, 0));
+      assertTrue(e.getMessage().endsWith("index 150"), e.getMessage());
+    }
+
+    @Test
+    @DisplayName("Should decode named JSON members into buffers")
+    void testParseJson() {
+      String json = "{\"name\":\"a+b\",\"data\":\"SGk\\/Pw==\",\"items\":[{\"data\":\"AAE\"}]}";
+      Object parsed = Base64Codec.parseJson(json, 0, "data");
+      assertTrue(parsed instanceof Map);
+      Map<?, ?> map = (Map<?, ?>) parsed;
+      assertEquals("a+b", map.get("name"));
+
+      ByteBuffer data = (ByteBuffer) map.get("data");
+      byte[] bytes = new byte[data.remaining()];
+      data.get(bytes);
+      assertArrayEquals(new byte[] {'H', 'i', '?', '?'}, bytes);
+
+      Map<?, ?> item = (Map<?, ?>) ((List<?>) map.get("items")).get(0);
+      assertEquals(2, ((ByteBuffer) item.get("data")).remaining());
+
+      String invalid = "{\"data\":\"S*\"}";
+      assertThrows(IllegalArgumentException.class, () -> Base64Codec.parseJson(invalid, 0, "data"));
+
+      if (NativeOptimizer.isNativeOptimizationAvailable()) {
+        // The index counts the string as written, escapes included
+        String escaped = "{\"data\":\"SG\\/\\/*A==\"}";
+        IllegalArgumentException e =
+            assertThrows(
+                IllegalArgumentException.class, () -> Base64Codec.parseJson(escaped, 0, "data"));
+        assertTrue(e.getMessage().endsWith("index 6"), e.getMessage());
+      }
+    }
+  }
+
+  @Nested
+  @DisplayName("CPU Dispatch Tests")
+  class CpuDispatchTests {
+    @Test
+    @DisplayName("Should report the SIMD kernel variant in use")
+    void testSimdVariant() {
+      String variant = NativeOptimizer.getSimdVariant();
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        assertNull(variant);
+        return;
+      }
+      assertTrue(List.of("avx512", "avx2", "sse42", "baseline", "neon").contains(variant), variant);
+    }
+  }
+
+  @Nested
+  @DisplayName("Native Bindings Tests")
+  class NativeBindingsTests {
+    @Test
+    @DisplayName("Should select a binding that is available")
+    void testSelectedBinding() {
+      NativeBindings selected = NativeBindings.get();
+      assertNotNull(selected);
+      assertNotNull(NativeBindings.jni());
+      if (Runtime.version().feature() < 22 || !NativeOptimizer.isNativeOptimizationAvailable()) {
+        assertNull(NativeBindings.ffm());
+        assertEquals("jni", selected.getName());
+      }
+    }
+
+    @Test
+    @DisplayName("Should return the same results through FFM as through JNI")
+    void testFfmMatchesJni() {
+      NativeBindings jni = NativeBindings.jni();
+      NativeBindings ffm = NativeBindings.ffm();
+      if (ffm == null) {
+        return;
+      }
+
+      byte[] json = "{\"a\":1}".getBytes(StandardCharsets.US_ASCII);
+      ByteBuffer body = ByteBuffer.allocateDirect(json.length);
+      body.put(json).flip();
+      assertEquals(
+          jni.analyzeHttpBody(body, json.length, "application/json"),
+          ffm.analyzeHttpBody(body, json.length, "application/json"));
+      assertEquals(
+          jni.detectContentType(body, json.length), ffm.detectContentType(body, json.length));
+
+      byte[] cookies = "a=1; b=two; c=\"3\"".getBytes(StandardCharsets.ISO_8859_1);
+      int[] jniIndex = new int[16 * 4];
+      int[] ffmIndex = new int[16 * 4];
+      assertEquals(3, jni.parseCookies(cookies, cookies.length, jniIndex));
+      assertEquals(3, ffm.parseCookies(cookies, cookies.length, ffmIndex));
+      assertArrayEquals(jniIndex, ffmIndex);
+      assertEquals(-3, ffm.parseCookies(cookies, cookies.length, new int[4]));
+
+      byte[] query = "x=1&y=a%20b+c&z".getBytes(StandardCharsets.ISO_8859_1);
+      jniIndex = new int[16 * 5];
+      ffmIndex = new int[16 * 5];
+      assertEquals(3, jni.parseQuery(query, query.length, jniIndex));
+      assertEquals(3, ffm.parseQuery(query, query.length, ffmIndex));
+      assertArrayEquals(jniIndex, ffmIndex);
+
+      byte[] jniDecoded = new byte[query.length];
+      byte[] ffmDecoded = new byte[query.length];
+      int decodedLength = jni.percentDecode(query, 4, 9, jniDecoded, true);
+      assertEquals(decodedLength, ffm.percentDecode(query, 4, 9, ffmDecoded, true));
+      assertEquals("y=a b c", new String(ffmDecoded, 0, decodedLength, StandardCharsets.UTF_8));
+      assertEquals(-2, ffm.percentDecode(query, 10, 9, ffmDecoded, true));
+    }
+  }
+
+  @Nested
+  @DisplayName("Direct Buffer Pool Tests")
+  class DirectBufferPoolTests {
+    @Test
+    @DisplayName("Should round buffers up to size classes and reuse released ones")
+    void testAcquireAndRelease() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        assertNull(DirectBufferPool.acquire(100));
+        return;
+      }
+
+      DirectBufferPool.Stats before = DirectBufferPool.stats();
+      DirectBufferPool.Lease small = DirectBufferPool.acquire(100);
+      DirectBufferPool.Lease medium = DirectBufferPool.acquire(5000);
+      assertTrue(small.buffer().isDirect());
+      assertEquals(4096, small.buffer().capacity());
+      assertEquals(0, small.buffer().position());
+      assertEquals(4096, small.buffer().limit());
+      assertEquals(8192, medium.buffer().capacity());
+      assertNull(DirectBufferPool.acquire(DirectBufferPool.MAX_BLOCK_SIZE + 1));
+
+      DirectBufferPool.Stats during = DirectBufferPool.stats();
+      assertEquals(before.getInUseBytes() + 4096 + 8192, during.getInUseBytes());
+      assertEquals(before.getInUse(8192) + 1, during.getInUse(8192));
+      assertTrue(during.getPeakInUseBytes() >= during.getInUseBytes());
+
+      assertTrue(small.release());
+      assertFalse(small.release(), "released twice");
+      assertTrue(medium.release());
+
+      // The released block comes back from this thread's cache
+      DirectBufferPool.Lease again = DirectBufferPool.acquire(4000);
+      DirectBufferPool.Stats after = DirectBufferPool.stats();
+      assertEquals(before.getInUseBytes() + 4096, after.getInUseBytes());
+      assertEquals(during.getThreadCacheHits() + 1, after.getThreadCacheHits());
+      // A stale release of the same block does not free its new holder's buffer
+      assertFalse(small.release());
+      assertEquals(after.getInUseBytes(), DirectBufferPool.stats().getInUseBytes());
+      assertTrue(again.release());
+      assertThrows(IllegalArgumentException.class, () -> after.getInUse(3000));
+      assertEquals(after.getBudget(), after.toMap().get("budget"));
+    }
+
+    @Test
+    @DisplayName("Should refuse buffers beyond the budget and release free memory")
+    void testBudget() {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      long budget = DirectBufferPool.stats().getBudget();
+      try {
+        DirectBufferPool.flushThreadCache();
+        DirectBufferPool.trim();
+        long reserved = DirectBufferPool.stats().getReservedBytes();
+        DirectBufferPool.setBudget(reserved + 2 * 1024 * 1024);
+
+        DirectBufferPool.Lease first = DirectBufferPool.acquire(1024 * 1024);
+        DirectBufferPool.Lease second = DirectBufferPool.acquire(1024 * 1024);
+        assertNotNull(first);
+        assertNotNull(second);
+        long rejected = DirectBufferPool.stats().getRejected();
+        assertNull(DirectBufferPool.acquire(4096));
+        assertEquals(rejected + 1, DirectBufferPool.stats().getRejected());
+        assertEquals(reserved + 2 * 1024 * 1024, DirectBufferPool.stats().getReservedBytes());
+
+        // Free blocks of another size are unmapped to make room
+        assertTrue(first.release());
+        DirectBufferPool.Lease other = DirectBufferPool.acquire(512 * 1024);
+        assertNotNull(other);
+        assertTrue(DirectBufferPool.stats().getTrimmed() > 0);
+        assertTrue(other.release());
+        assertTrue(second.release());
+        assertTrue(DirectBufferPool.trim() >= 1024 * 1024);
+        assertFalse(first.release());
+      } finally {
+        DirectBufferPool.setBudget(budget);
+      }
+    }
+
+    @Test
+    @DisplayName("Should keep a buffer with a deferred release until its views are unreachable")
+    void testReleaseWhenUnreachable() throws InterruptedException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      int capacity = 2 * 1024 * 1024;
+      long inUse = DirectBufferPool.stats().getInUse(capacity);
+      DirectBufferPool.Lease lease = DirectBufferPool.acquire(capacity);
+      ByteBuffer view = lease.buffer().asReadOnlyBuffer().slice(16, 32);
+      assertTrue(lease.releaseWhenUnreachable());
+      assertFalse(lease.release());
+      assertFalse(lease.releaseWhenUnreachable());
+      lease = null;
+
+      System.gc();
+      Thread.sleep(50);
+      assertEquals(inUse + 1, DirectBufferPool.stats().getInUse(capacity));
+      assertEquals(32, view.remaining());
+
+      view = null;
+      for (int i = 0; i < 100 && DirectBufferPool.stats().getInUse(capacity) > inUse; i++) {
+        System.gc();
+        Thread.sleep(50);
+      }
+      assertEquals(inUse, DirectBufferPool.stats().getInUse(capacity));
+    }
+
+    @Test
+    @DisplayName("Should reclaim a lease that was never released once its buffer is collected")
+    void testUnreleasedLeaseReclaimed() throws InterruptedException {
+      if (!NativeOptimizer.isNativeOptimizationAvailable()) {
+        return;
+      }
+
+      int capacity = 4 * 1024 * 1024;
+      long inUse = DirectBufferPool.stats().getInUse(capacity);
+      DirectBufferPool.Lease lease = DirectBufferPool.acquire(capacity);
+      assertEquals(inUse + 1, DirectBufferPool.stats().getInUse(capacity));
+
+      lease = null;
+      for (int i = 0; i < 100 && DirectBufferPool.stats().getInUse(capacity) > inUse; i++) {
+        System.gc();
+        Thread.sleep(50);
+      }
+      assertEquals(inUse, DirectBufferPool.stats().getInUse(capacity));
+
+      // An explicit release unregisters the lease, so nothing is released a second time later
+      DirectBufferPool.Lease released = DirectBufferPool.acquire(capacity);
+      assertTrue(released.release());
+      assertFalse(released.release());
+      assertEquals(inUse, DirectBufferPool.stats().getInUse(capacity));
+    }
+  }
+
   @Nested
   @DisplayName("String to Bytes Tests")
   class StringToBytesTests {